@@ -0,0 +1,817 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "capture_metadata_cache.h"
+
+#include <algorithm>
+#include <bit>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "content_hash.h"
+#include "data_core.h"
+#include "pm4_info.h"
+#include "user_cache_directory.h"
+
+namespace Dive
+{
+
+namespace
+{
+
+constexpr char kMagic[8] = {'D', 'I', 'V', 'E', 'M', 'E', 'T', 'A'};
+constexpr char kFileExtension[] = ".divecache";
+
+// How much of the start of each capture file is hashed. Captures start with their first submits,
+// so this catches captures being overwritten by others of the same size in the same second
+constexpr uint64_t kHashedFileSampleSize = 64 * 1024;
+
+struct CacheFileHeader
+{
+    char m_magic[8];
+    uint32_t m_version;
+    uint32_t m_reserved;
+    uint64_t m_capture_hash;
+    uint64_t m_file_size;  // Catches files that were truncated after being written
+};
+
+// A LazyDesc, with the PacketInfo pointer of packet fields replaced by an index into the table of
+// packets stored along with it
+struct CachedLazyDesc
+{
+    uint64_t m_value;
+    uint32_t m_key;  // Register offset, or index into the packet table
+    uint32_t m_is_packet_field;
+};
+
+struct CachedEventInfo
+{
+    uint32_t m_num_indices;
+    uint32_t m_submit_index;
+    uint32_t m_type;
+    uint32_t m_render_mode;
+    uint64_t m_num_shader_references;
+    uint64_t m_str_size;
+};
+
+struct CachedShader
+{
+    uint64_t m_addr;
+    uint32_t m_submit_index;
+    uint32_t m_reserved;
+    uint64_t m_code_size;
+    uint64_t m_code_hash;
+};
+
+//--------------------------------------------------------------------------------------------------
+// Packet fields refer to PacketInfo of a specific variant of a packet, so the opcode alone is not
+// enough to find it again
+const PacketInfo* FindPacketInfo(uint32_t opcode, const char* name)
+{
+    const PacketInfo* packet_info_ptr = GetPacketInfo(opcode);
+    if (packet_info_ptr != nullptr && std::strcmp(packet_info_ptr->m_name, name) == 0)
+    {
+        return packet_info_ptr;
+    }
+    return GetPacketInfo(opcode, name);
+}
+
+}  // namespace
+
+// =================================================================================================
+// CaptureMetadataCache::Writer
+// =================================================================================================
+class CaptureMetadataCache::Writer
+{
+ public:
+    explicit Writer(std::ofstream& stream) : m_stream(stream) {}
+
+    template <typename T> void Write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        WriteBytes(&value, sizeof(T));
+    }
+
+    // Arrays are stored as their size in bytes, followed by the data padded to 8 bytes. This keeps
+    // every array aligned within the file, so that they can be used in place from a mapping
+    void WriteArray(const void* data, uint64_t size)
+    {
+        static const char kPadding[8] = {};
+        Write(size);
+        WriteBytes(data, size);
+        WriteBytes(kPadding, (8 - size % 8) % 8);
+    }
+
+    template <typename Vector> void WriteVector(const Vector& vector)
+    {
+        WriteArray(vector.data(), vector.size() * sizeof(*vector.data()));
+    }
+
+    uint64_t GetSize() const { return m_size; }
+
+ private:
+    void WriteBytes(const void* data, uint64_t size)
+    {
+        if (size == 0) return;
+        m_stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        m_size += size;
+    }
+
+    std::ofstream& m_stream;
+    uint64_t m_size = 0;
+};
+
+// =================================================================================================
+// CaptureMetadataCache::Reader
+// =================================================================================================
+class CaptureMetadataCache::Reader
+{
+ public:
+    Reader(const uint8_t* data, uint64_t size) : m_data(data), m_size(size) {}
+
+    template <typename T> bool Read(T* value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (m_size - m_offset < sizeof(T)) return false;
+        std::memcpy(value, m_data + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return true;
+    }
+
+    // Returns the next array in place. Fails if the array does not fit in the file, or if its size
+    // is not a multiple of elem_size
+    bool ReadArray(uint64_t elem_size, const uint8_t** data, uint64_t* count)
+    {
+        uint64_t size = 0;
+        if (!Read(&size) || size > m_size - m_offset || size % elem_size != 0) return false;
+        uint64_t padded_size = size + (8 - size % 8) % 8;
+        if (padded_size > m_size - m_offset) return false;
+
+        *data = m_data + m_offset;
+        *count = size / elem_size;
+        m_offset += padded_size;
+        return true;
+    }
+
+    template <typename Vector> bool ReadVector(Vector* vector)
+    {
+        using T = std::remove_reference_t<decltype(*vector->data())>;
+        static_assert(std::is_trivially_copyable_v<T>);
+        const uint8_t* data = nullptr;
+        uint64_t count = 0;
+        if (!ReadArray(sizeof(T), &data, &count)) return false;
+        vector->resize(count);
+        if (count != 0) std::memcpy(static_cast<void*>(vector->data()), data, count * sizeof(T));
+        return true;
+    }
+
+ private:
+    const uint8_t* m_data;
+    uint64_t m_size;
+    uint64_t m_offset = 0;
+};
+
+// =================================================================================================
+// CaptureMetadataCache
+// =================================================================================================
+std::string CaptureMetadataCache::GetDefaultDirectory()
+{
+    return GetUserCacheDirectory("metadata_cache");
+}
+
+//--------------------------------------------------------------------------------------------------
+std::string CaptureMetadataCache::GetCacheFileName(const std::string& directory,
+                                                   const std::string& capture_file_name)
+{
+    // Captures with the same name in different directories must not share a cache file
+    std::error_code error;
+    std::filesystem::path capture_path = std::filesystem::absolute(capture_file_name, error);
+    if (error) capture_path = capture_file_name;
+    std::string path_str = capture_path.lexically_normal().string();
+    uint64_t path_hash =
+        HashData(0, reinterpret_cast<const uint8_t*>(path_str.data()), path_str.size());
+
+    char file_name[32];
+    snprintf(file_name, sizeof(file_name), "_%016" PRIx64 "%s", path_hash, kFileExtension);
+    return (std::filesystem::path(directory) / (capture_path.filename().string() + file_name))
+        .string();
+}
+
+//--------------------------------------------------------------------------------------------------
+std::optional<uint64_t> CaptureMetadataCache::HashFiles(const std::vector<std::string>& file_names)
+{
+    uint64_t hash = MixWord(0, file_names.size());
+    std::vector<uint8_t> sample(kHashedFileSampleSize);
+    for (const std::string& file_name : file_names)
+    {
+        std::error_code error;
+        uint64_t file_size = std::filesystem::file_size(file_name, error);
+        if (error) return std::nullopt;
+        auto write_time = std::filesystem::last_write_time(file_name, error);
+        if (error) return std::nullopt;
+
+        std::ifstream stream(file_name, std::ios::binary);
+        uint64_t sample_size = std::min<uint64_t>(file_size, sample.size());
+        if (!stream.read(reinterpret_cast<char*>(sample.data()),
+                         static_cast<std::streamsize>(sample_size)))
+        {
+            return std::nullopt;
+        }
+
+        hash = MixWord(hash, file_size);
+        hash = MixWord(hash, static_cast<uint64_t>(write_time.time_since_epoch().count()));
+        hash = HashData(hash, sample.data(), sample_size);
+    }
+    return hash;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool CaptureMetadataCache::Save(const std::string& cache_file_name, uint64_t capture_hash,
+                                const CaptureMetadata& metadata, uint64_t max_size)
+{
+    // Write to a temporary file that then replaces the cache file, so that a cache file that is
+    // being written is never loaded
+    std::string temp_file_name = cache_file_name + ".tmp";
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(cache_file_name).parent_path(),
+                                        error);
+    bool saved = false;
+    {
+        std::ofstream stream(temp_file_name, std::ios::binary | std::ios::trunc);
+        if (!stream) return false;
+
+        CacheFileHeader header = {};
+        std::memcpy(header.m_magic, kMagic, sizeof(kMagic));
+        header.m_version = kVersion;
+        header.m_capture_hash = capture_hash;
+
+        Writer writer(stream);
+        writer.Write(header);
+        writer.Write(metadata.m_num_pm4_packets);
+        if (SaveCommandHierarchy(writer, metadata.m_command_hierarchy))
+        {
+            // The variable-sized parts of each event are stored in arrays of their own
+            std::vector<CachedEventInfo> event_info;
+            std::vector<ShaderReference> shader_references;
+            std::string strs;
+            event_info.reserve(metadata.m_event_info.size());
+            for (const EventInfo& info : metadata.m_event_info)
+            {
+                CachedEventInfo cached = {};
+                cached.m_num_indices = info.m_num_indices;
+                cached.m_submit_index = info.m_submit_index;
+                cached.m_type = static_cast<uint32_t>(info.m_type);
+                cached.m_render_mode = static_cast<uint32_t>(info.m_render_mode);
+                cached.m_num_shader_references = info.m_shader_references.size();
+                cached.m_str_size = info.m_str.size();
+                event_info.push_back(cached);
+                shader_references.insert(shader_references.end(),
+                                         info.m_shader_references.begin(),
+                                         info.m_shader_references.end());
+                strs += info.m_str;
+            }
+            writer.WriteVector(event_info);
+            writer.WriteVector(shader_references);
+            writer.WriteVector(strs);
+
+            // Only the address and code of each shader are stored, since they are disassembled on
+            // demand
+            std::vector<CachedShader> shaders;
+            for (const Disassembly& shader : metadata.m_shaders)
+            {
+                shaders.push_back({shader.GetShaderAddr(), shader.GetSubmitIndex(), 0,
+                                   shader.GetCode().m_size, shader.GetCode().m_hash});
+            }
+            writer.WriteVector(shaders);
+
+            const EventStateInfo& event_state = metadata.m_event_state;
+            writer.Write(static_cast<uint64_t>(event_state.size()));
+            writer.Write(static_cast<uint64_t>(event_state.capacity()));
+            writer.WriteArray(event_state.RawBuffer(), event_state.RawBufferSize());
+            writer.WriteVector(event_state.RawIsSetBuffer());
+
+            header.m_file_size = writer.GetSize();
+            stream.seekp(0);
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            saved = stream.good();
+        }
+    }
+
+    if (saved)
+    {
+        std::filesystem::rename(temp_file_name, cache_file_name, error);
+        saved = !error;
+    }
+    if (!saved)
+    {
+        std::filesystem::remove(temp_file_name, error);
+        return false;
+    }
+
+    Trim(std::filesystem::path(cache_file_name).parent_path().string(), max_size);
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void CaptureMetadataCache::Trim(const std::string& directory, uint64_t max_size)
+{
+    TrimCacheDirectory(directory, kFileExtension, max_size);
+}
+
+//--------------------------------------------------------------------------------------------------
+bool CaptureMetadataCache::Load(const std::string& cache_file_name, uint64_t capture_hash,
+                                const IMemoryManager& mem_manager, CaptureMetadata& metadata,
+                                std::shared_ptr<const ShaderDisassemblyCache> shader_cache)
+{
+    std::shared_ptr<MappedFile> file = MappedFile::Open(cache_file_name.c_str());
+    if (file == nullptr) return false;
+
+    Reader reader(file->GetData(), file->GetSize());
+    CacheFileHeader header = {};
+    if (!reader.Read(&header) || std::memcmp(header.m_magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.m_version != kVersion || header.m_capture_hash != capture_hash ||
+        header.m_file_size != file->GetSize())
+    {
+        return false;
+    }
+
+    CaptureMetadata loaded;
+    if (!reader.Read(&loaded.m_num_pm4_packets) ||
+        !LoadCommandHierarchy(reader, loaded.m_command_hierarchy))
+    {
+        return false;
+    }
+
+    const uint8_t* data = nullptr;
+    uint64_t num_events = 0;
+    if (!reader.ReadArray(sizeof(CachedEventInfo), &data, &num_events)) return false;
+    const CachedEventInfo* event_info = reinterpret_cast<const CachedEventInfo*>(data);
+    std::vector<ShaderReference> shader_references;
+    std::string strs;
+    if (!reader.ReadVector(&shader_references) || !reader.ReadVector(&strs)) return false;
+
+    uint64_t shader_reference_offset = 0;
+    uint64_t str_offset = 0;
+    loaded.m_event_info.resize(num_events);
+    for (uint64_t event_index = 0; event_index < num_events; ++event_index)
+    {
+        const CachedEventInfo& cached = event_info[event_index];
+        if (cached.m_num_shader_references >
+                shader_references.size() - shader_reference_offset ||
+            cached.m_str_size > strs.size() - str_offset ||
+            cached.m_type > static_cast<uint32_t>(Util::EventType::kEventWriteEnd) ||
+            cached.m_render_mode > static_cast<uint32_t>(RenderModeType::kUnknown))
+        {
+            return false;
+        }
+
+        EventInfo& info = loaded.m_event_info[event_index];
+        info.m_num_indices = cached.m_num_indices;
+        info.m_submit_index = cached.m_submit_index;
+        info.m_type = static_cast<Util::EventType>(cached.m_type);
+        info.m_render_mode = static_cast<RenderModeType>(cached.m_render_mode);
+        auto references_begin = shader_references.begin() + shader_reference_offset;
+        info.m_shader_references.assign(references_begin,
+                                         references_begin + cached.m_num_shader_references);
+        info.m_str = strs.substr(str_offset, cached.m_str_size);
+        shader_reference_offset += cached.m_num_shader_references;
+        str_offset += cached.m_str_size;
+    }
+
+    // The shaders log to the first event that references them, same as when they are created from
+    // the capture
+    std::vector<CachedShader> shaders;
+    if (!reader.ReadVector(&shaders)) return false;
+    std::vector<uint64_t> first_event_index(shaders.size(), UINT64_MAX);
+    for (uint64_t event_index = num_events; event_index-- > 0;)
+    {
+        const EventInfo& info = loaded.m_event_info[event_index];
+        for (const ShaderReference& reference : info.m_shader_references)
+        {
+            if (reference.m_shader_index >= shaders.size() ||
+                static_cast<uint32_t>(reference.m_stage) >= kShaderStageCount)
+            {
+                return false;
+            }
+            first_event_index[reference.m_shader_index] = event_index;
+        }
+    }
+    // The copies of a shader share the disassembly of the first one, also same as when they are
+    // created from the capture
+    std::unordered_map<uint64_t, uint64_t> first_copy_index;
+    for (uint64_t shader_index = 0; shader_index < shaders.size(); ++shader_index)
+    {
+        const CachedShader& cached = shaders[shader_index];
+        if (cached.m_code_size != 0)
+        {
+            auto [it, inserted] = first_copy_index.try_emplace(cached.m_code_hash, shader_index);
+            if (!inserted && loaded.m_shaders[it->second].GetCode().m_size == cached.m_code_size)
+            {
+                loaded.m_shaders.emplace_back(cached.m_submit_index, cached.m_addr,
+                                              loaded.m_shaders[it->second]);
+                continue;
+            }
+        }
+
+        uint64_t event_index = first_event_index[shader_index];
+        ILog* log = nullptr;
+        if (event_index != UINT64_MAX) log = &loaded.m_event_info[event_index].m_metadata_log;
+        ShaderCode code;
+        code.m_size = cached.m_code_size;
+        code.m_hash = cached.m_code_hash;
+        loaded.m_shaders.emplace_back(mem_manager, cached.m_submit_index, cached.m_addr, code, log,
+                                      shader_cache);
+    }
+
+    uint64_t event_state_size = 0;
+    uint64_t event_state_cap = 0;
+    const uint8_t* event_state_buffer = nullptr;
+    uint64_t event_state_buffer_size = 0;
+    const uint8_t* is_set_buffer = nullptr;
+    uint64_t is_set_buffer_size = 0;
+    if (!reader.Read(&event_state_size) || !reader.Read(&event_state_cap) ||
+        !reader.ReadArray(1, &event_state_buffer, &event_state_buffer_size) ||
+        !reader.ReadArray(1, &is_set_buffer, &is_set_buffer_size) || event_state_cap > UINT32_MAX)
+    {
+        return false;
+    }
+    using EventStateId = EventStateInfo::Id::basic_type;
+    if (!loaded.m_event_state.AssignRaw(static_cast<EventStateId>(event_state_size),
+                                        static_cast<EventStateId>(event_state_cap),
+                                        event_state_buffer, event_state_buffer_size,
+                                        is_set_buffer, is_set_buffer_size))
+    {
+        return false;
+    }
+
+    // The modification time of the files is when they were last used, for Trim()
+    std::error_code error;
+    std::filesystem::last_write_time(cache_file_name,
+                                     std::filesystem::file_time_type::clock::now(), error);
+
+    metadata = std::move(loaded);
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool CaptureMetadataCache::SaveCommandHierarchy(Writer& writer,
+                                                const CommandHierarchy& command_hierarchy)
+{
+    const CommandHierarchy::Nodes& nodes = command_hierarchy.m_nodes;
+    writer.WriteVector(nodes.m_node_type);
+    writer.WriteVector(nodes.m_aux_info);
+    writer.WriteVector(nodes.m_event_node_indices);
+
+    // The descriptions are stored as one block of null-terminated strings, along with the offset
+    // of each description. Interned descriptions are only stored once. Which nodes have a stored
+    // description follows from the nodes themselves, so m_desc_groups is not stored
+    std::string descs;
+    std::vector<uint64_t> desc_offsets;
+    std::unordered_map<const char*, uint64_t> desc_offset_map;
+    desc_offsets.reserve(nodes.m_description.size());
+    for (const char* desc : nodes.m_description)
+    {
+        auto [it, inserted] = desc_offset_map.try_emplace(desc, descs.size());
+        if (inserted)
+        {
+            descs.append(desc);
+            descs.push_back('\0');
+        }
+        desc_offsets.push_back(it->second);
+    }
+    writer.WriteVector(descs);
+    writer.WriteVector(desc_offsets);
+
+    // Whether a LazyDesc is of a packet field is only known from the nodes that refer to it
+    std::vector<bool> is_packet_field(nodes.m_lazy_desc.size(), false);
+    for (uint64_t node_index = 0; node_index < nodes.m_node_type.size(); ++node_index)
+    {
+        NodeType type = nodes.m_node_type[node_index];
+        const auto& info = nodes.m_aux_info[node_index].reg_field_node;
+        if ((type == NodeType::kRegNode || type == NodeType::kFieldNode) &&
+            (CommandHierarchy::LazyDescType)info.m_lazy_desc_type ==
+                CommandHierarchy::LazyDescType::kPacketField)
+        {
+            is_packet_field[info.m_lazy_desc_index] = true;
+        }
+    }
+
+    std::vector<CachedLazyDesc> lazy_descs(nodes.m_lazy_desc.size());
+    std::vector<uint32_t> packet_opcodes;
+    std::string packet_names;
+    std::unordered_map<const PacketInfo*, uint32_t> packet_indices;
+    for (uint64_t lazy_desc_index = 0; lazy_desc_index < lazy_descs.size(); ++lazy_desc_index)
+    {
+        const CommandHierarchy::LazyDesc& lazy_desc = nodes.m_lazy_desc[lazy_desc_index];
+        CachedLazyDesc& cached = lazy_descs[lazy_desc_index];
+        cached.m_value = lazy_desc.m_value;
+        if (!is_packet_field[lazy_desc_index])
+        {
+            cached.m_key = lazy_desc.m_reg_offset;
+            continue;
+        }
+
+        const PacketInfo* packet_info_ptr = lazy_desc.m_packet_info;
+        auto [it, inserted] = packet_indices.try_emplace(packet_info_ptr,
+                                                         (uint32_t)packet_opcodes.size());
+        if (inserted)
+        {
+            uint32_t opcode = 0;
+            while (opcode < 0x80 && FindPacketInfo(opcode, packet_info_ptr->m_name) !=
+                                        packet_info_ptr)
+            {
+                ++opcode;
+            }
+            if (opcode == 0x80) return false;
+            packet_opcodes.push_back(opcode);
+            packet_names.append(packet_info_ptr->m_name);
+            packet_names.push_back('\0');
+        }
+        cached.m_key = it->second;
+        cached.m_is_packet_field = 1;
+    }
+    writer.WriteVector(lazy_descs);
+    writer.WriteVector(packet_opcodes);
+    writer.WriteVector(packet_names);
+
+    for (uint32_t filter = 0; filter < CommandHierarchy::kFilterListTypeCount; ++filter)
+    {
+        const std::unordered_set<uint64_t>& indices =
+            command_hierarchy.m_filter_exclude_indices_list[filter];
+        writer.WriteVector(std::vector<uint64_t>(indices.begin(), indices.end()));
+    }
+
+    for (uint32_t topology = 0; topology < CommandHierarchy::kTopologyTypeCount; ++topology)
+    {
+        SaveTopology(writer, command_hierarchy.m_topology[topology]);
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void CaptureMetadataCache::SaveTopology(Writer& writer, const SharedNodeTopology& topology)
+{
+    writer.WriteVector(topology.m_children_list);
+    writer.WriteVector(topology.m_node_children);
+    writer.WriteVector(topology.m_node_parent);
+    writer.WriteVector(topology.m_node_child_index);
+    writer.WriteVector(topology.m_shared_children_indices);
+    writer.WriteVector(topology.m_node_shared_children);
+    writer.WriteVector(topology.m_start_shared_child);
+    writer.WriteVector(topology.m_end_shared_child);
+    writer.WriteVector(topology.m_root_node_index);
+}
+
+//--------------------------------------------------------------------------------------------------
+bool CaptureMetadataCache::LoadCommandHierarchy(Reader& reader,
+                                                CommandHierarchy& command_hierarchy)
+{
+    CommandHierarchy::Nodes& nodes = command_hierarchy.m_nodes;
+    if (!reader.ReadVector(&nodes.m_node_type)) return false;
+    uint64_t num_nodes = nodes.m_node_type.size();
+    for (NodeType type : nodes.m_node_type)
+    {
+        if (type > NodeType::kGfxrRootFrameNode) return false;
+    }
+
+    // AuxInfo has no default constructor, so it can't be resized like the other vectors
+    const uint8_t* aux_info = nullptr;
+    uint64_t num_aux_info = 0;
+    if (!reader.ReadArray(sizeof(CommandHierarchy::AuxInfo), &aux_info, &num_aux_info) ||
+        num_aux_info != num_nodes)
+    {
+        return false;
+    }
+    nodes.m_aux_info.resize(num_nodes, CommandHierarchy::AuxInfo(0));
+    if (num_nodes != 0)
+    {
+        std::memcpy(static_cast<void*>(nodes.m_aux_info.data()), aux_info,
+                    num_nodes * sizeof(CommandHierarchy::AuxInfo));
+    }
+    if (!reader.ReadVector(&nodes.m_event_node_indices)) return false;
+    for (uint64_t event_node_index : nodes.m_event_node_indices)
+    {
+        if (event_node_index >= num_nodes) return false;
+    }
+
+    // All the descriptions are added to the string arena at once, and each description points
+    // into it
+    nodes.UpdateDescGroups();
+    uint64_t num_descs = 0;
+    if (!nodes.m_desc_groups.empty())
+    {
+        const CommandHierarchy::Nodes::DescGroup& last_group = nodes.m_desc_groups.back();
+        num_descs = last_group.m_first_desc_index + std::popcount(last_group.m_stored_mask);
+    }
+    const uint8_t* descs = nullptr;
+    uint64_t descs_size = 0;
+    std::vector<uint64_t> desc_offsets;
+    if (!reader.ReadArray(1, &descs, &descs_size) || !reader.ReadVector(&desc_offsets) ||
+        desc_offsets.size() != num_descs || (descs_size != 0 && descs[descs_size - 1] != '\0'))
+    {
+        return false;
+    }
+    const char* descs_copy = nodes.m_strings.Add(
+        std::string_view(reinterpret_cast<const char*>(descs), descs_size));
+    nodes.m_description.resize(num_descs);
+    for (uint64_t desc_index = 0; desc_index < num_descs; ++desc_index)
+    {
+        if (desc_offsets[desc_index] >= descs_size) return false;
+        nodes.m_description[desc_index] = descs_copy + desc_offsets[desc_index];
+    }
+
+    std::vector<CachedLazyDesc> lazy_descs;
+    std::vector<uint32_t> packet_opcodes;
+    std::string packet_names;
+    if (!reader.ReadVector(&lazy_descs) || !reader.ReadVector(&packet_opcodes) ||
+        !reader.ReadVector(&packet_names))
+    {
+        return false;
+    }
+
+    std::vector<const PacketInfo*> packet_infos;
+    size_t name_offset = 0;
+    for (uint32_t opcode : packet_opcodes)
+    {
+        size_t name_end = packet_names.find('\0', name_offset);
+        if (opcode >= 0x80 || name_end == std::string::npos) return false;
+        const PacketInfo* packet_info_ptr = FindPacketInfo(opcode, &packet_names[name_offset]);
+        if (packet_info_ptr == nullptr) return false;
+        packet_infos.push_back(packet_info_ptr);
+        name_offset = name_end + 1;
+    }
+
+    nodes.m_lazy_desc.resize(lazy_descs.size());
+    for (uint64_t lazy_desc_index = 0; lazy_desc_index < lazy_descs.size(); ++lazy_desc_index)
+    {
+        const CachedLazyDesc& cached = lazy_descs[lazy_desc_index];
+        CommandHierarchy::LazyDesc& lazy_desc = nodes.m_lazy_desc[lazy_desc_index];
+        lazy_desc.m_value = cached.m_value;
+        if (cached.m_is_packet_field == 0)
+        {
+            lazy_desc.m_reg_offset = cached.m_key;
+            continue;
+        }
+        if (cached.m_key >= packet_infos.size()) return false;
+        lazy_desc.m_packet_info = packet_infos[cached.m_key];
+    }
+
+    // The descriptions of the nodes that refer to a LazyDesc are formatted from it on demand, so
+    // each of these must refer to an existing LazyDesc of the right kind, and to an existing field
+    for (uint64_t node_index = 0; node_index < num_nodes; ++node_index)
+    {
+        NodeType type = nodes.m_node_type[node_index];
+        const auto& info = nodes.m_aux_info[node_index].reg_field_node;
+        auto lazy_desc_type = (CommandHierarchy::LazyDescType)info.m_lazy_desc_type;
+        if ((type != NodeType::kRegNode && type != NodeType::kFieldNode) ||
+            lazy_desc_type == CommandHierarchy::LazyDescType::kNone)
+        {
+            continue;
+        }
+        if (info.m_lazy_desc_index >= lazy_descs.size()) return false;
+
+        const CachedLazyDesc& cached = lazy_descs[info.m_lazy_desc_index];
+        const CommandHierarchy::LazyDesc& lazy_desc = nodes.m_lazy_desc[info.m_lazy_desc_index];
+        uint32_t field = info.m_lazy_desc_field;
+        if (lazy_desc_type == CommandHierarchy::LazyDescType::kPacketField)
+        {
+            if (cached.m_is_packet_field == 0 ||
+                field >= lazy_desc.m_packet_info->m_fields.size())
+            {
+                return false;
+            }
+            continue;
+        }
+        if (cached.m_is_packet_field != 0) return false;
+
+        // Registers are written a dword at a time, and the value of an enum register is one of
+        // the enum's values
+        const RegInfo* reg_info_ptr = GetRegInfo(lazy_desc.m_reg_offset);
+        if (reg_info_ptr == nullptr)
+        {
+            if (lazy_desc_type == CommandHierarchy::LazyDescType::kRegisterField) return false;
+            continue;
+        }
+        if ((!reg_info_ptr->m_is_64_bit && lazy_desc.m_value > UINT32_MAX) ||
+            (lazy_desc_type == CommandHierarchy::LazyDescType::kRegister &&
+             reg_info_ptr->m_enum_handle != UINT8_MAX &&
+             GetEnumString(reg_info_ptr->m_enum_handle,
+                           (uint32_t)(lazy_desc.m_value << reg_info_ptr->m_shr)) == nullptr) ||
+            (lazy_desc_type == CommandHierarchy::LazyDescType::kRegisterField &&
+             field >= reg_info_ptr->m_fields.size()))
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t filter = 0; filter < CommandHierarchy::kFilterListTypeCount; ++filter)
+    {
+        std::vector<uint64_t> indices;
+        if (!reader.ReadVector(&indices)) return false;
+        for (uint64_t index : indices)
+        {
+            if (index >= num_nodes) return false;
+        }
+        command_hierarchy.m_filter_exclude_indices_list[filter].insert(indices.begin(),
+                                                                       indices.end());
+    }
+
+    for (uint32_t topology = 0; topology < CommandHierarchy::kTopologyTypeCount; ++topology)
+    {
+        if (!LoadTopology(reader, num_nodes, command_hierarchy.m_topology[topology]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool CaptureMetadataCache::LoadTopology(Reader& reader, uint64_t num_nodes,
+                                        SharedNodeTopology& topology)
+{
+    if (!reader.ReadVector(&topology.m_children_list) ||
+        !reader.ReadVector(&topology.m_node_children) ||
+        !reader.ReadVector(&topology.m_node_parent) ||
+        !reader.ReadVector(&topology.m_node_child_index) ||
+        !reader.ReadVector(&topology.m_shared_children_indices) ||
+        !reader.ReadVector(&topology.m_node_shared_children) ||
+        !reader.ReadVector(&topology.m_start_shared_child) ||
+        !reader.ReadVector(&topology.m_end_shared_child) ||
+        !reader.ReadVector(&topology.m_root_node_index))
+    {
+        return false;
+    }
+
+    // A topology can cover fewer nodes than the hierarchy (such as the PM4 part of a Dive capture),
+    // or none at all, but every node it covers has children, a parent and a child index
+    uint64_t num_topology_nodes = topology.m_node_children.size();
+    if (num_topology_nodes > num_nodes || topology.m_node_parent.size() != num_topology_nodes ||
+        topology.m_node_child_index.size() != num_topology_nodes ||
+        (!topology.m_node_shared_children.empty() &&
+         topology.m_node_shared_children.size() != num_topology_nodes) ||
+        topology.m_start_shared_child.size() > num_nodes ||
+        topology.m_end_shared_child.size() > num_nodes ||
+        topology.m_root_node_index.size() > num_nodes)
+    {
+        return false;
+    }
+
+    auto is_valid_range = [](const Topology::ChildrenInfo& info, uint64_t list_size) {
+        return info.m_num_children == 0 || (info.m_start_index <= list_size &&
+                                            info.m_num_children <= list_size - info.m_start_index);
+    };
+    auto are_valid_nodes = [](const DiveVector<uint64_t>& node_indices, uint64_t count,
+                              bool allow_unset) {
+        return std::all_of(node_indices.begin(), node_indices.end(), [&](uint64_t node_index) {
+            return node_index < count || (allow_unset && node_index == UINT64_MAX);
+        });
+    };
+    for (const Topology::ChildrenInfo& info : topology.m_node_children)
+    {
+        if (!is_valid_range(info, topology.m_children_list.size())) return false;
+    }
+    for (const Topology::ChildrenInfo& info : topology.m_node_shared_children)
+    {
+        if (!is_valid_range(info, topology.m_shared_children_indices.size())) return false;
+    }
+    for (uint64_t node_index = 0; node_index < num_topology_nodes; ++node_index)
+    {
+        uint64_t parent_index = topology.m_node_parent[node_index];
+        uint64_t child_index = topology.m_node_child_index[node_index];
+        if (parent_index == UINT64_MAX) continue;
+        if (parent_index >= num_topology_nodes ||
+            child_index >= topology.m_node_children[parent_index].m_num_children)
+        {
+            return false;
+        }
+    }
+
+    // Children and root nodes are looked up in the topology again, unlike the start and end nodes
+    return are_valid_nodes(topology.m_children_list, num_topology_nodes, false) &&
+           are_valid_nodes(topology.m_shared_children_indices, num_topology_nodes, false) &&
+           are_valid_nodes(topology.m_root_node_index, num_topology_nodes, true) &&
+           are_valid_nodes(topology.m_start_shared_child, num_nodes, true) &&
+           are_valid_nodes(topology.m_end_shared_child, num_nodes, true);
+}
+
+}  // namespace Dive
@@ -0,0 +1,91 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace Dive
+{
+
+class CommandHierarchy;
+class IMemoryManager;
+class SharedNodeTopology;
+class ShaderDisassemblyCache;
+struct CaptureMetadata;
+
+//--------------------------------------------------------------------------------------------------
+// Saves the metadata parsed from a capture (command hierarchy, event info and event state) to a
+// file in the per-user cache directory, so that opening the same capture again does not need to
+// emulate the submits. The file is a flat list of arrays, each aligned to 8 bytes, which are copied
+// out of a mapping of the file when loading. It is keyed on the size, modification time and first
+// bytes of the capture files, and is ignored if either the key or the format version do not match.
+// Every index in the file is checked when loading, so a corrupt file is a cache miss. The least
+// recently used files are removed once the directory grows past its size limit
+class CaptureMetadataCache
+{
+ public:
+    // Increment whenever the file layout, or the layout of any structure stored as is (such as
+    // CommandHierarchy's AuxInfo or the fields of EventStateInfo) changes
+    static constexpr uint32_t kVersion = 4;
+
+    // The metadata of a large capture can take hundreds of MiB, so this keeps a few of them
+    static constexpr uint64_t kDefaultMaxSize = uint64_t(1) << 30;
+
+    // The per-user cache directory of the platform, or the temporary directory if there is none
+    static std::string GetDefaultDirectory();
+
+    // Name of the cache file of the given capture file in the given directory, which is named after
+    // the absolute path of the capture
+    static std::string GetCacheFileName(const std::string& directory,
+                                        const std::string& capture_file_name);
+
+    // Hash of the size, modification time and first bytes of all the given files, which changes
+    // whenever they are replaced or written to without reading them whole. Returns std::nullopt if
+    // a file cannot be read
+    static std::optional<uint64_t> HashFiles(const std::vector<std::string>& file_names);
+
+    // Replace the metadata with the one in the cache file. Returns false, leaving the metadata
+    // untouched, if the file does not exist, does not match the version or capture hash, or is
+    // malformed. The shaders are recreated from the capture memory in mem_manager, and use
+    // shader_cache for their disassembly if it is not null
+    static bool Load(const std::string& cache_file_name, uint64_t capture_hash,
+                     const IMemoryManager& mem_manager, CaptureMetadata& metadata,
+                     std::shared_ptr<const ShaderDisassemblyCache> shader_cache = nullptr);
+
+    // Write the metadata to the cache file, replacing any existing one. Creates the directory of
+    // the cache file if needed, and trims it to max_size afterwards
+    static bool Save(const std::string& cache_file_name, uint64_t capture_hash,
+                     const CaptureMetadata& metadata, uint64_t max_size = kDefaultMaxSize);
+
+    // Remove the least recently used cache files until the directory is within max_size
+    static void Trim(const std::string& directory, uint64_t max_size = kDefaultMaxSize);
+
+ private:
+    class Reader;
+    class Writer;
+
+    // Fails if a packet field refers to packet info that can't be found again when loading
+    static bool SaveCommandHierarchy(Writer& writer, const CommandHierarchy& command_hierarchy);
+    static void SaveTopology(Writer& writer, const SharedNodeTopology& topology);
+    static bool LoadCommandHierarchy(Reader& reader, CommandHierarchy& command_hierarchy);
+    static bool LoadTopology(Reader& reader, uint64_t num_nodes, SharedNodeTopology& topology);
+};
+
+}  // namespace Dive
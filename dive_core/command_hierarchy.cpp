@@ -20,6 +20,7 @@
 #include <assert.h>
 
 #include <algorithm>  // std::transform
+#include <bit>
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
@@ -100,22 +101,28 @@ void Topology::SetNumNodes(uint64_t num_nodes)
 
 //--------------------------------------------------------------------------------------------------
 void Topology::AddChildren(uint64_t node_index, const DiveVector<uint64_t>& children)
+{
+    AddChildren(node_index, children.data(), children.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+void Topology::AddChildren(uint64_t node_index, const uint64_t* children, uint64_t num_children)
 {
     DIVE_ASSERT(m_node_children.size() == m_node_parent.size());
     DIVE_ASSERT(m_node_children.size() == m_node_child_index.size());
 
     // Append to m_children_list
     uint64_t prev_size = m_children_list.size();
-    m_children_list.resize(m_children_list.size() + children.size());
-    std::copy(children.begin(), children.end(), m_children_list.begin() + prev_size);
+    m_children_list.resize(m_children_list.size() + num_children);
+    std::copy(children, children + num_children, m_children_list.begin() + prev_size);
 
     // Set "pointer" to children_list
     DIVE_ASSERT(m_node_children[node_index].m_num_children == 0);
     m_node_children[node_index].m_start_index = prev_size;
-    m_node_children[node_index].m_num_children = children.size();
+    m_node_children[node_index].m_num_children = num_children;
 
     // Set parent pointer and child_index for each child
-    for (uint64_t i = 0; i < children.size(); ++i)
+    for (uint64_t i = 0; i < num_children; ++i)
     {
         uint64_t child_node_index = children[i];
         DIVE_ASSERT(child_node_index < m_node_children.size());  // Sanity check
@@ -128,6 +135,42 @@ void Topology::AddChildren(uint64_t node_index, const DiveVector<uint64_t>& chil
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+void Topology::AppendChildren(uint64_t node_index, const uint64_t* children, uint64_t num_children)
+{
+    DIVE_ASSERT(m_node_children.size() == m_node_parent.size());
+    DIVE_ASSERT(m_node_children.size() == m_node_child_index.size());
+
+    ChildrenInfo& children_info = m_node_children[node_index];
+    uint64_t end_index = children_info.m_start_index + children_info.m_num_children;
+    if (children_info.m_num_children == 0)
+    {
+        children_info.m_start_index = m_children_list.size();
+    }
+    else if (end_index != m_children_list.size())
+    {
+        // The previous range is left unused
+        uint64_t start_index = m_children_list.size();
+        m_children_list.resize(start_index + children_info.m_num_children);
+        std::copy(m_children_list.begin() + children_info.m_start_index,
+                  m_children_list.begin() + end_index, m_children_list.begin() + start_index);
+        children_info.m_start_index = start_index;
+    }
+
+    uint64_t prev_size = m_children_list.size();
+    m_children_list.resize(prev_size + num_children);
+    std::copy(children, children + num_children, m_children_list.begin() + prev_size);
+    for (uint64_t i = 0; i < num_children; ++i)
+    {
+        uint64_t child_node_index = children[i];
+        DIVE_ASSERT(child_node_index < m_node_children.size());
+        DIVE_ASSERT(m_node_parent[child_node_index] == UINT64_MAX);
+        m_node_parent[child_node_index] = node_index;
+        m_node_child_index[child_node_index] = children_info.m_num_children + i;
+    }
+    children_info.m_num_children += num_children;
+}
+
 // =================================================================================================
 // SharedNodeTopology
 // =================================================================================================
@@ -191,19 +234,116 @@ void SharedNodeTopology::SetNumNodes(uint64_t num_nodes)
 //--------------------------------------------------------------------------------------------------
 void SharedNodeTopology::AddSharedChildren(uint64_t node_index,
                                            const DiveVector<uint64_t>& children)
+{
+    AddSharedChildren(node_index, children.data(), children.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+void SharedNodeTopology::AddSharedChildren(uint64_t node_index, const uint64_t* children,
+                                           uint64_t num_children)
 {
     DIVE_ASSERT(m_node_shared_children.size() == m_node_parent.size());
     DIVE_ASSERT(m_node_shared_children.size() == m_node_child_index.size());
 
     // Append to m_shared_children_indices
     uint64_t prev_size = m_shared_children_indices.size();
-    m_shared_children_indices.resize(m_shared_children_indices.size() + children.size());
-    std::copy(children.begin(), children.end(), m_shared_children_indices.begin() + prev_size);
+    m_shared_children_indices.resize(m_shared_children_indices.size() + num_children);
+    std::copy(children, children + num_children, m_shared_children_indices.begin() + prev_size);
 
     // Set "pointer" to children_list
     DIVE_ASSERT(m_node_shared_children[node_index].m_num_children == 0);
     m_node_shared_children[node_index].m_start_index = prev_size;
-    m_node_shared_children[node_index].m_num_children = children.size();
+    m_node_shared_children[node_index].m_num_children = num_children;
+}
+
+// =================================================================================================
+// NodeChildrenLists
+// =================================================================================================
+void NodeChildrenLists::Reserve(uint64_t num_children) { m_links.reserve(num_children); }
+
+//--------------------------------------------------------------------------------------------------
+void NodeChildrenLists::AddChild(uint64_t node_index, uint64_t child_node_index)
+{
+    DIVE_ASSERT(m_offsets.empty());
+    m_links.push_back(Link{node_index, child_node_index});
+}
+
+//--------------------------------------------------------------------------------------------------
+void NodeChildrenLists::GetChildrenSince(uint64_t node_index, uint64_t first_link,
+                                         DiveVector<uint64_t>* children) const
+{
+    DIVE_ASSERT(m_offsets.empty());
+    children->clear();
+    for (uint64_t i = first_link; i < m_links.size(); ++i)
+    {
+        if (m_links[i].m_node_index == node_index)
+            children->push_back(m_links[i].m_child_node_index);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void NodeChildrenLists::GetLinksSince(uint64_t first_link,
+                                      std::vector<CommandHierarchyChunk::Link>* links) const
+{
+    DIVE_ASSERT(m_offsets.empty());
+    for (uint64_t i = first_link; i < m_links.size(); ++i)
+        links->push_back({m_links[i].m_node_index, m_links[i].m_child_node_index});
+}
+
+//--------------------------------------------------------------------------------------------------
+void NodeChildrenLists::Group(uint64_t num_nodes)
+{
+    DIVE_ASSERT(m_offsets.empty());
+
+    // Counting sort by parent node, which keeps the children of each node in the order they were
+    // added. First count the children of each node, and turn that into the start of each range
+    m_offsets.resize(num_nodes + 1, 0);
+    for (const Link& link : m_links)
+    {
+        DIVE_ASSERT(link.m_node_index < num_nodes);
+        ++m_offsets[link.m_node_index + 1];
+    }
+    for (uint64_t node_index = 1; node_index <= num_nodes; ++node_index)
+        m_offsets[node_index] += m_offsets[node_index - 1];
+
+    // Scatter the children. This advances the start of each range to its end, which is the start of
+    // the next range, so shift the offsets back afterwards
+    m_children.resize(m_links.size());
+    for (const Link& link : m_links)
+        m_children[m_offsets[link.m_node_index]++] = link.m_child_node_index;
+    for (uint64_t node_index = num_nodes; node_index > 0; --node_index)
+        m_offsets[node_index] = m_offsets[node_index - 1];
+    m_offsets[0] = 0;
+
+    m_links = DiveVector<Link>();
+}
+
+//--------------------------------------------------------------------------------------------------
+uint64_t NodeChildrenLists::GetNumNodes() const
+{
+    DIVE_ASSERT(!m_offsets.empty());
+    return m_offsets.size() - 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+uint64_t NodeChildrenLists::GetNumChildren(uint64_t node_index) const
+{
+    DIVE_ASSERT(node_index + 1 < m_offsets.size());
+    return m_offsets[node_index + 1] - m_offsets[node_index];
+}
+
+//--------------------------------------------------------------------------------------------------
+const uint64_t* NodeChildrenLists::GetChildren(uint64_t node_index) const
+{
+    DIVE_ASSERT(node_index + 1 < m_offsets.size());
+    return m_children.data() + m_offsets[node_index];
+}
+
+//--------------------------------------------------------------------------------------------------
+uint64_t* NodeChildrenLists::GetChildren(uint64_t node_index)
+{
+    DIVE_ASSERT(node_index + 1 < m_offsets.size());
+    return m_children.data() + m_offsets[node_index];
 }
 
 // =================================================================================================
@@ -234,17 +374,37 @@ NodeType CommandHierarchy::GetNodeType(uint64_t node_index) const
 }
 
 //--------------------------------------------------------------------------------------------------
-const char* CommandHierarchy::GetNodeDesc(uint64_t node_index) const
+std::string CommandHierarchy::GetNodeDesc(uint64_t node_index) const
 {
-    DIVE_ASSERT(node_index < m_nodes.m_description.size());
-    return m_nodes.m_description[node_index].c_str();
+    DIVE_ASSERT(node_index < m_nodes.m_node_type.size());
+    uint64_t desc_index = m_nodes.GetDescIndex(node_index);
+    if (desc_index == UINT64_MAX)
+    {
+        return FormatLazyDesc(node_index);
+    }
+    return m_nodes.m_description[desc_index];
+}
+
+//--------------------------------------------------------------------------------------------------
+void CommandHierarchy::GetNodeDesc(uint64_t node_index, std::string& desc) const
+{
+    DIVE_ASSERT(node_index < m_nodes.m_node_type.size());
+    uint64_t desc_index = m_nodes.GetDescIndex(node_index);
+    if (desc_index == UINT64_MAX)
+    {
+        desc = FormatLazyDesc(node_index);
+        return;
+    }
+    desc.assign(m_nodes.m_description[desc_index]);
 }
 
 //--------------------------------------------------------------------------------------------------
 void CommandHierarchy::SetNodeDesc(uint64_t node_index, const std::string& desc)
 {
-    DIVE_ASSERT(node_index < m_nodes.m_description.size());
-    m_nodes.m_description[node_index] = desc;
+    DIVE_ASSERT(node_index < m_nodes.m_node_type.size());
+    uint64_t desc_index = m_nodes.GetDescIndex(node_index);
+    DIVE_ASSERT(desc_index != UINT64_MAX);
+    m_nodes.m_description[desc_index] = m_nodes.m_strings.Add(desc);
     return;
 }
 
@@ -364,6 +524,24 @@ uint8_t CommandHierarchy::GetPacketNodeIbLevel(uint64_t node_index) const
     const AuxInfo& info = m_nodes.m_aux_info[node_index];
     return info.packet_node.m_ib_level;
 }
+//--------------------------------------------------------------------------------------------------
+std::optional<uint64_t> CommandHierarchy::GetGfxrNodeBlockIndex(uint64_t node_index) const
+{
+    DIVE_ASSERT(node_index < m_nodes.m_aux_info.size());
+    NodeType type = m_nodes.m_node_type[node_index];
+    // The other nodes use the bits of the info for something else
+    if (type < NodeType::kGfxrVulkanSubmitNode || type > NodeType::kGfxrRootFrameNode)
+    {
+        return std::nullopt;
+    }
+    const AuxInfo& info = m_nodes.m_aux_info[node_index];
+    if (!info.gfxr_node.m_has_block_index)
+    {
+        return std::nullopt;
+    }
+    return info.gfxr_node.m_block_index;
+}
+
 //--------------------------------------------------------------------------------------------------
 bool CommandHierarchy::GetRegFieldNodeIsCe(uint64_t node_index) const
 {
@@ -383,15 +561,22 @@ bool CommandHierarchy::IsEventNodeIgnoredDuringCorrelation(uint64_t node_index)
 }
 
 //--------------------------------------------------------------------------------------------------
-uint64_t CommandHierarchy::AddNode(NodeType type, std::string&& desc, AuxInfo aux_info)
+uint64_t CommandHierarchy::AddNode(NodeType type, std::string_view desc, AuxInfo aux_info)
 {
-    return m_nodes.AddNode(type, std::move(desc), aux_info);
+    return m_nodes.AddNode(type, desc, aux_info);
 }
 
 //--------------------------------------------------------------------------------------------------
-uint64_t CommandHierarchy::AddGfxrNode(NodeType type, std::string&& desc)
+uint64_t CommandHierarchy::AddGfxrNode(NodeType type, std::string_view desc, AuxInfo aux_info)
 {
-    return m_nodes.AddGfxrNode(type, std::move(desc));
+    return m_nodes.AddGfxrNode(type, desc, aux_info);
+}
+
+//--------------------------------------------------------------------------------------------------
+uint64_t CommandHierarchy::AddLazyDesc(const LazyDesc& lazy_desc)
+{
+    m_nodes.m_lazy_desc.push_back(lazy_desc);
+    return m_nodes.m_lazy_desc.size() - 1;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -406,31 +591,169 @@ size_t CommandHierarchy::GetEventIndex(uint64_t node_index) const
     return it - indices.begin() + 1;
 }
 
+//--------------------------------------------------------------------------------------------------
+void CommandHierarchy::AppendChunk(const CommandHierarchyChunk& chunk,
+                                   ChunkAppendListener* listener)
+{
+    SharedNodeTopology& topology = m_topology[kAllEventTopology];
+    uint64_t prev_num_nodes = size();
+
+    // Append the new children of each node at once, in the order they were added
+    std::vector<CommandHierarchyChunk::Link> links = chunk.m_links;
+    std::stable_sort(links.begin(), links.end(),
+                     [](const CommandHierarchyChunk::Link& lhs,
+                        const CommandHierarchyChunk::Link& rhs) {
+                         return lhs.m_node_index < rhs.m_node_index;
+                     });
+    struct ChildrenRange
+    {
+        uint64_t m_node_index;
+        size_t m_first_link;
+        size_t m_end_link;
+        bool m_shown;
+    };
+    std::vector<ChildrenRange> ranges;
+    for (size_t i = 0; i < links.size();)
+    {
+        ChildrenRange range = {links[i].m_node_index, i, i, false};
+        for (; i < links.size() && links[i].m_node_index == range.m_node_index; ++i)
+            range.m_end_link = i + 1;
+        // Only the root and the nodes with a parent are shown. Nodes can get a parent in the same
+        // chunk as their own children, so this is checked before appending any of them
+        range.m_shown = listener != nullptr &&
+                        (range.m_node_index == Topology::kRootNodeIndex ||
+                         (range.m_node_index < prev_num_nodes &&
+                          topology.GetParentNodeIndex(range.m_node_index) != UINT64_MAX));
+        ranges.push_back(range);
+    }
+
+    m_nodes.AppendChunk(chunk);
+    uint64_t num_nodes = size();
+    topology.SetNumNodes(num_nodes);
+    // The chunks have no shared children, so all nodes point at the root node, which has none
+    topology.m_start_shared_child.resize(num_nodes, 0);
+    topology.m_end_shared_child.resize(num_nodes, 0);
+    topology.m_root_node_index.resize(num_nodes, 0);
+
+    std::vector<uint64_t> children;
+    auto append_children = [&](const ChildrenRange& range) {
+        children.clear();
+        for (size_t i = range.m_first_link; i < range.m_end_link; ++i)
+            children.push_back(links[i].m_child_node_index);
+        topology.AppendChildren(range.m_node_index, children.data(), children.size());
+    };
+    for (const ChildrenRange& range : ranges)
+    {
+        if (!range.m_shown) append_children(range);
+    }
+    for (const ChildrenRange& range : ranges)
+    {
+        if (!range.m_shown) continue;
+        listener->BeginAppendChildren(range.m_node_index,
+                                      topology.GetNumChildren(range.m_node_index),
+                                      range.m_end_link - range.m_first_link);
+        append_children(range);
+        listener->EndAppendChildren();
+    }
+}
+
 // =================================================================================================
 // CommandHierarchy::Nodes
 // =================================================================================================
-uint64_t CommandHierarchy::Nodes::AddNode(NodeType type, std::string&& desc, AuxInfo aux_info)
+uint64_t CommandHierarchy::Nodes::AddNode(NodeType type, std::string_view desc, AuxInfo aux_info)
 {
-    DIVE_ASSERT(m_node_type.size() == m_description.size());
-    DIVE_ASSERT(m_node_type.size() == m_aux_info.size());
+    PushNode(type, StoresDesc(type, aux_info) ? AddDesc(type, desc) : nullptr, aux_info);
+    return m_node_type.size() - 1;
+}
 
-    m_node_type.push_back(type);
-    m_description.push_back(std::move(desc));
-    m_aux_info.push_back(aux_info);
+//--------------------------------------------------------------------------------------------------
+void CommandHierarchy::Nodes::AppendChunk(const CommandHierarchyChunk& chunk)
+{
+    DIVE_ASSERT(chunk.m_first_node_index == m_node_type.size());
+    DIVE_ASSERT(chunk.m_first_lazy_desc_index == m_lazy_desc.size());
+    DIVE_ASSERT(chunk.m_node_type.size() == chunk.m_aux_info.size());
+
+    uint64_t desc_index = 0;
+    for (uint64_t i = 0; i < chunk.m_node_type.size(); ++i)
+    {
+        const char* desc = nullptr;
+        if (StoresDesc(chunk.m_node_type[i], chunk.m_aux_info[i]))
+        {
+            DIVE_ASSERT(desc_index < chunk.m_description.size());
+            desc = chunk.m_description[desc_index++];
+        }
+        PushNode(chunk.m_node_type[i], desc, chunk.m_aux_info[i]);
+    }
+    for (const LazyDesc& lazy_desc : chunk.m_lazy_desc)
+        m_lazy_desc.push_back(lazy_desc);
+    for (uint64_t node_index : chunk.m_event_node_indices)
+        m_event_node_indices.push_back(node_index);
+}
+
+//--------------------------------------------------------------------------------------------------
+const char* CommandHierarchy::Nodes::AddDesc(NodeType type, std::string_view desc)
+{
+    bool intern = (type == NodeType::kPacketNode || type == NodeType::kRegNode ||
+                   type == NodeType::kFieldNode);
+    return intern ? m_strings.Intern(desc) : m_strings.Add(desc);
+}
+
+//--------------------------------------------------------------------------------------------------
+uint64_t CommandHierarchy::Nodes::AddGfxrNode(NodeType type, std::string_view desc,
+                                               AuxInfo aux_info)
+{
+    PushNode(type, m_strings.Add(desc), aux_info);
     return m_node_type.size() - 1;
 }
 
 //--------------------------------------------------------------------------------------------------
-uint64_t CommandHierarchy::Nodes::AddGfxrNode(NodeType type, std::string&& desc)
+bool CommandHierarchy::Nodes::StoresDesc(NodeType type, AuxInfo aux_info)
+{
+    if (type != NodeType::kRegNode && type != NodeType::kFieldNode) return true;
+    return (LazyDescType)aux_info.reg_field_node.m_lazy_desc_type == LazyDescType::kNone;
+}
+
+//--------------------------------------------------------------------------------------------------
+uint64_t CommandHierarchy::Nodes::GetDescIndex(uint64_t node_index) const
 {
-    DIVE_ASSERT(m_node_type.size() == m_description.size());
+    DIVE_ASSERT(node_index / 64 < m_desc_groups.size());
+    const DescGroup& group = m_desc_groups[node_index / 64];
+    uint64_t node_bit = 1ull << (node_index % 64);
+    if ((group.m_stored_mask & node_bit) == 0) return UINT64_MAX;
+    return group.m_first_desc_index + std::popcount(group.m_stored_mask & (node_bit - 1));
+}
 
+//--------------------------------------------------------------------------------------------------
+void CommandHierarchy::Nodes::UpdateDescGroups()
+{
+    m_desc_groups.clear();
+    m_desc_groups.reserve((m_node_type.size() + 63) / 64);
+    uint64_t num_descs = 0;
+    for (uint64_t node_index = 0; node_index < m_node_type.size(); ++node_index)
+    {
+        if (node_index % 64 == 0) m_desc_groups.push_back(DescGroup{0, num_descs});
+        if (StoresDesc(m_node_type[node_index], m_aux_info[node_index]))
+        {
+            m_desc_groups.back().m_stored_mask |= 1ull << (node_index % 64);
+            ++num_descs;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void CommandHierarchy::Nodes::PushNode(NodeType type, const char* desc, AuxInfo aux_info)
+{
+    DIVE_ASSERT(m_node_type.size() == m_aux_info.size());
+
+    uint64_t node_index = m_node_type.size();
+    if (node_index % 64 == 0) m_desc_groups.push_back(DescGroup{0, m_description.size()});
+    if (desc != nullptr)
+    {
+        m_desc_groups.back().m_stored_mask |= 1ull << (node_index % 64);
+        m_description.push_back(desc);
+    }
     m_node_type.push_back(type);
-    m_description.push_back(std::move(desc));
-    // Adds a dummy AuxInfo object to ensure the m_node_type, m_description, and m_aux_info sizes
-    // stay the same.
-    m_aux_info.push_back(AuxInfo(0));
-    return m_node_type.size() - 1;
+    m_aux_info.push_back(aux_info);
 }
 
 // =================================================================================================
@@ -484,6 +807,21 @@ CommandHierarchy::AuxInfo CommandHierarchy::AuxInfo::RegFieldNode(bool is_ce_pac
     return info;
 }
 
+//--------------------------------------------------------------------------------------------------
+CommandHierarchy::AuxInfo CommandHierarchy::AuxInfo::LazyDescNode(LazyDescType type,
+                                                                  uint64_t lazy_desc_index,
+                                                                  uint32_t field)
+{
+    DIVE_ASSERT(lazy_desc_index == (lazy_desc_index & 0x0000FFFFFFFFFFFF));
+    DIVE_ASSERT(field < (1 << 13));
+    AuxInfo info(0);
+    info.reg_field_node.m_is_ce_packet = false;
+    info.reg_field_node.m_lazy_desc_type = (uint64_t)type;
+    info.reg_field_node.m_lazy_desc_field = field;
+    info.reg_field_node.m_lazy_desc_index = lazy_desc_index;
+    return info;
+}
+
 //--------------------------------------------------------------------------------------------------
 CommandHierarchy::AuxInfo CommandHierarchy::AuxInfo::EventNode(uint32_t event_id,
                                                                Util::EventType type,
@@ -505,6 +843,15 @@ CommandHierarchy::AuxInfo CommandHierarchy::AuxInfo::MarkerNode(MarkerType type,
     return info;
 }
 
+//--------------------------------------------------------------------------------------------------
+CommandHierarchy::AuxInfo CommandHierarchy::AuxInfo::GfxrNode(uint64_t block_index)
+{
+    AuxInfo info(0);
+    info.gfxr_node.m_block_index = block_index;
+    info.gfxr_node.m_has_block_index = 1;
+    return info;
+}
+
 // =================================================================================================
 // CommandHierarchyCreator
 // =================================================================================================
@@ -542,11 +889,11 @@ bool CommandHierarchyCreator::CreateTrees(bool flatten_chain_nodes,
             m_node_end_shared_children[topology].reserve(*reserve_size);
             m_node_root_node_indices[topology].reserve(*reserve_size);
 
-            m_node_children[topology][kSingleParentNodeChildren].reserve(*reserve_size);
-            m_node_children[topology][kSharedNodeChildren].reserve(*reserve_size);
+            m_node_children[topology][kSingleParentNodeChildren].Reserve(*reserve_size);
+            m_node_children[topology][kSharedNodeChildren].Reserve(*reserve_size);
 
             m_command_hierarchy.m_nodes.m_node_type.reserve(*reserve_size);
-            m_command_hierarchy.m_nodes.m_description.reserve(*reserve_size);
+            m_command_hierarchy.m_nodes.m_desc_groups.reserve(*reserve_size / 64 + 1);
             m_command_hierarchy.m_nodes.m_aux_info.reserve(*reserve_size);
             m_command_hierarchy.m_nodes.m_event_node_indices.reserve(*reserve_size);
         }
@@ -590,11 +937,11 @@ bool CommandHierarchyCreator::CreateTrees(const Pm4CaptureData& capture_data,
             m_node_end_shared_children[topology].reserve(*reserve_size);
             m_node_root_node_indices[topology].reserve(*reserve_size);
 
-            m_node_children[topology][kSingleParentNodeChildren].reserve(*reserve_size);
-            m_node_children[topology][kSharedNodeChildren].reserve(*reserve_size);
+            m_node_children[topology][kSingleParentNodeChildren].Reserve(*reserve_size);
+            m_node_children[topology][kSharedNodeChildren].Reserve(*reserve_size);
 
             m_command_hierarchy.m_nodes.m_node_type.reserve(*reserve_size);
-            m_command_hierarchy.m_nodes.m_description.reserve(*reserve_size);
+            m_command_hierarchy.m_nodes.m_desc_groups.reserve(*reserve_size / 64 + 1);
             m_command_hierarchy.m_nodes.m_aux_info.reserve(*reserve_size);
             m_command_hierarchy.m_nodes.m_event_node_indices.reserve(*reserve_size);
         }
@@ -637,11 +984,11 @@ bool CommandHierarchyCreator::CreateTrees(bool flatten_chain_nodes, bool createT
             m_node_end_shared_children[topology].reserve(*reserve_size);
             m_node_root_node_indices[topology].reserve(*reserve_size);
 
-            m_node_children[topology][kSingleParentNodeChildren].reserve(*reserve_size);
-            m_node_children[topology][kSharedNodeChildren].reserve(*reserve_size);
+            m_node_children[topology][kSingleParentNodeChildren].Reserve(*reserve_size);
+            m_node_children[topology][kSharedNodeChildren].Reserve(*reserve_size);
 
             m_command_hierarchy.m_nodes.m_node_type.reserve(*reserve_size);
-            m_command_hierarchy.m_nodes.m_description.reserve(*reserve_size);
+            m_command_hierarchy.m_nodes.m_desc_groups.reserve(*reserve_size / 64 + 1);
             m_command_hierarchy.m_nodes.m_aux_info.reserve(*reserve_size);
             m_command_hierarchy.m_nodes.m_event_node_indices.reserve(*reserve_size);
         }
@@ -683,6 +1030,12 @@ bool CommandHierarchyCreator::CreateTrees(EngineType engine_type, QueueType queu
             memcpy(buffer_ptr, &command_bytes[va_addr], size);
             return true;
         }
+        virtual const void* GetMemoryPointer(uint32_t submit_index, uint64_t va_addr,
+                                             uint64_t size) const
+        {
+            if ((va_addr + size) > (m_size_in_dwords * sizeof(uint32_t))) return nullptr;
+            return (const uint8_t*)m_command_dwords.data() + va_addr;
+        }
         virtual bool GetMemoryOfUnknownSizeViaCallback(uint32_t submit_index, uint64_t va_addr,
                                                        PfnGetMemory data_callback,
                                                        void* user_ptr) const
@@ -923,15 +1276,19 @@ bool CommandHierarchyCreator::OnIbEnd(uint32_t submit_index, uint32_t ib_index,
 
 //--------------------------------------------------------------------------------------------------
 bool CommandHierarchyCreator::OnPacket(const IMemoryManager& mem_manager, uint32_t submit_index,
-                                       uint32_t ib_index, uint64_t va_addr, Pm4Header header)
+                                       uint32_t ib_index, uint64_t va_addr, const Pm4Packet& packet)
 {
-    if (!EmulateCallbacksBase::OnPacket(mem_manager, submit_index, ib_index, va_addr, header))
+    if (!EmulateCallbacksBase::OnPacket(mem_manager, submit_index, ib_index, va_addr, packet))
         return false;
+    Pm4Header header = packet.GetHeader();
+
     // THIS IS TEMPORARY! Only deal with typ4 & type7 packets for now
     if ((header.type != 4) && (header.type != 7)) return true;
 
     // Create the packet node and add it as child to the current submit_node and ib_node
-    uint64_t packet_node_index = AddPacketNode(mem_manager, submit_index, va_addr, false, header);
+    uint64_t first_link =
+        m_node_children[CommandHierarchy::kSubmitTopology][kSingleParentNodeChildren].GetNumLinks();
+    uint64_t packet_node_index = AddPacketNode(va_addr, false, packet);
 
     if (m_new_event_start)
     {
@@ -957,7 +1314,7 @@ bool CommandHierarchyCreator::OnPacket(const IMemoryManager& mem_manager, uint32
 
     // Cache set_draw_state packet
     if (opcode == CP_SET_DRAW_STATE)
-        CacheSetDrawStateGroupInfo(mem_manager, submit_index, va_addr, packet_node_index, header);
+        CacheSetDrawStateGroupInfo(packet, packet_node_index, first_link);
 
     if (Util::IsEvent(mem_manager, submit_index, va_addr, opcode, m_state_tracker))
     {
@@ -984,7 +1341,7 @@ bool CommandHierarchyCreator::OnPacket(const IMemoryManager& mem_manager, uint32
 
             CommandHierarchy::AuxInfo aux_info = CommandHierarchy::AuxInfo::EventNode(
                 event_id, type, should_ignore_during_correlation);
-            uint64_t node_index = AddNode(NodeType::kEventNode, std::move(event_string), aux_info);
+            uint64_t node_index = AddNode(NodeType::kEventNode, event_string, aux_info);
             AppendEventNodeIndex(node_index);
             event_node_index = node_index;
         }
@@ -1017,11 +1374,12 @@ bool CommandHierarchyCreator::OnPacket(const IMemoryManager& mem_manager, uint32
     else if (opcode == CP_LOAD_STATE6 || opcode == CP_LOAD_STATE6_GEOM ||
              opcode == CP_LOAD_STATE6_FRAG)
     {
-        AppendLoadStateExtBufferNode(mem_manager, submit_index, va_addr, packet_node_index);
+        AppendLoadStateExtBufferNode(mem_manager, submit_index, va_addr, packet,
+                                     packet_node_index);
     }
     else if (opcode == CP_MEM_TO_REG)
     {
-        AppendMemRegNodes(mem_manager, submit_index, va_addr, packet_node_index);
+        AppendMemRegNodes(mem_manager, submit_index, packet, packet_node_index);
     }
     else if (opcode == CP_START_BIN)
     {
@@ -1035,13 +1393,12 @@ bool CommandHierarchyCreator::OnPacket(const IMemoryManager& mem_manager, uint32
     {
         m_draw_table_node_index = packet_node_index;
     }
-    else if (opcode == CP_SET_MARKER)
+    else if (opcode == CP_SET_MARKER && packet.As<PM4_CP_SET_MARKER>() != nullptr)
     {
-        PM4_CP_SET_MARKER packet{};
-        DIVE_VERIFY(mem_manager.RetrieveMemoryData(&packet, submit_index, va_addr, sizeof(packet)));
+        const PM4_CP_SET_MARKER& marker_packet = *packet.As<PM4_CP_SET_MARKER>();
         // as mentioned in adreno_pm4.xml, only b0-b3 are considered when b8 is not set
-        DIVE_ASSERT((packet.u32All0 & 0x100) == 0);
-        a6xx_marker marker = static_cast<a6xx_marker>(packet.u32All0 & 0xf);
+        DIVE_ASSERT((marker_packet.u32All0 & 0x100) == 0);
+        a6xx_marker marker = static_cast<a6xx_marker>(marker_packet.u32All0 & 0xf);
 
         std::string desc;
         bool add_child = true;
@@ -1112,7 +1469,7 @@ bool CommandHierarchyCreator::OnPacket(const IMemoryManager& mem_manager, uint32
                 m_start_node_stack[CommandHierarchy::kAllEventTopology].pop_back();
             }
 
-            m_render_marker_index = AddNode(NodeType::kRenderMarkerNode, std::move(desc), 0);
+            m_render_marker_index = AddNode(NodeType::kRenderMarkerNode, desc, 0);
 
             if (marker == RM6_BIN_VISIBILITY)
             {
@@ -1208,18 +1565,6 @@ void CommandHierarchyCreator::OnSubmitStart(uint32_t submit_index, const SubmitI
 //--------------------------------------------------------------------------------------------------
 void CommandHierarchyCreator::OnSubmitEnd(uint32_t submit_index, const SubmitInfo& submit_info)
 {
-    // For the submit topology, the IBs are inserted in emulation order, and are not necessarily in
-    // ib-index order. Sort them here so they appear in order of ib-index.
-    DiveVector<uint64_t>& submit_children =
-        m_node_children[CommandHierarchy::kSubmitTopology][kSingleParentNodeChildren]
-                       [m_cur_submit_node_index];
-    std::sort(submit_children.begin(), submit_children.end(),
-              [&](uint64_t lhs, uint64_t rhs) -> bool {
-                  uint8_t lhs_index = m_command_hierarchy.GetIbNodeIndex(lhs);
-                  uint8_t rhs_index = m_command_hierarchy.GetIbNodeIndex(rhs);
-                  return lhs_index < rhs_index;
-              });
-
     // Insert present node to event topology, when appropriate
     for (uint32_t i = 0; i < m_capture_data.GetNumPresents(); ++i)
     {
@@ -1254,13 +1599,20 @@ void CommandHierarchyCreator::OnSubmitEnd(uint32_t submit_index, const SubmitInf
         uint64_t present_node_index = AddNode(NodeType::kPresentNode, present_string_stream.str());
         AddChild(CommandHierarchy::kAllEventTopology, Topology::kRootNodeIndex, present_node_index);
     }
+
+    if (m_hierarchy_chunk_callback &&
+        std::chrono::steady_clock::now() >= m_next_hierarchy_chunk_time)
+    {
+        m_hierarchy_chunk_callback(CreateHierarchyChunk());
+        m_next_hierarchy_chunk_time = std::chrono::steady_clock::now() + m_hierarchy_chunk_interval;
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
-uint64_t CommandHierarchyCreator::AddPacketNode(const IMemoryManager& mem_manager,
-                                                uint32_t submit_index, uint64_t va_addr,
-                                                bool is_ce_packet, Pm4Header header)
+uint64_t CommandHierarchyCreator::AddPacketNode(uint64_t va_addr, bool is_ce_packet,
+                                                const Pm4Packet& packet)
 {
+    Pm4Header header = packet.GetHeader();
     if (header.type == 7)
     {
         std::ostringstream packet_string_stream;
@@ -1275,9 +1627,8 @@ uint64_t CommandHierarchyCreator::AddPacketNode(const IMemoryManager& mem_manage
 
         if (header.type7.opcode == CP_CONTEXT_REG_BUNCH)
         {
-            AppendRegNodes(mem_manager, submit_index,
-                           va_addr + sizeof(Pm4Type7Header),  // skip the type7 PM4
-                           header.type7.count, packet_node_index);
+            AppendRegNodes(packet.GetPayload(), packet.GetPayloadSizeInDwords(),
+                           packet_node_index);
         }
         else
         {
@@ -1289,10 +1640,8 @@ uint64_t CommandHierarchyCreator::AddPacketNode(const IMemoryManager& mem_manage
 
             const PacketInfo* packet_info_ptr = GetPacketInfo(header.type7.opcode);
             DIVE_ASSERT(packet_info_ptr != nullptr);
-            AppendPacketFieldNodes(mem_manager, submit_index,
-                                   va_addr + sizeof(Pm4Type7Header),  // skip the type7 PM4
-                                   header.type7.count, append_extra_dwords, packet_info_ptr,
-                                   packet_node_index);
+            AppendPacketFieldNodes(packet.GetPayload(), packet.GetPayloadSizeInDwords(),
+                                   append_extra_dwords, packet_info_ptr, packet_node_index);
         }
         return packet_node_index;
     }
@@ -1308,7 +1657,7 @@ uint64_t CommandHierarchyCreator::AddPacketNode(const IMemoryManager& mem_manage
         uint64_t packet_node_index =
             AddNode(NodeType::kPacketNode, packet_string_stream.str(), aux_info);
 
-        AppendRegNodes(mem_manager, submit_index, va_addr, header, packet_node_index);
+        AppendRegNodes(packet, packet_node_index);
         return packet_node_index;
     }
     return UINT32_MAX;  // This is temporary. Shouldn't happen once we properly add the packet node!
@@ -1385,55 +1734,128 @@ void OutputValue(std::ostringstream& string_stream, ValueType type, uint64_t val
 }
 
 //--------------------------------------------------------------------------------------------------
-uint64_t CommandHierarchyCreator::AddRegisterNode(uint32_t reg, uint64_t reg_value,
-                                                  const RegInfo* reg_info_ptr)
+void OutputRegister(std::ostringstream& string_stream, const RegInfo& reg_info, uint64_t reg_value)
 {
-    // Should never have an "unknown register" unless something is seriously wrong!
-    DIVE_ASSERT(reg_info_ptr != nullptr);
-    reg_value = reg_value << reg_info_ptr->m_shr;
-    // Reg item
-    std::ostringstream reg_string_stream;
-    if (reg_info_ptr->m_enum_handle != UINT8_MAX)
+    reg_value = reg_value << reg_info.m_shr;
+    if (reg_info.m_enum_handle != UINT8_MAX)
     {
-        const char* enum_str = GetEnumString(reg_info_ptr->m_enum_handle, (uint32_t)reg_value);
+        const char* enum_str = GetEnumString(reg_info.m_enum_handle, (uint32_t)reg_value);
         DIVE_ASSERT(enum_str != nullptr);
-        reg_string_stream << reg_info_ptr->m_name << ": " << enum_str;
+        string_stream << reg_info.m_name << ": " << enum_str;
     }
     else
     {
-        reg_string_stream << reg_info_ptr->m_name << ": ";
-        OutputValue(reg_string_stream, (ValueType)reg_info_ptr->m_type, reg_value,
-                    reg_info_ptr->m_bit_width, reg_info_ptr->m_radix);
+        string_stream << reg_info.m_name << ": ";
+        OutputValue(string_stream, (ValueType)reg_info.m_type, reg_value, reg_info.m_bit_width,
+                    reg_info.m_radix);
     }
+}
 
-    CommandHierarchy::AuxInfo aux_info = CommandHierarchy::AuxInfo::RegFieldNode(false);
-    uint64_t reg_node_index = AddNode(NodeType::kRegNode, reg_string_stream.str(), aux_info);
+//--------------------------------------------------------------------------------------------------
+void OutputRegisterField(std::ostringstream& string_stream, const RegInfo& reg_info,
+                         const RegField& reg_field, uint64_t reg_value)
+{
+    reg_value = reg_value << reg_info.m_shr;
+    uint64_t field_value = ((reg_value & reg_field.m_mask) >> reg_field.m_shift)
+                           << reg_field.m_shr;
 
-    // Go through each field of this register, create a FieldNode out of it and append as child
-    // to reg_node_ptr
-    for (uint32_t field = 0; field < reg_info_ptr->m_fields.size(); ++field)
+    string_stream << reg_field.m_name << ": ";
+    if (reg_field.m_enum_handle != UINT8_MAX)
     {
-        const RegField& reg_field = reg_info_ptr->m_fields[field];
-        uint64_t field_value = ((reg_value & reg_field.m_mask) >> reg_field.m_shift)
-                               << reg_field.m_shr;
+        const char* enum_str = GetEnumString(reg_field.m_enum_handle, (uint32_t)field_value);
+        if (enum_str != nullptr)
+            string_stream << enum_str;
+        else
+            OutputValue(string_stream, (ValueType)reg_field.m_type, field_value);
+    }
+    else
+        OutputValue(string_stream, (ValueType)reg_field.m_type, field_value,
+                    reg_field.m_bit_width, reg_field.m_radix);
+}
 
-        // Field item
-        std::ostringstream field_string_stream;
-        field_string_stream << reg_field.m_name << ": ";
-        if (reg_field.m_enum_handle != UINT8_MAX)
-        {
-            const char* enum_str = GetEnumString(reg_field.m_enum_handle, (uint32_t)field_value);
-            if (enum_str != nullptr)
-                field_string_stream << enum_str;
-            else
-                OutputValue(field_string_stream, (ValueType)reg_field.m_type, field_value);
-        }
+//--------------------------------------------------------------------------------------------------
+void OutputPacketField(std::ostringstream& string_stream, const PacketField& packet_field,
+                       uint32_t dword_value)
+{
+    uint32_t field_value = ((dword_value & packet_field.m_mask) >> packet_field.m_shift)
+                           << packet_field.m_shr;
+
+    string_stream << packet_field.m_name << ": ";
+    if (packet_field.m_enum_handle != UINT8_MAX)
+    {
+        const char* enum_str = GetEnumString(packet_field.m_enum_handle, field_value);
+        if (enum_str != nullptr)
+            string_stream << enum_str;
         else
-            OutputValue(field_string_stream, (ValueType)reg_field.m_type, field_value,
-                        reg_field.m_bit_width, reg_field.m_radix);
+            OutputValue(string_stream, (ValueType)packet_field.m_type, field_value);
+    }
+    else
+        OutputValue(string_stream, (ValueType)packet_field.m_type, field_value);
+}
+
+//--------------------------------------------------------------------------------------------------
+std::string CommandHierarchy::FormatLazyDesc(uint64_t node_index) const
+{
+    const AuxInfo& info = m_nodes.m_aux_info[node_index];
+    DIVE_ASSERT(info.reg_field_node.m_lazy_desc_index < m_nodes.m_lazy_desc.size());
+    const LazyDesc& lazy_desc = m_nodes.m_lazy_desc[info.reg_field_node.m_lazy_desc_index];
+    uint32_t field = info.reg_field_node.m_lazy_desc_field;
+
+    std::ostringstream string_stream;
+    LazyDescType type = (LazyDescType)info.reg_field_node.m_lazy_desc_type;
+    if (type == LazyDescType::kPacketField)
+    {
+        DIVE_ASSERT(field < lazy_desc.m_packet_info->m_fields.size());
+        OutputPacketField(string_stream, lazy_desc.m_packet_info->m_fields[field],
+                          (uint32_t)lazy_desc.m_value);
+        return string_stream.str();
+    }
+
+    const RegInfo* reg_info_ptr = GetRegInfo(lazy_desc.m_reg_offset);
+    RegInfo temp = {};
+    temp.m_name = "Unknown";
+    temp.m_enum_handle = UINT8_MAX;
+    if (reg_info_ptr == nullptr) reg_info_ptr = &temp;
+
+    if (type == LazyDescType::kRegister)
+    {
+        OutputRegister(string_stream, *reg_info_ptr, lazy_desc.m_value);
+    }
+    else
+    {
+        DIVE_ASSERT(type == LazyDescType::kRegisterField);
+        DIVE_ASSERT(field < reg_info_ptr->m_fields.size());
+        OutputRegisterField(string_stream, *reg_info_ptr, reg_info_ptr->m_fields[field],
+                            lazy_desc.m_value);
+    }
+    return string_stream.str();
+}
+
+//--------------------------------------------------------------------------------------------------
+uint64_t CommandHierarchyCreator::AddRegisterNode(uint32_t reg, uint64_t reg_value,
+                                                  const RegInfo* reg_info_ptr)
+{
+    // Should never have an "unknown register" unless something is seriously wrong!
+    DIVE_ASSERT(reg_info_ptr != nullptr);
+
+    // The descriptions of the register and its fields are formatted on demand from the value
+    CommandHierarchy::LazyDesc lazy_desc{};
+    lazy_desc.m_reg_offset = reg;
+    lazy_desc.m_value = reg_value;
+    uint64_t lazy_desc_index = m_command_hierarchy.AddLazyDesc(lazy_desc);
 
-        uint64_t field_node_index =
-            AddNode(NodeType::kFieldNode, field_string_stream.str(), aux_info);
+    CommandHierarchy::AuxInfo aux_info =
+        CommandHierarchy::AuxInfo::LazyDescNode(CommandHierarchy::LazyDescType::kRegister,
+                                                lazy_desc_index);
+    uint64_t reg_node_index = AddNode(NodeType::kRegNode, std::string(), aux_info);
+
+    // Go through each field of this register, create a FieldNode out of it and append as child
+    // to reg_node_ptr
+    for (uint32_t field = 0; field < reg_info_ptr->m_fields.size(); ++field)
+    {
+        CommandHierarchy::AuxInfo field_aux_info = CommandHierarchy::AuxInfo::LazyDescNode(
+            CommandHierarchy::LazyDescType::kRegisterField, lazy_desc_index, field);
+        uint64_t field_node_index = AddNode(NodeType::kFieldNode, std::string(), field_aux_info);
 
         // Add it as child to reg_node
         AddChild(CommandHierarchy::kSubmitTopology, reg_node_index, field_node_index);
@@ -1466,53 +1888,39 @@ bool CommandHierarchyCreator::IsBeginDebugMarkerNode(uint64_t node_index)
 }
 
 //--------------------------------------------------------------------------------------------------
-void CommandHierarchyCreator::AppendRegNodes(const IMemoryManager& mem_manager,
-                                             uint32_t submit_index, uint64_t va_addr,
-                                             uint32_t dword_count, uint64_t packet_node_index)
+void CommandHierarchyCreator::AppendRegNodes(const uint32_t* dwords, uint32_t dword_count,
+                                             uint64_t packet_node_index)
 {
     // This version of AppendRegNodes takes in a raw buffer consisting of register offset + value
     // pairs
     uint32_t dword = 0;
-    while (dword < dword_count)
+    while (dword + 2 <= dword_count)
     {
-        struct RegPair
-        {
-            uint32_t m_reg_offset;
-            uint32_t m_reg_value;
-        };
-        RegPair reg_pair{};
-        uint64_t pair_addr = va_addr + dword * sizeof(uint32_t);
-        DIVE_VERIFY(
-            mem_manager.RetrieveMemoryData(&reg_pair, submit_index, pair_addr, sizeof(reg_pair)));
+        uint32_t reg_offset = dwords[dword];
+        uint64_t reg_value = dwords[dword + 1];
         dword += 2;
 
-        const RegInfo* reg_info_ptr = GetRegInfo(reg_pair.m_reg_offset);
+        const RegInfo* reg_info_ptr = GetRegInfo(reg_offset);
 
         RegInfo temp = {};
         temp.m_name = "Unknown";
         temp.m_enum_handle = UINT8_MAX;
         if (reg_info_ptr == nullptr) reg_info_ptr = &temp;
 
-        uint64_t reg_value = reg_pair.m_reg_value;
-        if (reg_info_ptr->m_is_64_bit)
+        if (reg_info_ptr->m_is_64_bit && dword + 2 <= dword_count)
         {
-            RegPair new_reg_pair{};
-            uint64_t new_pair_addr = va_addr + dword * sizeof(uint32_t);
-            DIVE_VERIFY(mem_manager.RetrieveMemoryData(&new_reg_pair, submit_index, new_pair_addr,
-                                                       sizeof(new_reg_pair)));
-
             // Sometimes the upper 32-bits are not set
             // Probably because they're 0s and there's no need to set it
-            if (new_reg_pair.m_reg_offset == reg_pair.m_reg_offset + 1)
+            if (dwords[dword] == reg_offset + 1)
             {
+                reg_value |= ((uint64_t)dwords[dword + 1]) << 32;
                 dword += 2;
-                reg_value |= ((uint64_t)new_reg_pair.m_reg_value) << 32;
             }
         }
 
         // Create the register node, as well as all its children nodes that describe the various
         // fields set in the single 32-bit register
-        uint64_t reg_node_index = AddRegisterNode(reg_pair.m_reg_offset, reg_value, reg_info_ptr);
+        uint64_t reg_node_index = AddRegisterNode(reg_offset, reg_value, reg_info_ptr);
 
         // Add it as child to packet node
         AddChild(CommandHierarchy::kSubmitTopology, packet_node_index, reg_node_index);
@@ -1521,19 +1929,17 @@ void CommandHierarchyCreator::AppendRegNodes(const IMemoryManager& mem_manager,
 }
 
 //--------------------------------------------------------------------------------------------------
-void CommandHierarchyCreator::AppendRegNodes(const IMemoryManager& mem_manager,
-                                             uint32_t submit_index, uint64_t va_addr,
-                                             Pm4Header header, uint64_t packet_node_index)
+void CommandHierarchyCreator::AppendRegNodes(const Pm4Packet& packet, uint64_t packet_node_index)
 {
     // This version of AppendRegNodes takes in an offset from the header, and expects a contiguous
     // sequence of register values
+    Pm4Header header = packet.GetHeader();
+    const uint32_t* payload = packet.GetPayload();
 
     // Go through each register set by this packet
-    uint32_t offset_in_bytes = 0;
     uint32_t dword = 0;
     while (dword < header.type4.count)
     {
-        uint64_t reg_va_addr = va_addr + sizeof(header) + offset_in_bytes;
         uint32_t reg_offset = header.type4.offset + dword;
         const RegInfo* reg_info_ptr = GetRegInfo(reg_offset);
 
@@ -1542,13 +1948,11 @@ void CommandHierarchyCreator::AppendRegNodes(const IMemoryManager& mem_manager,
         temp.m_enum_handle = UINT8_MAX;
         if (reg_info_ptr == nullptr) reg_info_ptr = &temp;
 
-        uint32_t size_to_read = sizeof(uint32_t);
-        if (reg_info_ptr->m_is_64_bit) size_to_read = sizeof(uint64_t);
-        offset_in_bytes += size_to_read;
+        // The packet may end after the lower 32-bits of a 64-bit register
+        uint64_t reg_value = payload[dword];
+        if (reg_info_ptr->m_is_64_bit && dword + 1 < header.type4.count)
+            reg_value |= ((uint64_t)payload[dword + 1]) << 32;
 
-        uint64_t reg_value = 0;
-        DIVE_VERIFY(
-            mem_manager.RetrieveMemoryData(&reg_value, submit_index, reg_va_addr, size_to_read));
         // Create the register node, as well as all its children nodes that describe the various
         // fields set in the single 32-bit register
         uint64_t reg_node_index = AddRegisterNode(reg_offset, reg_value, reg_info_ptr);
@@ -1610,9 +2014,8 @@ void CommandHierarchyCreator::AppendEventWriteFieldNodes(const IMemoryManager& m
 }
 
 //--------------------------------------------------------------------------------------------------
-void CommandHierarchyCreator::AppendPacketFieldNodes(const IMemoryManager& mem_manager,
-                                                     uint32_t submit_index, uint64_t va_addr,
-                                                     uint32_t dword_count, bool append_extra_dwords,
+void CommandHierarchyCreator::AppendPacketFieldNodes(const uint32_t* dwords, uint32_t dword_count,
+                                                     bool append_extra_dwords,
                                                      const PacketInfo* packet_info_ptr,
                                                      uint64_t packet_node_index, const char* prefix)
 {
@@ -1659,33 +2062,32 @@ void CommandHierarchyCreator::AppendPacketFieldNodes(const IMemoryManager& mem_m
                 break;
             }
 
-            uint32_t dword_value = 0;
             // (field_dword - 1) since each field is always 1 32bit register, we don't have any
             // 64bit field
-            uint64_t dword_va_addr = va_addr + (field_dword - 1) * sizeof(uint32_t);
-            DIVE_VERIFY(mem_manager.RetrieveMemoryData(&dword_value, submit_index, dword_va_addr,
-                                                       sizeof(uint32_t)));
-
-            uint32_t field_value = ((dword_value & packet_field.m_mask) >> packet_field.m_shift)
-                                   << packet_field.m_shr;
+            uint32_t dword_value = dwords[field_dword - 1];
 
-            // Field item
-            std::ostringstream field_string_stream;
-            field_string_stream << prefix << packet_field.m_name << ": ";
-            if (packet_field.m_enum_handle != UINT8_MAX)
+            uint64_t field_node_index = UINT64_MAX;
+            if (prefix[0] == '\0')
             {
-                const char* enum_str = GetEnumString(packet_field.m_enum_handle, field_value);
-                if (enum_str != nullptr)
-                    field_string_stream << enum_str;
-                else
-                    OutputValue(field_string_stream, (ValueType)packet_field.m_type, field_value);
+                // The description is formatted on demand from the dword
+                CommandHierarchy::LazyDesc lazy_desc{};
+                lazy_desc.m_packet_info = packet_info_ptr;
+                lazy_desc.m_value = dword_value;
+                CommandHierarchy::AuxInfo aux_info = CommandHierarchy::AuxInfo::LazyDescNode(
+                    CommandHierarchy::LazyDescType::kPacketField,
+                    m_command_hierarchy.AddLazyDesc(lazy_desc), (uint32_t)field);
+                field_node_index = AddNode(NodeType::kFieldNode, std::string(), aux_info);
             }
             else
-                OutputValue(field_string_stream, (ValueType)packet_field.m_type, field_value);
+            {
+                std::ostringstream field_string_stream;
+                field_string_stream << prefix;
+                OutputPacketField(field_string_stream, packet_field, dword_value);
 
-            CommandHierarchy::AuxInfo aux_info = CommandHierarchy::AuxInfo::RegFieldNode(false);
-            uint64_t field_node_index =
-                AddNode(NodeType::kFieldNode, field_string_stream.str(), aux_info);
+                CommandHierarchy::AuxInfo aux_info = CommandHierarchy::AuxInfo::RegFieldNode(false);
+                field_node_index =
+                    AddNode(NodeType::kFieldNode, field_string_stream.str(), aux_info);
+            }
 
             // Add it as child to packet_node
             AddChild(CommandHierarchy::kSubmitTopology, parent_node_index, field_node_index);
@@ -1701,12 +2103,10 @@ void CommandHierarchyCreator::AppendPacketFieldNodes(const IMemoryManager& mem_m
     {
         if (end_dword < dword_count)
         {
+            // Like packet_field.m_dword, DWORD i is the i-th dword, counting from 1
             for (size_t i = end_dword + 1; i <= dword_count; i++)
             {
-                uint32_t dword_value = 0;
-                uint64_t dword_va_addr = va_addr + i * sizeof(uint32_t);
-                DIVE_VERIFY(mem_manager.RetrieveMemoryData(&dword_value, submit_index,
-                                                           dword_va_addr, sizeof(uint32_t)));
+                uint32_t dword_value = dwords[i - 1];
 
                 std::ostringstream field_string_stream;
                 field_string_stream << prefix << "(DWORD " << i << "): 0x" << std::hex
@@ -1727,10 +2127,12 @@ void CommandHierarchyCreator::AppendPacketFieldNodes(const IMemoryManager& mem_m
 //--------------------------------------------------------------------------------------------------
 void CommandHierarchyCreator::AppendLoadStateExtBufferNode(const IMemoryManager& mem_manager,
                                                            uint32_t submit_index, uint64_t va_addr,
+                                                           const Pm4Packet& pm4_packet,
                                                            uint64_t packet_node_index)
 {
-    PM4_CP_LOAD_STATE6 packet{};
-    DIVE_VERIFY(mem_manager.RetrieveMemoryData(&packet, submit_index, va_addr, sizeof(packet)));
+    const PM4_CP_LOAD_STATE6* packet_ptr = pm4_packet.As<PM4_CP_LOAD_STATE6>();
+    if (packet_ptr == nullptr) return;
+    const PM4_CP_LOAD_STATE6& packet = *packet_ptr;
 
     enum class StateBlockCat
     {
@@ -1803,15 +2205,21 @@ void CommandHierarchyCreator::AppendLoadStateExtBufferNode(const IMemoryManager&
     }
 
     auto AppendSharps = [&](const char* sharp_struct_name, uint32_t sharp_struct_size) {
+        // The sharps are not part of the packet, so each one is copied out of memory
+        uint32_t sharp_dword_count = sharp_struct_size / sizeof(uint32_t);
+        DiveVector<uint32_t> sharp_dwords;
         for (uint32_t i = 0; i < packet.bitfields0.NUM_UNIT; ++i)
         {
             uint64_t addr = ext_src_addr + i * sharp_struct_size;
+            sharp_dwords.clear();
+            sharp_dwords.resize(sharp_dword_count, 0);
+            DIVE_VERIFY(mem_manager.RetrieveMemoryData(sharp_dwords.data(), submit_index, addr,
+                                                       sharp_struct_size));
             const PacketInfo* packet_info_ptr = GetPacketInfo(0, sharp_struct_name);
             DIVE_ASSERT(packet_info_ptr != nullptr);
             std::ostringstream prefix_stream;
             prefix_stream << "  [" << i << "] ";
-            AppendPacketFieldNodes(mem_manager, submit_index, addr,
-                                   sharp_struct_size / sizeof(uint32_t), false, packet_info_ptr,
+            AppendPacketFieldNodes(sharp_dwords.data(), sharp_dword_count, false, packet_info_ptr,
                                    packet_node_index, prefix_stream.str().c_str());
         }
     };
@@ -1874,11 +2282,12 @@ void CommandHierarchyCreator::AppendLoadStateExtBufferNode(const IMemoryManager&
 
 //--------------------------------------------------------------------------------------------------
 void CommandHierarchyCreator::AppendMemRegNodes(const IMemoryManager& mem_manager,
-                                                uint32_t submit_index, uint64_t va_addr,
+                                                uint32_t submit_index, const Pm4Packet& pm4_packet,
                                                 uint64_t packet_node_index)
 {
-    PM4_CP_MEM_TO_REG packet{};
-    DIVE_VERIFY(mem_manager.RetrieveMemoryData(&packet, submit_index, va_addr, sizeof(packet)));
+    const PM4_CP_MEM_TO_REG* packet_ptr = pm4_packet.As<PM4_CP_MEM_TO_REG>();
+    if (packet_ptr == nullptr) return;
+    const PM4_CP_MEM_TO_REG& packet = *packet_ptr;
 
     // Add base register name
     const RegInfo* reg_info_ptr = GetRegInfo(packet.bitfields0.REG);
@@ -1899,25 +2308,24 @@ void CommandHierarchyCreator::AppendMemRegNodes(const IMemoryManager& mem_manage
 }
 
 //--------------------------------------------------------------------------------------------------
-void CommandHierarchyCreator::CacheSetDrawStateGroupInfo(const IMemoryManager& mem_manager,
-                                                         uint32_t submit_index, uint64_t va_addr,
+void CommandHierarchyCreator::CacheSetDrawStateGroupInfo(const Pm4Packet& packet,
                                                          uint64_t set_draw_state_node_index,
-                                                         Pm4Header header)
+                                                         uint64_t first_link)
 {
     // Find all the children of the set_draw_state packet, which should contain array indices
-    // Using any of the topologies where field nodes are added will work
-    uint64_t index = set_draw_state_node_index;
-    DiveVector<uint64_t>& children =
-        m_node_children[CommandHierarchy::kSubmitTopology][kSingleParentNodeChildren][index];
+    // Using any of the topologies where field nodes are added will work. These were all added
+    // after first_link, which was taken before the packet node was created
+    DiveVector<uint64_t> children;
+    m_node_children[CommandHierarchy::kSubmitTopology][kSingleParentNodeChildren].GetChildrenSince(
+        set_draw_state_node_index, first_link, &children);
 
-    // Obtain the address of each of the children group IBs
-    PM4_CP_SET_DRAW_STATE packet{};
-    DIVE_VERIFY(mem_manager.RetrieveMemoryData(&packet, submit_index, va_addr,
-                                               (header.type7.count + 1) * sizeof(uint32_t)));
+    // Obtain the address of each of the children group IBs, which follow the header
+    using ArrayElement = PM4_CP_SET_DRAW_STATE::ARRAY_ELEMENT;
+    const ArrayElement* array = reinterpret_cast<const ArrayElement*>(packet.GetPayload());
 
     // Sanity check: The # of children should match the array size
-    uint32_t total_size_bytes = (header.type7.count * sizeof(uint32_t));
-    uint32_t per_element_size = sizeof(PM4_CP_SET_DRAW_STATE::ARRAY_ELEMENT);
+    uint32_t total_size_bytes = (packet.GetPayloadSizeInDwords() * sizeof(uint32_t));
+    uint32_t per_element_size = sizeof(ArrayElement);
     uint32_t array_size = total_size_bytes / per_element_size;
     DIVE_ASSERT(total_size_bytes % per_element_size == 0);
     DIVE_ASSERT(children.size() == array_size);
@@ -1926,29 +2334,25 @@ void CommandHierarchyCreator::CacheSetDrawStateGroupInfo(const IMemoryManager& m
     for (uint32_t i = 0; i < array_size; ++i)
     {
         m_group_info[i].m_group_node_index = children[i];
-        m_group_info[i].m_group_addr = packet.ARRAY[i].ADDR;
+        m_group_info[i].m_group_addr = array[i].ADDR;
     }
 
     m_group_info_size = array_size;
 }
 
 //--------------------------------------------------------------------------------------------------
-uint64_t CommandHierarchyCreator::AddNode(NodeType type, std::string&& desc,
+uint64_t CommandHierarchyCreator::AddNode(NodeType type, std::string_view desc,
                                           CommandHierarchy::AuxInfo aux_info)
 {
-    uint64_t node_index = m_command_hierarchy.AddNode(type, std::move(desc), aux_info);
+    uint64_t node_index = m_command_hierarchy.AddNode(type, desc, aux_info);
     for (uint32_t i = 0; i < CommandHierarchy::kTopologyTypeCount; ++i)
     {
-        DIVE_ASSERT(m_node_children[i][kSingleParentNodeChildren].size() == node_index);
-        DIVE_ASSERT(m_node_children[i][kSharedNodeChildren].size() == node_index);
-        m_node_children[i][kSingleParentNodeChildren].resize(
-            m_node_children[i][kSingleParentNodeChildren].size() + 1);
-        m_node_children[i][kSharedNodeChildren].resize(
-            m_node_children[i][kSharedNodeChildren].size() + 1);
-
-        m_node_start_shared_children[i].resize(m_node_start_shared_children[i].size() + 1);
-        m_node_end_shared_children[i].resize(m_node_end_shared_children[i].size() + 1);
-        m_node_root_node_indices[i].resize(m_node_root_node_indices[i].size() + 1);
+        DIVE_ASSERT(m_node_start_shared_children[i].size() == node_index);
+        // Nodes that are not given a range of shared children (such as packet nodes) are left
+        // pointing at the root node, which has none
+        m_node_start_shared_children[i].resize(m_node_start_shared_children[i].size() + 1, 0);
+        m_node_end_shared_children[i].resize(m_node_end_shared_children[i].size() + 1, 0);
+        m_node_root_node_indices[i].resize(m_node_root_node_indices[i].size() + 1, 0);
         DIVE_ASSERT(m_node_start_shared_children[i].size() == m_node_end_shared_children[i].size());
         DIVE_ASSERT(m_node_start_shared_children[i].size() == m_node_root_node_indices[i].size());
     }
@@ -1968,8 +2372,8 @@ void CommandHierarchyCreator::AddChild(CommandHierarchy::TopologyType type, uint
 {
     // Store children info into the temporary m_node_children
     // Use this to create the appropriate topology later
-    DIVE_ASSERT(node_index < m_node_children[type][kSingleParentNodeChildren].size());
-    m_node_children[type][kSingleParentNodeChildren][node_index].push_back(child_node_index);
+    DIVE_ASSERT(node_index < m_node_start_shared_children[type].size());
+    m_node_children[type][kSingleParentNodeChildren].AddChild(node_index, child_node_index);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -1978,8 +2382,8 @@ void CommandHierarchyCreator::AddSharedChild(CommandHierarchy::TopologyType type
 {
     // Store children info into the temporary m_node_children
     // Use this to create the appropriate topology later
-    DIVE_ASSERT(node_index < m_node_children[type][kSharedNodeChildren].size());
-    m_node_children[type][kSharedNodeChildren][node_index].push_back(child_node_index);
+    DIVE_ASSERT(node_index < m_node_start_shared_children[type].size());
+    m_node_children[type][kSharedNodeChildren].AddChild(node_index, child_node_index);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -2010,59 +2414,59 @@ void CommandHierarchyCreator::SetSharedChildRootNodeIndex(CommandHierarchy::Topo
 }
 
 //--------------------------------------------------------------------------------------------------
-uint64_t CommandHierarchyCreator::GetChildNodeIndex(CommandHierarchy::TopologyType type,
-                                                    uint64_t node_index, uint64_t child_index) const
+void CommandHierarchyCreator::GroupNodeChildren()
 {
-    DIVE_ASSERT(node_index < m_node_children[type][kSingleParentNodeChildren].size());
-    DIVE_ASSERT(child_index < m_node_children[type][kSingleParentNodeChildren][node_index].size());
-    return m_node_children[type][kSingleParentNodeChildren][node_index][child_index];
-}
+    // Only the nodes added by this creator. Other nodes may have been added to the same command
+    // hierarchy since (ie. GFXR nodes), and those are not part of these lists
+    uint64_t num_nodes = m_node_start_shared_children[0].size();
+    for (uint32_t topology = 0; topology < CommandHierarchy::kTopologyTypeCount; ++topology)
+    {
+        for (uint32_t i = 0; i < kChildrenNodeTypeCount; ++i)
+            m_node_children[topology][i].Group(num_nodes);
+    }
 
-//--------------------------------------------------------------------------------------------------
-uint64_t CommandHierarchyCreator::GetChildCount(CommandHierarchy::TopologyType type,
-                                                uint64_t node_index) const
-{
-    DIVE_ASSERT(node_index < m_node_children[type][kSingleParentNodeChildren].size());
-    return m_node_children[type][kSingleParentNodeChildren][node_index].size();
+    // For the submit topology, the IBs are inserted in emulation order, and are not necessarily in
+    // ib-index order. Sort them here so they appear in order of ib-index.
+    NodeChildrenLists& submit_children =
+        m_node_children[CommandHierarchy::kSubmitTopology][kSingleParentNodeChildren];
+    for (uint64_t node_index = 0; node_index < num_nodes; ++node_index)
+    {
+        if (m_command_hierarchy.GetNodeType(node_index) != NodeType::kSubmitNode) continue;
+
+        uint64_t* children = submit_children.GetChildren(node_index);
+        std::sort(children, children + submit_children.GetNumChildren(node_index),
+                  [&](uint64_t lhs, uint64_t rhs) -> bool {
+                      uint8_t lhs_index = m_command_hierarchy.GetIbNodeIndex(lhs);
+                      uint8_t rhs_index = m_command_hierarchy.GetIbNodeIndex(rhs);
+                      return lhs_index < rhs_index;
+                  });
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
 void CommandHierarchyCreator::CreateTopologies()
 {
-    uint64_t total_num_children[CommandHierarchy::kTopologyTypeCount] = {};
-    uint64_t total_num_shared_children[CommandHierarchy::kTopologyTypeCount] = {};
+    GroupNodeChildren();
 
     // Convert the m_node_children temporary structure into CommandHierarchy's topologies
     for (uint32_t topology = 0; topology < CommandHierarchy::kTopologyTypeCount; ++topology)
     {
-        size_t num_nodes = m_node_children[topology][kSingleParentNodeChildren].size();
+        const NodeChildrenLists& children = m_node_children[topology][kSingleParentNodeChildren];
+        const NodeChildrenLists& shared_children = m_node_children[topology][kSharedNodeChildren];
+        uint64_t num_nodes = children.GetNumNodes();
         SharedNodeTopology& cur_topology = m_command_hierarchy.m_topology[topology];
         cur_topology.SetNumNodes(num_nodes);
 
-        // Optional loop: Pre-reserve to prevent the resize() from allocating memory later
-        // Note: The number of children for some of the topologies have been determined
-        // earlier in this function already
-        if (total_num_children[topology] == 0 && total_num_shared_children[topology] == 0)
-        {
-            for (uint64_t node_index = 0; node_index < num_nodes; ++node_index)
-            {
-                auto& node_children = m_node_children[topology];
-                total_num_children[topology] +=
-                    node_children[kSingleParentNodeChildren][node_index].size();
-                total_num_shared_children[topology] += node_children[1][node_index].size();
-            }
-        }
-        cur_topology.m_children_list.reserve(total_num_children[topology]);
-        cur_topology.m_shared_children_indices.reserve(total_num_shared_children[topology]);
+        // Pre-reserve to prevent the resize() from allocating memory later
+        cur_topology.m_children_list.reserve(children.GetTotalNumChildren());
+        cur_topology.m_shared_children_indices.reserve(shared_children.GetTotalNumChildren());
 
         for (uint64_t node_index = 0; node_index < num_nodes; ++node_index)
         {
-            DIVE_ASSERT(m_node_children[topology][kSingleParentNodeChildren].size() ==
-                        m_node_children[topology][kSingleParentNodeChildren].size());
-            cur_topology.AddChildren(
-                node_index, m_node_children[topology][kSingleParentNodeChildren][node_index]);
-            cur_topology.AddSharedChildren(
-                node_index, m_node_children[topology][kSharedNodeChildren][node_index]);
+            cur_topology.AddChildren(node_index, children.GetChildren(node_index),
+                                     children.GetNumChildren(node_index));
+            cur_topology.AddSharedChildren(node_index, shared_children.GetChildren(node_index),
+                                           shared_children.GetNumChildren(node_index));
         }
         cur_topology.m_start_shared_child = std::move(m_node_start_shared_children[topology]);
         cur_topology.m_end_shared_child = std::move(m_node_end_shared_children[topology]);
@@ -2070,6 +2474,45 @@ void CommandHierarchyCreator::CreateTopologies()
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+void CommandHierarchyCreator::SetHierarchyChunkCallback(HierarchyChunkCallback callback,
+                                                        std::chrono::milliseconds interval)
+{
+    m_hierarchy_chunk_callback = std::move(callback);
+    m_hierarchy_chunk_interval = interval;
+    m_next_hierarchy_chunk_time = std::chrono::steady_clock::time_point::min();
+}
+
+//--------------------------------------------------------------------------------------------------
+std::unique_ptr<CommandHierarchyChunk> CommandHierarchyCreator::CreateHierarchyChunk()
+{
+    const CommandHierarchy::Nodes& nodes = m_command_hierarchy.m_nodes;
+    auto chunk = std::make_unique<CommandHierarchyChunk>();
+    chunk->m_first_node_index = m_num_chunk_nodes;
+    chunk->m_node_type.assign(nodes.m_node_type.begin() + m_num_chunk_nodes,
+                              nodes.m_node_type.end());
+    chunk->m_aux_info.assign(nodes.m_aux_info.begin() + m_num_chunk_nodes,
+                             nodes.m_aux_info.end());
+    chunk->m_description.assign(nodes.m_description.begin() + m_num_chunk_descs,
+                                nodes.m_description.end());
+    chunk->m_first_lazy_desc_index = m_num_chunk_lazy_descs;
+    chunk->m_lazy_desc.assign(nodes.m_lazy_desc.begin() + m_num_chunk_lazy_descs,
+                              nodes.m_lazy_desc.end());
+    chunk->m_event_node_indices.assign(nodes.m_event_node_indices.begin() + m_num_chunk_event_nodes,
+                                       nodes.m_event_node_indices.end());
+
+    const NodeChildrenLists& children =
+        m_node_children[CommandHierarchy::kAllEventTopology][kSingleParentNodeChildren];
+    children.GetLinksSince(m_num_chunk_links, &chunk->m_links);
+
+    m_num_chunk_nodes = nodes.m_node_type.size();
+    m_num_chunk_descs = nodes.m_description.size();
+    m_num_chunk_lazy_descs = nodes.m_lazy_desc.size();
+    m_num_chunk_event_nodes = nodes.m_event_node_indices.size();
+    m_num_chunk_links = children.GetNumLinks();
+    return chunk;
+}
+
 //--------------------------------------------------------------------------------------------------
 bool CommandHierarchyCreator::EventNodeHelper(uint64_t node_index,
                                               std::function<bool(uint32_t)> callback) const
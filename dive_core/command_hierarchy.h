@@ -20,9 +20,12 @@
 // =====================================================================================================================
 
 #pragma once
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -32,6 +35,7 @@
 #include "dive_core/common/emulate_pm4.h"
 #include "dive_core/common/pm4_packets/pfp_pm4_packets.h"
 #include "dive_core/stl_replacement.h"
+#include "dive_core/string_arena.h"
 #include "pm4_capture_data.h"
 
 // Forward declarations
@@ -47,6 +51,7 @@ class GFRData;
 class MemoryManager;
 class SubmitInfo;
 class ILog;
+struct CommandHierarchyChunk;
 
 //--------------------------------------------------------------------------------------------------
 enum class NodeType
@@ -133,11 +138,18 @@ class Topology
 
     virtual void SetNumNodes(uint64_t num_nodes);
     void AddChildren(uint64_t node_index, const DiveVector<uint64_t>& children);
+    void AddChildren(uint64_t node_index, const uint64_t* children, uint64_t num_children);
+
+    // Add children after the ones the node already has. Unlike AddChildren(), this can be called
+    // more than once per node. The children of a node have to be contiguous in m_children_list, so
+    // they are moved to its end first if they aren't there
+    void AppendChildren(uint64_t node_index, const uint64_t* children, uint64_t num_children);
 
  private:
     friend class CommandHierarchy;
     friend class GfxrVulkanCommandHierarchyCreator;
     friend class DiveCommandHierarchyCreator;
+    friend class CaptureMetadataCache;
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -168,6 +180,7 @@ class SharedNodeTopology : public Topology
     friend class CommandHierarchy;
     friend class CommandHierarchyCreator;
     friend class DiveCommandHierarchyCreator;
+    friend class CaptureMetadataCache;
 
     // List of all children for shared nodes.
 
@@ -191,6 +204,22 @@ class SharedNodeTopology : public Topology
 
     void SetNumNodes(uint64_t num_nodes) override;
     void AddSharedChildren(uint64_t node_index, const DiveVector<uint64_t>& children);
+    void AddSharedChildren(uint64_t node_index, const uint64_t* children, uint64_t num_children);
+};
+
+//--------------------------------------------------------------------------------------------------
+// Told about the children appended to the nodes that are shown in the all-event topology while a
+// chunk is appended, such as to insert their rows in a view. See CommandHierarchy::AppendChunk()
+class ChunkAppendListener
+{
+ public:
+    virtual ~ChunkAppendListener() = default;
+
+    // Called before num_children children are appended after the first_child_index children that
+    // node_index already has
+    virtual void BeginAppendChildren(uint64_t node_index, uint64_t first_child_index,
+                                     uint64_t num_children) = 0;
+    virtual void EndAppendChildren() = 0;
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -208,6 +237,8 @@ class CommandHierarchy
     };
     CommandHierarchy();
     ~CommandHierarchy();
+    CommandHierarchy(CommandHierarchy&&) = default;
+    CommandHierarchy& operator=(CommandHierarchy&&) = default;
 
     inline size_t size() const { return m_nodes.m_node_type.size(); }
 
@@ -222,7 +253,13 @@ class CommandHierarchy
     const SharedNodeTopology& GetAllEventHierarchyTopology() const;
 
     NodeType GetNodeType(uint64_t node_index) const;
-    const char* GetNodeDesc(uint64_t node_index) const;
+
+    // The descriptions of most register and field nodes are formatted on demand, so the
+    // description is returned by value
+    std::string GetNodeDesc(uint64_t node_index) const;
+    // Same, but into desc, so that a caller going through many nodes can reuse its memory
+    void GetNodeDesc(uint64_t node_index, std::string& desc) const;
+    // Not for the nodes whose descriptions are formatted on demand
     void SetNodeDesc(uint64_t node_index, const std::string& desc);
 
     Dive::EngineType GetSubmitNodeEngineType(uint64_t node_index) const;
@@ -240,6 +277,8 @@ class CommandHierarchy
     uint8_t GetPacketNodeIbLevel(uint64_t node_index) const;
     bool GetRegFieldNodeIsCe(uint64_t node_index) const;
     bool IsEventNodeIgnoredDuringCorrelation(uint64_t node_index) const;
+    // The block of the GFXR file that the Vulkan command of a gfxr node was read from, if any
+    std::optional<uint64_t> GetGfxrNodeBlockIndex(uint64_t node_index) const;
 
     // GetEventIndex returns sequence number for Event/Sync Nodes, 0 if not exist.
     size_t GetEventIndex(uint64_t node_index) const;
@@ -268,10 +307,20 @@ class CommandHierarchy
         return m_filter_exclude_indices_list[filter_type];
     }
 
+    // Append the nodes of a chunk, and their children in the all-event topology. Appending all the
+    // chunks of a hierarchy being created, in order, gives the nodes of the submits processed so
+    // far (see CommandHierarchyCreator::SetHierarchyChunkCallback()). The descriptions are not
+    // copied, so the hierarchy being created has to outlive this one. The nodes that were
+    // connected to the root before the chunk get their new children last, each between calls to
+    // the listener, so the new children are added along with all their own children
+    void AppendChunk(const CommandHierarchyChunk& chunk, ChunkAppendListener* listener = nullptr);
+
  private:
     friend class CommandHierarchyCreator;
     friend class GfxrVulkanCommandHierarchyCreator;
     friend class DiveCommandHierarchyCreator;
+    friend class CaptureMetadataCache;
+    friend struct CommandHierarchyChunk;
 
     enum TopologyType
     {
@@ -283,6 +332,27 @@ class CommandHierarchy
     static const uint8_t kMaxNumIbsBits = 6;
     static_assert((1 << kMaxNumIbsBits) >= EmulatePM4::kMaxNumIbsPerSubmit, "Not enough bits!");
 
+    // Register and field nodes can number in the tens of millions, and most are never displayed.
+    // So instead of a description, they can refer to a LazyDesc which holds just enough to format
+    // the description on demand. A register's field nodes share the LazyDesc of the register
+    enum class LazyDescType : uint8_t
+    {
+        kNone,  // The description is stored in Nodes::m_description
+        kRegister,
+        kRegisterField,
+        kPacketField,
+    };
+
+    struct LazyDesc
+    {
+        union
+        {
+            uint32_t m_reg_offset;            // kRegister & kRegisterField
+            const PacketInfo* m_packet_info;  // kPacketField
+        };
+        uint64_t m_value;  // Register value, or the packet dword containing the field
+    };
+
     union AuxInfo
     {
         struct
@@ -324,9 +394,18 @@ class CommandHierarchy
 
         struct
         {
-            bool m_is_ce_packet;
+            uint64_t m_is_ce_packet : 1;
+            uint64_t m_lazy_desc_type : 2;    // LazyDescType
+            uint64_t m_lazy_desc_field : 13;  // Index of the field within the register/packet
+            uint64_t m_lazy_desc_index : 48;  // Index into Nodes::m_lazy_desc
         } reg_field_node;
 
+        struct
+        {
+            uint64_t m_block_index : 63;
+            uint64_t m_has_block_index : 1;
+        } gfxr_node;
+
         uint64_t m_u64All;
 
         AuxInfo(uint64_t val);
@@ -335,9 +414,12 @@ class CommandHierarchy
                               bool fully_captured);
         static AuxInfo PacketNode(uint64_t addr, uint8_t opcode, uint8_t ib_level);
         static AuxInfo RegFieldNode(bool is_ce_packet);
+        static AuxInfo LazyDescNode(LazyDescType type, uint64_t lazy_desc_index,
+                                    uint32_t field = 0);
         static AuxInfo EventNode(uint32_t event_id, Util::EventType type,
                                  bool ignore_during_correlation);
         static AuxInfo MarkerNode(MarkerType type, uint32_t id = 0);
+        static AuxInfo GfxrNode(uint64_t block_index);
     };
     static_assert(sizeof(AuxInfo) == sizeof(uint64_t), "Unexpected size!");
 
@@ -345,19 +427,58 @@ class CommandHierarchy
     // Arranged in structure-of-arrays for better locality
     struct Nodes
     {
+        // Which nodes of a group of 64 store a description, and how many nodes before the group do
+        struct DescGroup
+        {
+            uint64_t m_stored_mask;
+            uint64_t m_first_desc_index;
+        };
+
         DiveVector<NodeType> m_node_type;
-        DiveVector<std::string> m_description;
         DiveVector<AuxInfo> m_aux_info;
         DiveVector<uint64_t> m_event_node_indices;
+        DiveVector<LazyDesc> m_lazy_desc;
+
+        // Descriptions of the nodes that store one, in node order. Nodes with a LazyDesc have no
+        // entry, so m_desc_groups is used to find the entry of a node
+        // Points into m_strings, or into the strings of another hierarchy (see AppendChunk())
+        DiveVector<const char*> m_description;
+        DiveVector<DescGroup> m_desc_groups;
+
+        // Backing storage of the descriptions. The descriptions of packet, register and field
+        // nodes repeat a lot (opcode and register names), so those are interned
+        StringArena m_strings;
 
-        uint64_t AddNode(NodeType type, std::string&& desc, AuxInfo aux_info);
-        uint64_t AddGfxrNode(NodeType type, std::string&& desc);
+        uint64_t AddNode(NodeType type, std::string_view desc, AuxInfo aux_info);
+        uint64_t AddGfxrNode(NodeType type, std::string_view desc, AuxInfo aux_info);
+
+        // Append the nodes of chunk, pointing at its descriptions rather than copying them
+        void AppendChunk(const CommandHierarchyChunk& chunk);
+
+        // Copy desc into m_strings, interning the descriptions of the types that repeat a lot
+        const char* AddDesc(NodeType type, std::string_view desc);
+
+        // Whether a node of the given type and info has an entry in m_description
+        static bool StoresDesc(NodeType type, AuxInfo aux_info);
+
+        // Index of the node's entry in m_description, or UINT64_MAX if it has a LazyDesc instead
+        uint64_t GetDescIndex(uint64_t node_index) const;
+
+        // Recreate m_desc_groups from m_node_type and m_aux_info
+        void UpdateDescGroups();
+
+     private:
+        void PushNode(NodeType type, const char* desc, AuxInfo aux_info);
     };
 
     // Add a node and returns index of the added node
-    uint64_t AddNode(NodeType type, std::string&& desc, AuxInfo aux_info);
-    // Add a gfxr node and returns index of the added node
-    uint64_t AddGfxrNode(NodeType type, std::string&& desc);
+    uint64_t AddNode(NodeType type, std::string_view desc, AuxInfo aux_info);
+    // Add a gfxr node and returns index of the added node. The info of the node is either 0 or
+    // from AuxInfo::GfxrNode()
+    uint64_t AddGfxrNode(NodeType type, std::string_view desc, AuxInfo aux_info = AuxInfo(0));
+    // Add info to format descriptions from, and returns its index for LazyDescNode()
+    uint64_t AddLazyDesc(const LazyDesc& lazy_desc);
+    std::string FormatLazyDesc(uint64_t node_index) const;
     void AddToFilterExcludeIndexList(uint64_t index, FilterListType filter_mode)
     {
         m_filter_exclude_indices_list[filter_mode].insert(index);
@@ -368,6 +489,78 @@ class CommandHierarchy
     SharedNodeTopology m_topology[kTopologyTypeCount];
 };
 
+//--------------------------------------------------------------------------------------------------
+// The nodes added to a command hierarchy being created since the previous chunk, and the links of
+// the all-event topology added since. See CommandHierarchy::AppendChunk()
+struct CommandHierarchyChunk
+{
+    struct Link
+    {
+        uint64_t m_node_index;
+        uint64_t m_child_node_index;
+    };
+
+    uint64_t m_first_node_index = 0;
+    std::vector<NodeType> m_node_type;
+    std::vector<CommandHierarchy::AuxInfo> m_aux_info;
+
+    // Entries of CommandHierarchy::Nodes::m_description, so only for the nodes that store one.
+    // They point into the strings of the hierarchy being created
+    std::vector<const char*> m_description;
+
+    uint64_t m_first_lazy_desc_index = 0;
+    std::vector<CommandHierarchy::LazyDesc> m_lazy_desc;
+    std::vector<uint64_t> m_event_node_indices;
+
+    // In the order they were added
+    std::vector<Link> m_links;
+};
+
+//--------------------------------------------------------------------------------------------------
+// Children of each node, gathered while a command hierarchy is being created. Rather than keeping a
+// vector per node, every (parent, child) link is appended to one flat list, so that adding nodes
+// and children does not allocate per node. Group() then sorts the links by parent, after which the
+// children of each node are contiguous, in the order they were added.
+class NodeChildrenLists
+{
+ public:
+    void Reserve(uint64_t num_children);
+
+    // Only valid before Group()
+    void AddChild(uint64_t node_index, uint64_t child_node_index);
+    uint64_t GetNumLinks() const { return m_links.size(); }
+
+    // Gather the children of node_index among the links added since GetNumLinks() returned
+    // first_link. Only valid before Group(), and only cheap when few links were added since
+    void GetChildrenSince(uint64_t node_index, uint64_t first_link,
+                          DiveVector<uint64_t>* children) const;
+
+    // Append the links added since GetNumLinks() returned first_link. Only valid before Group()
+    void GetLinksSince(uint64_t first_link, std::vector<CommandHierarchyChunk::Link>* links) const;
+
+    void Group(uint64_t num_nodes);
+
+    // Only valid after Group()
+    uint64_t GetNumNodes() const;
+    uint64_t GetTotalNumChildren() const { return m_children.size(); }
+    uint64_t GetNumChildren(uint64_t node_index) const;
+    const uint64_t* GetChildren(uint64_t node_index) const;
+    uint64_t* GetChildren(uint64_t node_index);
+
+ private:
+    struct Link
+    {
+        uint64_t m_node_index;
+        uint64_t m_child_node_index;
+    };
+
+    DiveVector<Link> m_links;  // Released by Group()
+
+    // m_children[m_offsets[i]] to m_children[m_offsets[i + 1]] are the children of node i
+    DiveVector<uint64_t> m_offsets;
+    DiveVector<uint64_t> m_children;
+};
+
 //--------------------------------------------------------------------------------------------------
 class CommandHierarchyCreator : public EmulateCallbacksBase
 {
@@ -393,6 +586,18 @@ class CommandHierarchyCreator : public EmulateCallbacksBase
     bool CreateTrees(EngineType engine_type, QueueType queue_type,
                      std::vector<uint32_t>& command_dwords, uint32_t size_in_dwords);
 
+    // Called at the end of a submit with the nodes added since the previous call, so that the
+    // submits processed so far can be displayed before the whole capture is processed. It is called
+    // on the thread creating the hierarchy, after the first submit and then at most once per
+    // interval
+    using HierarchyChunkCallback =
+        std::function<void(std::shared_ptr<const CommandHierarchyChunk>)>;
+    void SetHierarchyChunkCallback(HierarchyChunkCallback callback,
+                                   std::chrono::milliseconds interval);
+
+    // The nodes and all-event links added since the previous chunk
+    std::unique_ptr<CommandHierarchyChunk> CreateHierarchyChunk();
+
     bool OnIbStart(uint32_t submit_index, uint32_t ib_index, const IndirectBufferInfo& ib_info,
                    IbType type) override;
 
@@ -400,14 +605,18 @@ class CommandHierarchyCreator : public EmulateCallbacksBase
                  const IndirectBufferInfo& ib_info) override;
 
     bool OnPacket(const IMemoryManager& mem_manager, uint32_t submit_index, uint32_t ib_index,
-                  uint64_t va_addr, Pm4Header header) override;
+                  uint64_t va_addr, const Pm4Packet& packet) override;
 
     void CreateTopologies();
 
+    // Group the children gathered so far by parent node. Needs to be called once all nodes have
+    // been added, and before the children are retrieved with GetNodeChildren()
+    void GroupNodeChildren();
+
     void OnSubmitStart(uint32_t submit_index, const SubmitInfo& submit_info) override;
     void OnSubmitEnd(uint32_t submit_index, const SubmitInfo& submit_info) override;
 
-    const DiveVector<DiveVector<uint64_t>>& GetNodeChildren(uint64_t type, size_t sub_index) const
+    const NodeChildrenLists& GetNodeChildren(uint64_t type, size_t sub_index) const
     {
         return m_node_children[type][sub_index];
     }
@@ -451,18 +660,15 @@ class CommandHierarchyCreator : public EmulateCallbacksBase
         kChildrenNodeTypeCount
     };
 
-    uint64_t AddPacketNode(const IMemoryManager& mem_manager, uint32_t submit_index,
-                           uint64_t va_addr, bool is_ce_packet, Pm4Header header);
+    uint64_t AddPacketNode(uint64_t va_addr, bool is_ce_packet, const Pm4Packet& packet);
     uint64_t AddRegisterNode(uint32_t reg, uint64_t reg_value, const RegInfo* reg_info_ptr);
 
     bool IsBeginDebugMarkerNode(uint64_t node_index);
 
     uint32_t GetMarkerSize(const uint8_t* marker_ptr, size_t num_dwords);
 
-    void AppendRegNodes(const IMemoryManager& mem_manager, uint32_t submit_index, uint64_t va_addr,
-                        Pm4Header header, uint64_t packet_node_index);
-    void AppendRegNodes(const IMemoryManager& mem_manager, uint32_t submit_index, uint64_t va_addr,
-                        uint32_t dword_count, uint64_t packet_node_index);
+    void AppendRegNodes(const Pm4Packet& packet, uint64_t packet_node_index);
+    void AppendRegNodes(const uint32_t* dwords, uint32_t dword_count, uint64_t packet_node_index);
     void AppendContextRegRmwNodes(const IMemoryManager& mem_manager, uint32_t submit_index,
                                   uint64_t va_addr, const PM4_PFP_TYPE_3_HEADER& header,
                                   uint64_t packet_node_index);
@@ -478,18 +684,17 @@ class CommandHierarchyCreator : public EmulateCallbacksBase
     void AppendEventWriteFieldNodes(const IMemoryManager& mem_manager, uint32_t submit_index,
                                     uint64_t va_addr, const PM4_PFP_TYPE_3_HEADER& header,
                                     const PacketInfo* packet_info_ptr, uint64_t packet_node_index);
-    void AppendPacketFieldNodes(const IMemoryManager& mem_manager, uint32_t submit_index,
-                                uint64_t va_addr, uint32_t dword_count, bool append_extra_dwords,
-                                const PacketInfo* packet_info_ptr, uint64_t packet_node_index,
-                                const char* prefix = "");
+    void AppendPacketFieldNodes(const uint32_t* dwords, uint32_t dword_count,
+                                bool append_extra_dwords, const PacketInfo* packet_info_ptr,
+                                uint64_t packet_node_index, const char* prefix = "");
     void AppendLoadStateExtBufferNode(const IMemoryManager& mem_manager, uint32_t submit_index,
-                                      uint64_t va_addr, uint64_t packet_node_index);
+                                      uint64_t va_addr, const Pm4Packet& pm4_packet,
+                                      uint64_t packet_node_index);
     void AppendMemRegNodes(const IMemoryManager& mem_manager, uint32_t submit_index,
-                           uint64_t va_addr, uint64_t packet_node_index);
-    void CacheSetDrawStateGroupInfo(const IMemoryManager& mem_manager, uint32_t submit_index,
-                                    uint64_t va_addr, uint64_t set_draw_state_node_index,
-                                    Pm4Header header);
-    uint64_t AddNode(NodeType type, std::string&& desc, CommandHierarchy::AuxInfo aux_info = 0);
+                           const Pm4Packet& pm4_packet, uint64_t packet_node_index);
+    void CacheSetDrawStateGroupInfo(const Pm4Packet& packet, uint64_t set_draw_state_node_index,
+                                    uint64_t first_link);
+    uint64_t AddNode(NodeType type, std::string_view desc, CommandHierarchy::AuxInfo aux_info = 0);
 
     void AppendEventNodeIndex(uint64_t node_index);
 
@@ -504,10 +709,6 @@ class CommandHierarchyCreator : public EmulateCallbacksBase
     void SetSharedChildRootNodeIndex(CommandHierarchy::TopologyType type, uint64_t node_index,
                                      uint64_t root_node_index);
 
-    uint64_t GetChildNodeIndex(CommandHierarchy::TopologyType type, uint64_t node_index,
-                               uint64_t child_index) const;
-    uint64_t GetChildCount(CommandHierarchy::TopologyType type, uint64_t node_index) const;
-
     bool EventNodeHelper(uint64_t node_index, std::function<bool(uint32_t)> callback) const;
 
     template <typename T>
@@ -583,8 +784,19 @@ class CommandHierarchyCreator : public EmulateCallbacksBase
     // Once parsing is complete, we will create a topology from this
     // There are 2 sets of children per node, per topology. The second set of children nodes can
     // have more than 1 parent each
-    DiveVector<DiveVector<uint64_t>> m_node_children[CommandHierarchy::kTopologyTypeCount]
-                                                    [kChildrenNodeTypeCount];
+    NodeChildrenLists m_node_children[CommandHierarchy::kTopologyTypeCount]
+                                     [kChildrenNodeTypeCount];
+
+    HierarchyChunkCallback m_hierarchy_chunk_callback;
+    std::chrono::milliseconds m_hierarchy_chunk_interval = {};
+    std::chrono::steady_clock::time_point m_next_hierarchy_chunk_time;
+
+    // How much of the hierarchy the chunks created so far cover
+    uint64_t m_num_chunk_nodes = 0;
+    uint64_t m_num_chunk_descs = 0;
+    uint64_t m_num_chunk_lazy_descs = 0;
+    uint64_t m_num_chunk_event_nodes = 0;
+    uint64_t m_num_chunk_links = 0;
 };
 
 }  // namespace Dive
@@ -22,6 +22,7 @@
 #include <stdarg.h>
 #include <string.h>  // memcpy
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
@@ -44,15 +45,17 @@ EmulateStateTracker::EmulateStateTracker() {}
 
 //--------------------------------------------------------------------------------------------------
 bool EmulateStateTracker::OnPacket(const IMemoryManager& mem_manager, uint32_t submit_index,
-                                   uint32_t ib_index, uint64_t va_addr, Pm4Header header)
+                                   uint32_t ib_index, uint64_t va_addr, const Pm4Packet& packet)
 {
+    Pm4Header header = packet.GetHeader();
+    const PM4_CP_SET_MARKER* marker_packet = nullptr;
     if (header.type == 7 && header.type7.opcode == CP_SET_MARKER)
+        marker_packet = packet.As<PM4_CP_SET_MARKER>();
+    if (marker_packet != nullptr)
     {
-        PM4_CP_SET_MARKER packet{};
-        DIVE_VERIFY(mem_manager.RetrieveMemoryData(&packet, submit_index, va_addr, sizeof(packet)));
         // as mentioned in adreno_pm4.xml, only b0-b3 are considered when b8 is not set
-        DIVE_ASSERT((packet.u32All0 & 0x100) == 0);
-        a6xx_marker marker = static_cast<a6xx_marker>(packet.u32All0 & 0xf);
+        DIVE_ASSERT((marker_packet->u32All0 & 0x100) == 0);
+        a6xx_marker marker = static_cast<a6xx_marker>(marker_packet->u32All0 & 0xf);
         switch (marker)
         {
                 // This is emitted at the beginning of the render pass if tiled rendering mode is
@@ -98,35 +101,25 @@ bool EmulateStateTracker::OnPacket(const IMemoryManager& mem_manager, uint32_t s
 
     if (header.type == 7 && header.type7.opcode == CP_CONTEXT_REG_BUNCH)
     {
+        // Register offset + value pairs
+        const uint32_t* payload = packet.GetPayload();
+        uint32_t payload_size = packet.GetPayloadSizeInDwords();
         uint32_t dword = 0;
-        while (dword < header.type7.count)
+        while (dword + 2 <= payload_size)
         {
-            struct RegPair
-            {
-                uint32_t m_reg_offset;
-                uint32_t m_reg_value;
-            };
-            RegPair reg_pair{};
-            uint64_t pair_addr = va_addr + sizeof(header) + dword * sizeof(uint32_t);
-            DIVE_VERIFY(mem_manager.RetrieveMemoryData(&reg_pair, submit_index, pair_addr,
-                                                       sizeof(reg_pair)));
+            uint32_t reg_offset = payload[dword];
+            SetReg(reg_offset, payload[dword + 1]);
             dword += 2;
-            SetReg(reg_pair.m_reg_offset, reg_pair.m_reg_value);
 
-            const RegInfo* reg_info_ptr = GetRegInfo(reg_pair.m_reg_offset);
-            if (reg_info_ptr && reg_info_ptr->m_is_64_bit)
+            const RegInfo* reg_info_ptr = GetRegInfo(reg_offset);
+            if (reg_info_ptr && reg_info_ptr->m_is_64_bit && dword + 2 <= payload_size)
             {
-                RegPair new_reg_pair{};
-                uint64_t new_pair_addr = va_addr + sizeof(header) + dword * sizeof(uint32_t);
-                DIVE_VERIFY(mem_manager.RetrieveMemoryData(&new_reg_pair, submit_index,
-                                                           new_pair_addr, sizeof(new_reg_pair)));
-
                 // Sometimes the upper 32-bits are not set
                 // Probably because they're 0s and there's no need to set it
-                if (new_reg_pair.m_reg_offset == reg_pair.m_reg_offset + 1)
+                if (payload[dword] == reg_offset + 1)
                 {
+                    SetReg(payload[dword], payload[dword + 1]);
                     dword += 2;
-                    SetReg(new_reg_pair.m_reg_offset, new_reg_pair.m_reg_value);
                 }
             }
         }
@@ -134,28 +127,25 @@ bool EmulateStateTracker::OnPacket(const IMemoryManager& mem_manager, uint32_t s
     // type 4 is setting register
     else if (header.type == 4)
     {
-        uint32_t offset_in_bytes = 0;
+        const uint32_t* payload = packet.GetPayload();
         uint32_t dword = 0;
         while (dword < header.type4.count)
         {
-            uint64_t reg_va_addr = va_addr + sizeof(header) + offset_in_bytes;
             uint32_t reg_offset = header.type4.offset + dword;
             DIVE_ASSERT(reg_offset < kNumRegs);
             const RegInfo* reg_info_ptr = GetRegInfo(reg_offset);
 
-            constexpr size_t dword_in_bytes = sizeof(uint32_t);
             uint32_t size_in_dwords = 1;
             if (reg_info_ptr != nullptr)
             {
                 if (reg_info_ptr->m_is_64_bit) size_in_dwords = 2;
             }
-            offset_in_bytes += size_in_dwords * dword_in_bytes;
+
+            // The packet may end after the lower 32-bits of a 64-bit register
+            size_in_dwords = std::min<uint32_t>(size_in_dwords, header.type4.count - dword);
             for (uint32_t i = 0; i < size_in_dwords; ++i)
             {
-                uint32_t reg_value = 0;
-                DIVE_VERIFY(mem_manager.RetrieveMemoryData(
-                    &reg_value, submit_index, reg_va_addr + i * dword_in_bytes, dword_in_bytes));
-                SetReg(reg_offset + i, reg_value);
+                SetReg(reg_offset + i, payload[dword + i]);
             }
 
             dword += size_in_dwords;
@@ -332,9 +322,8 @@ bool EmulatePM4::ExecuteSubmit(EmulateCallbacksBase& callbacks, const IMemoryMan
         // Callbacks + advance
         EmulateState::IbStack* cur_ib_level = &emu_state.m_ib_stack[emu_state.m_top_of_stack];
 
-        Pm4Header header{};
-        DIVE_VERIFY(mem_manager.RetrieveMemoryData(&header, emu_state.m_submit_index,
-                                                   cur_ib_level->m_cur_va, sizeof(Pm4Header)));
+        Pm4Header header = GetIbPacketHeader(mem_manager, emu_state.m_submit_index, *cur_ib_level,
+                                             cur_ib_level->m_cur_va);
 
         // Check validity of packet
         if (header.type == 4)
@@ -351,27 +340,80 @@ bool EmulatePM4::ExecuteSubmit(EmulateCallbacksBase& callbacks, const IMemoryMan
             if (type7_header->zeroes != 0) return false;
         }
 
+        // The packet is resolved once, and shared by the callbacks and the emulation
+        Pm4Packet packet = GetCurPacket(mem_manager, &emu_state, header);
         if (!callbacks.OnPacket(mem_manager, emu_state.m_submit_index, emu_state.m_ib_index,
-                                cur_ib_level->m_cur_va, header))
+                                cur_ib_level->m_cur_va, packet))
             return false;
-        if (!AdvanceCb(mem_manager, &emu_state, callbacks, header)) return false;
+        if (!AdvanceCb(mem_manager, &emu_state, callbacks, packet)) return false;
     }  // while there are packets left in submit
     return true;
 }
 
+//--------------------------------------------------------------------------------------------------
+const uint32_t* EmulatePM4::GetIbDwords(const EmulateState::IbStack& ib, uint64_t va_addr,
+                                        uint32_t size_in_dwords) const
+{
+    uint64_t ib_end_addr = ib.m_cur_ib_addr + ib.m_cur_ib_size_in_dwords * sizeof(uint32_t);
+    if (ib.m_cur_ib_dwords == nullptr || va_addr < ib.m_cur_ib_addr ||
+        va_addr + size_in_dwords * sizeof(uint32_t) > ib_end_addr)
+    {
+        return nullptr;
+    }
+    return ib.m_cur_ib_dwords + (va_addr - ib.m_cur_ib_addr) / sizeof(uint32_t);
+}
+
+//--------------------------------------------------------------------------------------------------
+Pm4Header EmulatePM4::GetIbPacketHeader(const IMemoryManager& mem_manager, uint32_t submit_index,
+                                        const EmulateState::IbStack& ib, uint64_t va_addr) const
+{
+    Pm4Header header{};
+    if (const uint32_t* dwords = GetIbDwords(ib, va_addr, 1))
+        header.u32All = dwords[0];
+    else
+        DIVE_VERIFY(mem_manager.RetrieveMemoryData(&header, submit_index, va_addr, sizeof(header)));
+    return header;
+}
+
+//--------------------------------------------------------------------------------------------------
+Pm4Packet EmulatePM4::GetCurPacket(const IMemoryManager& mem_manager, EmulateState* emu_state,
+                                   Pm4Header header) const
+{
+    const EmulateState::IbStack& cur_ib_level = *emu_state->GetCurIb();
+
+    // The header is always included, even if the packet type is unknown
+    uint32_t size_in_dwords = std::max(GetPacketSize(header), 1u);
+    const uint32_t* dwords = GetIbDwords(cur_ib_level, cur_ib_level.m_cur_va, size_in_dwords);
+    if (dwords == nullptr)
+    {
+        // The IB is not in a single memory block, or the packet runs past the end of the IB
+        emu_state->m_packet_copy.clear();
+        emu_state->m_packet_copy.resize(size_in_dwords, 0);
+        DIVE_VERIFY(mem_manager.RetrieveMemoryData(emu_state->m_packet_copy.data(),
+                                                   emu_state->m_submit_index,
+                                                   cur_ib_level.m_cur_va,
+                                                   size_in_dwords * sizeof(uint32_t)));
+        dwords = emu_state->m_packet_copy.data();
+    }
+    return Pm4Packet(dwords, size_in_dwords);
+}
+
 //--------------------------------------------------------------------------------------------------
 bool EmulatePM4::AdvanceCb(const IMemoryManager& mem_manager, EmulateState* emu_state_ptr,
-                           EmulateCallbacksBase& callbacks, Pm4Header header) const
+                           EmulateCallbacksBase& callbacks, const Pm4Packet& packet) const
 {
+    // The packet fields are read in place. Packets that are too small to hold the fields that
+    // reference IBs are skipped like any other packet
+    Pm4Header header = packet.GetHeader();
+
     // Deal with calls and chains
-    if (header.type == 7 && (header.type7.opcode == CP_INDIRECT_BUFFER_PFE ||
-                             header.type7.opcode == CP_INDIRECT_BUFFER_PFD ||
-                             header.type7.opcode == CP_INDIRECT_BUFFER_CHAIN))
-    {
-        PM4_CP_INDIRECT_BUFFER ib_packet{};
-        DIVE_VERIFY(mem_manager.RetrieveMemoryData(&ib_packet, emu_state_ptr->m_submit_index,
-                                                   emu_state_ptr->GetCurIb()->m_cur_va,
-                                                   sizeof(PM4_CP_INDIRECT_BUFFER)));
+    if (header.type == 7 &&
+        (header.type7.opcode == CP_INDIRECT_BUFFER_PFE ||
+         header.type7.opcode == CP_INDIRECT_BUFFER_PFD ||
+         header.type7.opcode == CP_INDIRECT_BUFFER_CHAIN) &&
+        packet.As<PM4_CP_INDIRECT_BUFFER>() != nullptr)
+    {
+        const PM4_CP_INDIRECT_BUFFER& ib_packet = *packet.As<PM4_CP_INDIRECT_BUFFER>();
         IbType ib_type =
             (header.type7.opcode == CP_INDIRECT_BUFFER_CHAIN) ? IbType::kChain : IbType::kCall;
         emu_state_ptr->GetCurIb()->m_ib_queue_index = 0;
@@ -385,25 +427,23 @@ bool EmulatePM4::AdvanceCb(const IMemoryManager& mem_manager, EmulateState* emu_
         if (!AdvanceToQueuedIB(mem_manager, emu_state_ptr, callbacks)) return false;
     }
     // Parse CP_SET_AMBLE (previously CP_SET_CTXSWITCH_IB), since it references implicit IBs
-    else if (header.type == 7 && header.type7.opcode == CP_SET_AMBLE)
+    else if (header.type == 7 && header.type7.opcode == CP_SET_AMBLE &&
+             packet.As<PM4_CP_SET_AMBLE>() != nullptr)
     {
         // For simplicity sake, treat CP_SET_AMBLE essentially as a
         // CALL (i.e. jump to the next IB level), although the hardware probably
         // doesn't do that.
-        PM4_CP_SET_AMBLE packet{};
-        DIVE_VERIFY(mem_manager.RetrieveMemoryData(&packet, emu_state_ptr->m_submit_index,
-                                                   emu_state_ptr->GetCurIb()->m_cur_va,
-                                                   (header.type7.count + 1) * sizeof(uint32_t)));
+        const PM4_CP_SET_AMBLE& amble_packet = *packet.As<PM4_CP_SET_AMBLE>();
 
         // Sometimes this packet is used for purposes other than to jump to an IB. Check size.
         // Example: When TYPE is SAVE_IB
         AdvancePacket(emu_state_ptr, header);
-        if (packet.bitfields1.DWORDS != 0)
+        if (amble_packet.bitfields1.DWORDS != 0)
         {
             emu_state_ptr->GetCurIb()->m_ib_queue_index = 0;
             emu_state_ptr->GetCurIb()->m_ib_queue_size = 0;
-            if (!QueueIB(packet.ADDR, packet.bitfields1.DWORDS, false, IbType::kContextSwitchIb,
-                         emu_state_ptr))
+            if (!QueueIB(amble_packet.ADDR, amble_packet.bitfields1.DWORDS, false,
+                         IbType::kContextSwitchIb, emu_state_ptr))
             {
                 return false;
             }
@@ -416,28 +456,26 @@ bool EmulatePM4::AdvanceCb(const IMemoryManager& mem_manager, EmulateState* emu_
         // For simplicity sake, treat CP_SET_DRAW_STATE essentially as multiple
         // CALLs (i.e. jump to the next IB level), although the hardware probably
         // doesn't do that.
-        PM4_CP_SET_DRAW_STATE packet{};
-        DIVE_VERIFY(mem_manager.RetrieveMemoryData(&packet, emu_state_ptr->m_submit_index,
-                                                   emu_state_ptr->GetCurIb()->m_cur_va,
-                                                   (header.type7.count + 1) * sizeof(uint32_t)));
-        uint32_t packet_size = (packet.HEADER.count * sizeof(uint32_t));
-        uint32_t array_size = packet_size / sizeof(PM4_CP_SET_DRAW_STATE::ARRAY_ELEMENT);
-        DIVE_ASSERT((packet_size % sizeof(PM4_CP_SET_DRAW_STATE::ARRAY_ELEMENT)) == 0);
+        // The array of groups follows the header. Only the elements within the packet are read
+        using ArrayElement = PM4_CP_SET_DRAW_STATE::ARRAY_ELEMENT;
+        const ArrayElement* array = reinterpret_cast<const ArrayElement*>(packet.GetPayload());
+        uint32_t packet_size = (packet.GetPayloadSizeInDwords() * sizeof(uint32_t));
+        uint32_t array_size = packet_size / sizeof(ArrayElement);
+        DIVE_ASSERT((packet_size % sizeof(ArrayElement)) == 0);
         bool ib_queued = false;
         emu_state_ptr->GetCurIb()->m_ib_queue_index = 0;
         emu_state_ptr->GetCurIb()->m_ib_queue_size = 0;
         for (uint32_t i = 0; i < array_size; i++)
         {
-            if (packet.ARRAY[i].bitfields0.DISABLE_ALL_GROUPS) break;
-            if (packet.ARRAY[i].bitfields0.DISABLE) continue;
+            if (array[i].bitfields0.DISABLE_ALL_GROUPS) break;
+            if (array[i].bitfields0.DISABLE) continue;
 
-            uint32_t enable_mask = packet.ARRAY[i].bitfields0.BINNING |
-                                   (packet.ARRAY[i].bitfields0.GMEM << 1) |
-                                   (packet.ARRAY[i].bitfields0.SYSMEM << 2);
+            uint32_t enable_mask = array[i].bitfields0.BINNING | (array[i].bitfields0.GMEM << 1) |
+                                   (array[i].bitfields0.SYSMEM << 2);
 
             ib_queued = true;
-            if (!QueueIB(packet.ARRAY[i].ADDR, packet.ARRAY[i].bitfields0.COUNT, false,
-                         IbType::kDrawState, emu_state_ptr, enable_mask))
+            if (!QueueIB(array[i].ADDR, array[i].bitfields0.COUNT, false, IbType::kDrawState,
+                         emu_state_ptr, enable_mask))
             {
                 return false;
             }
@@ -448,12 +486,10 @@ bool EmulatePM4::AdvanceCb(const IMemoryManager& mem_manager, EmulateState* emu_
             if (!AdvanceToQueuedIB(mem_manager, emu_state_ptr, callbacks)) return false;
         }
     }
-    else if ((header.type == 7) && (header.type7.opcode == CP_START_BIN))
+    else if ((header.type == 7) && (header.type7.opcode == CP_START_BIN) &&
+             packet.As<PM4_CP_START_BIN>() != nullptr)
     {
-        PM4_CP_START_BIN packet{};
-        DIVE_VERIFY(mem_manager.RetrieveMemoryData(&packet, emu_state_ptr->m_submit_index,
-                                                   emu_state_ptr->GetCurIb()->m_cur_va,
-                                                   sizeof(PM4_CP_START_BIN)));
+        const PM4_CP_START_BIN& start_bin_packet = *packet.As<PM4_CP_START_BIN>();
 
         // The CP_START_BIN & CP_END_BIN are pm4s only availabe at a650+
         // here is the layout:
@@ -481,9 +517,8 @@ bool EmulatePM4::AdvanceCb(const IMemoryManager& mem_manager, EmulateState* emu_
         uint32_t common_block_dword_size = UINT32_MAX;
         while (true)
         {
-            Pm4Header temp_header{};
-            DIVE_VERIFY(mem_manager.RetrieveMemoryData(&temp_header, emu_state_ptr->m_submit_index,
-                                                       temp_va, sizeof(Pm4Header)));
+            Pm4Header temp_header = GetIbPacketHeader(mem_manager, emu_state_ptr->m_submit_index,
+                                                      *cur_ib_level, temp_va);
             if (temp_header.type == 7 && temp_header.type7.opcode == CP_END_BIN)
             {
                 uint64_t common_block_size = temp_va - cp_start_common_block_va;
@@ -506,10 +541,12 @@ bool EmulatePM4::AdvanceCb(const IMemoryManager& mem_manager, EmulateState* emu_
             cp_start_common_block_va + common_block_dword_size * sizeof(uint32_t);
 
         // Go through each prefix+common pair
-        for (uint32_t bin = 0; bin < packet.BIN_COUNT; ++bin)
+        for (uint32_t bin = 0; bin < start_bin_packet.BIN_COUNT; ++bin)
         {
-            if (!QueueIB(packet.PREFIX_ADDR + bin * packet.PREFIX_DWORDS * sizeof(uint32_t),
-                         packet.PREFIX_DWORDS, false, IbType::kBinPrefix, emu_state_ptr))
+            uint64_t prefix_addr = start_bin_packet.PREFIX_ADDR +
+                                   bin * start_bin_packet.PREFIX_DWORDS * sizeof(uint32_t);
+            if (!QueueIB(prefix_addr, start_bin_packet.PREFIX_DWORDS, false, IbType::kBinPrefix,
+                         emu_state_ptr))
             {
                 return false;
             }
@@ -522,23 +559,23 @@ bool EmulatePM4::AdvanceCb(const IMemoryManager& mem_manager, EmulateState* emu_
         }
         if (!AdvanceToQueuedIB(mem_manager, emu_state_ptr, callbacks)) return false;
     }
-    else if ((header.type == 7) && (header.type7.opcode == CP_FIXED_STRIDE_DRAW_TABLE))
+    else if ((header.type == 7) && (header.type7.opcode == CP_FIXED_STRIDE_DRAW_TABLE) &&
+             packet.As<PM4_CP_FIXED_STRIDE_DRAW_TABLE>() != nullptr)
     {
         // CP_FIXED_STRIDE_DRAW_TABLE only availabe at a7xx+
         // Executes an array of fixed-size command buffers where each buffer is assumed to have one
         // draw call, skipping buffers with non - visible draw calls.
         // if CP_START_BIN/CP_END_BIN are used, and CP_FIXED_STRIDE_DRAW_TABLE is used for
         // drawcalls, it will be in the Common_block
-        PM4_CP_FIXED_STRIDE_DRAW_TABLE packet{};
-        DIVE_VERIFY(mem_manager.RetrieveMemoryData(&packet, emu_state_ptr->m_submit_index,
-                                                   emu_state_ptr->GetCurIb()->m_cur_va,
-                                                   sizeof(PM4_CP_FIXED_STRIDE_DRAW_TABLE)));
+        const PM4_CP_FIXED_STRIDE_DRAW_TABLE& table_packet =
+            *packet.As<PM4_CP_FIXED_STRIDE_DRAW_TABLE>();
 
-        for (uint32_t draw = 0; draw < packet.bitfields2.COUNT; ++draw)
+        for (uint32_t draw = 0; draw < table_packet.bitfields2.COUNT; ++draw)
         {
-            if (!QueueIB(packet.IB_BASE + draw * packet.bitfields1.STRIDE * sizeof(uint32_t),
-                         packet.bitfields1.STRIDE, false, IbType::kFixedStrideDrawTable,
-                         emu_state_ptr))
+            uint64_t ib_addr =
+                table_packet.IB_BASE + draw * table_packet.bitfields1.STRIDE * sizeof(uint32_t);
+            if (!QueueIB(ib_addr, table_packet.bitfields1.STRIDE, false,
+                         IbType::kFixedStrideDrawTable, emu_state_ptr))
             {
                 return false;
             }
@@ -651,6 +688,18 @@ bool EmulatePM4::AdvanceToQueuedIB(const IMemoryManager& mem_manager, EmulateSta
                                         cur_ib_level->m_cur_ib_size_in_dwords * sizeof(uint32_t));
     cur_ib_level->m_cur_ib_skip |= skip_ib;
 
+    // Resolve the IB once, so that its packets can be read in place. Misaligned data can't be read
+    // as dwords, so it is copied instead
+    const void* ib_data_ptr = nullptr;
+    if (!cur_ib_level->m_cur_ib_skip)
+    {
+        ib_data_ptr = mem_manager.GetMemoryPointer(
+            emu_state->m_submit_index, cur_ib_level->m_cur_va,
+            cur_ib_level->m_cur_ib_size_in_dwords * sizeof(uint32_t));
+    }
+    if (reinterpret_cast<uintptr_t>(ib_data_ptr) % alignof(uint32_t) != 0) ib_data_ptr = nullptr;
+    cur_ib_level->m_cur_ib_dwords = static_cast<const uint32_t*>(ib_data_ptr);
+
     // Start-Ib Callback
     {
         IndirectBufferInfo call_chain_ib_info{};
@@ -786,32 +835,100 @@ bool EmulateCallbacksBase::ProcessSubmits(const DiveVector<SubmitInfo>& submits,
 {
     for (uint32_t submit_index = 0; submit_index < submits.size(); ++submit_index)
     {
-        const Dive::SubmitInfo& submit_info = submits[submit_index];
-        OnSubmitStart(submit_index, submit_info);
-
-        if (submit_info.IsDummySubmit())
-        {
-            OnSubmitEnd(submit_index, submit_info);
-            continue;
-        }
+        if (!ProcessSubmit(submit_index, submits[submit_index], mem_manager)) return false;
+    }
+    return true;
+}
 
-        // Only gfx or compute engine types are parsed
-        if ((submit_info.GetEngineType() != Dive::EngineType::kUniversal) &&
-            (submit_info.GetEngineType() != Dive::EngineType::kCompute))
-        {
-            OnSubmitEnd(submit_index, submit_info);
-            continue;
-        }
+//--------------------------------------------------------------------------------------------------
+bool EmulateCallbacksBase::ProcessSubmit(uint32_t submit_index, const SubmitInfo& submit_info,
+                                         const IMemoryManager& mem_manager)
+{
+    OnSubmitStart(submit_index, submit_info);
 
-        EmulatePM4 emu;
-        if (!emu.ExecuteSubmit(*this, mem_manager, submit_index,
-                               submit_info.GetNumIndirectBuffers(),
-                               submit_info.GetIndirectBufferInfoPtr()))
-            return false;
+    if (submit_info.IsDummySubmit())
+    {
+        OnSubmitEnd(submit_index, submit_info);
+        return true;
+    }
 
+    // Only gfx or compute engine types are parsed
+    if ((submit_info.GetEngineType() != Dive::EngineType::kUniversal) &&
+        (submit_info.GetEngineType() != Dive::EngineType::kCompute))
+    {
         OnSubmitEnd(submit_index, submit_info);
+        return true;
+    }
+
+    EmulatePM4 emu;
+    if (!emu.ExecuteSubmit(*this, mem_manager, submit_index, submit_info.GetNumIndirectBuffers(),
+                           submit_info.GetIndirectBufferInfoPtr()))
+        return false;
+
+    OnSubmitEnd(submit_index, submit_info);
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void EmulateCallbacksComposite::AddCallbacks(EmulateCallbacksBase& callbacks)
+{
+    m_callbacks.push_back(&callbacks);
+}
+
+//--------------------------------------------------------------------------------------------------
+bool EmulateCallbacksComposite::OnIbStart(uint32_t submit_index, uint32_t ib_index,
+                                          const IndirectBufferInfo& ib_info, IbType type)
+{
+    // Every consumer sees the start of the IB, so that their IB-level tracking stays balanced
+    bool result = true;
+    for (EmulateCallbacksBase* callbacks : m_callbacks)
+    {
+        result &= callbacks->OnIbStart(submit_index, ib_index, ib_info, type);
+    }
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool EmulateCallbacksComposite::OnIbEnd(uint32_t submit_index, uint32_t ib_index,
+                                        const IndirectBufferInfo& ib_info)
+{
+    bool result = true;
+    for (EmulateCallbacksBase* callbacks : m_callbacks)
+    {
+        result &= callbacks->OnIbEnd(submit_index, ib_index, ib_info);
+    }
+    return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool EmulateCallbacksComposite::OnPacket(const IMemoryManager& mem_manager, uint32_t submit_index,
+                                         uint32_t ib_index, uint64_t va_addr,
+                                         const Pm4Packet& packet)
+{
+    for (EmulateCallbacksBase* callbacks : m_callbacks)
+    {
+        if (!callbacks->OnPacket(mem_manager, submit_index, ib_index, va_addr, packet))
+            return false;
     }
     return true;
 }
 
+//--------------------------------------------------------------------------------------------------
+void EmulateCallbacksComposite::OnSubmitStart(uint32_t submit_index, const SubmitInfo& submit_info)
+{
+    for (EmulateCallbacksBase* callbacks : m_callbacks)
+    {
+        callbacks->OnSubmitStart(submit_index, submit_info);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+void EmulateCallbacksComposite::OnSubmitEnd(uint32_t submit_index, const SubmitInfo& submit_info)
+{
+    for (EmulateCallbacksBase* callbacks : m_callbacks)
+    {
+        callbacks->OnSubmitEnd(submit_index, submit_info);
+    }
+}
+
 }  // namespace Dive
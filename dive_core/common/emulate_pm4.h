@@ -85,6 +85,46 @@ union Pm4Header
 
 // clang-format on
 
+//--------------------------------------------------------------------------------------------------
+// The dwords of a Pm4 packet, header included, as resolved once by the emulator. If the IB is in a
+// single memory block, they point directly into it, so that the packet fields are read in place
+// instead of being copied out of the memory manager. Only valid during the OnPacket() callback
+class Pm4Packet
+{
+ public:
+    Pm4Packet(const uint32_t* dwords, uint32_t size_in_dwords)
+        : m_dwords(dwords), m_size_in_dwords(size_in_dwords)
+    {
+    }
+
+    Pm4Header GetHeader() const
+    {
+        Pm4Header header;
+        header.u32All = m_dwords[0];
+        return header;
+    }
+
+    const uint32_t* GetDwords() const { return m_dwords; }
+    uint32_t GetSizeInDwords() const { return m_size_in_dwords; }
+
+    // The dwords following the header
+    const uint32_t* GetPayload() const { return m_dwords + 1; }
+    uint32_t GetPayloadSizeInDwords() const { return m_size_in_dwords - 1; }
+
+    // View the packet as one of the PM4_* packet structs. Returns nullptr if the packet is too
+    // small to hold it
+    template <typename T>
+    const T* As() const
+    {
+        if (sizeof(T) > m_size_in_dwords * sizeof(uint32_t)) return nullptr;
+        return reinterpret_cast<const T*>(m_dwords);
+    }
+
+ private:
+    const uint32_t* m_dwords;
+    uint32_t m_size_in_dwords;
+};
+
 //--------------------------------------------------------------------------------------------------
 enum class ShaderEnableBit : uint32_t
 {
@@ -112,7 +152,7 @@ class EmulateStateTracker
 
     // Call these functions to update the state tracker
     bool OnPacket(const IMemoryManager& mem_manager, uint32_t submit_index, uint32_t ib_index,
-                  uint64_t va_addr, Pm4Header header);
+                  uint64_t va_addr, const Pm4Packet& packet);
 
     // Accessing state tracking info
     bool IsUConfigStateSet(uint16_t reg) const;
@@ -170,6 +210,11 @@ class EmulateCallbacksBase
  public:
     bool ProcessSubmits(const DiveVector<SubmitInfo>& submits, const IMemoryManager& mem_manager);
 
+    // Emulate a single submit. Submits are independent of each other as far as the emulation is
+    // concerned, so this can be used to process a subset of the submits
+    bool ProcessSubmit(uint32_t submit_index, const SubmitInfo& submit_info,
+                       const IMemoryManager& mem_manager);
+
     // Callback on an IB start. Also called for all call/chain IBs
     // A return value of false indicates to the emulator to skip parsing this IB
     virtual bool OnIbStart(uint32_t submit_index, uint32_t ib_index,
@@ -189,9 +234,9 @@ class EmulateCallbacksBase
 
     // Callback for each Pm4 packet. Called in order of emulation
     virtual bool OnPacket(const IMemoryManager& mem_manager, uint32_t submit_index,
-                          uint32_t ib_index, uint64_t va_addr, Pm4Header header)
+                          uint32_t ib_index, uint64_t va_addr, const Pm4Packet& packet)
     {
-        if (!m_state_tracker.OnPacket(mem_manager, submit_index, ib_index, va_addr, header))
+        if (!m_state_tracker.OnPacket(mem_manager, submit_index, ib_index, va_addr, packet))
         {
             return false;
         }
@@ -206,6 +251,35 @@ class EmulateCallbacksBase
     EmulateStateTracker m_state_tracker;
 };
 
+//--------------------------------------------------------------------------------------------------
+// Forwards all callbacks to a list of consumers, so that they can share a single emulation walk
+// instead of each emulating all of the submits. Consumers are called in the order they were added.
+// Each consumer does its own state tracking, so the state tracker of this class is unused
+class EmulateCallbacksComposite : public EmulateCallbacksBase
+{
+ public:
+    ~EmulateCallbacksComposite() override = default;
+
+    // The consumer must outlive this object
+    void AddCallbacks(EmulateCallbacksBase& callbacks);
+
+    // All consumers are called, and false is returned if any of them returns false
+    bool OnIbStart(uint32_t submit_index, uint32_t ib_index, const IndirectBufferInfo& ib_info,
+                   IbType type) override;
+    bool OnIbEnd(uint32_t submit_index, uint32_t ib_index,
+                 const IndirectBufferInfo& ib_info) override;
+
+    // Returns false as soon as a consumer returns false, which ends emulation of the submit
+    bool OnPacket(const IMemoryManager& mem_manager, uint32_t submit_index, uint32_t ib_index,
+                  uint64_t va_addr, const Pm4Packet& packet) override;
+
+    void OnSubmitStart(uint32_t submit_index, const SubmitInfo& submit_info) override;
+    void OnSubmitEnd(uint32_t submit_index, const SubmitInfo& submit_info) override;
+
+ private:
+    DiveVector<EmulateCallbacksBase*> m_callbacks;
+};
+
 //--------------------------------------------------------------------------------------------------
 class EmulatePM4
 {
@@ -249,6 +323,10 @@ class EmulatePM4
             uint64_t m_cur_ib_addr;
             uint32_t m_cur_ib_size_in_dwords;
             bool m_cur_ib_skip;
+
+            // Points into the memory block backing the current IB, or nullptr if the IB is not
+            // in a single block and has to be copied out of the memory manager a packet at a time
+            const uint32_t* m_cur_ib_dwords;
             uint32_t m_cur_ib_enable_mask;
             IbType m_cur_ib_type;
 
@@ -280,11 +358,26 @@ class EmulatePM4
         IbStack m_ib_stack[kTotalIbLevels];
         IbLevel m_top_of_stack;
         IbStack* GetCurIb() { return &m_ib_stack[m_top_of_stack]; }
+
+        // Copy of the current packet, if it cannot be read in place
+        DiveVector<uint32_t> m_packet_copy;
     };
 
+    // Get a pointer to the given dwords of the IB, if they can be read in place
+    const uint32_t* GetIbDwords(const EmulateState::IbStack& ib, uint64_t va_addr,
+                                uint32_t size_in_dwords) const;
+
+    // Read the header of the packet at the given va of the IB
+    Pm4Header GetIbPacketHeader(const IMemoryManager& mem_manager, uint32_t submit_index,
+                                const EmulateState::IbStack& ib, uint64_t va_addr) const;
+
+    // Resolve the dwords of the current packet, reading them in place if possible
+    Pm4Packet GetCurPacket(const IMemoryManager& mem_manager, EmulateState* emu_state,
+                           Pm4Header header) const;
+
     // Advance dcb pointer after advancing past the packet header. Returns "true" if dcb is blocked.
     bool AdvanceCb(const IMemoryManager& mem_manager, EmulateState* emu_state_ptr,
-                   EmulateCallbacksBase& callbacks, Pm4Header header) const;
+                   EmulateCallbacksBase& callbacks, const Pm4Packet& packet) const;
 
     // Helper function to queue up an IB for later CALL or CHAIN
     // Use AdvanceToIB to actually jump to the 1st queued up IB
@@ -31,6 +31,14 @@ class IMemoryManager
     virtual bool RetrieveMemoryData(void* buffer_ptr, uint32_t submit_index, uint64_t va_addr,
                                     uint64_t size) const = 0;
 
+    // Get a pointer to the given va/size, for reading it in place. Returns nullptr if the range is
+    // not in a single memory block, in which case it has to be copied via RetrieveMemoryData()
+    virtual const void* GetMemoryPointer(uint32_t submit_index, uint64_t va_addr,
+                                         uint64_t size) const
+    {
+        return nullptr;
+    }
+
     // For resources of unknown size (eg. shaders). The caller is responsible (via return value of
     // callback) with notifying when end of resource is reached. Otherwise MemoryManager will keep
     // calling the callback until no more contiguous memory is available for copying.
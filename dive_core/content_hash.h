@@ -0,0 +1,60 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace Dive
+{
+
+//--------------------------------------------------------------------------------------------------
+inline uint64_t MixWord(uint64_t hash, uint64_t word)
+{
+    hash ^= word * 0x9e3779b97f4a7c15ull;
+    hash = (hash << 31) | (hash >> 33);
+    return hash * 0xbf58476d1ce4e5b9ull;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Only meant to detect changes to the contents, not to resist collisions that are made on purpose.
+// This can run over a whole capture, so it hashes 8 bytes at a time on 4 independent lanes
+inline uint64_t HashData(uint64_t hash, const uint8_t* data, uint64_t size)
+{
+    uint64_t lanes[4] = {hash, hash + 1, hash + 2, hash + 3};
+    uint64_t offset = 0;
+    for (; offset + sizeof(lanes) <= size; offset += sizeof(lanes))
+    {
+        for (uint32_t lane = 0; lane < 4; ++lane)
+        {
+            uint64_t word;
+            std::memcpy(&word, data + offset + lane * sizeof(word), sizeof(word));
+            lanes[lane] = MixWord(lanes[lane], word);
+        }
+    }
+    for (uint32_t lane = 0; lane < 4; ++lane) hash = MixWord(hash, lanes[lane]);
+    for (; offset < size; offset += sizeof(uint64_t))
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, data + offset, std::min<uint64_t>(sizeof(word), size - offset));
+        hash = MixWord(hash, word);
+    }
+    return MixWord(hash, size);
+}
+
+}  // namespace Dive
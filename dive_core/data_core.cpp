@@ -18,8 +18,12 @@
 
 #include <assert.h>
 
+#include <algorithm>
+#include <atomic>
 #include <optional>
+#include <thread>
 
+#include "capture_metadata_cache.h"
 #include "dive_core/command_hierarchy.h"
 #include "dive_core/gfxr_vulkan_command_hierarchy.h"
 #include "pm4_info.h"
@@ -27,12 +31,38 @@
 namespace Dive
 {
 
+namespace
+{
+
+//--------------------------------------------------------------------------------------------------
+// The number of pm4 packets is only counted while the submits are emulated, so when the command
+// hierarchy is created during that same walk, the count is estimated from the top-level IBs. Each
+// packet is at least 1 dword, so their dwords overestimate the top-level packets, which roughly
+// makes up for the packets of the nested IBs that aren't known up front
+uint64_t EstimateNumPm4Packets(const DiveVector<SubmitInfo>& submits)
+{
+    uint64_t num_dwords = 0;
+    for (const SubmitInfo& submit_info : submits)
+    {
+        for (uint32_t ib_index = 0; ib_index < submit_info.GetNumIndirectBuffers(); ++ib_index)
+        {
+            num_dwords += submit_info.GetIndirectBufferInfo(ib_index).m_size_in_dwords;
+        }
+    }
+    return num_dwords;
+}
+
+}  // namespace
+
 // =================================================================================================
 // DataCore
 // =================================================================================================
 
 //--------------------------------------------------------------------------------------------------
-DataCore::DataCore(ProgressTracker* progress_tracker) : m_progress_tracker(progress_tracker) {}
+DataCore::DataCore(ProgressTracker* progress_tracker)
+    : m_progress_tracker(progress_tracker), m_dive_capture_data(progress_tracker)
+{
+}
 
 //--------------------------------------------------------------------------------------------------
 CaptureData::LoadResult DataCore::LoadDiveCaptureData(const std::string& file_name)
@@ -40,6 +70,7 @@ CaptureData::LoadResult DataCore::LoadDiveCaptureData(const std::string& file_na
     std::filesystem::path rd_file_path(file_name);
     rd_file_path.replace_extension(".rd");
     m_capture_metadata = CaptureMetadata();
+    m_capture_file_names = {rd_file_path.string(), file_name};
     return m_dive_capture_data.LoadFiles(rd_file_path.string(), file_name);
 }
 
@@ -48,6 +79,7 @@ CaptureData::LoadResult DataCore::LoadPm4CaptureData(const std::string& file_nam
 {
     m_pm4_capture_data = Pm4CaptureData(m_progress_tracker);  // Clear any previously loaded data
     m_capture_metadata = CaptureMetadata();
+    m_capture_file_names = {file_name};
     return m_pm4_capture_data.LoadCaptureFile(file_name);
 }
 
@@ -59,22 +91,40 @@ CaptureData::LoadResult DataCore::LoadGfxrCaptureData(const std::string& file_na
 }
 
 //--------------------------------------------------------------------------------------------------
-bool DataCore::CreateDiveCommandHierarchy()
+bool DataCore::CreateGfxrCommandHierarchy()
 {
-    std::unique_ptr<EmulateStateTracker> state_tracker(new EmulateStateTracker);
-
-    // Optional: Reserve the internal vectors based on the number of pm4 packets in the capture
-    // This is an educated guess that each PM4 packet results in x number of associated
-    // field/register nodes. Overguessing means more memory used during creation. Underguessing
-    // means more allocations. For big captures, this is easily in the multi-millions, so
-    // pre-reserving the space is a signficiant performance win
-    uint64_t reserve_size = m_capture_metadata.m_num_pm4_packets * 10;
+    GfxrVulkanCommandHierarchyCreator vk_cmd_creator(m_capture_metadata.m_command_hierarchy,
+                                                     m_gfxr_capture_data);
+    if (!vk_cmd_creator.CreateTrees(/*used_in_mixed_command_hierarchy=*/false))
+    {
+        return false;
+    }
+    return true;
+}
 
-    // Command hierarchy tree creation
+//--------------------------------------------------------------------------------------------------
+bool DataCore::CreateDiveMetaDataAndCommandHierarchy()
+{
+    auto metadata_creator = CaptureMetadataCreator::Create(m_capture_metadata, m_shader_cache);
+    if (!metadata_creator)
+    {
+        return false;
+    }
 
+    // Same reservation as CreateDiveCommandHierarchy(), from an estimate of the number of packets
+    uint64_t reserve_size =
+        EstimateNumPm4Packets(m_dive_capture_data.GetPm4CaptureData().GetSubmits()) * 10;
     DiveCommandHierarchyCreator cmd_hier_creator(m_capture_metadata.m_command_hierarchy);
+    cmd_hier_creator.SetHierarchyChunkCallback(m_command_hierarchy_chunk_callback,
+                                               m_command_hierarchy_chunk_interval);
+    const Pm4CaptureData& pm4_capture_data = m_dive_capture_data.GetPm4CaptureData();
+    auto process_submits = [&](EmulateCallbacksBase& callbacks) {
+        return metadata_creator->ProcessSubmitsInParallel(pm4_capture_data.GetSubmits(),
+                                                          pm4_capture_data.GetMemoryManager(),
+                                                          GetNumParseThreads(), &callbacks);
+    };
     if (!cmd_hier_creator.CreateTrees(m_capture_metadata.m_command_hierarchy, m_dive_capture_data,
-                                      true, reserve_size))
+                                      true, reserve_size, process_submits))
     {
         return false;
     }
@@ -82,55 +132,48 @@ bool DataCore::CreateDiveCommandHierarchy()
 }
 
 //--------------------------------------------------------------------------------------------------
-bool DataCore::CreatePm4CommandHierarchy()
+bool DataCore::CreatePm4MetaDataAndCommandHierarchy()
 {
-    std::unique_ptr<EmulateStateTracker> state_tracker(new EmulateStateTracker);
-
-    // Optional: Reserve the internal vectors based on the number of pm4 packets in the capture
-    // This is an educated guess that each PM4 packet results in x number of associated
-    // field/register nodes. Overguessing means more memory used during creation. Underguessing
-    // means more allocations. For big captures, this is easily in the multi-millions, so
-    // pre-reserving the space is a signficiant performance win
-    uint64_t reserve_size = m_capture_metadata.m_num_pm4_packets * 10;
-
-    // Command hierarchy tree creation
+    auto metadata_creator = CaptureMetadataCreator::Create(m_capture_metadata, m_shader_cache);
     auto cmd_hier_creator =
         CommandHierarchyCreator::Create(m_capture_metadata.m_command_hierarchy, m_pm4_capture_data);
-    if (!cmd_hier_creator)
+    if (!metadata_creator || !cmd_hier_creator)
     {
         return false;
     }
-    if (!cmd_hier_creator->CreateTrees(m_pm4_capture_data,
-                                       /*flatten_chain_nodes=*/true, reserve_size))
+    cmd_hier_creator->SetHierarchyChunkCallback(m_command_hierarchy_chunk_callback,
+                                                m_command_hierarchy_chunk_interval);
+
+    // Same reservation as CreatePm4CommandHierarchy(), from an estimate of the number of packets
+    uint64_t reserve_size = EstimateNumPm4Packets(m_pm4_capture_data.GetSubmits()) * 10;
+    if (!cmd_hier_creator->CreateTrees(/*flatten_chain_nodes=*/true,
+                                       /*createTopologies=*/false, reserve_size))
     {
         return false;
     }
-    return true;
-}
 
-//--------------------------------------------------------------------------------------------------
-bool DataCore::CreateGfxrCommandHierarchy()
-{
-    GfxrVulkanCommandHierarchyCreator vk_cmd_creator(m_capture_metadata.m_command_hierarchy,
-                                                     m_gfxr_capture_data);
-    if (!vk_cmd_creator.CreateTrees(/*used_in_mixed_command_hierarchy=*/false))
+    if (!metadata_creator->ProcessSubmitsInParallel(m_pm4_capture_data.GetSubmits(),
+                                                    m_pm4_capture_data.GetMemoryManager(),
+                                                    GetNumParseThreads(), cmd_hier_creator.get()))
     {
         return false;
     }
+
+    cmd_hier_creator->CreateTopologies();
     return true;
 }
 
 //--------------------------------------------------------------------------------------------------
 bool DataCore::CreateDiveMetaData()
 {
-    auto metadata_creator = CaptureMetadataCreator::Create(m_capture_metadata);
+    auto metadata_creator = CaptureMetadataCreator::Create(m_capture_metadata, m_shader_cache);
     if (!metadata_creator)
     {
         return false;
     }
-    if (!metadata_creator->ProcessSubmits(
+    if (!metadata_creator->ProcessSubmitsInParallel(
             m_dive_capture_data.GetPm4CaptureData().GetSubmits(),
-            m_dive_capture_data.GetPm4CaptureData().GetMemoryManager()))
+            m_dive_capture_data.GetPm4CaptureData().GetMemoryManager(), GetNumParseThreads()))
     {
         return false;
     }
@@ -140,19 +183,51 @@ bool DataCore::CreateDiveMetaData()
 //--------------------------------------------------------------------------------------------------
 bool DataCore::CreatePm4MetaData()
 {
-    auto metadata_creator = CaptureMetadataCreator::Create(m_capture_metadata);
+    auto metadata_creator = CaptureMetadataCreator::Create(m_capture_metadata, m_shader_cache);
     if (!metadata_creator)
     {
         return false;
     }
-    if (!metadata_creator->ProcessSubmits(m_pm4_capture_data.GetSubmits(),
-                                          m_pm4_capture_data.GetMemoryManager()))
+    if (!metadata_creator->ProcessSubmitsInParallel(m_pm4_capture_data.GetSubmits(),
+                                                    m_pm4_capture_data.GetMemoryManager(),
+                                                    GetNumParseThreads()))
     {
         return false;
     }
     return true;
 }
 
+//--------------------------------------------------------------------------------------------------
+void DataCore::SetNumParseThreads(uint32_t num_threads) { m_num_parse_threads = num_threads; }
+
+//--------------------------------------------------------------------------------------------------
+void DataCore::SetMetadataCacheDirectory(const std::string& directory)
+{
+    m_metadata_cache_directory = directory;
+}
+
+//--------------------------------------------------------------------------------------------------
+void DataCore::SetShaderCacheDirectory(const std::string& directory)
+{
+    m_shader_cache = directory.empty() ? nullptr
+                                       : std::make_shared<ShaderDisassemblyCache>(directory);
+}
+
+//--------------------------------------------------------------------------------------------------
+void DataCore::SetCommandHierarchyChunkCallback(
+    CommandHierarchyCreator::HierarchyChunkCallback callback, std::chrono::milliseconds interval)
+{
+    m_command_hierarchy_chunk_callback = std::move(callback);
+    m_command_hierarchy_chunk_interval = interval;
+}
+
+//--------------------------------------------------------------------------------------------------
+uint32_t DataCore::GetNumParseThreads() const
+{
+    if (m_num_parse_threads != 0) return m_num_parse_threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
 //--------------------------------------------------------------------------------------------------
 bool DataCore::ParseDiveCaptureData()
 {
@@ -161,16 +236,33 @@ bool DataCore::ParseDiveCaptureData()
         m_progress_tracker->sendMessage("Processing command buffers...");
     }
 
-    if (!CreateDiveMetaData())
+    // The capture itself is the last of its files
+    std::string cache_file_name;
+    std::optional<uint64_t> capture_hash;
+    if (!m_metadata_cache_directory.empty() && !m_capture_file_names.empty())
     {
-        return false;
+        cache_file_name = CaptureMetadataCache::GetCacheFileName(m_metadata_cache_directory,
+                                                                 m_capture_file_names.back());
+        capture_hash = CaptureMetadataCache::HashFiles(m_capture_file_names);
+        if (capture_hash &&
+            CaptureMetadataCache::Load(cache_file_name, *capture_hash,
+                                       m_dive_capture_data.GetPm4CaptureData().GetMemoryManager(),
+                                       m_capture_metadata, m_shader_cache))
+        {
+            return true;
+        }
     }
 
-    if (!CreateDiveCommandHierarchy())
+    if (!CreateDiveMetaDataAndCommandHierarchy())
     {
         return false;
     }
 
+    // The cache only speeds up parsing the capture again, so failing to write it is not an error
+    if (capture_hash)
+    {
+        CaptureMetadataCache::Save(cache_file_name, *capture_hash, m_capture_metadata);
+    }
     return true;
 }
 
@@ -182,16 +274,33 @@ bool DataCore::ParsePm4CaptureData()
         m_progress_tracker->sendMessage("Processing command buffers...");
     }
 
-    if (!CreatePm4MetaData())
+    // The capture itself is the last of its files
+    std::string cache_file_name;
+    std::optional<uint64_t> capture_hash;
+    if (!m_metadata_cache_directory.empty() && !m_capture_file_names.empty())
     {
-        return false;
+        cache_file_name = CaptureMetadataCache::GetCacheFileName(m_metadata_cache_directory,
+                                                                 m_capture_file_names.back());
+        capture_hash = CaptureMetadataCache::HashFiles(m_capture_file_names);
+        if (capture_hash &&
+            CaptureMetadataCache::Load(cache_file_name, *capture_hash,
+                                       m_pm4_capture_data.GetMemoryManager(), m_capture_metadata,
+                                       m_shader_cache))
+        {
+            return true;
+        }
     }
 
-    if (!CreatePm4CommandHierarchy())
+    if (!CreatePm4MetaDataAndCommandHierarchy())
     {
         return false;
     }
 
+    // The cache only speeds up parsing the capture again, so failing to write it is not an error
+    if (capture_hash)
+    {
+        CaptureMetadataCache::Save(cache_file_name, *capture_hash, m_capture_metadata);
+    }
     return true;
 }
 
@@ -236,13 +345,15 @@ const CaptureMetadata& DataCore::GetCaptureMetadata() const { return m_capture_m
 // CaptureMetadataCreator
 // =================================================================================================
 std::unique_ptr<CaptureMetadataCreator> CaptureMetadataCreator::Create(
-    CaptureMetadata& capture_metadata)
+    CaptureMetadata& capture_metadata, std::shared_ptr<const ShaderDisassemblyCache> shader_cache)
 {
-    return std::unique_ptr<CaptureMetadataCreator>(new CaptureMetadataCreator(capture_metadata));
+    return std::unique_ptr<CaptureMetadataCreator>(
+        new CaptureMetadataCreator(capture_metadata, std::move(shader_cache)));
 }
 
-CaptureMetadataCreator::CaptureMetadataCreator(CaptureMetadata& capture_metadata)
-    : m_capture_metadata(capture_metadata)
+CaptureMetadataCreator::CaptureMetadataCreator(
+    CaptureMetadata& capture_metadata, std::shared_ptr<const ShaderDisassemblyCache> shader_cache)
+    : m_shader_cache(std::move(shader_cache)), m_capture_metadata(capture_metadata)
 {
     m_capture_metadata.m_num_pm4_packets = 0;
 }
@@ -250,6 +361,155 @@ CaptureMetadataCreator::CaptureMetadataCreator(CaptureMetadata& capture_metadata
 //--------------------------------------------------------------------------------------------------
 CaptureMetadataCreator::~CaptureMetadataCreator() {}
 
+//--------------------------------------------------------------------------------------------------
+bool CaptureMetadataCreator::ProcessSubmitsInParallel(const DiveVector<SubmitInfo>& submits,
+                                                      const IMemoryManager& mem_manager,
+                                                      uint32_t num_threads,
+                                                      EmulateCallbacksBase* serial_callbacks)
+{
+    // Use several chunks per thread, so that threads which finish early can pick up the slack
+    constexpr uint32_t kChunksPerThread = 4;
+    uint32_t num_submits = static_cast<uint32_t>(submits.size());
+    uint32_t num_chunks = std::min(num_submits, num_threads * kChunksPerThread);
+    if (num_threads <= 1 || num_chunks <= 1)
+    {
+        if (serial_callbacks == nullptr) return ProcessSubmits(submits, mem_manager);
+
+        // The composite is heap-allocated, since its (unused) state tracker is large
+        auto callbacks = std::make_unique<EmulateCallbacksComposite>();
+        callbacks->AddCallbacks(*this);
+        callbacks->AddCallbacks(*serial_callbacks);
+        return callbacks->ProcessSubmits(submits, mem_manager);
+    }
+
+    // The emulation state is reset at the start of each submit, so each chunk can be processed
+    // independently into its own metadata. Shaders are only de-duplicated within a chunk, and are
+    // de-duplicated across chunks when merging
+    std::vector<std::unique_ptr<CaptureMetadata>> chunk_metadata(num_chunks);
+    std::vector<uint8_t> chunk_results(num_chunks, 0);
+    std::vector<std::atomic<bool>> chunk_claimed(num_chunks);
+    auto chunk_begin = [&](uint32_t chunk) {
+        return static_cast<uint32_t>(uint64_t(num_submits) * chunk / num_chunks);
+    };
+    auto create_chunk_creator = [&](uint32_t chunk) {
+        chunk_metadata[chunk] = std::make_unique<CaptureMetadata>();
+        return CaptureMetadataCreator::Create(*chunk_metadata[chunk]);
+    };
+
+    // The chunks are claimed from the end, away from the calling thread when it walks the submits
+    // in order for serial_callbacks
+    auto process_chunks = [&]() {
+        for (uint32_t chunk = num_chunks; chunk-- > 0;)
+        {
+            if (chunk_claimed[chunk].exchange(true)) continue;
+            auto chunk_creator = create_chunk_creator(chunk);
+            bool result = true;
+            for (uint32_t submit_index = chunk_begin(chunk);
+                 result && submit_index < chunk_begin(chunk + 1); ++submit_index)
+            {
+                result = chunk_creator->ProcessSubmit(submit_index, submits[submit_index],
+                                                      mem_manager);
+            }
+            chunk_results[chunk] = result;
+        }
+    };
+
+    // serial_callbacks are given every submit, in order. The chunks that no other thread has
+    // claimed by the time the walk reaches them share the walk
+    auto process_serial_callbacks = [&]() {
+        for (uint32_t chunk = 0; chunk < num_chunks; ++chunk)
+        {
+            std::unique_ptr<CaptureMetadataCreator> chunk_creator;
+            std::unique_ptr<EmulateCallbacksComposite> composite;
+            EmulateCallbacksBase* callbacks = serial_callbacks;
+            if (!chunk_claimed[chunk].exchange(true))
+            {
+                chunk_creator = create_chunk_creator(chunk);
+                composite = std::make_unique<EmulateCallbacksComposite>();
+                composite->AddCallbacks(*chunk_creator);
+                composite->AddCallbacks(*serial_callbacks);
+                callbacks = composite.get();
+            }
+            bool result = true;
+            for (uint32_t submit_index = chunk_begin(chunk);
+                 result && submit_index < chunk_begin(chunk + 1); ++submit_index)
+            {
+                result = callbacks->ProcessSubmit(submit_index, submits[submit_index], mem_manager);
+            }
+            if (chunk_creator)
+            {
+                chunk_results[chunk] = result;
+            }
+            if (!result) return false;
+        }
+        return true;
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < num_threads; ++i)
+    {
+        threads.emplace_back(process_chunks);
+    }
+    bool serial_result = true;
+    if (serial_callbacks != nullptr)
+    {
+        serial_result = process_serial_callbacks();
+    }
+    else
+    {
+        process_chunks();
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    size_t num_events = m_capture_metadata.m_event_info.size();
+    for (const auto& metadata : chunk_metadata)
+    {
+        num_events += metadata->m_event_info.size();
+    }
+    m_capture_metadata.m_event_info.reserve(num_events);
+
+    // Stop at the first chunk that failed, which leaves the metadata in the same state as when
+    // ProcessSubmits() fails on that submit
+    for (uint32_t chunk = 0; chunk < num_chunks; ++chunk)
+    {
+        MergeChunkMetadata(mem_manager, *chunk_metadata[chunk]);
+        if (!chunk_results[chunk]) return false;
+    }
+    return serial_result;
+}
+
+//--------------------------------------------------------------------------------------------------
+void CaptureMetadataCreator::MergeChunkMetadata(const IMemoryManager& mem_manager,
+                                                CaptureMetadata& chunk_metadata)
+{
+    m_capture_metadata.m_num_pm4_packets += chunk_metadata.m_num_pm4_packets;
+    m_capture_metadata.m_event_state.Append(chunk_metadata.m_event_state);
+
+    // Remap the chunk's shader indices. Going through the references in event order visits the
+    // shaders in the same order as HandleShaders() would have, so new shaders get the same index
+    std::vector<uint32_t> shader_indices(chunk_metadata.m_shaders.size(), UINT32_MAX);
+    for (EventInfo& chunk_event_info : chunk_metadata.m_event_info)
+    {
+        m_capture_metadata.m_event_info.push_back(std::move(chunk_event_info));
+        EventInfo& event_info = m_capture_metadata.m_event_info.back();
+        for (ShaderReference& reference : event_info.m_shader_references)
+        {
+            uint32_t& shader_index = shader_indices[reference.m_shader_index];
+            if (shader_index == UINT32_MAX)
+            {
+                const Disassembly& shader = chunk_metadata.m_shaders[reference.m_shader_index];
+                shader_index = GetShaderIndex(mem_manager, event_info.m_submit_index,
+                                              shader.GetShaderAddr(), shader.GetCode(),
+                                              &event_info.m_metadata_log);
+            }
+            reference.m_shader_index = shader_index;
+        }
+    }
+}
+
 //--------------------------------------------------------------------------------------------------
 void CaptureMetadataCreator::OnSubmitStart(uint32_t submit_index, const SubmitInfo& submit_info)
 {
@@ -278,23 +538,24 @@ bool CaptureMetadataCreator::OnIbEnd(uint32_t submit_index, uint32_t ib_index,
 
 //--------------------------------------------------------------------------------------------------
 bool CaptureMetadataCreator::OnPacket(const IMemoryManager& mem_manager, uint32_t submit_index,
-                                      uint32_t ib_index, uint64_t va_addr, Pm4Header header)
+                                      uint32_t ib_index, uint64_t va_addr,
+                                      const Pm4Packet& packet)
 {
     m_capture_metadata.m_num_pm4_packets++;
-    if (!EmulateCallbacksBase::OnPacket(mem_manager, submit_index, ib_index, va_addr, header))
+    if (!EmulateCallbacksBase::OnPacket(mem_manager, submit_index, ib_index, va_addr, packet))
         return false;
+    Pm4Header header = packet.GetHeader();
 
     if (header.type != 7) return true;
 
     Pm4Type7Header* type7_header = (Pm4Type7Header*)&header;
 
-    if (type7_header->opcode == CP_SET_MARKER)
+    if (type7_header->opcode == CP_SET_MARKER && packet.As<PM4_CP_SET_MARKER>() != nullptr)
     {
-        PM4_CP_SET_MARKER packet{};
-        DIVE_VERIFY(mem_manager.RetrieveMemoryData(&packet, submit_index, va_addr, sizeof(packet)));
+        const PM4_CP_SET_MARKER& marker_packet = *packet.As<PM4_CP_SET_MARKER>();
         // as mentioned in adreno_pm4.xml, only b0-b3 are considered when b8 is not set
-        DIVE_ASSERT((packet.u32All0 & 0x100) == 0);
-        a6xx_marker marker = static_cast<a6xx_marker>(packet.u32All0 & 0xf);
+        DIVE_ASSERT((marker_packet.u32All0 & 0x100) == 0);
+        a6xx_marker marker = static_cast<a6xx_marker>(marker_packet.u32All0 & 0xf);
 
         // TODO(wangra): find a way to remove the duplicatation in CommandHierarchyCreator::OnPacket
         switch (marker)
@@ -417,55 +678,73 @@ bool CaptureMetadataCreator::HandleShaders(const IMemoryManager& mem_manager, ui
             // TODO(wangra): need to investigate why `addr` could be 0 here
             if (is_valid_shader && (addr != UINT64_MAX) && (addr != 0))
             {
-                // Check if we've already seen a shader at this address, in which case we just need
-                // to reference the existing shader.
-                if (m_shader_addrs.find(addr) != m_shader_addrs.end())
+                uint32_t shader_index = GetShaderIndex(mem_manager, submit_index, addr,
+                                                       std::nullopt,
+                                                       &cur_event_info.m_metadata_log);
+
+                // Check if this event already has a reference to this shader, in which case we
+                // just add to the existing reference's enable mask.
+                bool found = false;
+                for (auto& reference : cur_event_info.m_shader_references)
                 {
-                    uint32_t shader_index = m_shader_addrs[addr];
+                    if (reference.m_shader_index == shader_index)
                     {
-                        // Check if this event already has a reference to this shader, in which case
-                        // we just add to the existing reference's enable mask.
-                        bool found = false;
-                        for (auto& reference : cur_event_info.m_shader_references)
-                        {
-                            if (reference.m_shader_index == shader_index)
-                            {
-                                reference.m_enable_mask |= enable_mask;
-                                found = true;
-                            }
-                        }
-                        if (found) continue;
+                        reference.m_enable_mask |= enable_mask;
+                        found = true;
                     }
-                    ShaderReference reference;
-                    reference.m_shader_index = shader_index;
-                    reference.m_stage = (ShaderStage)shader;
-                    reference.m_enable_mask = enable_mask;
-                    cur_event_info.m_shader_references.push_back(reference);
-                }
-                else
-                {
-                    // We haven't seen this shader address before, so we need to create the shader
-                    // info.
-                    uint32_t shader_index =
-                        static_cast<uint32_t>(m_capture_metadata.m_shaders.size());
-
-                    m_capture_metadata.m_shaders.emplace_back(mem_manager, submit_index, addr,
-                                                              &cur_event_info.m_metadata_log);
-                    m_shader_addrs.insert(std::make_pair(addr, shader_index));
-
-                    // Add the shader index to the EventInfo
-                    ShaderReference reference;
-                    reference.m_shader_index = m_shader_addrs[addr];
-                    reference.m_stage = (ShaderStage)shader;
-                    reference.m_enable_mask = enable_mask;
-                    cur_event_info.m_shader_references.push_back(reference);
                 }
+                if (found) continue;
+
+                // Add the shader index to the EventInfo
+                ShaderReference reference;
+                reference.m_shader_index = shader_index;
+                reference.m_stage = (ShaderStage)shader;
+                reference.m_enable_mask = enable_mask;
+                cur_event_info.m_shader_references.push_back(reference);
             }
         }
     }
     return true;
 }
 
+//--------------------------------------------------------------------------------------------------
+uint32_t CaptureMetadataCreator::GetShaderIndex(const IMemoryManager& mem_manager,
+                                                uint32_t submit_index, uint64_t addr,
+                                                std::optional<ShaderCode> code, ILog* log)
+{
+    auto addr_it = m_shader_addrs.find(addr);
+    if (addr_it != m_shader_addrs.end())
+    {
+        return addr_it->second;
+    }
+
+    if (!code)
+    {
+        code = GetShaderCode(mem_manager, submit_index, addr);
+    }
+
+    // Each address is a shader of its own, but the copies of a shader at other addresses share the
+    // disassembly of the first copy. Shaders whose memory is missing from the capture can't be
+    // told apart by their code, so they are never shared
+    uint32_t shader_index = static_cast<uint32_t>(m_capture_metadata.m_shaders.size());
+    auto code_it = m_shader_code_hashes.end();
+    if (code->m_size != 0) code_it = m_shader_code_hashes.find(code->m_hash);
+    if (code_it != m_shader_code_hashes.end() &&
+        m_capture_metadata.m_shaders[code_it->second].GetCode().m_size == code->m_size)
+    {
+        m_capture_metadata.m_shaders.emplace_back(submit_index, addr,
+                                                  m_capture_metadata.m_shaders[code_it->second]);
+    }
+    else
+    {
+        m_capture_metadata.m_shaders.emplace_back(mem_manager, submit_index, addr, *code, log,
+                                                  m_shader_cache);
+        if (code->m_size != 0) m_shader_code_hashes.try_emplace(code->m_hash, shader_index);
+    }
+    m_shader_addrs.insert(std::make_pair(addr, shader_index));
+    return shader_index;
+}
+
 //--------------------------------------------------------------------------------------------------
 void CaptureMetadataCreator::FillDrawEventStateInfo(EventStateInfo::Iterator event_state_it)
 {
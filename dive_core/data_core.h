@@ -16,9 +16,13 @@
 */
 
 #pragma once
+#include <chrono>
 #include <deque>
 #include <map>
 #include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "capture_event_info.h"
@@ -29,6 +33,7 @@
 #include "gfxr_capture_data.h"
 #include "pm4_capture_data.h"
 #include "progress_tracker.h"
+#include "shader_disassembly_cache.h"
 
 namespace Dive
 {
@@ -81,6 +86,29 @@ class DataCore
     bool CreateDiveMetaData();
     bool CreatePm4MetaData();
 
+    // Set the number of threads used to create the meta data, with 0 (the default) using one thread
+    // per hardware thread. The meta data of the submits is split across those threads, and created
+    // in the same pass over the submits as the command hierarchy when parsing the capture. The
+    // result is the same regardless of the number of threads
+    void SetNumParseThreads(uint32_t num_threads);
+
+    // Keep the parsed meta data and command hierarchy of each capture in a file in the given
+    // directory, so that parsing the same capture again loads them instead. The directory is
+    // trimmed to CaptureMetadataCache::kDefaultMaxSize, removing the least recently used captures.
+    // Disabled by default, or when the directory is empty
+    void SetMetadataCacheDirectory(const std::string& directory);
+
+    // Keep the disassembly of the shaders in the given directory, which is shared by all the
+    // captures, so that shaders seen before are not disassembled again. Disabled by default, or
+    // when the directory is empty. Applies to the meta data created from then on
+    void SetShaderCacheDirectory(const std::string& directory);
+
+    // Called while a capture with PM4 data is parsed, with the nodes of the submits parsed since
+    // the previous call. See CommandHierarchyCreator::SetHierarchyChunkCallback()
+    void SetCommandHierarchyChunkCallback(
+        CommandHierarchyCreator::HierarchyChunkCallback callback,
+        std::chrono::milliseconds interval = std::chrono::milliseconds(100));
+
     // Get the dive capture data
     const DiveCaptureData& GetDiveCaptureData() const;
 
@@ -100,9 +128,17 @@ class DataCore
 
  private:
     // Create command hierarchy from the captured data
-    bool CreateDiveCommandHierarchy();
-    bool CreatePm4CommandHierarchy();
     bool CreateGfxrCommandHierarchy();
+
+    // Create both the meta data and the command hierarchy from a single emulation of the submits.
+    // The command hierarchy is created on the calling thread, sharing its walk with the meta data
+    // of the submits that the other parse threads haven't taken
+    bool CreateDiveMetaDataAndCommandHierarchy();
+    bool CreatePm4MetaDataAndCommandHierarchy();
+
+    // Number of threads to use for parsing, with 0 resolved to the hardware thread count
+    uint32_t GetNumParseThreads() const;
+
     // The relatively raw captured dive data (memory & submit blocks)
     DiveCaptureData m_dive_capture_data;
     // The relatively raw captured pm4 data (memory & submit blocks)
@@ -112,6 +148,17 @@ class DataCore
 
     // Metadata for the capture data in m_capture_data
     CaptureMetadata m_capture_metadata;
+
+    uint32_t m_num_parse_threads = 0;
+
+    // Files of the loaded capture, which the metadata cache is keyed on
+    std::vector<std::string> m_capture_file_names;
+    std::string m_metadata_cache_directory;
+
+    std::shared_ptr<const ShaderDisassemblyCache> m_shader_cache;
+
+    CommandHierarchyCreator::HierarchyChunkCallback m_command_hierarchy_chunk_callback;
+    std::chrono::milliseconds m_command_hierarchy_chunk_interval = {};
 };
 
 //--------------------------------------------------------------------------------------------------
@@ -119,7 +166,10 @@ class DataCore
 class CaptureMetadataCreator : public EmulateCallbacksBase
 {
  public:
-    static std::unique_ptr<CaptureMetadataCreator> Create(CaptureMetadata& capture_metadata);
+    // The disassembly of the shaders is looked up in, and added to, shader_cache if it is not null
+    static std::unique_ptr<CaptureMetadataCreator> Create(
+        CaptureMetadata& capture_metadata,
+        std::shared_ptr<const ShaderDisassemblyCache> shader_cache = nullptr);
     ~CaptureMetadataCreator() override;
 
     void OnSubmitStart(uint32_t submit_index, const SubmitInfo& submit_info) override;
@@ -127,6 +177,16 @@ class CaptureMetadataCreator : public EmulateCallbacksBase
 
     const EmulateStateTracker& GetStateTracker() const { return m_state_tracker; }
 
+    // Same as ProcessSubmits(), but the submits are split into chunks which are processed on
+    // num_threads threads. The chunks are merged in submit order, so the resulting metadata is
+    // identical to the one from ProcessSubmits()
+    // Optional: serial_callbacks are given every submit in order on the calling thread, whose
+    // emulation walk is shared with the chunks it processes, so that the submits are only emulated
+    // once. The other threads take the chunks from the end
+    bool ProcessSubmitsInParallel(const DiveVector<SubmitInfo>& submits,
+                                  const IMemoryManager& mem_manager, uint32_t num_threads,
+                                  EmulateCallbacksBase* serial_callbacks = nullptr);
+
     // Callbacks
     bool OnIbStart(uint32_t submit_index, uint32_t ib_index, const IndirectBufferInfo& ib_info,
                    IbType type) override;
@@ -135,13 +195,22 @@ class CaptureMetadataCreator : public EmulateCallbacksBase
                  const IndirectBufferInfo& ib_info) override;
 
     bool OnPacket(const IMemoryManager& mem_manager, uint32_t submit_index, uint32_t ib_index,
-                  uint64_t va_addr, Pm4Header header) override;
+                  uint64_t va_addr, const Pm4Packet& packet) override;
 
  protected:
-    CaptureMetadataCreator(CaptureMetadata& capture_metadata);
+    CaptureMetadataCreator(CaptureMetadata& capture_metadata,
+                           std::shared_ptr<const ShaderDisassemblyCache> shader_cache);
 
  private:
     bool HandleShaders(const IMemoryManager& mem_manager, uint32_t submit_index, uint32_t opcode);
+
+    // Get the index of the shader at the given address, adding it to the metadata if the address
+    // hasn't been seen before. The code is found from memory if it isn't given
+    uint32_t GetShaderIndex(const IMemoryManager& mem_manager, uint32_t submit_index,
+                            uint64_t addr, std::optional<ShaderCode> code, ILog* log);
+
+    // Append the metadata of a chunk of submits that directly follows the submits processed so far
+    void MergeChunkMetadata(const IMemoryManager& mem_manager, CaptureMetadata& chunk_metadata);
     void FillDrawEventStateInfo(EventStateInfo::Iterator event_state_it);
     void FillResolveOrClearEventStateInfo(EventStateInfo::Iterator event_state_it);
     void FillResolveEventStateInfo(EventStateInfo::Iterator event_state_it);
@@ -158,6 +227,12 @@ class CaptureMetadataCreator : public EmulateCallbacksBase
     // Map from shader address to shader index (in m_capture_metadata.m_shaders)
     std::map<uint64_t, uint32_t> m_shader_addrs;
 
+    // Map from the hash of the code of a shader to the index of its first copy, so that the copies
+    // of a shader at different addresses share its disassembly
+    std::unordered_map<uint64_t, uint32_t> m_shader_code_hashes;
+
+    std::shared_ptr<const ShaderDisassemblyCache> m_shader_cache;
+
     CaptureMetadata& m_capture_metadata;
     RenderModeType m_current_render_mode = RenderModeType::kUnknown;
 };
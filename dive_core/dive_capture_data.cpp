@@ -16,6 +16,8 @@
 
 #include "dive_capture_data.h"
 
+#include <thread>
+
 namespace Dive
 {
 
@@ -23,6 +25,12 @@ namespace Dive
 // DiveCaptureData
 // =================================================================================================
 
+//--------------------------------------------------------------------------------------------------
+DiveCaptureData::DiveCaptureData(ProgressTracker* progress_tracker)
+    : m_progress_tracker(progress_tracker)
+{
+}
+
 //--------------------------------------------------------------------------------------------------
 CaptureData::LoadResult DiveCaptureData::LoadFiles(const std::string& pm4_file_name,
                                                    const std::string& gfxr_file_name)
@@ -31,20 +39,31 @@ CaptureData::LoadResult DiveCaptureData::LoadFiles(const std::string& pm4_file_n
     m_gfxr_capture_data = GfxrCaptureData();
     m_pm4_capture_data = Pm4CaptureData(m_progress_tracker);
 
-    // 1. Load the PM4 capture file
+    // 1. Load the GFXR capture file on its own thread
+    CaptureData::LoadResult gfxr_result = CaptureData::LoadResult::kSuccess;
+    std::thread gfxr_thread([this, &gfxr_file_name, &gfxr_result]() {
+        if (m_progress_tracker)
+        {
+            m_progress_tracker->sendMessage("Loading GFXR capture file...");
+        }
+        gfxr_result = m_gfxr_capture_data.LoadCaptureFile(gfxr_file_name);
+    });
+
+    // 2. Load the PM4 capture file on this thread
+    if (m_progress_tracker)
+    {
+        m_progress_tracker->sendMessage("Loading PM4 capture file...");
+    }
     CaptureData::LoadResult pm4_result = m_pm4_capture_data.LoadCaptureFile(pm4_file_name);
+    gfxr_thread.join();
+
+    // If either file fails, return its error code, reporting the PM4 error if both fail
     if (pm4_result != CaptureData::LoadResult::kSuccess)
     {
-        // If the first file fails, stop and return its error code
         return pm4_result;
     }
-
-    // 2. Load the GFXR capture file
-    CaptureData::LoadResult gfxr_result = m_gfxr_capture_data.LoadCaptureFile(gfxr_file_name);
     if (gfxr_result != CaptureData::LoadResult::kSuccess)
     {
-        // If the second file fails, you might want to clean up the first one if necessary
-        // before returning the error.
         return gfxr_result;
     }
 
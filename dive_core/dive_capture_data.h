@@ -27,6 +27,11 @@ class CommandHierarchy;
 class DiveCaptureData
 {
  public:
+    DiveCaptureData() = default;
+    DiveCaptureData(ProgressTracker* progress_tracker);
+
+    // Loads the PM4 and GFXR files at the same time, on separate threads. They are independent
+    // until the command hierarchy correlates them
     CaptureData::LoadResult LoadFiles(const std::string& pm4_file_name,
                                       const std::string& gfxr_file_name);
     const Pm4CaptureData& GetPm4CaptureData() const;
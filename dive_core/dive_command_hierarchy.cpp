@@ -34,7 +34,8 @@ DiveCommandHierarchyCreator::DiveCommandHierarchyCreator(CommandHierarchy& comma
 bool DiveCommandHierarchyCreator::CreateTrees(Dive::CommandHierarchy& command_hierarchy,
                                               DiveCaptureData& dive_capture_data,
                                               bool flatten_chain_nodes,
-                                              std::optional<uint64_t> reserve_size)
+                                              std::optional<uint64_t> reserve_size,
+                                              const ProcessSubmitsFunction& process_submits)
 {
     auto pm4_command_hierarchy_creator =
         CommandHierarchyCreator::Create(m_command_hierarchy, dive_capture_data.GetPm4CaptureData());
@@ -45,14 +46,17 @@ bool DiveCommandHierarchyCreator::CreateTrees(Dive::CommandHierarchy& command_hi
     {
         return false;
     }
+    pm4_command_hierarchy_creator->SetHierarchyChunkCallback(m_hierarchy_chunk_callback,
+                                                             m_hierarchy_chunk_interval);
 
     pm4_command_hierarchy_creator->CreateTrees(flatten_chain_nodes,
                                                /*createTopologies=*/false, reserve_size);
     gfxr_command_hierarchy_creator->CreateTrees(/*used_in_mixed_command_hierarchy=*/true);
 
-    bool result = pm4_command_hierarchy_creator->ProcessSubmits(
-        dive_capture_data.GetPm4CaptureData().GetSubmits(),
-        dive_capture_data.GetPm4CaptureData().GetMemoryManager());
+    bool result = process_submits ? process_submits(*pm4_command_hierarchy_creator)
+                                  : pm4_command_hierarchy_creator->ProcessSubmits(
+                                        dive_capture_data.GetPm4CaptureData().GetSubmits(),
+                                        dive_capture_data.GetPm4CaptureData().GetMemoryManager());
     if (!result)
     {
         return false;
@@ -71,51 +75,49 @@ bool DiveCommandHierarchyCreator::CreateTrees(Dive::CommandHierarchy& command_hi
     return true;
 }
 
+//--------------------------------------------------------------------------------------------------
+void DiveCommandHierarchyCreator::SetHierarchyChunkCallback(
+    CommandHierarchyCreator::HierarchyChunkCallback callback, std::chrono::milliseconds interval)
+{
+    m_hierarchy_chunk_callback = std::move(callback);
+    m_hierarchy_chunk_interval = interval;
+}
+
 //--------------------------------------------------------------------------------------------------
 void DiveCommandHierarchyCreator::CreateTopologies(
     CommandHierarchyCreator& pm4_command_hierarchy_creator,
     GfxrVulkanCommandHierarchyCreator& gfxr_command_hierarchy_creator)
 {
-    uint64_t total_num_children[CommandHierarchy::kTopologyTypeCount] = {};
-    uint64_t total_num_shared_children[CommandHierarchy::kTopologyTypeCount] = {};
+    pm4_command_hierarchy_creator.GroupNodeChildren();
 
     // Convert the m_node_children temporary structure into CommandHierarchy's topologies
     for (uint32_t topology = 0; topology < CommandHierarchy::kTopologyTypeCount; ++topology)
     {
-        size_t num_pm4_nodes = pm4_command_hierarchy_creator.GetNodeChildren(topology, 0).size();
+        const NodeChildrenLists& pm4_children =
+            pm4_command_hierarchy_creator.GetNodeChildren(topology, 0);
+        const NodeChildrenLists& pm4_shared_children =
+            pm4_command_hierarchy_creator.GetNodeChildren(topology, 1);
+        size_t num_pm4_nodes = pm4_children.GetNumNodes();
         size_t total_num_nodes =
             num_pm4_nodes + gfxr_command_hierarchy_creator.GetNodeChildren(topology).size();
 
         SharedNodeTopology& cur_topology = m_command_hierarchy.m_topology[topology];
         cur_topology.SetNumNodes(total_num_nodes);
 
-        // Optional loop: Pre-reserve to prevent the resize() from allocating memory later
-        // Note: The number of children for some of the topologies have been determined
-        // earlier in this function already
-        if (total_num_children[topology] == 0 && total_num_shared_children[topology] == 0)
-        {
-            for (uint64_t node_index = 0; node_index < num_pm4_nodes; ++node_index)
-            {
-                total_num_children[topology] +=
-                    pm4_command_hierarchy_creator.GetNodeChildren(topology, 0)[node_index].size();
-                total_num_shared_children[topology] +=
-                    pm4_command_hierarchy_creator.GetNodeChildren(topology, 1)[node_index].size();
-            }
-        }
-        cur_topology.m_children_list.reserve(total_num_children[topology]);
-        cur_topology.m_shared_children_indices.reserve(total_num_shared_children[topology]);
+        // Pre-reserve to prevent the resize() from allocating memory later
+        cur_topology.m_children_list.reserve(pm4_children.GetTotalNumChildren());
+        cur_topology.m_shared_children_indices.reserve(pm4_shared_children.GetTotalNumChildren());
 
-        DiveVector<uint64_t> combined_root_children =
-            pm4_command_hierarchy_creator.GetNodeChildren(topology, 0)[0];
+        DiveVector<uint64_t> combined_root_children;
+        for (uint64_t i = 0; i < pm4_children.GetNumChildren(0); ++i)
+            combined_root_children.push_back(pm4_children.GetChildren(0)[i]);
 
         for (uint64_t node_index = 1; node_index < num_pm4_nodes; ++node_index)
         {
-            DIVE_ASSERT(pm4_command_hierarchy_creator.GetNodeChildren(topology, 0).size() ==
-                        pm4_command_hierarchy_creator.GetNodeChildren(topology, 1).size());
-            cur_topology.AddChildren(
-                node_index, pm4_command_hierarchy_creator.GetNodeChildren(topology, 0)[node_index]);
-            cur_topology.AddSharedChildren(
-                node_index, pm4_command_hierarchy_creator.GetNodeChildren(topology, 1)[node_index]);
+            cur_topology.AddChildren(node_index, pm4_children.GetChildren(node_index),
+                                     pm4_children.GetNumChildren(node_index));
+            cur_topology.AddSharedChildren(node_index, pm4_shared_children.GetChildren(node_index),
+                                           pm4_shared_children.GetNumChildren(node_index));
         }
 
         cur_topology.m_start_shared_child =
@@ -20,6 +20,8 @@
 // UI.
 // =====================================================================================================================
 
+#include <functional>
+
 #include "dive_core/command_hierarchy.h"
 #include "dive_core/common/emulate_pm4.h"
 #include "dive_core/dive_capture_data.h"
@@ -42,12 +44,22 @@ class DiveCommandHierarchyCreator
     // deep tree of chain nodes when a capture chains together tons of IBs.
     // Optional: Passing a reserve_size will allow the creator to pre-reserve the memory needed and
     // potentially speed up the creation
+    // Optional: Passing process_submits replaces the emulation walk that creates the pm4 nodes, so
+    // that it can be shared with other consumers of the submits. It is given the callbacks which
+    // create the pm4 nodes, and must pass every submit to them in order
+    using ProcessSubmitsFunction = std::function<bool(EmulateCallbacksBase& callbacks)>;
     bool CreateTrees(Dive::CommandHierarchy& command_hierarchy, DiveCaptureData& dive_capture_data,
-                     bool flatten_chain_nodes, std::optional<uint64_t> reserve_size);
+                     bool flatten_chain_nodes, std::optional<uint64_t> reserve_size,
+                     const ProcessSubmitsFunction& process_submits = nullptr);
 
     void CreateTopologies(CommandHierarchyCreator& pm4_command_hierarchy_creator,
                           GfxrVulkanCommandHierarchyCreator& gfxr_command_hierarchy_creator);
 
+    // Called with the pm4 nodes of the submits processed so far. See
+    // CommandHierarchyCreator::SetHierarchyChunkCallback()
+    void SetHierarchyChunkCallback(CommandHierarchyCreator::HierarchyChunkCallback callback,
+                                   std::chrono::milliseconds interval);
+
  private:
     friend class CommandHierarchyCreator;
     friend class GfxrVulkanCommandHierarchyCreator;
@@ -57,6 +69,9 @@ class DiveCommandHierarchyCreator
     bool m_flatten_chain_nodes = false;
 
     uint32_t m_num_events = 0;
+
+    CommandHierarchyCreator::HierarchyChunkCallback m_hierarchy_chunk_callback;
+    std::chrono::milliseconds m_hierarchy_chunk_interval = {};
 };
 
 }  // namespace Dive
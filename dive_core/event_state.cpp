@@ -458,6 +458,174 @@ EventStateInfo::Iterator EventStateInfoT<EventStateInfo_CONFIG>::Add()
     return find(id);
 }
 
+template <>
+void EventStateInfoT<EventStateInfo_CONFIG>::Append(const EventStateInfo& other)
+{
+    if (other.m_size == 0) return;
+    Reserve(m_size + other.m_size);
+
+    // Each field is stored as a separate array, so each can be copied with a single memcpy
+    memcpy(reinterpret_cast<uint8_t*>(TopologyPtr()) + kTopologySize * m_size,
+           other.TopologyPtr(), kTopologySize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(PrimRestartEnabledPtr()) + kPrimRestartEnabledSize * m_size,
+           other.PrimRestartEnabledPtr(), kPrimRestartEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(PatchControlPointsPtr()) + kPatchControlPointsSize * m_size,
+           other.PatchControlPointsPtr(), kPatchControlPointsSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(ViewportPtr()) + kViewportSize * m_size,
+           other.ViewportPtr(), kViewportSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(ScissorPtr()) + kScissorSize * m_size,
+           other.ScissorPtr(), kScissorSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(DepthClampEnabledPtr()) + kDepthClampEnabledSize * m_size,
+           other.DepthClampEnabledPtr(), kDepthClampEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(RasterizerDiscardEnabledPtr()) +
+               kRasterizerDiscardEnabledSize * m_size,
+           other.RasterizerDiscardEnabledPtr(), kRasterizerDiscardEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(PolygonModePtr()) + kPolygonModeSize * m_size,
+           other.PolygonModePtr(), kPolygonModeSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(CullModePtr()) + kCullModeSize * m_size,
+           other.CullModePtr(), kCullModeSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(FrontFacePtr()) + kFrontFaceSize * m_size,
+           other.FrontFacePtr(), kFrontFaceSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(DepthBiasEnabledPtr()) + kDepthBiasEnabledSize * m_size,
+           other.DepthBiasEnabledPtr(), kDepthBiasEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(DepthBiasConstantFactorPtr()) +
+               kDepthBiasConstantFactorSize * m_size,
+           other.DepthBiasConstantFactorPtr(), kDepthBiasConstantFactorSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(DepthBiasClampPtr()) + kDepthBiasClampSize * m_size,
+           other.DepthBiasClampPtr(), kDepthBiasClampSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(DepthBiasSlopeFactorPtr()) +
+               kDepthBiasSlopeFactorSize * m_size,
+           other.DepthBiasSlopeFactorPtr(), kDepthBiasSlopeFactorSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(LineWidthPtr()) + kLineWidthSize * m_size,
+           other.LineWidthPtr(), kLineWidthSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(RasterizationSamplesPtr()) +
+               kRasterizationSamplesSize * m_size,
+           other.RasterizationSamplesPtr(), kRasterizationSamplesSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(SampleShadingEnabledPtr()) +
+               kSampleShadingEnabledSize * m_size,
+           other.SampleShadingEnabledPtr(), kSampleShadingEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(MinSampleShadingPtr()) + kMinSampleShadingSize * m_size,
+           other.MinSampleShadingPtr(), kMinSampleShadingSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(SampleMaskPtr()) + kSampleMaskSize * m_size,
+           other.SampleMaskPtr(), kSampleMaskSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(AlphaToCoverageEnabledPtr()) +
+               kAlphaToCoverageEnabledSize * m_size,
+           other.AlphaToCoverageEnabledPtr(), kAlphaToCoverageEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(DepthTestEnabledPtr()) + kDepthTestEnabledSize * m_size,
+           other.DepthTestEnabledPtr(), kDepthTestEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(DepthWriteEnabledPtr()) + kDepthWriteEnabledSize * m_size,
+           other.DepthWriteEnabledPtr(), kDepthWriteEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(DepthCompareOpPtr()) + kDepthCompareOpSize * m_size,
+           other.DepthCompareOpPtr(), kDepthCompareOpSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(DepthBoundsTestEnabledPtr()) +
+               kDepthBoundsTestEnabledSize * m_size,
+           other.DepthBoundsTestEnabledPtr(), kDepthBoundsTestEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(MinDepthBoundsPtr()) + kMinDepthBoundsSize * m_size,
+           other.MinDepthBoundsPtr(), kMinDepthBoundsSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(MaxDepthBoundsPtr()) + kMaxDepthBoundsSize * m_size,
+           other.MaxDepthBoundsPtr(), kMaxDepthBoundsSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(StencilTestEnabledPtr()) + kStencilTestEnabledSize * m_size,
+           other.StencilTestEnabledPtr(), kStencilTestEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(StencilOpStateFrontPtr()) + kStencilOpStateFrontSize * m_size,
+           other.StencilOpStateFrontPtr(), kStencilOpStateFrontSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(StencilOpStateBackPtr()) + kStencilOpStateBackSize * m_size,
+           other.StencilOpStateBackPtr(), kStencilOpStateBackSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(LogicOpEnabledPtr()) + kLogicOpEnabledSize * m_size,
+           other.LogicOpEnabledPtr(), kLogicOpEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(LogicOpPtr()) + kLogicOpSize * m_size,
+           other.LogicOpPtr(), kLogicOpSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(AttachmentPtr()) + kAttachmentSize * m_size,
+           other.AttachmentPtr(), kAttachmentSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(BlendConstantPtr()) + kBlendConstantSize * m_size,
+           other.BlendConstantPtr(), kBlendConstantSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(LRZEnabledPtr()) + kLRZEnabledSize * m_size,
+           other.LRZEnabledPtr(), kLRZEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(LRZWritePtr()) + kLRZWriteSize * m_size,
+           other.LRZWritePtr(), kLRZWriteSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(LRZDirStatusPtr()) + kLRZDirStatusSize * m_size,
+           other.LRZDirStatusPtr(), kLRZDirStatusSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(LRZDirWritePtr()) + kLRZDirWriteSize * m_size,
+           other.LRZDirWritePtr(), kLRZDirWriteSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(ZTestModePtr()) + kZTestModeSize * m_size,
+           other.ZTestModePtr(), kZTestModeSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(BinWPtr()) + kBinWSize * m_size,
+           other.BinWPtr(), kBinWSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(BinHPtr()) + kBinHSize * m_size,
+           other.BinHPtr(), kBinHSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(WindowScissorTLXPtr()) + kWindowScissorTLXSize * m_size,
+           other.WindowScissorTLXPtr(), kWindowScissorTLXSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(WindowScissorTLYPtr()) + kWindowScissorTLYSize * m_size,
+           other.WindowScissorTLYPtr(), kWindowScissorTLYSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(WindowScissorBRXPtr()) + kWindowScissorBRXSize * m_size,
+           other.WindowScissorBRXPtr(), kWindowScissorBRXSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(WindowScissorBRYPtr()) + kWindowScissorBRYSize * m_size,
+           other.WindowScissorBRYPtr(), kWindowScissorBRYSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(RenderModePtr()) + kRenderModeSize * m_size,
+           other.RenderModePtr(), kRenderModeSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(BuffersLocationPtr()) + kBuffersLocationSize * m_size,
+           other.BuffersLocationPtr(), kBuffersLocationSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(ThreadSizePtr()) + kThreadSizeSize * m_size,
+           other.ThreadSizePtr(), kThreadSizeSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(EnableAllHelperLanesPtr()) +
+               kEnableAllHelperLanesSize * m_size,
+           other.EnableAllHelperLanesPtr(), kEnableAllHelperLanesSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(EnablePartialHelperLanesPtr()) +
+               kEnablePartialHelperLanesSize * m_size,
+           other.EnablePartialHelperLanesPtr(), kEnablePartialHelperLanesSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(UBWCEnabledPtr()) + kUBWCEnabledSize * m_size,
+           other.UBWCEnabledPtr(), kUBWCEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(UBWCLosslessEnabledPtr()) + kUBWCLosslessEnabledSize * m_size,
+           other.UBWCLosslessEnabledPtr(), kUBWCLosslessEnabledSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(UBWCEnabledOnDSPtr()) + kUBWCEnabledOnDSSize * m_size,
+           other.UBWCEnabledOnDSPtr(), kUBWCEnabledOnDSSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(UBWCLosslessEnabledOnDSPtr()) +
+               kUBWCLosslessEnabledOnDSSize * m_size,
+           other.UBWCLosslessEnabledOnDSPtr(), kUBWCLosslessEnabledOnDSSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(ResolveScissorPtr()) + kResolveScissorSize * m_size,
+           other.ResolveScissorPtr(), kResolveScissorSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(ResolveBaseGmemPtr()) + kResolveBaseGmemSize * m_size,
+           other.ResolveBaseGmemPtr(), kResolveBaseGmemSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(ResolveBaseSysmemPtr()) + kResolveBaseSysmemSize * m_size,
+           other.ResolveBaseSysmemPtr(), kResolveBaseSysmemSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(ResolveFormatPtr()) + kResolveFormatSize * m_size,
+           other.ResolveFormatPtr(), kResolveFormatSize * other.m_size);
+    memcpy(reinterpret_cast<uint8_t*>(ResolveTileModePtr()) + kResolveTileModeSize * m_size,
+           other.ResolveTileModePtr(), kResolveTileModeSize * other.m_size);
+
+    // The is-set bits are stored per element, so they just need to be shifted past the
+    // existing elements
+    for (size_t bit = 0; bit < other.m_size * kNumFields; ++bit)
+    {
+        if ((other.m_is_set_buffer[bit / 8] & (1 << (bit % 8))) != 0)
+        {
+            size_t dst_bit = m_size * kNumFields + bit;
+            m_is_set_buffer[dst_bit / 8] |= (1 << (dst_bit % 8));
+        }
+    }
+
+    m_size += other.m_size;
+}
+
+template <>
+bool EventStateInfoT<EventStateInfo_CONFIG>::AssignRaw(
+    typename EventStateInfo::Id::basic_type size, typename EventStateInfo::Id::basic_type cap,
+    const void* buffer, size_t buffer_size, const uint8_t* is_set_buffer, size_t is_set_buffer_size)
+{
+    // Start from an empty buffer, so that `Reserve` allocates exactly `cap` elements
+    m_size = 0;
+    m_cap = 0;
+    m_buffer.reset();
+    m_is_set_buffer.clear();
+    Reserve(cap);
+    if (size > cap || m_cap != cap || buffer_size != RawBufferSize()) return false;
+    if (is_set_buffer_size != m_is_set_buffer.size()) return false;
+
+    if (buffer_size != 0) memcpy(m_buffer.get(), buffer, buffer_size);
+    if (is_set_buffer_size != 0) memcpy(m_is_set_buffer.data(), is_set_buffer, is_set_buffer_size);
+    m_size = size;
+    return true;
+}
+
 template <>
 void EventStateInfoRefT<EventStateInfo_CONFIG>::assign(
     const EventStateInfo& other_obj, EventStateInfoRefT<EventStateInfo_CONFIG>::Id other_id) const
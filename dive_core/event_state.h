@@ -8670,9 +8670,24 @@ class EventStateInfoT
     // element. This will re-allocate memory if necessary
     Iterator Add();
 
+    // `Append` adds a copy of every element of `other` after the existing
+    // elements. This will re-allocate memory if necessary
+    void Append(const SOA& other);
+
     // `Clear` resets size to 0, but keeps the allocated memory.
     inline void Clear() { m_size = 0; }
 
+    // Raw access to the memory of all the fields, for serialization. The memory layout depends on
+    // the capacity, so it can only be restored by `AssignRaw` with the same capacity
+    inline const void* RawBuffer() const { return m_buffer.get(); }
+    inline size_t RawBufferSize() const { return m_cap * kElemSize; }
+    inline const std::vector<uint8_t>& RawIsSetBuffer() const { return m_is_set_buffer; }
+
+    // `AssignRaw` replaces all elements with the contents of buffers obtained from `RawBuffer` and
+    // `RawIsSetBuffer`. Returns false if the buffer sizes do not match `cap`
+    bool AssignRaw(typename Id::basic_type size, typename Id::basic_type cap, const void* buffer,
+                   size_t buffer_size, const uint8_t* is_set_buffer, size_t is_set_buffer_size);
+
  protected:
     template <typename CONFIG_>
     friend class EventStateInfoRefT;
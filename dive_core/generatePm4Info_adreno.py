@@ -45,6 +45,7 @@ def outputH(pm4_info_file):
 
 #include <stdint.h>
 #include <string.h>
+#include <span>
 #include "dive_core/stl_replacement.h"
 
 enum ValueType
@@ -78,7 +79,7 @@ constexpr uint32_t kInvalidRegOffset = UINT32_MAX;
 // be careful when increase this value
 // this is used in
 // - RegField::m_gpu_variants, so the unused bits needs to be adjusted
-// - key of g_sRegInfo, the register offset needs at least 16bits, so kGPUVariantsBits cannot be
+// - key of kRegInfos, the register offset needs at least 16bits, so kGPUVariantsBits cannot be
 // larger than 16
 constexpr uint32_t kGPUVariantsBits = 7;
 
@@ -107,7 +108,7 @@ struct RegInfo
     uint32_t    m_bit_width : 6; // high - low, range [0, 63]
     uint32_t    m_radix : 5; // only used when the type is ufixed/fixed, range [0, 31]
     uint32_t : 3;
-    DiveVector<RegField> m_fields;
+    std::span<const RegField> m_fields;
 };
 
 struct PacketField
@@ -128,9 +129,10 @@ struct PacketInfo
     uint32_t    m_max_array_size : 8;
     uint32_t    m_stripe_variant : 8;  // Which variant of the packet this is
     uint32_t : 16;
-    DiveVector<PacketField> m_fields;
+    std::span<const PacketField> m_fields;
 };
 
+// All of the tables are constant-initialized, so this does nothing. Kept for existing callers
 void              Pm4InfoInit();
 const char       *GetOpCodeString(uint32_t op_code);
 const RegInfo    *GetRegInfo(uint32_t reg);
@@ -152,88 +154,293 @@ def outputHeaderCpp(pm4_info_header_file_name, pm4_info_file):
   pm4_info_file.write('#include "%s"\n' % (pm4_info_header_file_name))
   pm4_info_file.writelines('''
 #include <assert.h>
-#include <algorithm>
 #include <cstring>
-#include <map>
-#include <string>
-#include <unordered_map>
-#include <vector>
+#include <iterator>
 #include "dive_core/common/common.h"
 
-static DiveVector<const char*> g_sOpCodeToString;
-static std::unordered_map<uint32_t, RegInfo> g_sRegInfoVariant;
-static DiveVector<RegInfo> g_sRegInfo;
-static std::unordered_map<std::string, uint32_t> g_sRegNameToIndex;
-static DiveVector<DiveVector<const char*>> g_sEnumReflection;
-static DiveVector<PacketInfo> g_sPacketInfo;
-static std::unordered_map<uint32_t, PacketInfo> g_sPacketInfoVariant;
-static std::multimap<uint32_t, PacketInfo> g_sPacketInfoMultiple;
 static GPUVariantType g_sGPU_variant = kGPUVariantNone;
 static uint32_t g_sGPU_id = 0;
 
-std::string GetGPUStr(GPUVariantType variant)
+static const char *GetGPUStr(GPUVariantType variant)
 {
-    std::string s;
     switch(variant)
     {
-    case kA2XX: s = "A2XX"; break;
-    case kA3XX: s = "A3XX"; break;
-    case kA4XX: s = "A4XX"; break;
-    case kA5XX: s = "A5XX"; break;
-    case kA6XX: s = "A6XX"; break;
-    case kA7XX: s = "A7XX"; break;
-    case kA8XX: s = "A8XX"; break;
+    case kA2XX: return "A2XX";
+    case kA3XX: return "A3XX";
+    case kA4XX: return "A4XX";
+    case kA5XX: return "A5XX";
+    case kA6XX: return "A6XX";
+    case kA7XX: return "A7XX";
+    case kA8XX: return "A8XX";
     case kGPUVariantNone:
     default:
         DIVE_ASSERT(false);
-        break;
+        return "";
     }
-    return s;
 }
 
+// The lookup tables below are perfect hashes built by the generator: a key's bucket selects the
+// seed that hashes it to a slot no other key uses, so a lookup is 2 hashes and 1 comparison.
+// Must match hashKey() and hashName() in generatePm4Info_adreno.py
+static constexpr uint32_t HashKey(uint32_t key, uint32_t seed)
+{
+    uint32_t h = key ^ seed;
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+// FNV-1a, continuing from |hash| so that a suffix can be hashed without concatenating it
+static constexpr uint32_t kNameHashBasis = 0x811c9dc5;
+static uint32_t HashName(uint32_t hash, const char *name)
+{
+    for (; *name != '\\0'; ++name)
+    {
+        hash = (hash ^ static_cast<uint8_t>(*name)) * 0x01000193;
+    }
+    return hash;
+}
+
+// Returns the index of the only entry that |key| can be; the caller must check that it matches
+template<size_t kNumBuckets, size_t kNumSlots>
+static uint32_t LookupPerfectHash(uint32_t key, const uint32_t (&seeds)[kNumBuckets],
+                                  const uint16_t (&slots)[kNumSlots])
+{
+    uint32_t seed = seeds[HashKey(key, 0) % kNumBuckets];
+    return slots[HashKey(key, seed) % kNumSlots];
+}
+
+struct RegName
+{
+    const char *m_name;
+    uint32_t    m_offset;
+};
+
+struct PacketInfoEntry
+{
+    uint32_t   m_key;
+    PacketInfo m_info;
+};
 '''
   )
 
 # ---------------------------------------------------------------------------------------
-def outputPm4InfoInitFunc(pm4_info_file, registers_et_root, opcode_dict):
+# Everything parsed from the xml, kept as C++ initializers until the tables are written out
+class Pm4Tables():
+  def __init__(self):
+    self.opcodes = {}               # opcode -> packet name
+    self.reg_fields = []            # RegField initializers
+    self.reg_field_ranges = {}      # tuple of RegField initializers -> index in reg_fields
+    self.reg_infos = {}             # (offset << kGPUVariantsBits) | variant -> RegInfo
+    self.packet_fields = []         # PacketField initializers
+    self.packet_field_ranges = {}   # tuple of PacketField initializers -> index in packet_fields
+    self.packet_infos = {}          # opcode -> PacketInfo
+    self.packet_info_variants = {}  # (opcode << kGPUVariantsBits) | variant -> PacketInfo
+    self.packet_info_multiple = []  # (opcode, PacketInfo) for the 2nd and later packets of an opcode
+
+kGPUVariantsBits = 7
+kGPUVariantStrings = [ 'A2XX', 'A3XX', 'A4XX', 'A5XX', 'A6XX', 'A7XX', 'A8XX' ]
 
-  # Get enum values from the XML element tree, being careful not to have duplicates
-  enum_index_dict = {}
-  enum_list = []
-  parseEnumInfo(enum_index_dict, enum_list, registers_et_root)
+# ---------------------------------------------------------------------------------------
+# Returns the span initializer for a list of field initializers. Registers and packets with the
+# same fields (e.g. the elements of an array) share them
+def addFields(fields, field_ranges, array_name, new_fields):
+  if len(new_fields) == 0:
+    return '{}'
+  key = tuple(new_fields)
+  if key not in field_ranges:
+    field_ranges[key] = len(fields)
+    fields.extend(new_fields)
+  return '{ &%s[%d], %d }' % (array_name, field_ranges[key], len(new_fields))
 
-  pm4_info_file.writelines('''
-static int Pm4InfoInitImpl()
-{
-''')
-  outputOpcodes(pm4_info_file, opcode_dict)
+# ---------------------------------------------------------------------------------------
+# Must match HashKey() and HashName() in the generated code
+def hashKey(key, seed):
+  h = (key ^ seed) & 0xffffffff
+  h ^= h >> 16
+  h = (h * 0x85ebca6b) & 0xffffffff
+  h ^= h >> 13
+  h = (h * 0xc2b2ae35) & 0xffffffff
+  h ^= h >> 16
+  return h
+
+def hashName(name):
+  h = 0x811c9dc5
+  for c in name.encode():
+    h = ((h ^ c) * 0x01000193) & 0xffffffff
+  return h
+
+# ---------------------------------------------------------------------------------------
+# Hash-and-displace: keys are grouped into buckets, and starting from the biggest bucket, each
+# bucket gets the first seed that hashes all of its keys into free slots
+def buildPerfectHash(keys):
+  if len(set(keys)) != len(keys):
+    raise Exception('Perfect hash keys are not unique')
+  if len(keys) > 0xffff:
+    raise Exception('Too many keys for 16-bit perfect hash slots: %d' % len(keys))
+
+  num_buckets = len(keys) // 4 + 1
+  num_slots = len(keys) + len(keys) // 8 + 1
+  buckets = [[] for _ in range(num_buckets)]
+  for index, key in enumerate(keys):
+    buckets[hashKey(key, 0) % num_buckets].append(index)
+
+  seeds = [0] * num_buckets
+  slots = [None] * num_slots
+  for bucket in sorted(range(num_buckets), key=lambda b: len(buckets[b]), reverse=True):
+    if len(buckets[bucket]) == 0:
+      break
+    seed = 1
+    while True:
+      bucket_slots = [hashKey(keys[index], seed) % num_slots for index in buckets[bucket]]
+      if len(set(bucket_slots)) == len(bucket_slots) and \
+         all(slots[slot] is None for slot in bucket_slots):
+        break
+      seed = seed + 1
+    seeds[bucket] = seed
+    for slot, index in zip(bucket_slots, buckets[bucket]):
+      slots[slot] = index
+
+  # Keys that are not in the table can land on an empty slot, so it has to refer to an entry
+  # that the caller then finds does not match
+  slots = [0 if slot is None else slot for slot in slots]
+  return seeds, slots
+
+# ---------------------------------------------------------------------------------------
+def outputIntArray(pm4_info_file, type, name, values, format):
+  pm4_info_file.write('static constexpr %s %s[] = {' % (type, name))
+  for idx, value in enumerate(values):
+    if idx % 12 == 0:
+      pm4_info_file.write('\n   ')
+    pm4_info_file.write(' ' + format % value + ',')
+  pm4_info_file.write('\n};\n')
+
+# ---------------------------------------------------------------------------------------
+def outputPerfectHash(pm4_info_file, name, keys):
+  seeds, slots = buildPerfectHash(keys)
+  outputIntArray(pm4_info_file, 'uint32_t', name + 'Seeds', seeds, '%d')
+  outputIntArray(pm4_info_file, 'uint16_t', name + 'Slots', slots, '%d')
+
+# ---------------------------------------------------------------------------------------
+def outputInitializerArray(pm4_info_file, type, name, initializers):
+  pm4_info_file.write('static constexpr %s %s[] = {\n' % (type, name))
+  for initializer in initializers:
+    pm4_info_file.write('    %s,\n' % initializer)
+  pm4_info_file.write('};\n\n')
+
+# ---------------------------------------------------------------------------------------
+def outputOpcodes(pm4_info_file, tables):
+  max_opcode = max(tables.opcodes)
+  initializers = []
+  for opcode in range(max_opcode+1):
+    if opcode in tables.opcodes:
+      initializers.append('"%s"' % tables.opcodes[opcode])
+    else:
+      initializers.append('nullptr')
+  outputInitializerArray(pm4_info_file, 'const char *', 'kOpCodeToString', initializers)
+
+# ---------------------------------------------------------------------------------------
+def outputRegisters(pm4_info_file, tables):
+  outputInitializerArray(pm4_info_file, 'RegField', 'kRegFields', tables.reg_fields)
+
+  keys = sorted(tables.reg_infos)
+  outputInitializerArray(pm4_info_file, 'RegInfo', 'kRegInfos',
+                         [tables.reg_infos[key][1] for key in keys])
+  outputIntArray(pm4_info_file, 'uint32_t', 'kRegInfoKeys', keys, '0x%x')
+  outputPerfectHash(pm4_info_file, 'kRegInfo', keys)
   pm4_info_file.write('\n')
-  outputRegisterInfo(pm4_info_file, registers_et_root, enum_index_dict)
+
+  # Registers that differ across GPUs are also named with the GPU (e.g. PC_POLYGON_MODE_A7XX),
+  # since the same name can be at a different offset on each of them. Such a name without the GPU
+  # is left out, so that looking it up falls back to the name with the current GPU
+  reg_offsets_by_name = {}
+  variant_offsets_by_name = {}
+  variant_mask = (1 << kGPUVariantsBits) - 1
+  for key in keys:
+    name = tables.reg_infos[key][0]
+    offset = key >> kGPUVariantsBits
+    if (key & variant_mask) == 0:
+      reg_offsets_by_name[name] = offset
+      continue
+    variant_offsets_by_name.setdefault(name, set()).add(offset)
+    for bit, gpu in enumerate(kGPUVariantStrings):
+      if key & (1 << bit):
+        reg_offsets_by_name[name + '_' + gpu] = offset
+  for name, offsets in variant_offsets_by_name.items():
+    if name not in reg_offsets_by_name and len(offsets) == 1:
+      reg_offsets_by_name[name] = offsets.pop()
+
+  names = sorted(reg_offsets_by_name)
+  outputInitializerArray(pm4_info_file, 'RegName', 'kRegNames',
+                         ['{ "%s", 0x%x }' % (name, reg_offsets_by_name[name]) for name in names])
+  outputPerfectHash(pm4_info_file, 'kRegName', [hashName(name) for name in names])
   pm4_info_file.write('\n')
-  outputEnums(pm4_info_file, enum_list)
+
+# ---------------------------------------------------------------------------------------
+def outputEnums(pm4_info_file, enum_list):
+  # enum_list is an array of {string, dict()}, where the key of the dict() is
+  # the integer enum_value
+  for idx, enum_info in enumerate(enum_list):
+    max_enum_value = max(enum_info[1])
+    initializers = []
+    for enum_value in range(max_enum_value+1):
+      if enum_value in enum_info[1]:
+        initializers.append('"%s"' % enum_info[1][enum_value])
+      else:
+        initializers.append('nullptr')
+    pm4_info_file.write('// %s\n' % enum_info[0])
+    outputInitializerArray(pm4_info_file, 'const char *', 'kEnum%d' % idx, initializers)
+
+  outputInitializerArray(pm4_info_file, 'std::span<const char *const>', 'kEnumReflection',
+                         ['kEnum%d' % idx for idx in range(len(enum_list))])
+
+# ---------------------------------------------------------------------------------------
+def outputPackets(pm4_info_file, tables):
+  outputInitializerArray(pm4_info_file, 'PacketField', 'kPacketFields', tables.packet_fields)
+
+  # For descriptors, we purposefully try to include them as "packets" for easier parsing.
+  # They are not technically PM4 packets, hence the 0x0.
+  # Example: const PacketInfo *packet_info_ptr = GetPacketInfo(0, sharp_struct_name);
+  max_opcode = max(tables.packet_infos)
+  initializers = []
+  for opcode in range(max_opcode+1):
+    initializers.append(tables.packet_infos.get(opcode, '{}'))
+  outputInitializerArray(pm4_info_file, 'PacketInfo', 'kPacketInfos', initializers)
+
+  # Some PM4s share the same opcode, but for different GPUs (CP_THREAD_CONTROL (A7XX-) and
+  # IN_IB_PREFETCH_END (A2XX) both use 0x17)
+  keys = sorted(tables.packet_info_variants)
+  outputInitializerArray(pm4_info_file, 'PacketInfoEntry', 'kPacketInfoVariants',
+                         ['{ 0x%x, %s }' % (key, tables.packet_info_variants[key]) for key in keys])
+  outputPerfectHash(pm4_info_file, 'kPacketInfoVariant', keys)
   pm4_info_file.write('\n')
-  outputPacketInfo(pm4_info_file, registers_et_root, enum_index_dict, opcode_dict)
-  pm4_info_file.writelines('''
-    return 0;
-}
 
-void Pm4InfoInit()
-{
-    static int initialized = Pm4InfoInitImpl();
-    (void)initialized;
-}
-''')
-  return
+  # Packets with several variants (e.g. CP_DRAW_INDIRECT_MULTI). Only the 1st one is in
+  # kPacketInfos
+  outputInitializerArray(pm4_info_file, 'PacketInfoEntry', 'kPacketInfoMultiple',
+                         ['{ 0x%x, %s }' % entry for entry in tables.packet_info_multiple])
 
-valid_opcodes = {}
 # ---------------------------------------------------------------------------------------
-def outputOpcodes(pm4_info_file, opcode_dict):
-  # Find max opcode first
-  max_opcode = max(opcode_dict)
+def outputPm4InfoTables(pm4_info_file, registers_et_root, opcode_dict):
+
+  # Get enum values from the XML element tree, being careful not to have duplicates
+  enum_index_dict = {}
+  enum_list = []
+  parseEnumInfo(enum_index_dict, enum_list, registers_et_root)
+
+  tables = Pm4Tables()
+  tables.opcodes = opcode_dict
+  parseRegisterInfo(tables, registers_et_root, enum_index_dict)
+  parsePacketInfo(tables, registers_et_root, enum_index_dict, opcode_dict)
 
-  pm4_info_file.write('    g_sOpCodeToString.resize(0x%x);\n' % (max_opcode+1))
-  for opcode in opcode_dict:
-    pm4_info_file.write('    g_sOpCodeToString[%s] = "%s";\n' % (hex(opcode), opcode_dict[opcode]))
+  pm4_info_file.write('\n')
+  outputOpcodes(pm4_info_file, tables)
+  outputRegisters(pm4_info_file, tables)
+  outputEnums(pm4_info_file, enum_list)
+  outputPackets(pm4_info_file, tables)
   return
 
 # ---------------------------------------------------------------------------------------
@@ -303,7 +510,7 @@ def GetBitfieldsOrEnumHandleFromBitset(input_type, input_bitfields, input_name,
   return bitfields, enum_handle
 
 # ---------------------------------------------------------------------------------------
-def AppendBitfield(pm4_info_file, enum_index_dict, bitfields, is_64):
+def AppendBitfield(fields, enum_index_dict, bitfields, is_64):
     # Iterate through optional bitfields
     for bitfield in bitfields:
       if bitfield.tag != '{http://nouveau.freedesktop.org/}bitfield':
@@ -349,7 +556,7 @@ def AppendBitfield(pm4_info_file, enum_index_dict, bitfields, is_64):
 
       radix = getIntAttributeValue(bitfield, 'radix')
 
-      pm4_info_file.write('    { %s, %s, %d, %d, %d, %d, %d, 0x%x, "%s" }, '  % (
+      fields.append('{ %s, %s, %d, %d, %d, %d, %d, 0x%x, "%s" }'  % (
           getTypeEnumString(bitfield_type),
           enum_handle,
           shift,
@@ -362,26 +569,28 @@ def AppendBitfield(pm4_info_file, enum_index_dict, bitfields, is_64):
         ))
 
 # ---------------------------------------------------------------------------------------
-def outputSingleRegister(pm4_info_file, registers_et_root, enum_index_dict, attributes: RegAttributes):
+def parseSingleRegister(tables, registers_et_root, enum_index_dict, attributes: RegAttributes):
   is_64_string = '0'
   if attributes.is_64 is True:
     is_64_string = '1'
 
   bitfields, enum_handle = GetBitfieldsOrEnumHandleFromBitset(attributes.type, attributes.bitfields, attributes.name, registers_et_root, enum_index_dict)
 
+  fields = []
+  AppendBitfield(fields, enum_index_dict, bitfields, attributes.is_64)
+  fields_span = addFields(tables.reg_fields, tables.reg_field_ranges, 'kRegFields', fields)
+  reg_info = '{ "%s", %s, %s, %s, %d, %d, %d, %s }' % (attributes.name, is_64_string, getTypeEnumString(attributes.type), enum_handle, attributes.shr, attributes.bit_width, attributes.radix, fields_span)
+
   variants_bitfield = GetGPUVariantsBitField(attributes.variants)
   if (variants_bitfield != 0):
       # kGPUVariantsBits has 7 bits
       for i in range(7):
           cur_variant_bitfield = (1<<i)
           if cur_variant_bitfield & variants_bitfield:
-              pm4_info_file.write('    g_sRegInfoVariant[(0x%x << kGPUVariantsBits) | 0x%x] = { "%s", %s, %s, %s, %d, %d, %d, {' % (attributes.offset, cur_variant_bitfield, attributes.name, is_64_string, getTypeEnumString(attributes.type), enum_handle, attributes.shr, attributes.bit_width, attributes.radix))
-              AppendBitfield(pm4_info_file, enum_index_dict, bitfields, attributes.is_64)
-              pm4_info_file.write('} };\n')
+              key = (attributes.offset << kGPUVariantsBits) | cur_variant_bitfield
+              tables.reg_infos[key] = (attributes.name, reg_info)
   else:
-      pm4_info_file.write('    g_sRegInfo[0x%x] = { "%s", %s, %s, %s, %d, %d, %d, {' % (attributes.offset, attributes.name, is_64_string, getTypeEnumString(attributes.type), enum_handle, attributes.shr, attributes.bit_width, attributes.radix))
-      AppendBitfield(pm4_info_file, enum_index_dict, bitfields, attributes.is_64)
-      pm4_info_file.write('} };\n')
+      tables.reg_infos[attributes.offset << kGPUVariantsBits] = (attributes.name, reg_info)
 
 
 # ---------------------------------------------------------------------------------------
@@ -401,7 +610,7 @@ def getIntAttributeValue(reg, attribute_name):
   return value
 
 # ---------------------------------------------------------------------------------------
-def outputRegisterInfo(pm4_info_file, registers_et_root, enum_index_dict):
+def parseRegisterInfo(tables, registers_et_root, enum_index_dict):
   a6xx_domain = registers_et_root.find('./{http://nouveau.freedesktop.org/}domain[@name="A6XX"]')
 
   # Create a list of 32-bit and 64-bit registers
@@ -412,13 +621,6 @@ def outputRegisterInfo(pm4_info_file, registers_et_root, enum_index_dict):
     if is_reg_32 or is_reg_64:
       regs.append(element)
 
-  # Determine highest register offset
-  max_offset = 0
-  for reg in regs:
-    offset = int(reg.attrib['offset'],0)
-    max_offset = max(max_offset, offset)
-  pm4_info_file.write('    g_sRegInfo.resize(0x%x);\n' % (max_offset+1))
-
   # Parse through registers
   for reg in regs:
     offset = int(reg.attrib['offset'],0)
@@ -449,7 +651,7 @@ def outputRegisterInfo(pm4_info_file, registers_et_root, enum_index_dict):
     reg_attributes.bit_width = bit_width
     reg_attributes.radix = radix
 
-    outputSingleRegister(pm4_info_file, registers_et_root, enum_index_dict, reg_attributes)
+    parseSingleRegister(tables, registers_et_root, enum_index_dict, reg_attributes)
 
   # Iterate and output the arrays as a sequence of reg32s with an index as a suffix
   arrays = a6xx_domain.findall('{http://nouveau.freedesktop.org/}array')
@@ -489,7 +691,7 @@ def outputRegisterInfo(pm4_info_file, registers_et_root, enum_index_dict):
         reg_attributes.shr = 0
         reg_attributes.bit_width = 0
         reg_attributes.radix = 0
-        outputSingleRegister(pm4_info_file, registers_et_root, enum_index_dict, reg_attributes)
+        parseSingleRegister(tables, registers_et_root, enum_index_dict, reg_attributes)
       elif stride == 2 and not array_regs:
         reg_attributes.name = array_name+str(i)+'_LO'
         reg_attributes.offset = offset+i*stride
@@ -500,7 +702,7 @@ def outputRegisterInfo(pm4_info_file, registers_et_root, enum_index_dict):
         reg_attributes.shr = 0
         reg_attributes.bit_width = 0
         reg_attributes.radix = 0
-        outputSingleRegister(pm4_info_file, registers_et_root, enum_index_dict, reg_attributes)
+        parseSingleRegister(tables, registers_et_root, enum_index_dict, reg_attributes)
       else:
         for reg_idx, reg in enumerate(array_regs):
           reg_name = reg.attrib['name']
@@ -530,7 +732,7 @@ def outputRegisterInfo(pm4_info_file, registers_et_root, enum_index_dict):
           # if no register variants, check if there are array-level variants (e.g. GRAS_CL_VIEWPORT)
           if (not reg_attributes.variants) and ('variants' in array.attrib):
             reg_attributes.variants = array.attrib['variants']
-          outputSingleRegister(pm4_info_file, registers_et_root, enum_index_dict, reg_attributes)
+          parseSingleRegister(tables, registers_et_root, enum_index_dict, reg_attributes)
   return
 
 # ---------------------------------------------------------------------------------------
@@ -579,12 +781,12 @@ class FieldAttributes():
   mask = 0
 
 # ---------------------------------------------------------------------------------------
-def outputField(pm4_info_file, field_attributes: FieldAttributes):
-  pm4_info_file.write('{ "%s", %d, %d, %s, %s, %d, %d, 0x%x },' %
+def appendField(fields, field_attributes: FieldAttributes):
+  fields.append('{ "%s", %d, %d, %s, %s, %d, %d, 0x%x }' %
                        (field_attributes.name, field_attributes.is_variant_opcode, field_attributes.dword_count, getTypeEnumString(field_attributes.type), field_attributes.enum_handle, field_attributes.shift, field_attributes.shr, field_attributes.mask))
 
 # ---------------------------------------------------------------------------------------
-def outputPacketFields(pm4_info_file, enum_index_dict, reg_list):
+def appendPacketFields(fields, enum_index_dict, reg_list):
   dword_count = 0
   address_end_offset = sys.maxsize
   for element in reg_list:
@@ -643,15 +845,15 @@ def outputPacketFields(pm4_info_file, enum_index_dict, reg_list):
         field_attributes.name = field_name
         field_attributes.dword_count = dword_count
 
-        outputField(pm4_info_file, field_attributes)
+        appendField(fields, field_attributes)
       elif is_reg_64:
         field_attributes.name = field_name+'_LO'
         field_attributes.dword_count = dword_count - 1
-        outputField(pm4_info_file, field_attributes)
+        appendField(fields, field_attributes)
 
         field_attributes.name = field_name+'_HI'
         field_attributes.dword_count = dword_count
-        outputField(pm4_info_file, field_attributes)
+        appendField(fields, field_attributes)
 
     if is_reg_64 and len(bitfields) > 0:
       raise Exception('Found a reg64 with bitfields: ' + field_name)
@@ -701,51 +903,16 @@ def outputPacketFields(pm4_info_file, enum_index_dict, reg_list):
       field_attributes.shift = shift
       field_attributes.shr = shr
       field_attributes.mask = mask
-      outputField(pm4_info_file, field_attributes)
-
-# ---------------------------------------------------------------------------------------
-def outputEnums(pm4_info_file, enum_list):
-  pm4_info_file.write('    g_sEnumReflection.resize(%d);\n' % (len(enum_list)+1));
-  # Output enum_list to file
-  for idx, enum_info in enumerate(enum_list):
-    # enum_list is an array of {string, dict()}, where the key of the dict() is
-    # the integer enum_value
-    enum_sorted_items = sorted(enum_info[1].items())
-    max_enum_value = enum_sorted_items[-1][0]
-    pm4_info_file.write('    g_sEnumReflection[%d].resize(%d, nullptr); // %s\n' % (idx, max_enum_value+1, enum_info[0]));
-    for enum_value, enum_value_string in enum_sorted_items:
-      pm4_info_file.write('    g_sEnumReflection[%d][%d] = "%s";\n' % (idx, enum_value, enum_value_string));
+      appendField(fields, field_attributes)
 
 # ---------------------------------------------------------------------------------------
 # This function adds info for PM4 packets as well as structs that have no opcodes (e.g. V#s/T#s/S#s)
-def outputPacketInfo(pm4_info_file, registers_et_root, enum_index_dict, opcode_dict):
+def parsePacketInfo(tables, registers_et_root, enum_index_dict, opcode_dict):
   domains = registers_et_root.findall('{http://nouveau.freedesktop.org/}domain')
 
   # Find all CP packet types so we can find out which domains are relevant
   pm4_type_packets = registers_et_root.find('./{http://nouveau.freedesktop.org/}enum[@name="adreno_pm4_type3_packets"]')
 
-  # Get highest opcode value to properly resize() the vector
-  highest_opcode = 0
-  for domain in domains:
-    domain_name = domain.attrib['name']
-
-    # Check if it is a domain describing a PM4 packet
-    pm4_type_packet = pm4_type_packets.find('./{http://nouveau.freedesktop.org/}value[@name="'+domain_name+'"]')
-    if (pm4_type_packet is None) and (not domain_name.startswith('A6XX_')):
-      continue
-
-    opcode = 0
-    if pm4_type_packet is not None:
-      opcode = int(pm4_type_packet.attrib['value'],0)
-      if opcode_dict[opcode] != domain_name:
-        continue
-
-    if highest_opcode < opcode:
-      highest_opcode = opcode
-
-  pm4_info_file.write('    g_sPacketInfo.resize(0x%x);\n' % (highest_opcode+1))
-
-  ############################################################################
   packet_type_instances = {}
   for domain in domains:
     domain_name = domain.attrib['name']
@@ -848,28 +1015,21 @@ def outputPacketInfo(pm4_info_file, registers_et_root, enum_index_dict, opcode_d
       # Sort based on offset
       reg_list = sorted(reg_list, key=lambda x: int(x.attrib['offset'],0))
 
-      # Keep track of instance #. Only the 1st instance belongs in the vector. The rest are in the multimap.
+      fields = []
+      appendPacketFields(fields, enum_index_dict, reg_list)
+      fields_span = addFields(tables.packet_fields, tables.packet_field_ranges, 'kPacketFields', fields)
+      packet_info = '{ "%s", %d, %s, %s }' % (packet_name, array_size, stripe_variant, fields_span)
+
+      # Keep track of instance #. Only the 1st instance belongs in kPacketInfos. The rest are in kPacketInfoMultiple.
       if opcode not in packet_type_instances:
         packet_type_instances[opcode] = 1
-        if (opcode == 0):
-          pm4_info_file.write('''
-    // For descriptors, we purposefully try to include them as "packets" for easier parsing.
-    // They are not technically PM4 packets, hence the 0x0.
-    // Example: const PacketInfo *packet_info_ptr = GetPacketInfo(0, sharp_struct_name);
-''')
-
-        pm4_info_file.write('    g_sPacketInfo[0x%x] = { "%s", %d, %s, {' % (opcode, packet_name, array_size, stripe_variant))
-        outputPacketFields(pm4_info_file, enum_index_dict, reg_list)
-        pm4_info_file.write(' } };\n')
+        tables.packet_infos[opcode] = packet_info
       else:
         packet_type_instances[opcode] += 1
-        pm4_info_file.write('    g_sPacketInfoMultiple.insert(std::pair<uint32_t, PacketInfo>(')
-        pm4_info_file.write('0x%x, { "%s", %d, %s, {' % (opcode, packet_name, array_size, stripe_variant))
-        outputPacketFields(pm4_info_file, enum_index_dict, reg_list)
-        pm4_info_file.write(' } }));\n')
+        tables.packet_info_multiple.append((opcode, packet_info))
 
   # Not all pm4 packets are described via a 'domain'. These are usually packets (such as CP_WAIT_FOR_IDLE) which
-  # have no fields. In that case, add a corresponding g_sPacketInfo entry with no fields
+  # have no fields. In that case, add a corresponding kPacketInfos entry with no fields
   pm4_type_packets_values = pm4_type_packets.findall('./{http://nouveau.freedesktop.org/}value')
   for pm4_type_packet_value in pm4_type_packets_values:
     # See if it shows up in the domains list
@@ -879,7 +1039,7 @@ def outputPacketInfo(pm4_info_file, registers_et_root, enum_index_dict, opcode_d
     if domain is None:
       opcode = int(pm4_type_packet_value.attrib['value'],0)
 
-      # We need the g_sPacketInfoVariant because some PM4s share the same value
+      # We need the kPacketInfoVariants because some PM4s share the same value
       # but with different variants (CP_THREAD_CONTROL (A7XX-) and IN_IB_PREFETCH_END (A2XX) both use 0x17)
       if 'variants' in pm4_type_packet_value.attrib:
         variants = pm4_type_packet_value.attrib['variants']
@@ -890,73 +1050,46 @@ def outputPacketInfo(pm4_info_file, registers_et_root, enum_index_dict, opcode_d
           for i in range(6):
             cur_variant_bitfield = (1<<i)
             if cur_variant_bitfield & variants_bitfield:
-              pm4_info_file.write('    g_sPacketInfoVariant[(0x%x << kGPUVariantsBits) | 0x%x] = { "%s", 0, UINT8_MAX, {' % (opcode, cur_variant_bitfield, packet_name) + ' } };\n')
+              key = (opcode << kGPUVariantsBits) | cur_variant_bitfield
+              tables.packet_info_variants[key] = '{ "%s", 0, UINT8_MAX, {} }' % (packet_name)
       else:
-        pm4_info_file.write('    g_sPacketInfo[0x%x] = { "%s", 0, UINT8_MAX, {' % (opcode, packet_name) + ' } };\n')
-
-  pm4_info_file.write('\n')
+        tables.packet_infos[opcode] = '{ "%s", 0, UINT8_MAX, {} }' % (packet_name)
 
-  # Append _A?XX to the name if there is any variant
-  # This is to handle the cases where the regsiters have the same name
-  # but different offset for different variants, like PC_POLYGON_MODE
-  pm4_info_file.writelines('''
-  for (uint64_t i = 0; i < g_sRegInfo.size(); ++i)
-  {
-    if (g_sRegInfo[i].m_name != nullptr)
-    {
-      g_sRegNameToIndex[g_sRegInfo[i].m_name] = (uint32_t)i;
-    }
-  }
-	for (auto &reg : g_sRegInfoVariant)
-	{
-		const std::string& name = reg.second.m_name;
-		const uint32_t shift_bits = 32 - kGPUVariantsBits;
-		uint32_t gpu_variants = reg.first << shift_bits >> shift_bits;
-		uint32_t reg_offset = reg.first >> kGPUVariantsBits;
-		g_sRegNameToIndex[name] = reg_offset;
-		if (gpu_variants != 0)
-		{
-			uint32_t bit_offset = 0;
-			while(gpu_variants != 0)
-			{
-				if ((gpu_variants & 0x1) != 0)
-				{
-					const std::string name_with_variant = name + "_" + GetGPUStr(static_cast<GPUVariantType>(1 << (bit_offset)));
-					g_sRegNameToIndex[name_with_variant] = reg_offset;
-				}
-				gpu_variants = gpu_variants>>1;
-				++bit_offset;
-			}
-		}
-	}\n''')
 
 # ---------------------------------------------------------------------------------------
 
 def outputFunctionsCpp(pm4_info_file):
   pm4_info_file.writelines('''
+void Pm4InfoInit() {}
+
 const char *GetOpCodeString(uint32_t op_code)
 {
-    Pm4InfoInit();
-    return g_sOpCodeToString[op_code];
+    if (op_code >= std::size(kOpCodeToString))
+        return nullptr;
+    return kOpCodeToString[op_code];
+}
+
+static const RegInfo *FindRegInfo(uint32_t key)
+{
+    uint32_t index = LookupPerfectHash(key, kRegInfoSeeds, kRegInfoSlots);
+    if (kRegInfoKeys[index] != key)
+        return nullptr;
+    return &kRegInfos[index];
 }
 
 const RegInfo *GetRegInfo(uint32_t reg)
 {
-    Pm4InfoInit();
+    if (reg > (UINT32_MAX >> kGPUVariantsBits))
+        return nullptr;
 
     // check without variant as key
-    if (g_sRegInfo[reg].m_name == nullptr)
+    const RegInfo *info = FindRegInfo(reg << kGPUVariantsBits);
+    if (info == nullptr)
     {
         // check with variant as key
-        uint32_t key = (reg << kGPUVariantsBits) | g_sGPU_variant;
-        auto it = g_sRegInfoVariant.find(key);
-        if (it == g_sRegInfoVariant.end())
-        {
-            return nullptr;
-        }
-        return &it->second;
+        info = FindRegInfo((reg << kGPUVariantsBits) | g_sGPU_variant);
     }
-    return &g_sRegInfo[reg];
+    return info;
 }
 
 const RegInfo *GetRegByName(const char *name)
@@ -974,76 +1107,96 @@ const RegField *GetRegFieldByName(const char *name, const RegInfo *info)
     if (info == nullptr)
         return nullptr;
 
-    const DiveVector<RegField> &field = info->m_fields;
-    auto i = std::find_if(field.begin(), field.end(), [&](const RegField& f) {
-        return strcmp(name, f.m_name) == 0;
-    });
+    for (const RegField &field : info->m_fields)
+    {
+        if (strcmp(name, field.m_name) == 0)
+            return &field;
+    }
+    return nullptr;
+}
+
+// Whether |reg_name| is |name|, followed by "_" and |suffix| if there is a suffix
+static bool IsRegName(const char *reg_name, const char *name, const char *suffix)
+{
+    size_t name_length = strlen(name);
+    if (strncmp(reg_name, name, name_length) != 0)
+        return false;
+    reg_name += name_length;
+    if (*suffix == '\\0')
+        return *reg_name == '\\0';
+    return *reg_name == '_' && strcmp(reg_name + 1, suffix) == 0;
+}
 
-    if (i == info->m_fields.end())
+static const RegName *FindRegName(uint32_t hash, const char *name, const char *suffix)
+{
+    const RegName &reg_name = kRegNames[LookupPerfectHash(hash, kRegNameSeeds, kRegNameSlots)];
+    if (!IsRegName(reg_name.m_name, name, suffix))
         return nullptr;
-    return &(*i);
+    return &reg_name;
 }
 
 uint32_t GetRegOffsetByName(const char *name)
 {
-    Pm4InfoInit();
-
     if (g_sGPU_variant == kGPUVariantNone) 
     {
         return kInvalidRegOffset;
     }
 
-    std::string str = std::string(name);
-    auto i = g_sRegNameToIndex.find(str);
-    if (i == g_sRegNameToIndex.end())
+    uint32_t hash = HashName(kNameHashBasis, name);
+    const RegName *reg_name = FindRegName(hash, name, "");
+    if (reg_name == nullptr)
     {
-        std::string name_with_variant = str + "_" + GetGPUStr(g_sGPU_variant);
-        i = g_sRegNameToIndex.find(name_with_variant);
-        if (i == g_sRegNameToIndex.end())
+        const char *gpu_str = GetGPUStr(g_sGPU_variant);
+        reg_name = FindRegName(HashName(HashName(hash, "_"), gpu_str), name, gpu_str);
+        if (reg_name == nullptr)
         {
             return kInvalidRegOffset;
         }
     }
-    return i->second;
+    return reg_name->m_offset;
 }
 
 const char *GetEnumString(uint32_t enum_handle, uint32_t val)
 {
-    if (g_sEnumReflection.size() <= enum_handle)
+    if (std::size(kEnumReflection) <= enum_handle)
         return nullptr;
-    if (g_sEnumReflection[enum_handle].size() <= val)
+    if (kEnumReflection[enum_handle].size() <= val)
         return nullptr;
-    return g_sEnumReflection[enum_handle][val];
+    return kEnumReflection[enum_handle][val];
 }
 
 const PacketInfo *GetPacketInfo(uint32_t op_code)
 {
     // check without variant as key
-    if (g_sPacketInfo[op_code].m_name == nullptr)
+    if (op_code >= std::size(kPacketInfos) || kPacketInfos[op_code].m_name == nullptr)
     {
+        if (op_code > (UINT32_MAX >> kGPUVariantsBits))
+            return nullptr;
+
         // check with variant as key
         uint32_t key = (op_code << kGPUVariantsBits) | g_sGPU_variant;
-        auto it = g_sPacketInfoVariant.find(key);
-        if (it == g_sPacketInfoVariant.end())
+        const PacketInfoEntry &entry =
+            kPacketInfoVariants[LookupPerfectHash(key, kPacketInfoVariantSeeds,
+                                                  kPacketInfoVariantSlots)];
+        if (entry.m_key != key)
         {
             return nullptr;
         }
-        return &it->second;
+        return &entry.m_info;
     }
 
-    return &g_sPacketInfo[op_code];
+    return &kPacketInfos[op_code];
 }
 
 const PacketInfo *GetPacketInfo(uint32_t op_code, const char *name)
 {
-    if (g_sPacketInfo[op_code].m_name == nullptr)
+    if (op_code >= std::size(kPacketInfos) || kPacketInfos[op_code].m_name == nullptr)
         return nullptr;
-    if (strcmp(g_sPacketInfo[op_code].m_name, name) == 0)
-        return &g_sPacketInfo[op_code];
-    auto ret_pair = g_sPacketInfoMultiple.equal_range(op_code);
-    for (auto it  = ret_pair.first; it != ret_pair.second; ++it) {
-        if (strcmp(it->second.m_name, name) == 0)
-            return &it->second;
+    if (strcmp(kPacketInfos[op_code].m_name, name) == 0)
+        return &kPacketInfos[op_code];
+    for (const PacketInfoEntry &entry : kPacketInfoMultiple) {
+        if (entry.m_key == op_code && strcmp(entry.m_info.m_name, name) == 0)
+            return &entry.m_info;
     }
     return nullptr;
 }
@@ -1139,7 +1292,7 @@ try:
 
   # .CPP file
   outputHeaderCpp(pm4_info_filename_h, pm4_info_file_cpp)
-  outputPm4InfoInitFunc(pm4_info_file_cpp, registers_et_root, opcode_dict)
+  outputPm4InfoTables(pm4_info_file_cpp, registers_et_root, opcode_dict)
   outputFunctionsCpp(pm4_info_file_cpp)
 
   # close to flush
@@ -16,13 +16,18 @@
 
 #include "gfxr_capture_data.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "absl/cleanup/cleanup.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "decode/annotation_handler.h"
 #include "dive_core/common/common.h"
 #include "generated/generated_vulkan_dive_consumer.h"
 #include "gfxr_ext/decode/dive_file_processor.h"
@@ -40,6 +45,15 @@ using gfxrecon::util::platform::FileSeek;
 using gfxrecon::util::platform::FileSeekOrigin;
 using gfxrecon::util::platform::FileTell;
 
+using gfxrecon::decode::DiveBlockData;
+using gfxrecon::decode::DiveFileProcessor;
+using gfxrecon::decode::DiveVulkanCommandTable;
+using FunctionRecord = DiveAnnotationProcessor::FunctionRecord;
+
+// Unless the number of threads is set, each thread decodes at least this many blocks, since each
+// has its own decoder to set up
+constexpr size_t kMinBlocksPerLoadThread = 4096;
+
 absl::StatusOr<uint64_t> GetFileSize(const std::filesystem::path& file_path)
 {
     FILE* file = nullptr;
@@ -67,6 +81,202 @@ absl::StatusOr<uint64_t> GetFileSize(const std::filesystem::path& file_path)
     GFXRECON_ASSERT(file_size >= 0);
     return static_cast<uint64_t>(file_size);
 }
+
+// Decodes the Vulkan function calls of a GFXR file into function data for an annotation handler
+struct GfxrFileDecoder
+{
+    bool Initialize(const std::string& file_name, gfxrecon::decode::AnnotationHandler* handler)
+    {
+        if (!file_processor.Initialize(file_name))
+        {
+            return false;
+        }
+        vulkan_decoder.AddConsumer(&dive_consumer);
+        file_processor.AddDecoder(&vulkan_decoder);
+        file_processor.SetAnnotationProcessor(handler);
+        dive_consumer.Initialize(handler);
+        return true;
+    }
+
+    // Declared before the file processor, which refers to them
+    gfxrecon::decode::VulkanExportDiveConsumer dive_consumer;
+    gfxrecon::decode::VulkanDecoder vulkan_decoder;
+    DiveFileProcessor file_processor;
+};
+
+// Keeps the records of the function calls, with the command table that their ids are from
+class FunctionRecorder : public gfxrecon::decode::AnnotationHandler
+{
+ public:
+    void WriteBlockEnd(const gfxrecon::util::DiveFunctionData& function_data) override
+    {
+        m_records.push_back(
+            DiveAnnotationProcessor::MakeFunctionRecord(function_data, m_command_table));
+    }
+
+    void ProcessAnnotation(uint64_t block_index, gfxrecon::format::AnnotationType type,
+                           const std::string& label, const std::string& data) override
+    {
+    }
+
+    std::vector<FunctionRecord>& GetRecords() { return m_records; }
+    const DiveVulkanCommandTable& GetCommandTable() const { return m_command_table; }
+
+ private:
+    DiveVulkanCommandTable m_command_table;
+    std::vector<FunctionRecord> m_records;
+};
+
+//--------------------------------------------------------------------------------------------------
+// Decodes all the blocks of the file in a single pass
+bool ProcessFile(const std::string& file_name, const std::shared_ptr<DiveBlockData>& block_data,
+                 DiveAnnotationProcessor& dive_annotation_processor)
+{
+    GfxrFileDecoder decoder;
+    if (!decoder.Initialize(file_name, &dive_annotation_processor))
+    {
+        return false;
+    }
+    decoder.file_processor.SetDiveBlockData(block_data);
+
+    if (!decoder.file_processor.ProcessAllFrames())
+    {
+        std::cerr << "Error using gfxrecon DiveFileProcessor to load file: " << file_name
+                  << std::endl;
+        std::cerr << decoder.file_processor.GetErrorState() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Decodes blocks [begin, end) of deferred_blocks. This creates and destroys its own decoder, which
+// must happen on the thread that uses it since gfxreconstruct decodes into a per-thread allocator
+bool DecodeDeferredBlocks(const std::string& file_name,
+                          const std::vector<DiveFileProcessor::DeferredBlock>& deferred_blocks,
+                          size_t begin, size_t end, FunctionRecorder& recorder)
+{
+    GfxrFileDecoder decoder;
+    if (!decoder.Initialize(file_name, &recorder))
+    {
+        return false;
+    }
+
+    recorder.GetRecords().reserve(end - begin);
+    for (size_t i = begin; i < end; ++i)
+    {
+        const DiveFileProcessor::DeferredBlock& block = deferred_blocks[i];
+        if (!decoder.file_processor.ProcessBlockAtOffset(block.offset, block.block_index))
+        {
+            std::cerr << "Error decoding block " << block.block_index
+                      << " of gfxr file: " << file_name << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// The file is first read on the calling thread, decoding only the blocks that the others depend on:
+// metadata, markers, and the function calls read from asset files. The function calls of the GFXR
+// file itself are most of the blocks and most of the decoding time. They are then decoded by
+// up to num_threads threads, each taking a contiguous range of at least min_blocks_per_thread of
+// them. The records of all the threads are then processed in block order
+bool ProcessFileInParallel(const std::string& file_name,
+                           const std::shared_ptr<DiveBlockData>& block_data, uint32_t num_threads,
+                           size_t min_blocks_per_thread,
+                           DiveAnnotationProcessor& dive_annotation_processor)
+{
+    FunctionRecorder scan_recorder;
+    std::vector<DiveFileProcessor::DeferredBlock> deferred_blocks;
+    {
+        GfxrFileDecoder decoder;
+        if (!decoder.Initialize(file_name, &scan_recorder))
+        {
+            return false;
+        }
+        decoder.file_processor.SetDiveBlockData(block_data);
+        decoder.file_processor.SetDeferFunctionCalls(true);
+
+        if (!decoder.file_processor.ProcessAllFrames())
+        {
+            std::cerr << "Error using gfxrecon DiveFileProcessor to load file: " << file_name
+                      << std::endl;
+            std::cerr << decoder.file_processor.GetErrorState() << std::endl;
+            return false;
+        }
+        deferred_blocks = decoder.file_processor.TakeDeferredBlocks();
+    }
+
+    size_t num_blocks = deferred_blocks.size();
+    num_threads = static_cast<uint32_t>(
+        std::clamp<size_t>(num_blocks / min_blocks_per_thread, 1, num_threads));
+    std::vector<FunctionRecorder> recorders(num_threads);
+    std::vector<uint8_t> results(num_threads, 0);
+    auto decode_range = [&](uint32_t thread_index) {
+        size_t begin = num_blocks * thread_index / num_threads;
+        size_t end = num_blocks * (thread_index + 1) / num_threads;
+        results[thread_index] =
+            DecodeDeferredBlocks(file_name, deferred_blocks, begin, end, recorders[thread_index]);
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t thread_index = 1; thread_index < num_threads; ++thread_index)
+    {
+        threads.emplace_back(decode_range, thread_index);
+    }
+    decode_range(0);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    if (std::find(results.begin(), results.end(), 0) != results.end())
+    {
+        return false;
+    }
+
+    // The ids of the commands that are not known at compile time differ between command tables.
+    // The command buffer indices were counted by the consumer of each thread, from only the
+    // commands that it decoded, so they are counted again in block order. Commands with an index of
+    // 0, such as vkBeginCommandBuffer, aren't counted by the consumer either
+    DiveVulkanCommandTable& command_table = dive_annotation_processor.GetCommandTable();
+    std::unordered_map<uint64_t, uint32_t> cmd_buffer_record_indices;
+    auto process_record = [&](FunctionRecord& record, const FunctionRecorder& recorder) {
+        if (record.command_id >= DiveVulkanCommandTable::kKnownCommandCount)
+        {
+            record.command_id =
+                command_table.GetId(recorder.GetCommandTable().GetName(record.command_id));
+        }
+        if (record.cmd_buffer_index != 0 && record.command_buffer)
+        {
+            record.cmd_buffer_index = ++cmd_buffer_record_indices[*record.command_buffer];
+        }
+        dive_annotation_processor.ProcessFunctionRecord(record);
+    };
+
+    // The ranges of the threads are in order, and the records within each range too
+    std::vector<FunctionRecord>& scan_records = scan_recorder.GetRecords();
+    size_t scan_index = 0;
+    for (FunctionRecorder& recorder : recorders)
+    {
+        for (FunctionRecord& record : recorder.GetRecords())
+        {
+            for (; scan_index < scan_records.size() &&
+                   scan_records[scan_index].block_index < record.block_index;
+                 ++scan_index)
+            {
+                process_record(scan_records[scan_index], scan_recorder);
+            }
+            process_record(record, recorder);
+        }
+    }
+    for (; scan_index < scan_records.size(); ++scan_index)
+    {
+        process_record(scan_records[scan_index], scan_recorder);
+    }
+    return true;
+}
+
 }  // namespace
 
 // =================================================================================================
@@ -85,29 +295,21 @@ CaptureData::LoadResult GfxrCaptureData::LoadCaptureFile(const std::string& file
 
     m_gfxr_capture_block_data = std::make_shared<gfxrecon::decode::DiveBlockData>();
 
-    gfxrecon::decode::DiveFileProcessor file_processor;
-
-    if (!file_processor.Initialize(file_name))
+    DiveAnnotationProcessor dive_annotation_processor;
+    uint32_t num_threads = GetNumLoadThreads();
+    bool processed = false;
+    if (num_threads <= 1)
     {
-        return LoadResult::kFileIoError;
+        processed = ProcessFile(file_name, m_gfxr_capture_block_data, dive_annotation_processor);
     }
-
-    file_processor.SetDiveBlockData(m_gfxr_capture_block_data);
-
-    gfxrecon::decode::VulkanExportDiveConsumer dive_consumer;
-    gfxrecon::decode::VulkanDecoder decoder;
-    decoder.AddConsumer(&dive_consumer);
-    file_processor.AddDecoder(&decoder);
-
-    DiveAnnotationProcessor dive_annotation_processor;
-    file_processor.SetAnnotationProcessor(&dive_annotation_processor);
-    dive_consumer.Initialize(&dive_annotation_processor);
-
-    if (!file_processor.ProcessAllFrames())
+    else
+    {
+        size_t min_blocks_per_thread = (m_num_load_threads != 0) ? 1 : kMinBlocksPerLoadThread;
+        processed = ProcessFileInParallel(file_name, m_gfxr_capture_block_data, num_threads,
+                                          min_blocks_per_thread, dive_annotation_processor);
+    }
+    if (!processed)
     {
-        std::cerr << "Error using gfxrecon DiveFileProcessor to load file: " << file_name
-                  << std::endl;
-        std::cerr << file_processor.GetErrorState() << std::endl;
         return LoadResult::kFileIoError;
     }
 
@@ -115,6 +317,7 @@ CaptureData::LoadResult GfxrCaptureData::LoadCaptureFile(const std::string& file
     DIVE_ASSERT(!m_gfxr_submits.empty());
     m_gfxr_command_buffers = dive_annotation_processor.TakeVkCommandsCache();
     m_gfxr_draw_call_counts = dive_annotation_processor.TakeDrawCallMap();
+    m_gfxr_command_table = dive_annotation_processor.TakeCommandTable();
 
     absl::StatusOr<uint64_t> file_size = GetFileSize(file_name);
     if (!file_size.ok())
@@ -130,10 +333,22 @@ CaptureData::LoadResult GfxrCaptureData::LoadCaptureFile(const std::string& file
     }
 
     m_cur_capture_file = file_name;
+    m_command_args_cache = std::make_unique<GfxrCommandArgsCache>(m_cur_capture_file,
+                                                                  m_gfxr_capture_block_data);
 
     return LoadResult::kSuccess;
 }
 
+//--------------------------------------------------------------------------------------------------
+uint32_t GfxrCaptureData::GetNumLoadThreads() const
+{
+    if (m_num_load_threads != 0)
+    {
+        return m_num_load_threads;
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
 //--------------------------------------------------------------------------------------------------
 bool GfxrCaptureData::WriteModifiedGfxrFile(const char* new_file_name)
 {
@@ -174,4 +389,14 @@ const DiveAnnotationProcessor::DrawCallCounts& GfxrCaptureData::GetDrawCallCount
     return m_gfxr_draw_call_counts.at(cmd_handle);
 }
 
+//--------------------------------------------------------------------------------------------------
+GfxrCommandArgsCache::Args GfxrCaptureData::GetCommandArgs(uint64_t block_index) const
+{
+    if (m_command_args_cache == nullptr)
+    {
+        return nullptr;
+    }
+    return m_command_args_cache->GetArgs(block_index);
+}
+
 }  // namespace Dive
@@ -15,7 +15,10 @@
 */
 
 #pragma once
+#include <memory>
+
 #include "dive_core/capture_data.h"
+#include "dive_core/gfxr_command_args_cache.h"
 #include "gfxr_ext/decode/dive_annotation_processor.h"
 #include "gfxr_ext/decode/dive_block_data.h"
 
@@ -36,6 +39,23 @@ class GfxrCaptureData : public CaptureData
     const std::vector<DiveAnnotationProcessor::VulkanCommandInfo>& GetGfxrCommandBuffers(
         uint64_t cmd_handle) const;
     const DiveAnnotationProcessor::DrawCallCounts& GetDrawCallCounts(uint64_t cmd_handle) const;
+    // Names and types of the commands referred to by VulkanCommandInfo::command_id
+    const gfxrecon::decode::DiveVulkanCommandTable& GetVulkanCommandTable() const
+    {
+        return m_gfxr_command_table;
+    }
+
+    // Arguments of the command of the block (see VulkanCommandInfo::block_index), decoded again
+    // from the GFXR file since they are not kept after loading. Returns nullptr if they can't be
+    // decoded
+    GfxrCommandArgsCache::Args GetCommandArgs(uint64_t block_index) const;
+
+    // Set the number of threads that decode the GFXR file when loading it. 1 decodes the whole file
+    // in a single pass. Otherwise the file is read once to find the function calls, which are then
+    // decoded by the given number of threads. 0 (the default) uses up to one thread per hardware
+    // thread, with fewer threads for small files. The result is the same regardless of the number
+    // of threads
+    void SetNumLoadThreads(uint32_t num_threads) { m_num_load_threads = num_threads; }
 
     // Sets m_cur_capture_file and m_gfxr_capture_block_data with info from the original GFXR file
     LoadResult LoadCaptureFile(const std::string& file_name) override;
@@ -52,6 +72,10 @@ class GfxrCaptureData : public CaptureData
     bool WriteModifiedGfxrFile(const char* new_file_name);
 
  private:
+    uint32_t GetNumLoadThreads() const;
+
+    uint32_t m_num_load_threads = 0;
+
     // Metadata for the original GFXR file m_cur_capture_file, as well as modifications
     std::shared_ptr<gfxrecon::decode::DiveBlockData> m_gfxr_capture_block_data = nullptr;
 
@@ -60,6 +84,10 @@ class GfxrCaptureData : public CaptureData
     std::unordered_map<uint64_t, std::vector<DiveAnnotationProcessor::VulkanCommandInfo>>
         m_gfxr_command_buffers;
     std::unordered_map<uint64_t, DiveAnnotationProcessor::DrawCallCounts> m_gfxr_draw_call_counts;
+    gfxrecon::decode::DiveVulkanCommandTable m_gfxr_command_table;
+
+    // Set once the file is loaded
+    std::unique_ptr<GfxrCommandArgsCache> m_command_args_cache;
 };
 
 }  // namespace Dive
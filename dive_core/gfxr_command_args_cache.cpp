@@ -0,0 +1,165 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "gfxr_command_args_cache.h"
+
+#include <iostream>
+#include <optional>
+
+#include "decode/annotation_handler.h"
+#include "generated/generated_vulkan_dive_consumer.h"
+#include "gfxr_ext/decode/dive_block_data.h"
+#include "gfxr_ext/decode/dive_file_processor.h"
+#include "third_party/gfxreconstruct/framework/generated/generated_vulkan_decoder.h"
+
+namespace Dive
+{
+
+// =================================================================================================
+// GfxrCommandArgsCache::Decoder
+// =================================================================================================
+// Keeps the file open and the decoders set up between the blocks that are decoded
+class GfxrCommandArgsCache::Decoder : public gfxrecon::decode::AnnotationHandler
+{
+ public:
+    bool Initialize(const std::string& file_name)
+    {
+        if (!m_file_processor.Initialize(file_name))
+        {
+            return false;
+        }
+        m_vulkan_decoder.AddConsumer(&m_dive_consumer);
+        m_file_processor.AddDecoder(&m_vulkan_decoder);
+        m_file_processor.SetAnnotationProcessor(this);
+        m_dive_consumer.Initialize(this);
+        return true;
+    }
+
+    // Returns the function data of the block at offset, if it is a Vulkan function call
+    std::optional<gfxrecon::util::DiveFunctionData> DecodeBlock(int64_t offset,
+                                                                uint64_t block_index)
+    {
+        m_function_data.reset();
+        if (!m_file_processor.ProcessBlockAtOffset(offset, block_index))
+        {
+            return std::nullopt;
+        }
+        return std::move(m_function_data);
+    }
+
+    void WriteBlockEnd(const gfxrecon::util::DiveFunctionData& function_data) override
+    {
+        m_function_data = function_data;
+    }
+
+    void ProcessAnnotation(uint64_t block_index, gfxrecon::format::AnnotationType type,
+                           const std::string& label, const std::string& data) override
+    {
+    }
+
+ private:
+    // Declared before the file processor, which refers to them
+    gfxrecon::decode::VulkanExportDiveConsumer m_dive_consumer;
+    gfxrecon::decode::VulkanDecoder m_vulkan_decoder;
+    gfxrecon::decode::DiveFileProcessor m_file_processor;
+
+    std::optional<gfxrecon::util::DiveFunctionData> m_function_data;
+};
+
+// =================================================================================================
+// GfxrCommandArgsCache
+// =================================================================================================
+GfxrCommandArgsCache::GfxrCommandArgsCache(
+    std::string file_name, std::shared_ptr<const gfxrecon::decode::DiveBlockData> block_data,
+    size_t capacity)
+    : m_file_name(std::move(file_name)), m_block_data(std::move(block_data)), m_capacity(capacity)
+{
+}
+
+GfxrCommandArgsCache::~GfxrCommandArgsCache() = default;
+
+//--------------------------------------------------------------------------------------------------
+GfxrCommandArgsCache::Args GfxrCommandArgsCache::GetArgs(uint64_t block_index)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_lru_map.find(block_index);
+    if (it != m_lru_map.end())
+    {
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return it->second->second;
+    }
+
+    Args args = DecodeArgs(block_index);
+    if (args == nullptr)
+    {
+        return nullptr;
+    }
+
+    m_lru.emplace_front(block_index, args);
+    m_lru_map[block_index] = m_lru.begin();
+    if (m_lru.size() > m_capacity)
+    {
+        m_lru_map.erase(m_lru.back().first);
+        m_lru.pop_back();
+    }
+    return args;
+}
+
+//--------------------------------------------------------------------------------------------------
+size_t GfxrCommandArgsCache::GetCachedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lru.size();
+}
+
+//--------------------------------------------------------------------------------------------------
+GfxrCommandArgsCache::Args GfxrCommandArgsCache::DecodeArgs(uint64_t block_index)
+{
+    // A block read from an asset file is recorded at the current offset in the GFXR file, so the
+    // block found there is a different one
+    if (m_block_data == nullptr || m_block_data->IsOriginalBlockInAssetFile(block_index))
+    {
+        return nullptr;
+    }
+    std::optional<uint64_t> offset = m_block_data->GetOriginalBlockOffset(block_index);
+    if (!offset)
+    {
+        return nullptr;
+    }
+
+    if (m_decoder == nullptr)
+    {
+        auto decoder = std::make_unique<Decoder>();
+        if (!decoder->Initialize(m_file_name))
+        {
+            std::cerr << "Error: cannot open gfxr file to decode command arguments: "
+                      << m_file_name << std::endl;
+            return nullptr;
+        }
+        m_decoder = std::move(decoder);
+    }
+
+    std::optional<gfxrecon::util::DiveFunctionData> function_data =
+        m_decoder->DecodeBlock(static_cast<int64_t>(*offset), block_index);
+    if (!function_data)
+    {
+        return nullptr;
+    }
+    return std::make_shared<const nlohmann::ordered_json>(function_data->GetArgs());
+}
+
+}  // namespace Dive
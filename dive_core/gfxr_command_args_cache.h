@@ -0,0 +1,78 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "util/dive_function_data.h"
+
+namespace gfxrecon::decode
+{
+class DiveBlockData;
+}  // namespace gfxrecon::decode
+
+namespace Dive
+{
+
+//--------------------------------------------------------------------------------------------------
+// Decodes the arguments of the Vulkan commands of a GFXR file on demand. Only the block index of
+// each command is kept after loading, since the arguments of all the commands of a large capture
+// don't fit in memory. The block is found again from the offset recorded in the DiveBlockData, and
+// decoded on its own. The arguments of the most recently used commands are kept
+class GfxrCommandArgsCache
+{
+ public:
+    using Args = std::shared_ptr<const nlohmann::ordered_json>;
+
+    static constexpr size_t kDefaultCapacity = 256;
+
+    GfxrCommandArgsCache(std::string file_name,
+                         std::shared_ptr<const gfxrecon::decode::DiveBlockData> block_data,
+                         size_t capacity = kDefaultCapacity);
+    ~GfxrCommandArgsCache();
+
+    // Returns nullptr if the block can't be decoded, or is not a function call. The blocks read
+    // from an asset file rather than from the GFXR file can't be decoded
+    Args GetArgs(uint64_t block_index);
+
+    size_t GetCachedCount() const;
+
+ private:
+    class Decoder;
+
+    // Decode the block, without going through the cache
+    Args DecodeArgs(uint64_t block_index);
+
+    const std::string m_file_name;
+    const std::shared_ptr<const gfxrecon::decode::DiveBlockData> m_block_data;
+    const size_t m_capacity;
+
+    // The decoder is shared, so blocks are decoded one at a time
+    mutable std::mutex m_mutex;
+    std::unique_ptr<Decoder> m_decoder;  // Created on first use
+
+    // Most recently used first
+    std::list<std::pair<uint64_t, Args>> m_lru;
+    std::unordered_map<uint64_t, std::list<std::pair<uint64_t, Args>>::iterator> m_lru_map;
+};
+
+}  // namespace Dive
@@ -13,14 +13,15 @@
 
 #include "dive_core/gfxr_vulkan_command_hierarchy.h"
 
-#include <iostream>
+#include <string_view>
 
-#include "absl/strings/numbers.h"
 #include "dive_core/dive_strings.h"
 
 namespace Dive
 {
 
+using gfxrecon::decode::DiveVulkanCommandType;
+
 // =================================================================================================
 // GfxrVulkanCommandHierarchyCreator
 // =================================================================================================
@@ -49,156 +50,122 @@ void GfxrVulkanCommandHierarchyCreator::ConditionallyAddChild(uint64_t node_inde
     }
 }
 
-//--------------------------------------------------------------------------------------------------
-std::string GfxrVulkanCommandHierarchyCreator::GetCurrDrawCallString()
-{
-    // Early return for zero instance count
-    if (m_cur_draw_call_info.instance_count == 0)
-    {
-        return "";
-    }
-
-    std::ostringstream s;
-
-    s << "(";
-
-    if (m_cur_draw_call_info.index_count > 0)
-    {
-        s << "indexCount:" << m_cur_draw_call_info.index_count << ",";
-    }
-    else if (m_cur_draw_call_info.vertex_count > 0)
-    {
-        s << "vertexCount:" << m_cur_draw_call_info.vertex_count << ",";
-    }
-
-    s << "instanceCount:" << m_cur_draw_call_info.instance_count << ")";
-
-    return s.str();
-}
-
 //--------------------------------------------------------------------------------------------------
 void GfxrVulkanCommandHierarchyCreator::OnCommand(
     const DiveAnnotationProcessor::VulkanCommandInfo& vk_cmd_info, uint64_t draw_call_count,
     std::vector<uint64_t>& render_pass_draw_call_counts)
 {
-    const std::string& vulkan_cmd_name = vk_cmd_info.name;
-    const nlohmann::ordered_json& vulkan_cmd_args = vk_cmd_info.args;
+    const gfxrecon::decode::DiveVulkanCommandTable& command_table =
+        m_capture_data.GetVulkanCommandTable();
+    std::string_view vulkan_cmd_name = command_table.GetName(vk_cmd_info.command_id);
+    DiveVulkanCommandType command_type = command_table.GetType(vk_cmd_info.command_id);
+    // The arguments are decoded from the block when the node is selected
+    CommandHierarchy::AuxInfo aux_info =
+        CommandHierarchy::AuxInfo::GfxrNode(vk_cmd_info.block_index);
     std::ostringstream vk_cmd_string_stream;
     vk_cmd_string_stream << vulkan_cmd_name;
-    if (vulkan_cmd_name == "vkBeginCommandBuffer")
-    {
-        vk_cmd_string_stream << ", Draw Call Count: " << draw_call_count;
-        uint64_t cmd_buffer_index =
-            AddNode(NodeType::kGfxrVulkanBeginCommandBufferNode, vk_cmd_string_stream.str());
-        m_cur_command_buffer_node_index = cmd_buffer_index;
-        GetArgs(vulkan_cmd_args, m_cur_command_buffer_node_index);
-        AddChild(CommandHierarchy::TopologyType::kAllEventTopology, m_cur_submit_node_index,
-                 cmd_buffer_index);
-    }
-    else if (vulkan_cmd_name == "vkEndCommandBuffer")
-    {
-        uint64_t cmd_buffer_index =
-            AddNode(NodeType::kGfxrVulkanEndCommandBufferNode, vk_cmd_string_stream.str());
-
-        GetArgs(vulkan_cmd_args, cmd_buffer_index);
-        AddChild(CommandHierarchy::TopologyType::kAllEventTopology, m_cur_command_buffer_node_index,
-                 cmd_buffer_index);
-    }
-    else if (vulkan_cmd_name.find("BeginDebugUtilsLabelEXT") != std::string::npos)
-    {
-        std::string label_name = vulkan_cmd_args["pLabelInfo"]["pLabelName"];
 
-        uint64_t begin_debug_utils_label_cmd_index =
-            AddNode(NodeType::kGfxrBeginDebugUtilsLabelCommandNode, label_name.c_str());
-        GetArgs(vulkan_cmd_args, begin_debug_utils_label_cmd_index);
-        ConditionallyAddChild(begin_debug_utils_label_cmd_index);
-        m_cur_parent_node_index_stack.push(begin_debug_utils_label_cmd_index);
-    }
-    else if (vulkan_cmd_name.find("EndDebugUtilsLabelEXT") != std::string::npos)
+    NodeType node_type = NodeType::kGfxrVulkanCommandNode;
+    switch (command_type)
     {
-        if (!m_cur_parent_node_index_stack.empty() &&
-            m_command_hierarchy.GetNodeType(m_cur_parent_node_index_stack.top()) ==
-                NodeType::kGfxrBeginDebugUtilsLabelCommandNode)
+        case DiveVulkanCommandType::kBeginCommandBuffer:
         {
-            // Remove the corresponding begin debug utils node from the stack
-            m_cur_parent_node_index_stack.pop();
+            vk_cmd_string_stream << ", Draw Call Count: " << draw_call_count;
+            uint64_t cmd_buffer_index = AddNode(NodeType::kGfxrVulkanBeginCommandBufferNode,
+                                                vk_cmd_string_stream.str(), aux_info);
+            m_cur_command_buffer_node_index = cmd_buffer_index;
+            AddChild(CommandHierarchy::TopologyType::kAllEventTopology, m_cur_submit_node_index,
+                     cmd_buffer_index);
+            return;
         }
-    }
-    else if (vulkan_cmd_name.find("vkCmdDraw") != std::string::npos ||
-             vulkan_cmd_name.find("vkCmdDispatch") != std::string::npos)
-    {
-        m_cur_draw_call_info = {};
-
-        uint64_t vk_cmd_index =
-            AddNode(NodeType::kGfxrVulkanDrawCommandNode, vk_cmd_string_stream.str());
-        GetArgs(vulkan_cmd_args, vk_cmd_index);
-        ConditionallyAddChild(vk_cmd_index);
-
-        if (vulkan_cmd_name.find("vkCmdDraw") != std::string::npos)
+        case DiveVulkanCommandType::kEndCommandBuffer:
         {
-            std::string extra_info = GetCurrDrawCallString();
-            if (!extra_info.empty())
-            {
-                // Update the draw node description with info obtained from its args
-                vk_cmd_string_stream << extra_info;
-                m_command_hierarchy.SetNodeDesc(vk_cmd_index, vk_cmd_string_stream.str());
-            }
+            uint64_t cmd_buffer_index = AddNode(NodeType::kGfxrVulkanEndCommandBufferNode,
+                                                vk_cmd_string_stream.str(), aux_info);
+            AddChild(CommandHierarchy::TopologyType::kAllEventTopology,
+                     m_cur_command_buffer_node_index, cmd_buffer_index);
+            return;
         }
-    }
-    else if (vulkan_cmd_name.find("vkCmdBeginRenderPass") != std::string::npos)
-    {
-        if (!render_pass_draw_call_counts.empty())
+        case DiveVulkanCommandType::kBeginDebugUtilsLabel:
         {
-            draw_call_count = render_pass_draw_call_counts.front();
-            render_pass_draw_call_counts.erase(render_pass_draw_call_counts.begin());
+            // The details are the label name
+            std::string label_name(vk_cmd_info.details.empty() ? vulkan_cmd_name
+                                                               : vk_cmd_info.details);
+            uint64_t begin_debug_utils_label_cmd_index = AddNode(
+                NodeType::kGfxrBeginDebugUtilsLabelCommandNode, std::move(label_name), aux_info);
+            ConditionallyAddChild(begin_debug_utils_label_cmd_index);
+            m_cur_parent_node_index_stack.push(begin_debug_utils_label_cmd_index);
+            return;
         }
-        vk_cmd_string_stream << ", Draw Call Count: " << draw_call_count;
-        uint64_t vk_cmd_index =
-            AddNode(NodeType::kGfxrVulkanBeginRenderPassCommandNode, vk_cmd_string_stream.str());
-        GetArgs(vulkan_cmd_args, vk_cmd_index);
-        ConditionallyAddChild(vk_cmd_index);
-        m_cur_parent_node_index_stack.push(vk_cmd_index);
-    }
-    else if (vulkan_cmd_name.find("vkCmdEndRenderPass") != std::string::npos)
-    {
-        uint64_t vk_cmd_index =
-            AddNode(NodeType::kGfxrVulkanEndRenderPassCommandNode, vk_cmd_string_stream.str());
-        GetArgs(vulkan_cmd_args, vk_cmd_index);
-        ConditionallyAddChild(vk_cmd_index);
-        if (!m_cur_parent_node_index_stack.empty())
+        case DiveVulkanCommandType::kEndDebugUtilsLabel:
         {
-            // Remove the corresponding vkCmdBeginRenderPass node from the stack
-            m_cur_parent_node_index_stack.pop();
+            if (!m_cur_parent_node_index_stack.empty() &&
+                m_command_hierarchy.GetNodeType(m_cur_parent_node_index_stack.top()) ==
+                    NodeType::kGfxrBeginDebugUtilsLabelCommandNode)
+            {
+                // Remove the corresponding begin debug utils node from the stack
+                m_cur_parent_node_index_stack.pop();
+            }
+            return;
         }
-    }
-    else
-    {
-        NodeType node_type = NodeType::kGfxrVulkanCommandNode;
-        if (vulkan_cmd_name.find("vkCmdCopyBuffer") != std::string::npos)
+        case DiveVulkanCommandType::kDraw:
+        case DiveVulkanCommandType::kDispatch:
         {
-            node_type = NodeType::kGfxrVulkanCopyBufferCommandNode;
+            // The details of a draw are its counts
+            vk_cmd_string_stream << vk_cmd_info.details;
+            uint64_t vk_cmd_index = AddNode(NodeType::kGfxrVulkanDrawCommandNode,
+                                            vk_cmd_string_stream.str(), aux_info);
+            ConditionallyAddChild(vk_cmd_index);
+            return;
         }
-        else if (vulkan_cmd_name.find("vkCmdClearAttachments") != std::string::npos)
+        case DiveVulkanCommandType::kBeginRenderPass:
         {
-            node_type = NodeType::kGfxrVulkanClearAttachmentsCommandNode;
+            if (!render_pass_draw_call_counts.empty())
+            {
+                draw_call_count = render_pass_draw_call_counts.front();
+                render_pass_draw_call_counts.erase(render_pass_draw_call_counts.begin());
+            }
+            vk_cmd_string_stream << ", Draw Call Count: " << draw_call_count;
+            uint64_t vk_cmd_index = AddNode(NodeType::kGfxrVulkanBeginRenderPassCommandNode,
+                                            vk_cmd_string_stream.str(), aux_info);
+            ConditionallyAddChild(vk_cmd_index);
+            m_cur_parent_node_index_stack.push(vk_cmd_index);
+            return;
         }
-        else if (vulkan_cmd_name.find("vkCmdClearColorImage") != std::string::npos)
+        case DiveVulkanCommandType::kEndRenderPass:
         {
-            node_type = NodeType::kGfxrVulkanClearColorImageCommandNode;
+            uint64_t vk_cmd_index = AddNode(NodeType::kGfxrVulkanEndRenderPassCommandNode,
+                                            vk_cmd_string_stream.str(), aux_info);
+            ConditionallyAddChild(vk_cmd_index);
+            if (!m_cur_parent_node_index_stack.empty())
+            {
+                // Remove the corresponding vkCmdBeginRenderPass node from the stack
+                m_cur_parent_node_index_stack.pop();
+            }
+            return;
         }
-        else if (vulkan_cmd_name.find("vkCmdClearDepthStencilImage") != std::string::npos)
-        {
+        case DiveVulkanCommandType::kCopyBuffer:
+            node_type = NodeType::kGfxrVulkanCopyBufferCommandNode;
+            break;
+        case DiveVulkanCommandType::kClearAttachments:
+            node_type = NodeType::kGfxrVulkanClearAttachmentsCommandNode;
+            break;
+        case DiveVulkanCommandType::kClearColorImage:
+            node_type = NodeType::kGfxrVulkanClearColorImageCommandNode;
+            break;
+        case DiveVulkanCommandType::kClearDepthStencilImage:
             node_type = NodeType::kGfxrVulkanClearDepthStencilImageCommandNode;
-        }
-        else if (vulkan_cmd_name.find("vkCmdResolveImage") != std::string::npos)
-        {
+            break;
+        case DiveVulkanCommandType::kResolveImage:
             node_type = NodeType::kGfxrVulkanResolveImageCommandNode;
-        }
-
-        uint64_t vk_cmd_index = AddNode(node_type, vk_cmd_string_stream.str());
-        GetArgs(vulkan_cmd_args, vk_cmd_index);
-        ConditionallyAddChild(vk_cmd_index);
+            break;
+        case DiveVulkanCommandType::kQueueSubmit:
+        case DiveVulkanCommandType::kOther:
+            break;
     }
+
+    uint64_t vk_cmd_index = AddNode(node_type, vk_cmd_string_stream.str(), aux_info);
+    ConditionallyAddChild(vk_cmd_index);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -210,8 +177,7 @@ bool GfxrVulkanCommandHierarchyCreator::ProcessVkCmds(
 
     for (uint32_t i = 0; i < vkCmds.size(); ++i)
     {
-        DiveAnnotationProcessor::VulkanCommandInfo vk_cmd_info = vkCmds[i];
-        OnCommand(vk_cmd_info, draw_call_count, mutable_render_pass_draw_call_counts);
+        OnCommand(vkCmds[i], draw_call_count, mutable_render_pass_draw_call_counts);
     }
 
     // Ensure the parent node index stack is cleared
@@ -285,9 +251,33 @@ bool GfxrVulkanCommandHierarchyCreator::CreateTrees(bool used_in_mixed_command_h
 }
 
 //--------------------------------------------------------------------------------------------------
-uint64_t GfxrVulkanCommandHierarchyCreator::AddNode(NodeType type, std::string&& desc)
+bool GfxrVulkanCommandHierarchyCreator::CreateArgumentTrees(std::string_view command_desc,
+                                                            const nlohmann::ordered_json& args)
+{
+    m_used_in_mixed_command_hierarchy = false;
+    ClearCreatedDiveIndices();
+    for (auto& node_children : m_node_children)
+    {
+        node_children.clear();
+    }
+    m_command_hierarchy = CommandHierarchy();
+
+    uint64_t root_node_index = AddNode(NodeType::kRootNode, "");
+    DIVE_VERIFY(root_node_index == Topology::kRootNodeIndex);
+    uint64_t command_node_index =
+        AddNode(NodeType::kGfxrVulkanCommandNode, std::string(command_desc));
+    AddChild(CommandHierarchy::kAllEventTopology, root_node_index, command_node_index);
+    GetArgs(args, command_node_index);
+
+    CreateTopologies();
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+uint64_t GfxrVulkanCommandHierarchyCreator::AddNode(NodeType type, std::string&& desc,
+                                                    CommandHierarchy::AuxInfo aux_info)
 {
-    uint64_t node_index = m_command_hierarchy.AddGfxrNode(type, std::move(desc));
+    uint64_t node_index = m_command_hierarchy.AddGfxrNode(type, std::move(desc), aux_info);
 
     if (m_used_in_mixed_command_hierarchy)
     {
@@ -326,44 +316,7 @@ void GfxrVulkanCommandHierarchyCreator::AddChild(CommandHierarchy::TopologyType
     }
 }
 
-bool GfxrVulkanCommandHierarchyCreator::ParseCurDrawCallInfo(std::string_view key,
-                                                             std::string_view val)
-{
-    if (key == "indexCount")
-    {
-        uint64_t value = 0;
-        if (!absl::SimpleAtoi(val, &value))
-        {
-            return false;
-        }
-        m_cur_draw_call_info.index_count = value;
-        return true;
-    }
-    if (key == "vertexCount")
-    {
-        uint64_t value = 0;
-        if (!absl::SimpleAtoi(val, &value))
-        {
-            return false;
-        }
-        m_cur_draw_call_info.vertex_count = value;
-        return true;
-    }
-    if (key == "instanceCount")
-    {
-        uint64_t value = 0;
-        if (!absl::SimpleAtoi(val, &value))
-        {
-            return false;
-        }
-        m_cur_draw_call_info.instance_count = value;
-        return true;
-    }
-
-    // key is unrelated to DrawCallDescInfo
-    return true;
-}
-
+//--------------------------------------------------------------------------------------------------
 void GfxrVulkanCommandHierarchyCreator::GetArgs(const nlohmann::ordered_json& json_args,
                                                 uint64_t curr_index)
 {
@@ -425,24 +378,10 @@ void GfxrVulkanCommandHierarchyCreator::GetArgs(const nlohmann::ordered_json& js
             }
             else
             {
-                std::ostringstream s;
-                std::string val_str;
-
-                s.str("");
-                s << val;
-                val_str = s.str();
-
-                s.str("");
-                s << key << ":" << val;
-
-                if (!ParseCurDrawCallInfo(key, val_str))
-                {
-                    std::cerr << "GfxrVulkanCommandHierarchyCreator::GetArgs() "
-                              << "could not parse draw call info from: " << s.str() << std::endl;
-                }
-
                 // If the value is a primitive,
                 // create a node containing the "key:value" pair.
+                std::ostringstream s;
+                s << key << ":" << val;
 
                 uint64_t vk_cmd_arg_index = AddNode(NodeType::kGfxrVulkanCommandArgNode, s.str());
                 AddChild(CommandHierarchy::TopologyType::kAllEventTopology, curr_index,
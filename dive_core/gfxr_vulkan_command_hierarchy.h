@@ -20,6 +20,7 @@
 // =====================================================================================================================
 
 #include <stack>
+#include <string_view>
 
 #include "dive_core/command_hierarchy.h"
 #include "dive_core/common/emulate_pm4.h"
@@ -35,6 +36,12 @@ class GfxrVulkanCommandHierarchyCreator
     ~GfxrVulkanCommandHierarchyCreator();
 
     bool CreateTrees(bool used_in_mixed_command_hierarchy = false);
+
+    // The nodes of the commands don't include their arguments, which are decoded on demand (see
+    // GfxrCaptureData::GetCommandArgs). This creates a separate hierarchy for the arguments of a
+    // single command instead, with a node for the command under the root node and the arguments
+    // under it
+    bool CreateArgumentTrees(std::string_view command_desc, const nlohmann::ordered_json& args);
     bool ProcessGfxrSubmits(const GfxrCaptureData& capture_date);
 
     void OnGfxrSubmit(uint32_t submit_index,
@@ -70,7 +77,8 @@ class GfxrVulkanCommandHierarchyCreator
     //
     // Also may add node to m_dive_indices_to_local_indices_map and reserve space in m_node_children
     // for future appends
-    uint64_t AddNode(NodeType type, std::string&& desc);
+    uint64_t AddNode(NodeType type, std::string&& desc,
+                     CommandHierarchy::AuxInfo aux_info = CommandHierarchy::AuxInfo(0));
 
     // Updates m_node_children
     void AddChild(CommandHierarchy::TopologyType type, uint64_t node_index,
@@ -88,27 +96,5 @@ class GfxrVulkanCommandHierarchyCreator
     Topology m_topology[CommandHierarchy::kTopologyTypeCount];
     bool m_used_in_mixed_command_hierarchy = false;
     std::unordered_map<uint64_t, uint64_t> m_dive_indices_to_local_indices_map;
-
-    // Additional info that will be displayed in the description of a draw call node
-    struct DrawCallDescInfo
-    {
-        uint64_t index_count = 0;
-        uint64_t vertex_count = 0;
-        uint64_t instance_count = 0;
-    };
-
-    // Returns false if key was recognized to correspond to a DrawCallDescInfo field but val could
-    // not be parsed
-    bool ParseCurDrawCallInfo(std::string_view key, std::string_view val);
-
-    // Forms string of drawcall info, some examples:
-    //
-    // vkCmdDraw: "(vertexCount=#,instanceCount=#)"
-    // vkCmdDrawIndexed: "(indexCount=#,instanceCount=#)"
-    // vkCmdDrawMultiEXT: "(instanceCount=#)"
-    // vkCmdDraw* without instanceCount parameter: ""
-    std::string GetCurrDrawCallString();
-
-    DrawCallDescInfo m_cur_draw_call_info;
 };
 }  // namespace Dive
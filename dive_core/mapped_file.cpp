@@ -0,0 +1,86 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Dive
+{
+
+//--------------------------------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    if (m_data != nullptr) UnmapViewOfFile(m_data);
+    if (m_mapping_handle != nullptr) CloseHandle(m_mapping_handle);
+    if (m_file_handle != nullptr) CloseHandle(m_file_handle);
+#else
+    if (m_data != nullptr) munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+std::shared_ptr<MappedFile> MappedFile::Open(const char* file_name)
+{
+    std::shared_ptr<MappedFile> mapped_file(new MappedFile());
+#ifdef _WIN32
+    HANDLE file_handle = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                     OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) return nullptr;
+    mapped_file->m_file_handle = file_handle;
+
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart <= 0) return nullptr;
+
+    HANDLE mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) return nullptr;
+    mapped_file->m_mapping_handle = mapping_handle;
+
+    void* data = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) return nullptr;
+    mapped_file->m_data = static_cast<const uint8_t*>(data);
+    mapped_file->m_size = static_cast<uint64_t>(file_size.QuadPart);
+#else
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    // The mapping holds its own reference to the file, so the descriptor can be closed right away
+    void* data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return nullptr;
+    mapped_file->m_data = static_cast<const uint8_t*>(data);
+    mapped_file->m_size = static_cast<uint64_t>(file_stat.st_size);
+#endif
+    return mapped_file;
+}
+
+}  // namespace Dive
@@ -0,0 +1,48 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+#include <cstdint>
+#include <memory>
+
+namespace Dive
+{
+
+//--------------------------------------------------------------------------------------------------
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+ public:
+    ~MappedFile();
+
+    // Map the given file. Returns nullptr if the file cannot be opened or mapped
+    static std::shared_ptr<MappedFile> Open(const char* file_name);
+
+    const uint8_t* GetData() const { return m_data; }
+    uint64_t GetSize() const { return m_size; }
+
+ private:
+    MappedFile() = default;
+
+    const uint8_t* m_data = nullptr;
+    uint64_t m_size = 0;
+#ifdef _WIN32
+    void* m_file_handle = nullptr;
+    void* m_mapping_handle = nullptr;
+#endif
+};
+
+}  // namespace Dive
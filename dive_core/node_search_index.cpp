@@ -0,0 +1,229 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "node_search_index.h"
+
+#include <algorithm>
+
+#include "absl/strings/ascii.h"
+#include "command_hierarchy.h"
+
+namespace Dive
+{
+
+namespace
+{
+// How often to check whether a build or search is cancelled, in nodes
+constexpr size_t kCancelCheckInterval = 4096;
+
+bool IsCancelled(const std::atomic<bool>* cancel)
+{
+    return cancel != nullptr && cancel->load(std::memory_order_relaxed);
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------------------
+bool NodeSearchIndex::Build(const CommandHierarchy& command_hierarchy, const Topology& topology,
+                            const std::atomic<bool>* cancel)
+{
+    Clear();
+
+    // Pre-order traversal, with the children pushed in reverse so that they are visited in order
+    std::vector<uint64_t> stack;
+    auto push_children = [&stack, &topology](uint64_t node_index) {
+        for (uint64_t child = topology.GetNumChildren(node_index); child > 0; --child)
+        {
+            stack.push_back(topology.GetChildNodeIndex(node_index, child - 1));
+        }
+    };
+    if (topology.GetNumNodes() != 0)
+    {
+        push_children(Topology::kRootNodeIndex);
+    }
+
+    // The distinct trigrams of each node's description, one node after the other. Those of the node
+    // at position i end at node_trigram_ends[i]
+    std::vector<Trigram> node_trigrams;
+    std::vector<size_t> node_trigram_ends;
+    std::string desc;
+    while (!stack.empty())
+    {
+        if ((m_node_indices.size() % kCancelCheckInterval) == 0 && IsCancelled(cancel))
+        {
+            Clear();
+            return false;
+        }
+
+        uint64_t node_index = stack.back();
+        stack.pop_back();
+        push_children(node_index);
+
+        m_node_indices.push_back(node_index);
+
+        command_hierarchy.GetNodeDesc(node_index, desc);
+        absl::AsciiStrToLower(&desc);
+        size_t node_begin = node_trigrams.size();
+        for (size_t i = 0; i + 3 <= desc.size(); ++i)
+        {
+            node_trigrams.push_back(GetTrigram(&desc[i]));
+        }
+        std::sort(node_trigrams.begin() + node_begin, node_trigrams.end());
+        node_trigrams.erase(std::unique(node_trigrams.begin() + node_begin, node_trigrams.end()),
+                            node_trigrams.end());
+        node_trigram_ends.push_back(node_trigrams.size());
+    }
+
+    if (IsCancelled(cancel))
+    {
+        Clear();
+        return false;
+    }
+
+    // Trigrams are 24 bits, so a bit per possible trigram is enough to list them in order
+    std::vector<bool> found_trigrams(Trigram(1) << 24);
+    for (Trigram trigram : node_trigrams)
+    {
+        found_trigrams[trigram] = true;
+    }
+    for (Trigram trigram = 0; trigram < found_trigrams.size(); ++trigram)
+    {
+        if (found_trigrams[trigram])
+        {
+            m_trigrams.push_back(trigram);
+        }
+    }
+
+    // Replace each trigram by its index in m_trigrams, counting the nodes of each one
+    m_trigram_offsets.assign(m_trigrams.size() + 1, 0);
+    for (Trigram& trigram : node_trigrams)
+    {
+        trigram = static_cast<Trigram>(
+            std::lower_bound(m_trigrams.begin(), m_trigrams.end(), trigram) - m_trigrams.begin());
+        ++m_trigram_offsets[trigram + 1];
+    }
+    for (size_t i = 1; i < m_trigram_offsets.size(); ++i)
+    {
+        m_trigram_offsets[i] += m_trigram_offsets[i - 1];
+    }
+
+    // Going through the nodes in order keeps the positions of each trigram in increasing order
+    m_positions.resize(node_trigrams.size());
+    std::vector<uint64_t> next_offsets(m_trigram_offsets.begin(), m_trigram_offsets.end() - 1);
+    size_t node_begin = 0;
+    for (uint32_t position = 0; position < node_trigram_ends.size(); ++position)
+    {
+        for (size_t i = node_begin; i < node_trigram_ends[position]; ++i)
+        {
+            m_positions[next_offsets[node_trigrams[i]]++] = position;
+        }
+        node_begin = node_trigram_ends[position];
+    }
+    m_command_hierarchy = &command_hierarchy;
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool NodeSearchIndex::Search(std::string_view text, const ResultCallback& on_results,
+                             const std::atomic<bool>* cancel) const
+{
+    std::string lower_text(text);
+    absl::AsciiStrToLower(&lower_text);
+    if (lower_text.empty())
+    {
+        return true;
+    }
+
+    // Only the nodes that contain the rarest trigram of the text need to be checked. A text that
+    // is too short to have a trigram is checked against all the nodes
+    bool check_all = lower_text.size() < 3;
+    const uint32_t* candidates = nullptr;
+    size_t num_candidates = check_all ? m_node_indices.size() : SIZE_MAX;
+    for (size_t i = 0; i + 3 <= lower_text.size(); ++i)
+    {
+        Trigram trigram = GetTrigram(&lower_text[i]);
+        auto it = std::lower_bound(m_trigrams.begin(), m_trigrams.end(), trigram);
+        if (it == m_trigrams.end() || *it != trigram)
+        {
+            // No description contains this trigram
+            return true;
+        }
+        size_t trigram_index = it - m_trigrams.begin();
+        size_t count = m_trigram_offsets[trigram_index + 1] - m_trigram_offsets[trigram_index];
+        if (count < num_candidates)
+        {
+            num_candidates = count;
+            candidates = &m_positions[m_trigram_offsets[trigram_index]];
+        }
+    }
+
+    std::vector<uint64_t> batch;
+    batch.reserve(std::min(num_candidates, kResultBatchSize));
+    std::string desc;
+    for (size_t i = 0; i < num_candidates; ++i)
+    {
+        if ((i % kCancelCheckInterval) == 0 && IsCancelled(cancel))
+        {
+            return false;
+        }
+
+        uint32_t position = check_all ? static_cast<uint32_t>(i) : candidates[i];
+        GetLowerDesc(position, desc);
+        if (desc.find(lower_text) == std::string::npos)
+        {
+            continue;
+        }
+        batch.push_back(m_node_indices[position]);
+        if (batch.size() == kResultBatchSize)
+        {
+            if (!on_results(batch))
+            {
+                return false;
+            }
+            batch.clear();
+        }
+    }
+    return batch.empty() || on_results(batch);
+}
+
+//--------------------------------------------------------------------------------------------------
+std::vector<uint64_t> NodeSearchIndex::Search(std::string_view text) const
+{
+    std::vector<uint64_t> results;
+    Search(text, [&results](const std::vector<uint64_t>& node_indices) {
+        results.insert(results.end(), node_indices.begin(), node_indices.end());
+        return true;
+    });
+    return results;
+}
+
+//--------------------------------------------------------------------------------------------------
+void NodeSearchIndex::GetLowerDesc(uint32_t position, std::string& desc) const
+{
+    m_command_hierarchy->GetNodeDesc(m_node_indices[position], desc);
+    absl::AsciiStrToLower(&desc);
+}
+
+//--------------------------------------------------------------------------------------------------
+void NodeSearchIndex::Clear()
+{
+    m_command_hierarchy = nullptr;
+    m_node_indices.clear();
+    m_trigrams.clear();
+    m_trigram_offsets.clear();
+    m_positions.clear();
+}
+
+}  // namespace Dive
@@ -0,0 +1,92 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Dive
+{
+class CommandHierarchy;
+class Topology;
+
+//--------------------------------------------------------------------------------------------------
+// Finds the nodes of a topology whose description contains some text, ignoring ASCII case. For
+// each trigram (3 consecutive characters) found in the descriptions, the index lists the nodes
+// whose description contains it. So only the nodes that contain the rarest trigram of the text
+// have their description checked, instead of all of them. The nodes are kept in the pre-order of
+// the topology, which is the order they are displayed in, and results are reported in that order.
+//
+// The index doesn't keep the descriptions: those of the candidate nodes are formatted again when
+// searching. So the command hierarchy must outlive the index, and must not be modified while a
+// search runs.
+class NodeSearchIndex
+{
+ public:
+    // Called with each batch of results. Returning false stops the search
+    using ResultCallback = std::function<bool(const std::vector<uint64_t>& node_indices)>;
+
+    static constexpr size_t kResultBatchSize = 1024;
+
+    // Indexes all the nodes of the topology except the root. This can run on a worker thread, as
+    // long as the command hierarchy isn't modified meanwhile. Stops early and returns false,
+    // leaving the index empty, once cancel is set
+    bool Build(const CommandHierarchy& command_hierarchy, const Topology& topology,
+               const std::atomic<bool>* cancel = nullptr);
+
+    // Returns false if the search was stopped early, by cancel or by on_results. This can run on a
+    // worker thread, with the same restrictions as Build()
+    bool Search(std::string_view text, const ResultCallback& on_results,
+                const std::atomic<bool>* cancel = nullptr) const;
+
+    // Returns all the results at once
+    std::vector<uint64_t> Search(std::string_view text) const;
+
+    size_t GetNumNodes() const { return m_node_indices.size(); }
+
+ private:
+    using Trigram = uint32_t;
+
+    static Trigram GetTrigram(const char* str)
+    {
+        return (Trigram(uint8_t(str[0])) << 16) | (Trigram(uint8_t(str[1])) << 8) |
+               Trigram(uint8_t(str[2]));
+    }
+
+    // Writes the lower case description of the node at the position into desc
+    void GetLowerDesc(uint32_t position, std::string& desc) const;
+
+    void Clear();
+
+    const CommandHierarchy* m_command_hierarchy = nullptr;
+
+    // Node indices, in pre-order of the topology. Positions in this order are what the rest of the
+    // index refers to
+    std::vector<uint64_t> m_node_indices;
+
+    // Sorted trigrams. The positions of the nodes whose description contains m_trigrams[i] are
+    // [m_trigram_offsets[i], m_trigram_offsets[i + 1]) of m_positions, in increasing order
+    std::vector<Trigram> m_trigrams;
+    std::vector<uint64_t> m_trigram_offsets;
+    std::vector<uint32_t> m_positions;
+};
+
+}  // namespace Dive
@@ -15,9 +15,11 @@
 
 #include <math.h>
 
+#include <algorithm>
 #include <array>
 #include <cctype>
 #include <cerrno>
+#include <charconv>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
@@ -28,6 +30,8 @@
 #include <limits>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -35,6 +39,7 @@
 #include "absl/base/no_destructor.h"
 #include "dive_core/available_metrics.h"
 #include "dive_core/command_hierarchy.h"
+#include "dive_core/mapped_file.h"
 #include "utils/string_utils.h"
 
 namespace Dive
@@ -160,51 +165,80 @@ std::optional<ParseHeadersResult> ParseHeaders(const std::string& line,
     return ParseHeadersResult{std::move(metric_names), std::move(metric_infos)};
 }
 
-std::optional<PerfMetricsRecord> ParseRecordFixedFields(const std::vector<std::string>& fields)
+// Splits the next line off data, without the line ending
+std::string_view GetLine(std::string_view& data)
 {
-    if (fields.size() < kFixedPerfMetricsDataHeaderCount)
+    size_t end = data.find('\n');
+    std::string_view line = data.substr(0, end);
+    data.remove_prefix(end == std::string_view::npos ? data.size() : end + 1);
+    return line;
+}
+
+// Splits the next field of a line off line. Returns false if there are no fields left
+bool GetField(std::string_view& line, std::string_view& field)
+{
+    if (line.data() == nullptr)
     {
-        return std::nullopt;
+        return false;
     }
+    size_t end = line.find(',');
+    field = line.substr(0, end);
+    // Past the last field, the line is set to null rather than to empty, so that an empty last
+    // field is still returned
+    line = (end == std::string_view::npos) ? std::string_view() : line.substr(end + 1);
+    return true;
+}
 
-    PerfMetricsRecord record{};
-    if (!StringUtils::SafeConvertFromString(fields[0], record.m_context_id) ||
-        !StringUtils::SafeConvertFromString(fields[1], record.m_process_id) ||
-        !StringUtils::SafeConvertFromString(fields[2], record.m_frame_id) ||
-        !StringUtils::SafeConvertFromString(fields[3], record.m_cmd_buffer_id) ||
-        !StringUtils::SafeConvertFromString(fields[4], record.m_draw_id) ||
-        !StringUtils::SafeConvertFromString(fields[5], record.m_draw_type) ||
-        !StringUtils::SafeConvertFromString(fields[6], record.m_draw_label) ||
-        !StringUtils::SafeConvertFromString(fields[7], record.m_program_id) ||
-        !StringUtils::SafeConvertFromString(fields[8], record.m_lrz_state))
+// Parses a field with std::from_chars, which doesn't need a null-terminated copy of the field.
+// Surrounding whitespace and quotes are ignored, like StringUtils::GetTrimmedField() does
+template <typename T>
+bool ParseField(std::string_view field, T& out)
+{
+    auto is_space = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
+    while (!field.empty() && is_space(field.front())) field.remove_prefix(1);
+    while (!field.empty() && is_space(field.back())) field.remove_suffix(1);
+    if (field.size() >= 2 && field.front() == '"' && field.back() == '"')
     {
-        return std::nullopt;  // Parsing failed
+        field = field.substr(1, field.size() - 2);
     }
-    return record;
+
+    const char* end = field.data() + field.size();
+    auto [ptr, ec] = std::from_chars(field.data(), end, out);
+    return ec == std::errc() && ptr == end && !field.empty();
 }
 
-bool ParseMetrics(const std::vector<std::string>& fields,
-                  const std::vector<const MetricInfo*>& metric_infos, PerfMetricsRecord& record)
+bool ParseRecordFixedFields(std::string_view& line, PerfMetricsRecord& record)
 {
-    for (size_t i = 0; i < metric_infos.size(); ++i)
+    std::string_view fields[kFixedPerfMetricsDataHeaderCount];
+    for (std::string_view& field : fields)
     {
-        const std::string& value_str = fields[kFixedPerfMetricsDataHeaderCount + i];
-        const MetricInfo* info = metric_infos[i];
-        if (info == nullptr)
+        if (!GetField(line, field))
         {
-            // Unknown metric, this is an error. The number of metric values
-            // will not match the number of metric names.
             return false;
         }
+    }
 
-        double value = NAN;
-        if (!StringUtils::SafeConvertFromString(value_str, value))
+    return ParseField(fields[0], record.m_context_id) &&
+           ParseField(fields[1], record.m_process_id) &&
+           ParseField(fields[2], record.m_frame_id) &&
+           ParseField(fields[3], record.m_cmd_buffer_id) &&
+           ParseField(fields[4], record.m_draw_id) && ParseField(fields[5], record.m_draw_type) &&
+           ParseField(fields[6], record.m_draw_label) &&
+           ParseField(fields[7], record.m_program_id) && ParseField(fields[8], record.m_lrz_state);
+}
+
+// The line must have exactly one value per metric left
+bool ParseMetrics(std::string_view line, std::vector<double>& metric_values)
+{
+    std::string_view field;
+    for (double& value : metric_values)
+    {
+        if (!GetField(line, field) || !ParseField(field, value))
         {
             return false;
         }
-        record.m_metric_values.emplace_back(value);
     }
-    return true;
+    return !GetField(line, field);
 }
 
 }  // namespace
@@ -212,18 +246,18 @@ bool ParseMetrics(const std::vector<std::string>& fields,
 std::unique_ptr<PerfMetricsData> PerfMetricsData::LoadFromCsv(
     const std::filesystem::path& file_path, const AvailableMetrics& available_metrics)
 {
-    std::vector<PerfMetricsRecord> records;
-
-    std::ifstream file(file_path);
-    if (!file.is_open())
+    std::shared_ptr<MappedFile> file = MappedFile::Open(file_path.string().c_str());
+    if (file == nullptr)
     {
         std::cerr << "Failed to open file: " << file_path << std::endl;
         return nullptr;
     }
+    std::string_view data(reinterpret_cast<const char*>(file->GetData()), file->GetSize());
 
-    std::string line;
     // Read header line
-    if (!StringUtils::GetTrimmedLine(file, line) || line.empty())
+    std::string line(GetLine(data));
+    StringUtils::Trim(line);
+    if (line.empty())
     {
         return nullptr;
     }
@@ -256,47 +290,64 @@ std::unique_ptr<PerfMetricsData> PerfMetricsData::LoadFromCsv(
                 return nullptr;
         }
     }
-    // Read data lines
-    while (StringUtils::GetTrimmedLine(file, line))
-    {
-        std::stringstream ss(line);
-        std::string field;
-        std::vector<std::string> fields;
-        while (StringUtils::GetTrimmedField(ss, field, ','))
-        {
-            fields.push_back(field);
-        }
 
-        if (fields.size() != kFixedPerfMetricsDataHeaderCount + metric_names.size())
-        {
-            continue;  // Skip malformed lines
-        }
+    // There is at most one record per line left
+    size_t max_records = std::count(data.begin(), data.end(), '\n') + 1;
+    std::vector<PerfMetricsRecord> records;
+    records.reserve(max_records);
+    std::vector<std::vector<double>> metric_values(metric_names.size());
+    for (std::vector<double>& values : metric_values)
+    {
+        values.reserve(max_records);
+    }
 
-        auto record = ParseRecordFixedFields(fields);
-        if (!record.has_value())
+    // Read data lines
+    std::vector<double> record_metric_values(metric_names.size());
+    while (!data.empty())
+    {
+        std::string_view record_line = GetLine(data);
+        PerfMetricsRecord record{};
+        if (!ParseRecordFixedFields(record_line, record) ||
+            !ParseMetrics(record_line, record_metric_values))
         {
             continue;  // Skip malformed lines
         }
 
-        if (ParseMetrics(fields, metric_infos, *record))
+        records.push_back(std::move(record));
+        for (size_t i = 0; i < metric_values.size(); ++i)
         {
-            records.push_back(*std::move(record));
+            metric_values[i].push_back(record_metric_values[i]);
         }
     }
 
-    return std::unique_ptr<PerfMetricsData>(
-        new PerfMetricsData(std::move(metric_names), std::move(metric_infos), std::move(records)));
+    return std::unique_ptr<PerfMetricsData>(new PerfMetricsData(std::move(metric_names),
+                                                                std::move(metric_infos),
+                                                                std::move(records),
+                                                                std::move(metric_values)));
 }
 
 PerfMetricsData::PerfMetricsData(std::vector<std::string> metric_names,
                                  std::vector<const MetricInfo*> metric_infos,
-                                 std::vector<PerfMetricsRecord> records)
+                                 std::vector<PerfMetricsRecord> records,
+                                 std::vector<std::vector<double>> metric_values)
     : m_metric_names(std::move(metric_names)),
       m_metric_infos(std::move(metric_infos)),
-      m_records(std::move(records))
+      m_records(std::move(records)),
+      m_metric_values(std::move(metric_values))
 {
 }
 
+PerfMetricsRecord PerfMetricsData::GetRecord(size_t record_index) const
+{
+    PerfMetricsRecord record = m_records[record_index];
+    record.m_metric_values.reserve(m_metric_values.size());
+    for (const std::vector<double>& values : m_metric_values)
+    {
+        record.m_metric_values.push_back(values[record_index]);
+    }
+    return record;
+}
+
 class PerfMetricsDataProvider::Correlator
 {
     struct NodeTag;
@@ -321,7 +372,7 @@ class PerfMetricsDataProvider::Correlator
         m_draw_to_metric.clear();
         m_metric_to_draw.clear();
 
-        m_record_to_metric.clear();
+        m_matched_frames.clear();
     }
 
     void AnalyzeCommands(const CommandHierarchy&);
@@ -330,7 +381,9 @@ class PerfMetricsDataProvider::Correlator
 
     size_t GetPatternSize() const { return m_metric_to_draw.size(); }
 
-    MetricIndex MatchOf(RecordIndex index) const { return index.Into(m_record_to_metric); }
+    // The first record of each frame that matches the pattern. The records of such a frame are
+    // [start, start + GetPatternSize()), and the record at start + i matches MetricIndex(i)
+    const std::vector<RecordIndex>& GetMatchedFrames() const { return m_matched_frames; }
 
     NodeIndex GetNodeFromDraw(DrawIndex index) const { return index.Into(m_draw_to_node); }
     DrawIndex GetDrawFromNode(NodeIndex index) const { return index.Into(m_node_to_draw); }
@@ -385,7 +438,7 @@ class PerfMetricsDataProvider::Correlator
     ArrayMap<DrawIndex, MetricIndex> m_draw_to_metric;
     ArrayMap<MetricIndex, DrawIndex> m_metric_to_draw;
 
-    ArrayMap<RecordIndex, MetricIndex> m_record_to_metric;
+    std::vector<RecordIndex> m_matched_frames;
 };
 
 void PerfMetricsDataProvider::Correlator::ExtractDraws(
@@ -511,7 +564,7 @@ bool PerfMetricsDataProvider::Correlator::MatchDrawSignatures(const DrawSignatur
 void PerfMetricsDataProvider::Correlator::AnalyzeRecords(
     const std::vector<PerfMetricsRecord>& records)
 {
-    m_record_to_metric.clear();
+    m_matched_frames.clear();
 
     if (records.empty())
     {
@@ -563,7 +616,7 @@ void PerfMetricsDataProvider::Correlator::AnalyzeRecords(
         records.data() + template_frame_start + template_frame_size,
     };
 
-    ArrayMap<RecordIndex, MetricIndex> record_to_metric(records.size());
+    std::vector<RecordIndex> matched_frames;
     {
         size_t frame_start = 0;
         auto emit_frame = [&](size_t start, size_t end) {
@@ -572,11 +625,7 @@ void PerfMetricsDataProvider::Correlator::AnalyzeRecords(
                 // Bad data?
                 return;
             }
-            const size_t frame_size = end - start;
-            for (int i = 0; i < frame_size; ++i)
-            {
-                record_to_metric[start + i] = MetricIndex(i);
-            }
+            matched_frames.push_back(RecordIndex(start));
         };
         for (size_t i = 0; i < records.size(); ++i)
         {
@@ -589,7 +638,7 @@ void PerfMetricsDataProvider::Correlator::AnalyzeRecords(
         emit_frame(frame_start, records.size());
     }
 
-    m_record_to_metric = std::move(record_to_metric);
+    m_matched_frames = std::move(matched_frames);
     m_draw_to_metric = std::move(draw_to_metric);
     m_metric_to_draw = std::move(metric_to_draw);
 }
@@ -641,71 +690,53 @@ void PerfMetricsDataProvider::Analyze(const CommandHierarchy* command_hierarchy)
     m_correlator->AnalyzeRecords(records);
 
     const size_t pattern_size = m_correlator->GetPatternSize();
+    const auto& matched_frames = m_correlator->GetMatchedFrames();
+    m_computed_records.clear();
     m_computed_records.resize(pattern_size);
 
-    // This map will store intermediate sums and counts for averaging.
-    // Key: {cmd_buffer_id, draw_id}
-    // Value: {vector of metric sums, count of records}
-    struct MetricSumWithRecordCount
-    {
-        std::vector<double> m_metric_sums;
-        uint32_t m_record_count = 0;
-    };
-
-    std::vector<MetricSumWithRecordCount> sums_and_counts;
-    sums_and_counts.resize(pattern_size);
-
-    size_t skipped = 0;
-    for (size_t record_index = 0; record_index < records.size(); ++record_index)
-    {
-        auto pattern_index = m_correlator->MatchOf(Correlator::RecordIndex(record_index));
-        if (!pattern_index)
-        {
-            ++skipped;
-            continue;
-        }
-        auto& record = records[record_index];
-        auto& draw_call_data = sums_and_counts[*pattern_index];
-        if (draw_call_data.m_record_count == 0)
-        {
-            draw_call_data.m_metric_sums.resize(num_metrics);
-
-            m_computed_records[*pattern_index] = record;
-        }
-
-        if (record.m_metric_values.size() == num_metrics)
-        {
-            for (size_t i = 0; i < num_metrics; ++i)
-            {
-                draw_call_data.m_metric_sums[i] += record.m_metric_values[i];
-            }
-            draw_call_data.m_record_count++;
-        }
-    }
+    const size_t skipped = records.size() - matched_frames.size() * pattern_size;
     if (skipped)
     {
         std::cerr << "Skipping " << skipped << " metrics." << std::endl;
     }
+    if (matched_frames.empty())
+    {
+        return;
+    }
 
-    // Now, build the final m_computed_records vector with averaged records in order.
+    // The fixed fields are those of the first matching frame. frame_id for aggregated data is
+    // meaningless.
+    const size_t first_frame_start = *matched_frames.front();
     for (size_t draw_index = 0; draw_index < pattern_size; ++draw_index)
     {
         PerfMetricsRecord& averaged_record = m_computed_records[draw_index];
-        averaged_record.m_metric_values.clear();
-        // frame_id for aggregated data is meaningless.
+        averaged_record = records[first_frame_start + draw_index];
         averaged_record.m_frame_id = 0;
+        averaged_record.m_metric_values.reserve(num_metrics);
+    }
 
-        const auto count = sums_and_counts[draw_index].m_record_count;
-        auto& sums = sums_and_counts[draw_index].m_metric_sums;
-        if (count == 0 || sums.empty())
+    // Every matching frame has a record for each draw of the pattern, in the same order. So the
+    // values of a metric for a frame are added to the sums of all the draws at once, which is a
+    // contiguous loop that the compiler vectorizes. The sums are in the same order as adding the
+    // records one at a time would be.
+    std::vector<double> sums(pattern_size);
+    for (size_t metric_index = 0; metric_index < num_metrics; ++metric_index)
+    {
+        std::fill(sums.begin(), sums.end(), 0.0);
+        const double* values = m_raw_data->GetMetricValues(metric_index).data();
+        for (const auto& frame_start : matched_frames)
         {
-            continue;
+            const double* frame_values = values + *frame_start;
+            for (size_t draw_index = 0; draw_index < pattern_size; ++draw_index)
+            {
+                sums[draw_index] += frame_values[draw_index];
+            }
         }
 
-        averaged_record.m_metric_values.reserve(num_metrics);
-        for (size_t i = 0; i < num_metrics; ++i)
+        for (size_t draw_index = 0; draw_index < pattern_size; ++draw_index)
         {
-            averaged_record.m_metric_values.emplace_back(sums[i] / count);
+            m_computed_records[draw_index].m_metric_values.emplace_back(sums[draw_index] /
+                                                                        matched_frames.size());
         }
     }
 }
@@ -112,15 +112,28 @@ struct PerfMetricsRecord
     std::vector<double> m_metric_values;
 };
 
+// The values of each metric are stored in their own array, one value per record, rather than in
+// each record. Captures of long replays with hundreds of metrics have GBs of values, which are
+// then aggregated one metric at a time
 class PerfMetricsData
 {
  public:
     // Load performance metrics data from a CSV file
     [[nodiscard]] static std::unique_ptr<PerfMetricsData> LoadFromCsv(
         const std::filesystem::path& file_path, const AvailableMetrics& available_metrics);
-    // Get all performance metrics records
+    // Get all performance metrics records. Only the fixed fields are set, the metric values are
+    // returned by GetMetricValues()
     const std::vector<PerfMetricsRecord>& GetRecords() const { return m_records; }
 
+    // Get the values of a metric, one per record
+    const std::vector<double>& GetMetricValues(size_t metric_index) const
+    {
+        return m_metric_values[metric_index];
+    }
+
+    // Get a record along with its metric values
+    PerfMetricsRecord GetRecord(size_t record_index) const;
+
     // Get the names of the performance metrics
     const std::vector<std::string>& GetMetricNames() const { return m_metric_names; }
 
@@ -129,12 +142,14 @@ class PerfMetricsData
 
     PerfMetricsData(std::vector<std::string> metric_names,
                     std::vector<const MetricInfo*> metric_infos,
-                    std::vector<PerfMetricsRecord> records);
+                    std::vector<PerfMetricsRecord> records,
+                    std::vector<std::vector<double>> metric_values);
 
  private:
     std::vector<std::string> m_metric_names;
     std::vector<const MetricInfo*> m_metric_infos;
     std::vector<PerfMetricsRecord> m_records;
+    std::vector<std::vector<double>> m_metric_values;  // Indexed by metric, then by record
 };
 
 class PerfMetricsDataProvider
@@ -105,6 +105,21 @@ int FileReader::Open()
     if (ret != ARCHIVE_OK)
     {
         std::cerr << "error archive_read_next_header: " << archive_error_string(m_handle.get());
+        return ret;
+    }
+
+    // Files that are neither compressed nor in an archive are mapped rather than read through
+    // libarchive, so that memory blocks can point directly into the file instead of being copied
+    if (archive_filter_code(m_handle.get(), 0) == ARCHIVE_FILTER_NONE &&
+        archive_format(m_handle.get()) == ARCHIVE_FORMAT_RAW)
+    {
+        std::shared_ptr<MappedFile> mapped_file = MappedFile::Open(m_file_name.c_str());
+        if (mapped_file != nullptr)
+        {
+            m_mapped_file = std::move(mapped_file);
+            m_mapped_offset = 0;
+            m_handle = nullptr;
+        }
     }
 
     return ret;
@@ -113,6 +128,15 @@ int FileReader::Open()
 //--------------------------------------------------------------------------------------------------
 int64_t FileReader::Read(char* buf, int64_t nbytes)
 {
+    if (m_mapped_file != nullptr)
+    {
+        uint64_t remaining = m_mapped_file->GetSize() - m_mapped_offset;
+        uint64_t size = std::min(static_cast<uint64_t>(std::max<int64_t>(nbytes, 0)), remaining);
+        memcpy(buf, m_mapped_file->GetData() + m_mapped_offset, size);
+        m_mapped_offset += size;
+        return static_cast<int64_t>(size);
+    }
+
     char* ptr = buf;
     int64_t ret = 0;
     while (nbytes > 0)
@@ -131,10 +155,22 @@ int64_t FileReader::Read(char* buf, int64_t nbytes)
     return ret;
 }
 
+//--------------------------------------------------------------------------------------------------
+const uint8_t* FileReader::ReadInPlace(int64_t size)
+{
+    if (m_mapped_file == nullptr || size < 0) return nullptr;
+    if (static_cast<uint64_t>(size) > m_mapped_file->GetSize() - m_mapped_offset) return nullptr;
+
+    const uint8_t* data_ptr = m_mapped_file->GetData() + m_mapped_offset;
+    m_mapped_offset += size;
+    return data_ptr;
+}
+
 //--------------------------------------------------------------------------------------------------
 int FileReader::Close()
 {
     m_handle = nullptr;
+    m_mapped_file = nullptr;
     return 0;
 }
 
@@ -198,10 +234,16 @@ MemoryManager::~MemoryManager()
 {
     for (uint32_t i = 0; i < m_memory_blocks.size(); ++i)
     {
-        delete[] m_memory_blocks[i].m_data_ptr;
+        FreeMemoryBlockData(m_memory_blocks[i]);
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+void MemoryManager::FreeMemoryBlockData(const MemoryBlock& mem_block)
+{
+    if (mem_block.m_owns_data) delete[] mem_block.m_data_ptr;
+}
+
 //--------------------------------------------------------------------------------------------------
 void MemoryManager::AddMemoryBlock(uint32_t submit_index, uint64_t va_addr, MemoryData&& data)
 {
@@ -209,6 +251,7 @@ void MemoryManager::AddMemoryBlock(uint32_t submit_index, uint64_t va_addr, Memo
     mem_block.m_submit_index = submit_index;
     mem_block.m_va_addr = va_addr;
     mem_block.m_data_size = data.m_data_size;
+    mem_block.m_owns_data = true;
     mem_block.m_data_ptr = data.m_data_ptr;
     m_memory_blocks.push_back(mem_block);
 
@@ -217,6 +260,26 @@ void MemoryManager::AddMemoryBlock(uint32_t submit_index, uint64_t va_addr, Memo
     data.m_data_ptr = nullptr;
 }
 
+//--------------------------------------------------------------------------------------------------
+void MemoryManager::AddMappedMemoryBlock(uint32_t submit_index, uint64_t va_addr, uint32_t size,
+                                         const uint8_t* data_ptr)
+{
+    MemoryBlock mem_block{};
+    mem_block.m_submit_index = submit_index;
+    mem_block.m_va_addr = va_addr;
+    mem_block.m_data_size = size;
+    mem_block.m_owns_data = false;
+    // The mapping is read-only, but MemoryManager never writes to block data
+    mem_block.m_data_ptr = const_cast<uint8_t*>(data_ptr);
+    m_memory_blocks.push_back(mem_block);
+}
+
+//--------------------------------------------------------------------------------------------------
+void MemoryManager::AddMappedFile(std::shared_ptr<MappedFile> mapped_file)
+{
+    m_mapped_files.push_back(std::move(mapped_file));
+}
+
 //--------------------------------------------------------------------------------------------------
 void MemoryManager::AddMemoryAllocations(uint32_t submit_index,
                                          MemoryAllocationsDataHeader::Type type,
@@ -282,12 +345,12 @@ void MemoryManager::Finalize(bool same_submit_copy_only, bool duplicate_ib_captu
                     if (memory_block.m_data_size >= temp_memory_blocks.back().m_data_size)
                     {
                         // Replace previous memory block with current one
-                        delete[] temp_memory_blocks.back().m_data_ptr;
+                        FreeMemoryBlockData(temp_memory_blocks.back());
                         temp_memory_blocks.back() = m_memory_blocks[i];
                     }
                     else
                     {
-                        delete[] m_memory_blocks[i].m_data_ptr;
+                        FreeMemoryBlockData(m_memory_blocks[i]);
                     }
                 }
             }
@@ -297,6 +360,10 @@ void MemoryManager::Finalize(bool same_submit_copy_only, bool duplicate_ib_captu
         m_memory_blocks = std::move(temp_memory_blocks);
     }
 
+    // Blocks may have moved, so the cached block is no longer valid
+    m_last_used_block.Set(nullptr);
+    BuildBlockIndex();
+
 #ifndef NDEBUG
     // Sanity check
     //      same_submit_only == true -> Make sure there are no overlaps within same submit
@@ -351,9 +418,10 @@ bool MemoryManager::RetrieveMemoryData(void* buffer_ptr, uint32_t submit_index,
                                        uint64_t size) const
 {
     // Check the last-used block first, because this is the desired block most of the time
-    if (m_last_used_block_ptr != nullptr)
+    const MemoryBlock* last_used_block_ptr = m_last_used_block.Get();
+    if (last_used_block_ptr != nullptr)
     {
-        const MemoryBlock& mem_block = *m_last_used_block_ptr;
+        const MemoryBlock& mem_block = *last_used_block_ptr;
         uint64_t mem_block_end_addr = mem_block.m_va_addr + mem_block.m_data_size;
         uint64_t end_addr = va_addr + size;
 
@@ -374,21 +442,26 @@ bool MemoryManager::RetrieveMemoryData(void* buffer_ptr, uint32_t submit_index,
         }
     }
 
+    // Only blocks that end after va_addr and start before end_addr can overlap the desired region.
+    // Both bounds are found via binary search, so only the overlapping blocks are visited
+    BlockRange range = GetBlockRange(submit_index);
+    uint64_t end_addr = va_addr + size;
+    uint32_t first_block = FindFirstCandidateBlock(range, va_addr);
+    uint32_t last_block = FindEndCandidateBlock(range, first_block, end_addr);
+    const MemoryBlock* memory_blocks = m_memory_blocks.data();
+
     // Iterate through the memory blocks to find overlapping blocks and do the appropriate memcopies
+    // Iterate backwards, since later blocks have a more up-to-date view of memory
     uint64_t amount_copied = 0;
-    uint32_t num_memory_blocks = (uint32_t)m_memory_blocks.size();
-    const MemoryBlock* memory_blocks = (num_memory_blocks > 0) ? &m_memory_blocks.front() : nullptr;
-    for (uint32_t i = num_memory_blocks - 1; i != UINT32_MAX; --i)
+    for (uint32_t i = last_block - 1; i != first_block - 1; --i)
     {
         const MemoryBlock& mem_block = memory_blocks[i];
 
         uint64_t mem_block_end_addr = mem_block.m_va_addr + mem_block.m_data_size;
-        uint64_t end_addr = va_addr + size;
-        bool valid_submit = m_same_submit_only ? (submit_index == mem_block.m_submit_index) : true;
         bool overlaps = (va_addr < mem_block_end_addr) && (mem_block.m_va_addr < end_addr);
-        if (valid_submit && overlaps)
+        if (overlaps)
         {
-            m_last_used_block_ptr = &mem_block;
+            m_last_used_block.Set(&mem_block);
             uint64_t max_start_addr = std::max(va_addr, mem_block.m_va_addr);
             uint64_t min_end_addr = std::min(mem_block_end_addr, end_addr);
             uint64_t src_offset = max_start_addr - mem_block.m_va_addr;
@@ -415,50 +488,79 @@ bool MemoryManager::RetrieveMemoryData(void* buffer_ptr, uint32_t submit_index,
     return false;
 }
 
+//--------------------------------------------------------------------------------------------------
+const void* MemoryManager::GetMemoryPointer(uint32_t submit_index, uint64_t va_addr,
+                                            uint64_t size) const
+{
+    uint64_t end_addr = va_addr + size;
+    auto encompasses = [va_addr, end_addr](const MemoryBlock& mem_block) {
+        return (mem_block.m_va_addr <= va_addr) &&
+               (end_addr <= mem_block.m_va_addr + mem_block.m_data_size);
+    };
+
+    // Same lookup as RetrieveMemoryData(), which copies the whole range from a single block if the
+    // most up-to-date block overlapping it encompasses it. Otherwise the range has to be pieced
+    // together from several blocks, so it cannot be read in place
+    const MemoryBlock* last_used_block_ptr = m_last_used_block.Get();
+    if (last_used_block_ptr != nullptr)
+    {
+        const MemoryBlock& mem_block = *last_used_block_ptr;
+        bool valid_submit = m_same_submit_only ? (submit_index == mem_block.m_submit_index) : true;
+        if (valid_submit && encompasses(mem_block))
+            return &mem_block.m_data_ptr[va_addr - mem_block.m_va_addr];
+    }
+
+    BlockRange range = GetBlockRange(submit_index);
+    uint32_t first_block = FindFirstCandidateBlock(range, va_addr);
+    uint32_t last_block = FindEndCandidateBlock(range, first_block, end_addr);
+    const MemoryBlock* memory_blocks = m_memory_blocks.data();
+    for (uint32_t i = last_block - 1; i != first_block - 1; --i)
+    {
+        const MemoryBlock& mem_block = memory_blocks[i];
+        uint64_t mem_block_end_addr = mem_block.m_va_addr + mem_block.m_data_size;
+        bool overlaps = (va_addr < mem_block_end_addr) && (mem_block.m_va_addr < end_addr);
+        if (overlaps)
+        {
+            if (!encompasses(mem_block)) return nullptr;
+            m_last_used_block.Set(&mem_block);
+            return &mem_block.m_data_ptr[va_addr - mem_block.m_va_addr];
+        }
+    }
+    return nullptr;
+}
+
 //--------------------------------------------------------------------------------------------------
 bool MemoryManager::GetMemoryOfUnknownSizeViaCallback(uint32_t submit_index, uint64_t va_addr,
                                                       PfnGetMemory data_callback,
                                                       void* user_ptr) const
 {
-    uint64_t cur_addr = va_addr;
-
-    // Iterate through the memory blocks to find the biggest block that contains the passed-in addr
-    // Note: m_same_submit_only => Blocks are sorted by submit, then by address
-    //       otherwise they are just sorted by address
-    for (uint64_t i = 0; i < m_memory_blocks.size(); ++i)
+    BlockRange range = GetBlockRange(submit_index);
+    uint32_t block_index = FindContainingBlock(range, va_addr);
+    if (block_index == UINT32_MAX) return true;
+
+    // First block just has to contain this address
+    const MemoryBlock& first_block = m_memory_blocks[block_index];
+    uint64_t cur_addr = first_block.m_va_addr + first_block.m_data_size;
+    void* data_ptr = first_block.m_data_ptr + (va_addr - first_block.m_va_addr);
+    if (!data_callback(data_ptr, va_addr, cur_addr - va_addr, user_ptr))
+        return true;  // Callback indicates no more searching is needed
+
+    // Blocks within a range are sorted by address, so keep going while they are contiguous
+    for (uint32_t i = block_index + 1; i < range.m_end; ++i)
     {
         const MemoryBlock& mem_block = m_memory_blocks[i];
-        bool valid_submit = m_same_submit_only ? (submit_index == mem_block.m_submit_index) : true;
-        if (valid_submit)
+        if (cur_addr != mem_block.m_va_addr)
         {
-            if (cur_addr == va_addr)
-            {
-                // First block just has to contain this address
-                uint64_t mem_block_end_addr = mem_block.m_va_addr + mem_block.m_data_size;
-                if (mem_block.m_va_addr <= va_addr && va_addr < mem_block_end_addr)
-                {
-                    void* data_ptr = mem_block.m_data_ptr + (va_addr - mem_block.m_va_addr);
-                    uint64_t size = mem_block_end_addr - va_addr;
-                    if (!data_callback(data_ptr, va_addr, size, user_ptr))
-                        break;  // Callback indicates no more searching is needed
-                    cur_addr = mem_block_end_addr;
-                }
-            }
-            else if (cur_addr == mem_block.m_va_addr)
-            {
-                if (!data_callback(mem_block.m_data_ptr, cur_addr, mem_block.m_data_size, user_ptr))
-                    break;  // Callback indicates no more searching is needed
-
-                // Is contiguous. Update the cur_addr to reflect this block.
-                cur_addr = mem_block.m_va_addr + mem_block.m_data_size;
-            }
-            else if (cur_addr != va_addr)
-            {
-                // Not contiguous, and found a discountinuity in captured address range
-                // So safe to early out instead of continuing the search
-                return true;
-            }
+            // Not contiguous, and found a discountinuity in captured address range
+            // So safe to early out instead of continuing the search
+            break;
         }
+
+        if (!data_callback(mem_block.m_data_ptr, cur_addr, mem_block.m_data_size, user_ptr))
+            break;  // Callback indicates no more searching is needed
+
+        // Is contiguous. Update the cur_addr to reflect this block.
+        cur_addr = mem_block.m_va_addr + mem_block.m_data_size;
     }
     return true;
 }
@@ -466,36 +568,20 @@ bool MemoryManager::GetMemoryOfUnknownSizeViaCallback(uint32_t submit_index, uin
 //--------------------------------------------------------------------------------------------------
 uint64_t MemoryManager::GetMaxContiguousSize(uint32_t submit_index, uint64_t va_addr) const
 {
-    uint64_t cur_addr = va_addr;
+    BlockRange range = GetBlockRange(submit_index);
+    uint32_t block_index = FindContainingBlock(range, va_addr);
+    if (block_index == UINT32_MAX) return 0;
+
+    // First block just has to contain this address
+    const MemoryBlock& first_block = m_memory_blocks[block_index];
+    uint64_t cur_addr = first_block.m_va_addr + first_block.m_data_size;
 
-    // Iterate through the memory blocks to find the biggest block that contains the passed-in addr
-    // Note: m_same_submit_only => Blocks are sorted by submit, then by address
-    //       otherwise they are just sorted by address
-    for (uint64_t i = 0; i < m_memory_blocks.size(); ++i)
+    // Blocks within a range are sorted by address, so keep going while they are contiguous
+    for (uint32_t i = block_index + 1; i < range.m_end; ++i)
     {
         const MemoryBlock& mem_block = m_memory_blocks[i];
-        bool valid_submit = m_same_submit_only ? (submit_index == mem_block.m_submit_index) : true;
-        if (valid_submit)
-        {
-            if (cur_addr == va_addr)
-            {
-                // First block just has to contain this address
-                uint64_t mem_block_end_addr = mem_block.m_va_addr + mem_block.m_data_size;
-                if (mem_block.m_va_addr <= va_addr && va_addr < mem_block_end_addr)
-                    cur_addr = mem_block_end_addr;
-            }
-            else if (cur_addr == mem_block.m_va_addr)
-            {
-                // Is contiguous. Update the cur_addr to reflect this block.
-                cur_addr = mem_block.m_va_addr + mem_block.m_data_size;
-            }
-            else if (cur_addr != va_addr)
-            {
-                // Not contiguous, and found a discountinuity in captured address range
-                // So safe to early out instead of continuing the search
-                return (cur_addr - va_addr);
-            }
-        }
+        if (cur_addr != mem_block.m_va_addr) break;
+        cur_addr = mem_block.m_va_addr + mem_block.m_data_size;
     }
     return (cur_addr - va_addr);
 }
@@ -507,6 +593,85 @@ bool MemoryManager::IsValid(uint32_t submit_index, uint64_t addr, uint64_t size)
     return (max_size >= size);
 }
 
+//--------------------------------------------------------------------------------------------------
+void MemoryManager::BuildBlockIndex()
+{
+    m_block_ranges.clear();
+    m_max_end_addrs.clear();
+    m_max_end_addrs.reserve(m_memory_blocks.size());
+
+    uint32_t num_blocks = (uint32_t)m_memory_blocks.size();
+    uint64_t max_end_addr = 0;
+    for (uint32_t i = 0; i < num_blocks; ++i)
+    {
+        const MemoryBlock& mem_block = m_memory_blocks[i];
+
+        // Blocks are sorted by submit first if m_same_submit_only, so each submit is a contiguous
+        // range. Otherwise all blocks belong to the same range
+        bool new_range = m_block_ranges.empty() ||
+                         (m_same_submit_only &&
+                          mem_block.m_submit_index != m_block_ranges.back().m_submit_index);
+        if (new_range)
+        {
+            if (!m_block_ranges.empty()) m_block_ranges.back().m_end = i;
+            m_block_ranges.push_back({mem_block.m_submit_index, i, num_blocks});
+            max_end_addr = 0;
+        }
+        max_end_addr = std::max(max_end_addr, mem_block.m_va_addr + mem_block.m_data_size);
+        m_max_end_addrs.push_back(max_end_addr);
+    }
+}
+
+//--------------------------------------------------------------------------------------------------
+MemoryManager::BlockRange MemoryManager::GetBlockRange(uint32_t submit_index) const
+{
+    if (m_block_ranges.empty()) return {submit_index, 0, 0};
+    if (!m_same_submit_only) return m_block_ranges.front();
+
+    const BlockRange* range_ptr =
+        std::lower_bound(m_block_ranges.begin(), m_block_ranges.end(), submit_index,
+                         [](const BlockRange& range, uint32_t index) {
+                             return range.m_submit_index < index;
+                         });
+    if (range_ptr == m_block_ranges.end() || range_ptr->m_submit_index != submit_index)
+        return {submit_index, 0, 0};
+    return *range_ptr;
+}
+
+//--------------------------------------------------------------------------------------------------
+uint32_t MemoryManager::FindFirstCandidateBlock(const BlockRange& range, uint64_t va_addr) const
+{
+    const uint64_t* max_end_addrs = m_max_end_addrs.data();
+    const uint64_t* candidate_ptr =
+        std::upper_bound(max_end_addrs + range.m_begin, max_end_addrs + range.m_end, va_addr);
+    return (uint32_t)(candidate_ptr - max_end_addrs);
+}
+
+//--------------------------------------------------------------------------------------------------
+uint32_t MemoryManager::FindEndCandidateBlock(const BlockRange& range, uint32_t first_block,
+                                              uint64_t end_addr) const
+{
+    const MemoryBlock* memory_blocks = m_memory_blocks.data();
+    const MemoryBlock* end_block_ptr =
+        std::lower_bound(memory_blocks + first_block, memory_blocks + range.m_end, end_addr,
+                         [](const MemoryBlock& block, uint64_t addr) {
+                             return block.m_va_addr < addr;
+                         });
+    return (uint32_t)(end_block_ptr - memory_blocks);
+}
+
+//--------------------------------------------------------------------------------------------------
+uint32_t MemoryManager::FindContainingBlock(const BlockRange& range, uint64_t va_addr) const
+{
+    for (uint32_t i = FindFirstCandidateBlock(range, va_addr); i < range.m_end; ++i)
+    {
+        const MemoryBlock& mem_block = m_memory_blocks[i];
+        if (mem_block.m_va_addr > va_addr) break;
+        if (va_addr < mem_block.m_va_addr + mem_block.m_data_size) return i;
+    }
+    return UINT32_MAX;
+}
+
 // =================================================================================================
 // SubmitInfo
 // =================================================================================================
@@ -819,6 +984,10 @@ CaptureData::LoadResult Pm4CaptureData::LoadAdrenoRdFile(FileReader& capture_fil
         uint32_t m_data_size;
     };
 
+    // Memory blocks of a mapped file point directly into the mapping, so it has to stay alive for
+    // as long as the MemoryManager
+    if (capture_file.IsMapped()) m_memory.AddMappedFile(capture_file.GetMappedFile());
+
     BlockInfo block_info{};
     uint64_t cur_gpu_addr = UINT64_MAX;
     uint32_t cur_size = UINT32_MAX;
@@ -877,6 +1046,13 @@ CaptureData::LoadResult Pm4CaptureData::LoadAdrenoRdFile(FileReader& capture_fil
             case RD_VERT_SHADER:
             case RD_FRAG_SHADER:
             {
+                // Skip over the section. No need to copy it out if the file is mapped
+                if (capture_file.IsMapped())
+                {
+                    if (capture_file.ReadInPlace(block_info.m_data_size) == nullptr)
+                        return LoadResult::kFileIoError;
+                    break;
+                }
                 DiveVector<char> buf(block_info.m_data_size);
                 capture_file.Read(buf.data(), block_info.m_data_size);
                 break;
@@ -1238,6 +1414,19 @@ bool Pm4CaptureData::LoadGpuAddressAndSize(FileReader& capture_file, uint32_t bl
 bool Pm4CaptureData::LoadMemoryBlockAdreno(FileReader& capture_file, uint64_t gpu_addr,
                                            uint32_t size)
 {
+    // Unlike with Dive, all memory blocks for a submit come *before* the submit
+    uint32_t submit_index = (uint32_t)(m_submits.size());
+
+    // For mapped (uncompressed) files, point directly into the mapping instead of copying. Pages
+    // are only brought in by the OS when the memory is actually accessed
+    if (capture_file.IsMapped())
+    {
+        const uint8_t* data_ptr = capture_file.ReadInPlace(size);
+        if (data_ptr == nullptr) return false;
+        m_memory.AddMappedMemoryBlock(submit_index, gpu_addr, size, data_ptr);
+        return true;
+    }
+
     MemoryData raw_memory{};
     raw_memory.m_data_size = size;
     raw_memory.m_data_ptr = new uint8_t[raw_memory.m_data_size];
@@ -1247,8 +1436,6 @@ bool Pm4CaptureData::LoadMemoryBlockAdreno(FileReader& capture_file, uint64_t gp
         return false;
     }
 
-    // Unlike with Dive, all memory blocks for a submit come *before* the submit
-    uint32_t submit_index = (uint32_t)(m_submits.size());
     m_memory.AddMemoryBlock(submit_index, gpu_addr, std::move(raw_memory));
     return true;
 }
@@ -15,15 +15,18 @@
 */
 
 #pragma once
+#include <atomic>
 #include <fstream>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "common.h"
 #include "dive_core/capture_data.h"
 #include "dive_core/common/dive_capture_format.h"
 #include "dive_core/common/memory_manager_base.h"
+#include "dive_core/mapped_file.h"
 #include "log.h"
 #include "progress_tracker.h"
 #include "third_party/libarchive/libarchive/archive.h"
@@ -90,6 +93,14 @@ class MemoryManager : public IMemoryManager
     // Given the amount of memory potentially in a capture, this can be significant
     void AddMemoryBlock(uint32_t submit_index, uint64_t va_addr, MemoryData&& data);
 
+    // Add a memory block whose data lives in a file mapping added via AddMappedFile(). The data is
+    // not copied, and is not owned by the MemoryManager
+    void AddMappedMemoryBlock(uint32_t submit_index, uint64_t va_addr, uint32_t size,
+                              const uint8_t* data_ptr);
+
+    // Keep the given file mapping alive for as long as the memory blocks pointing into it
+    void AddMappedFile(std::shared_ptr<MappedFile> mapped_file);
+
     // Add memory allocation info to internal MemoryAllocationInfo object
     void AddMemoryAllocations(uint32_t submit_index, MemoryAllocationsDataHeader::Type type,
                               DiveVector<MemoryAllocationData>&& allocations);
@@ -106,6 +117,10 @@ class MemoryManager : public IMemoryManager
     virtual bool RetrieveMemoryData(void* buffer_ptr, uint32_t submit_index, uint64_t va_addr,
                                     uint64_t size) const override;
 
+    // Get a pointer into the memory block that RetrieveMemoryData() would copy the va/size from
+    virtual const void* GetMemoryPointer(uint32_t submit_index, uint64_t va_addr,
+                                         uint64_t size) const override;
+
     // Keep grabbing contiguous memory blocks until the callback returns false
     virtual bool GetMemoryOfUnknownSizeViaCallback(uint32_t submit_index, uint64_t va_addr,
                                                    PfnGetMemory data_callback,
@@ -123,15 +138,75 @@ class MemoryManager : public IMemoryManager
         uint64_t m_va_addr;
         uint32_t m_submit_index;
         uint32_t m_data_size;
+        bool m_owns_data;  // False if m_data_ptr points into one of m_mapped_files
         uint8_t* m_data_ptr;
     };
 
-    // mutable variable for caching reasons
-    mutable const MemoryBlock* m_last_used_block_ptr = nullptr;
+    // Free the data of the memory block, if owned by the MemoryManager
+    static void FreeMemoryBlockData(const MemoryBlock& mem_block);
+
+    // Range of m_memory_blocks that is visible to a submit. Blocks within a range are sorted by
+    // address
+    struct BlockRange
+    {
+        uint32_t m_submit_index;
+        uint32_t m_begin;
+        uint32_t m_end;
+    };
+
+    // Build m_block_ranges and m_max_end_addrs from the sorted m_memory_blocks
+    void BuildBlockIndex();
+
+    // Find the range of blocks visible to the given submit. Returns an empty range if none
+    BlockRange GetBlockRange(uint32_t submit_index) const;
+
+    // Index of the first block in the range whose end address is beyond va_addr. All blocks before
+    // it end at or before va_addr, so they cannot contain any part of a range starting at va_addr
+    uint32_t FindFirstCandidateBlock(const BlockRange& range, uint64_t va_addr) const;
+
+    // Index one past the last block in the range that starts before end_addr, searching from
+    // first_block. Blocks from there on cannot contain any part of a range ending at end_addr
+    uint32_t FindEndCandidateBlock(const BlockRange& range, uint32_t first_block,
+                                   uint64_t end_addr) const;
+
+    // Index of the first block in the range that contains va_addr, or UINT32_MAX if none
+    uint32_t FindContainingBlock(const BlockRange& range, uint64_t va_addr) const;
+
+    // Cache of the last block a lookup was satisfied from. Lookups may be done from several threads
+    // at once, so the pointer is atomic. Any block is a valid entry since it is re-checked on use,
+    // so relaxed ordering is enough. Copies start out empty, since they own different blocks
+    class LastUsedBlockCache
+    {
+     public:
+        LastUsedBlockCache() = default;
+        LastUsedBlockCache(const LastUsedBlockCache&) {}
+        LastUsedBlockCache& operator=(const LastUsedBlockCache&)
+        {
+            Set(nullptr);
+            return *this;
+        }
+        const MemoryBlock* Get() const { return m_ptr.load(std::memory_order_relaxed); }
+        void Set(const MemoryBlock* ptr) const { m_ptr.store(ptr, std::memory_order_relaxed); }
+
+     private:
+        mutable std::atomic<const MemoryBlock*> m_ptr = nullptr;
+    };
+    LastUsedBlockCache m_last_used_block;
 
     // Memory blocks containing all the captured memory data
     DiveVector<MemoryBlock> m_memory_blocks;
 
+    // Per-submit ranges into m_memory_blocks, sorted by submit index. If m_same_submit_only is not
+    // set, then there is a single range covering all blocks
+    DiveVector<BlockRange> m_block_ranges;
+
+    // Running maximum of the block end addresses within each range, parallel to m_memory_blocks.
+    // It is monotonic within a range, so it can be binary searched even if blocks overlap
+    DiveVector<uint64_t> m_max_end_addrs;
+
+    // File mappings that some of the memory blocks point into
+    std::vector<std::shared_ptr<MappedFile>> m_mapped_files;
+
     // All the captured memory allocation info
     MemoryAllocationInfo m_memory_allocations;
 
@@ -256,6 +331,9 @@ class RegisterInfo
 };
 
 //--------------------------------------------------------------------------------------------------
+// Reads a capture file sequentially. Files that are neither compressed nor in an archive are
+// memory-mapped, so that large sections can be accessed in place via ReadInPlace(). Other files are
+// read through libarchive
 class FileReader
 {
  public:
@@ -264,9 +342,20 @@ class FileReader
     int64_t Read(char* buf, int64_t size);
     int Close();
 
+    // Whether the file is memory-mapped, in which case ReadInPlace() can be used
+    bool IsMapped() const { return m_mapped_file != nullptr; }
+
+    // Return a pointer to the next 'size' bytes of the mapping and advance past them. Returns
+    // nullptr if the file is not mapped or there are not enough bytes left
+    const uint8_t* ReadInPlace(int64_t size);
+
+    const std::shared_ptr<MappedFile>& GetMappedFile() const { return m_mapped_file; }
+
  private:
     std::string m_file_name;
     std::unique_ptr<struct archive, decltype(&archive_read_free)> m_handle;
+    std::shared_ptr<MappedFile> m_mapped_file;
+    uint64_t m_mapped_offset = 0;
 };
 
 //--------------------------------------------------------------------------------------------------
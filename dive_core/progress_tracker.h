@@ -24,6 +24,8 @@ namespace Dive
 class ProgressTracker
 {
  public:
+    // Can be called from several threads at once, e.g. while the files of a .dive capture are
+    // loaded at the same time
     virtual void sendMessage(std::string message) = 0;
 };
 
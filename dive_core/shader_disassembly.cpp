@@ -16,11 +16,14 @@
 
 #include "shader_disassembly.h"
 
+#include <cstring>
 #include <mutex>
 #include <string_view>
 
+#include "content_hash.h"
 #include "dive_core/common/memory_manager_base.h"
 #include "pm4_info.h"
+#include "shader_disassembly_cache.h"
 
 #ifdef _MSC_VER
 #include <stdio.h>
@@ -46,6 +49,68 @@ bool Disassemble(const uint8_t* shader_memory, uint64_t shader_address, size_t s
     return false;
 }
 
+//--------------------------------------------------------------------------------------------------
+ShaderCode GetShaderCode(const IMemoryManager& mem_manager, uint32_t submit_index,
+                         uint64_t address)
+{
+    uint64_t max_size = mem_manager.GetMaxContiguousSize(submit_index, address);
+
+    // The disassembler does not early-out when it encounters an "end" instruction (at least not in
+    // its "prepass"), so passing it a too-big max_size can make the disassembly very slow! Let's
+    // set an arbitrary limit for now. The "correct" fix would be for the disassembler to early-out.
+    uint64_t kMaxSizeLimit = 64 * 1024;
+    if (max_size > kMaxSizeLimit) max_size = kMaxSizeLimit;
+
+    // Most shaders are in a single memory block, and are scanned in place
+    std::vector<uint8_t> buffer;
+    const uint8_t* data_ptr =
+        static_cast<const uint8_t*>(mem_manager.GetMemoryPointer(submit_index, address, max_size));
+    if (data_ptr == nullptr && max_size != 0)
+    {
+        buffer.resize(max_size);
+        DIVE_VERIFY(mem_manager.RetrieveMemoryData(buffer.data(), submit_index, address, max_size));
+        data_ptr = buffer.data();
+    }
+
+    ShaderCode code;
+    code.m_size = (data_ptr != nullptr) ? GetShaderCodeSize(data_ptr, max_size) : 0;
+    code.m_hash = HashData(0, data_ptr, code.m_size);
+    return code;
+}
+
+//--------------------------------------------------------------------------------------------------
+uint64_t GetShaderCodeSize(const uint8_t* shader_memory, uint64_t max_size)
+{
+    // Same as the stop conditions of disasm_field_cb(), in disasm-a3xx.c. The bits of the cat0
+    // instructions without sources that are not flags or don't-cares (see ir3-cat0.xml), and their
+    // value for the opcodes the disassembler stops at. This includes bit 49, the high bit of the
+    // opcode, which is set for instructions such as bkt
+    constexpr uint64_t kCat0OpcodeMask = 0xe7f2e0fc00000000ull;
+    constexpr uint64_t kNopOpcode = 0x0ull << 55;
+    constexpr uint64_t kEndOpcode = 0x6ull << 55;
+    constexpr uint64_t kChshOpcode = 0xaull << 55;
+
+    bool has_end = false;
+    uint32_t nop_count = 0;
+    for (uint64_t offset = 0; offset + sizeof(uint64_t) <= max_size; offset += sizeof(uint64_t))
+    {
+        uint64_t instruction;
+        std::memcpy(&instruction, shader_memory + offset, sizeof(instruction));
+        uint64_t opcode = instruction & kCat0OpcodeMask;
+        if (opcode == kNopOpcode)
+        {
+            if (has_end && ++nop_count > 3) return offset + sizeof(uint64_t);
+            continue;
+        }
+        nop_count = 0;
+        if (opcode == kEndOpcode)
+            has_end = true;
+        else if (opcode == kChshOpcode)
+            return offset + sizeof(uint64_t);
+    }
+    return max_size;
+}
+
 //--------------------------------------------------------------------------------------------------
 std::string DisassembleA3XX(const uint8_t* data, size_t max_size, struct shader_stats* stats,
                             enum debug_t debug)
@@ -94,7 +159,41 @@ std::string DisassembleA3XX(const uint8_t* data, size_t max_size, struct shader_
 //--------------------------------------------------------------------------------------------------
 Disassembly::Disassembly(const IMemoryManager& mem_manager, uint32_t submit_index, uint64_t address,
                          ILog* log)
-    : m_mem_manager(mem_manager), m_submit_index(submit_index), m_address(address), m_log(log)
+    : Disassembly(mem_manager, submit_index, address,
+                  GetShaderCode(mem_manager, submit_index, address), log)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+Disassembly::Disassembly(const IMemoryManager& mem_manager, uint32_t submit_index, uint64_t address,
+                         const ShaderCode& code, ILog* log,
+                         std::shared_ptr<const ShaderDisassemblyCache> cache)
+    : m_submit_index(submit_index),
+      m_address(address),
+      m_code(code),
+      m_shared_data(std::make_shared<SharedData>(mem_manager, submit_index, address, log,
+                                                 std::move(cache)))
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+Disassembly::Disassembly(uint32_t submit_index, uint64_t address, const Disassembly& other)
+    : m_submit_index(submit_index),
+      m_address(address),
+      m_code(other.m_code),
+      m_shared_data(other.m_shared_data)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+Disassembly::SharedData::SharedData(const IMemoryManager& mem_manager, uint32_t submit_index,
+                                    uint64_t address, ILog* log,
+                                    std::shared_ptr<const ShaderDisassemblyCache> cache)
+    : m_mem_manager(mem_manager),
+      m_submit_index(submit_index),
+      m_address(address),
+      m_log(log),
+      m_cache(std::move(cache))
 {
     ((void)(m_log));  // avoid unused variable
 }
@@ -102,21 +201,28 @@ Disassembly::Disassembly(const IMemoryManager& mem_manager, uint32_t submit_inde
 //--------------------------------------------------------------------------------------------------
 void Disassembly::Disassemble() const
 {
-    std::call_once(m_disassembled_flag, [&]() {
-        DisassembledData disassembled_data;
-        uint64_t max_size = m_mem_manager.GetMaxContiguousSize(m_submit_index, m_address);
-
-        // The disassembler does not early-out when it encounters an "end" instruction (at least not
-        // in its "prepass"), so passing it a too-big max_size can make the disassembly very slow!
-        // Let's set an arbitrary limit for now. The "correct" fix would be for the disassembler to
-        // early-out.
-        uint64_t kMaxSizeLimit = 64 * 1024;
-        if (max_size > kMaxSizeLimit) max_size = kMaxSizeLimit;
+    SharedData& shared_data = *m_shared_data;
+    std::call_once(shared_data.m_disassembled_flag, [&]() {
+        // Only the code is disassembled, so that the disassembly is the same for all the shaders
+        // with the same code
+        uint64_t max_size = m_code.m_size;
+        std::vector<uint8_t> code(max_size);
+        if (max_size != 0)
+        {
+            DIVE_VERIFY(shared_data.m_mem_manager.RetrieveMemoryData(
+                code.data(), shared_data.m_submit_index, shared_data.m_address, max_size));
+        }
+        uint8_t* data_ptr = code.data();
 
-        uint8_t* data_ptr = new uint8_t[max_size];
-        DIVE_VERIFY(
-            m_mem_manager.RetrieveMemoryData(data_ptr, m_submit_index, m_address, max_size));
+        uint32_t gpu_id = GetGPUID();
+        if (shared_data.m_cache != nullptr &&
+            shared_data.m_cache->Load(gpu_id, data_ptr, max_size, m_code.m_hash,
+                                      shared_data.m_disassembled_data))
+        {
+            return;
+        }
 
+        DisassembledData disassembled_data;
         struct shader_stats stats = {};
         std::string disasm = DisassembleA3XX(data_ptr, max_size, &stats, PRINT_RAW);
         std::istringstream disasm_istr(disasm);
@@ -159,8 +265,15 @@ void Disassembly::Disassemble() const
         }
         disassembled_data.m_gpr_count = (stats.fullreg + 3) / 4;
         disassembled_data.m_listing = DisassembleA3XX(data_ptr, max_size, &stats, PRINT_STATS);
-        delete[] data_ptr;
-        m_disassembled_data = disassembled_data;
+        shared_data.m_disassembled_data = disassembled_data;
+
+        // The cache only speeds up disassembling the same code again, so failing to write it is
+        // not an error
+        if (shared_data.m_cache != nullptr)
+        {
+            shared_data.m_cache->Save(gpu_id, data_ptr, max_size, m_code.m_hash,
+                                      shared_data.m_disassembled_data);
+        }
     });
 }
 
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
@@ -28,6 +29,24 @@
 namespace Dive
 {
 class IMemoryManager;
+class ShaderDisassemblyCache;
+
+// The code of a shader is the part of its memory that the disassembler decodes. The disassembly of
+// a shader is identified by a hash of it, so that the copies of a shader at different addresses, or
+// in other captures, share their disassembly
+struct ShaderCode
+{
+    uint64_t m_size = 0;
+    uint64_t m_hash = 0;
+};
+
+// Get the code of the shader at the given address
+ShaderCode GetShaderCode(const IMemoryManager& mem_manager, uint32_t submit_index,
+                         uint64_t address);
+
+// Size of the part of the shader memory that the disassembler decodes, which ends at the 4th nop
+// following an "end" instruction, or at a "chsh" instruction
+uint64_t GetShaderCodeSize(const uint8_t* shader_memory, uint64_t max_size);
 
 class ShaderInstruction
 {
@@ -59,11 +78,31 @@ class ShaderInstruction
 class Disassembly
 {
  public:
+    struct DisassembledData
+    {
+        std::string m_listing;
+        std::vector<std::string> m_instructions_text;
+        std::vector<uint64_t> m_instructions_raw;
+        uint32_t m_gpr_count{};
+    };
+
     Disassembly(const IMemoryManager& mem_manager, uint32_t submit_index, uint64_t address,
                 ILog* log = nullptr);
 
+    // The code of the shader is already known. The disassembly is looked up in the cache, if any,
+    // before disassembling the code, and is added to it otherwise
+    Disassembly(const IMemoryManager& mem_manager, uint32_t submit_index, uint64_t address,
+                const ShaderCode& code, ILog* log = nullptr,
+                std::shared_ptr<const ShaderDisassemblyCache> cache = nullptr);
+
+    // A copy of the shader other, at another address. It shares the disassembly of other, which is
+    // only done once for both
+    Disassembly(uint32_t submit_index, uint64_t address, const Disassembly& other);
+
     std::string GetListing() const { return GetData().m_listing; }
     uint64_t GetShaderAddr() const { return m_address; }
+    uint32_t GetSubmitIndex() const { return m_submit_index; }
+    const ShaderCode& GetCode() const { return m_code; }
     size_t GetNumInstructions() const { return GetData().m_instructions_text.size(); }
     const std::string& GetInstructionText(uint32_t index) const
     {
@@ -79,12 +118,21 @@ class Disassembly
     void EagerEval() const { Disassemble(); }
 
  private:
-    struct DisassembledData
+    // The disassembly of the code, along with what is needed to get it. It is shared by all the
+    // copies of a shader, and the code is read from the first of them
+    struct SharedData
     {
-        std::string m_listing;
-        std::vector<std::string> m_instructions_text;
-        std::vector<uint64_t> m_instructions_raw;
-        uint32_t m_gpr_count{};
+        SharedData(const IMemoryManager& mem_manager, uint32_t submit_index, uint64_t address,
+                   ILog* log, std::shared_ptr<const ShaderDisassemblyCache> cache);
+
+        [[maybe_unused]] const IMemoryManager& m_mem_manager;
+        uint32_t m_submit_index;
+        uint64_t m_address;
+        [[maybe_unused]] ILog* m_log;
+        std::shared_ptr<const ShaderDisassemblyCache> m_cache;
+
+        std::once_flag m_disassembled_flag;
+        DisassembledData m_disassembled_data;
     };
 
     void Disassemble() const;
@@ -92,16 +140,13 @@ class Disassembly
     const DisassembledData& GetData() const
     {
         Disassemble();
-        return m_disassembled_data;
+        return m_shared_data->m_disassembled_data;
     }
 
-    [[maybe_unused]] const IMemoryManager& m_mem_manager;
-    [[maybe_unused]] uint32_t m_submit_index;
+    uint32_t m_submit_index;
     uint64_t m_address;
-    [[maybe_unused]] ILog* m_log;
-
-    mutable std::once_flag m_disassembled_flag;
-    mutable DisassembledData m_disassembled_data;
+    ShaderCode m_code;
+    std::shared_ptr<SharedData> m_shared_data;
 };
 
 bool Disassemble(const uint8_t* shader_memory, uint64_t shader_address, size_t shader_size,
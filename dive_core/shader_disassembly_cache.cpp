@@ -0,0 +1,235 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "shader_disassembly_cache.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <utility>
+
+#include "mapped_file.h"
+#include "user_cache_directory.h"
+
+namespace Dive
+{
+
+namespace
+{
+
+constexpr char kMagic[8] = {'D', 'I', 'V', 'E', 'S', 'H', 'D', 'R'};
+constexpr char kFileExtension[] = ".disasm";
+
+// Hash of the sources of the disassembler, set by the build, so that the disassembly of another
+// version of mesa is never loaded
+constexpr char kDisassemblerRevision[] = DIVE_DISASSEMBLER_REVISION;
+
+// Followed by the raw instructions, the size of the text of each instruction, the code, the
+// listing and the text of the instructions
+struct CacheFileHeader
+{
+    char m_magic[8];
+    uint32_t m_version;
+    uint32_t m_gpu_id;
+    uint64_t m_code_hash;
+    uint64_t m_code_size;
+    uint64_t m_num_instructions;
+    uint64_t m_listing_size;
+    uint64_t m_text_size;
+    uint32_t m_gpr_count;
+    uint32_t m_reserved;
+    uint64_t m_file_size;  // Catches files that were truncated after being written
+};
+
+//--------------------------------------------------------------------------------------------------
+void Append(std::string& buffer, const void* data, uint64_t size)
+{
+    buffer.append(static_cast<const char*>(data), size);
+}
+
+}  // namespace
+
+// =================================================================================================
+// ShaderDisassemblyCache
+// =================================================================================================
+ShaderDisassemblyCache::ShaderDisassemblyCache(std::string directory, uint64_t max_size)
+    : m_directory(std::move(directory)), m_max_size(max_size)
+{
+}
+
+//--------------------------------------------------------------------------------------------------
+std::string ShaderDisassemblyCache::GetDefaultDirectory()
+{
+    return GetUserCacheDirectory("shader_cache");
+}
+
+//--------------------------------------------------------------------------------------------------
+std::string ShaderDisassemblyCache::GetFileName(uint32_t gpu_id, uint64_t code_hash) const
+{
+    char file_name[128];
+    snprintf(file_name, sizeof(file_name), "%u_%s_%016" PRIx64 "%s", gpu_id,
+             kDisassemblerRevision, code_hash, kFileExtension);
+    return (std::filesystem::path(m_directory) / file_name).string();
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ShaderDisassemblyCache::Load(uint32_t gpu_id, const uint8_t* code, uint64_t code_size,
+                                  uint64_t code_hash, Disassembly::DisassembledData& data) const
+{
+    std::string file_name = GetFileName(gpu_id, code_hash);
+    std::shared_ptr<MappedFile> file = MappedFile::Open(file_name.c_str());
+    if (file == nullptr) return false;
+
+    const uint8_t* file_data = file->GetData();
+    uint64_t file_size = file->GetSize();
+    CacheFileHeader header = {};
+    if (file_size < sizeof(header)) return false;
+    std::memcpy(&header, file_data, sizeof(header));
+    if (std::memcmp(header.m_magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.m_version != kVersion || header.m_gpu_id != gpu_id ||
+        header.m_code_hash != code_hash || header.m_code_size != code_size ||
+        header.m_file_size != file_size)
+    {
+        return false;
+    }
+
+    // Each part is checked against the remaining size of the file, so that a malformed size
+    // can't overflow the sum of the sizes
+    uint64_t offset = sizeof(header);
+    auto take = [&](uint64_t count, uint64_t elem_size) -> const uint8_t* {
+        if (count > (file_size - offset) / elem_size) return nullptr;
+        const uint8_t* part = file_data + offset;
+        offset += count * elem_size;
+        return part;
+    };
+    uint64_t num_instructions = header.m_num_instructions;
+    const uint8_t* raw = take(num_instructions, sizeof(uint64_t));
+    const uint8_t* text_sizes = raw ? take(num_instructions, sizeof(uint64_t)) : nullptr;
+    const uint8_t* cached_code = text_sizes ? take(code_size, 1) : nullptr;
+    const uint8_t* listing = cached_code ? take(header.m_listing_size, 1) : nullptr;
+    const uint8_t* text = listing ? take(header.m_text_size, 1) : nullptr;
+    if (text == nullptr || offset != file_size) return false;
+    if (code_size != 0 && std::memcmp(cached_code, code, code_size) != 0) return false;
+
+    Disassembly::DisassembledData loaded;
+    loaded.m_listing.assign(reinterpret_cast<const char*>(listing), header.m_listing_size);
+    loaded.m_instructions_raw.resize(num_instructions);
+    loaded.m_instructions_text.resize(num_instructions);
+    uint64_t text_offset = 0;
+    for (uint64_t i = 0; i < num_instructions; ++i)
+    {
+        uint64_t text_size = 0;
+        std::memcpy(&loaded.m_instructions_raw[i], raw + i * sizeof(uint64_t), sizeof(uint64_t));
+        std::memcpy(&text_size, text_sizes + i * sizeof(uint64_t), sizeof(uint64_t));
+        if (text_size > header.m_text_size - text_offset) return false;
+        loaded.m_instructions_text[i].assign(reinterpret_cast<const char*>(text) + text_offset,
+                                             text_size);
+        text_offset += text_size;
+    }
+    if (text_offset != header.m_text_size) return false;
+    loaded.m_gpr_count = header.m_gpr_count;
+
+    // The modification time of the files is when they were last used, for Trim()
+    std::error_code error;
+    std::filesystem::last_write_time(file_name, std::filesystem::file_time_type::clock::now(),
+                                     error);
+
+    data = std::move(loaded);
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+bool ShaderDisassemblyCache::Save(uint32_t gpu_id, const uint8_t* code, uint64_t code_size,
+                                  uint64_t code_hash,
+                                  const Disassembly::DisassembledData& data) const
+{
+    CacheFileHeader header = {};
+    std::memcpy(header.m_magic, kMagic, sizeof(kMagic));
+    header.m_version = kVersion;
+    header.m_gpu_id = gpu_id;
+    header.m_code_hash = code_hash;
+    header.m_code_size = code_size;
+    header.m_num_instructions = data.m_instructions_text.size();
+    header.m_listing_size = data.m_listing.size();
+    header.m_gpr_count = data.m_gpr_count;
+    if (data.m_instructions_raw.size() != header.m_num_instructions) return false;
+
+    std::string buffer(sizeof(header), '\0');
+    Append(buffer, data.m_instructions_raw.data(), header.m_num_instructions * sizeof(uint64_t));
+    for (const std::string& text : data.m_instructions_text)
+    {
+        uint64_t text_size = text.size();
+        Append(buffer, &text_size, sizeof(text_size));
+        header.m_text_size += text_size;
+    }
+    Append(buffer, code, code_size);
+    buffer += data.m_listing;
+    for (const std::string& text : data.m_instructions_text)
+    {
+        buffer += text;
+    }
+    header.m_file_size = buffer.size();
+    std::memcpy(buffer.data(), &header, sizeof(header));
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    if (error) return false;
+
+    // Write to a temporary file that then replaces the cache file, so that a cache file that is
+    // being written is never loaded. The name of the temporary file is random, since other
+    // processes may be saving the same shader
+    std::string file_name = GetFileName(gpu_id, code_hash);
+    std::string temp_file_name = file_name + "." + std::to_string(std::random_device{}()) + ".tmp";
+    bool saved = false;
+    {
+        std::ofstream stream(temp_file_name, std::ios::binary | std::ios::trunc);
+        if (!stream) return false;
+        stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        saved = stream.good();
+    }
+
+    if (saved)
+    {
+        std::filesystem::rename(temp_file_name, file_name, error);
+        saved = !error;
+    }
+    if (!saved)
+    {
+        std::filesystem::remove(temp_file_name, error);
+        return false;
+    }
+
+    // Trimming lists the whole directory, so it is only done once an eighth of the size limit has
+    // been saved. Only one of the threads that save at the same time does it
+    uint64_t saved_size = m_saved_size.fetch_add(buffer.size()) + buffer.size();
+    if (saved_size >= m_max_size / 8 &&
+        m_saved_size.compare_exchange_strong(saved_size, 0))
+    {
+        Trim();
+    }
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void ShaderDisassemblyCache::Trim() const
+{
+    TrimCacheDirectory(m_directory, kFileExtension, m_max_size);
+}
+
+}  // namespace Dive
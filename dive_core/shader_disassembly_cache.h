@@ -0,0 +1,73 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "shader_disassembly.h"
+
+namespace Dive
+{
+
+//--------------------------------------------------------------------------------------------------
+// Keeps the disassembly of shaders in a directory shared by all the captures, so that shaders that
+// have been seen before, in any capture, do not need to be disassembled again. Each shader is in
+// its own file, named after the GPU, the revision of the disassembler and the hash of its code. The
+// file also has the code itself, which is compared with the code being looked up, so a hash
+// collision is a cache miss. The least recently used files are removed once the directory grows
+// past its size limit
+class ShaderDisassemblyCache
+{
+ public:
+    // Increment whenever the file layout changes. Changes to the disassembler change its revision
+    static constexpr uint32_t kVersion = 2;
+
+    static constexpr uint64_t kDefaultMaxSize = 256 * 1024 * 1024;
+
+    explicit ShaderDisassemblyCache(std::string directory, uint64_t max_size = kDefaultMaxSize);
+
+    // The per-user cache directory of the platform, or the temporary directory if there is none
+    static std::string GetDefaultDirectory();
+
+    const std::string& GetDirectory() const { return m_directory; }
+    uint64_t GetMaxSize() const { return m_max_size; }
+
+    // Get the disassembly of the given code on the given GPU. Returns false, leaving data
+    // untouched, if it is not in the cache, or the cache file does not match or is malformed
+    bool Load(uint32_t gpu_id, const uint8_t* code, uint64_t code_size, uint64_t code_hash,
+              Disassembly::DisassembledData& data) const;
+
+    // Add the disassembly of the given code on the given GPU, replacing any existing one. Several
+    // processes can save the same code at once. Trims the directory once enough has been saved
+    bool Save(uint32_t gpu_id, const uint8_t* code, uint64_t code_size, uint64_t code_hash,
+              const Disassembly::DisassembledData& data) const;
+
+    // Remove the least recently used files until the directory is within its size limit
+    void Trim() const;
+
+ private:
+    std::string GetFileName(uint32_t gpu_id, uint64_t code_hash) const;
+
+    std::string m_directory;
+    uint64_t m_max_size;
+
+    // Size of the files saved since the directory was last trimmed
+    mutable std::atomic<uint64_t> m_saved_size = 0;
+};
+
+}  // namespace Dive
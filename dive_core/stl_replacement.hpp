@@ -102,6 +102,7 @@ Vector<Type>& Vector<Type>::operator=(Vector<Type>&& a)
 {
     if (&a != this)
     {
+        internal_clear();
         m_buffer = a.m_buffer;
         m_reserved = a.m_reserved;
         m_size = a.m_size;
@@ -0,0 +1,100 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "string_arena.h"
+
+#include <cstring>
+#include <utility>
+
+namespace Dive
+{
+
+// =================================================================================================
+// StringArena
+// =================================================================================================
+StringArena::StringArena(StringArena&& other) noexcept { *this = std::move(other); }
+
+//--------------------------------------------------------------------------------------------------
+StringArena& StringArena::operator=(StringArena&& other) noexcept
+{
+    if (this != &other)
+    {
+        m_blocks = std::move(other.m_blocks);
+        m_interned = std::move(other.m_interned);
+        m_cur = std::exchange(other.m_cur, nullptr);
+        m_remaining = std::exchange(other.m_remaining, 0);
+        other.Clear();
+    }
+    return *this;
+}
+
+//--------------------------------------------------------------------------------------------------
+const char* StringArena::Add(std::string_view str)
+{
+    if (str.empty()) return "";
+
+    char* copy = Allocate(str.size() + 1);
+    std::memcpy(copy, str.data(), str.size());
+    copy[str.size()] = '\0';
+    return copy;
+}
+
+//--------------------------------------------------------------------------------------------------
+const char* StringArena::Intern(std::string_view str)
+{
+    if (str.empty()) return "";
+
+    auto it = m_interned.find(str);
+    if (it != m_interned.end()) return it->data();
+
+    const char* copy = Add(str);
+    m_interned.insert(std::string_view(copy, str.size()));
+    return copy;
+}
+
+//--------------------------------------------------------------------------------------------------
+void StringArena::Clear()
+{
+    m_blocks.clear();
+    m_interned.clear();
+    m_cur = nullptr;
+    m_remaining = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+char* StringArena::Allocate(size_t size)
+{
+    // Strings that do not fit in a block get a block of their own, which leaves the current block
+    // available for the strings that follow
+    if (size > kBlockSize / 4)
+    {
+        m_blocks.push_back(std::unique_ptr<char[]>(new char[size]));
+        return m_blocks.back().get();
+    }
+
+    if (size > m_remaining)
+    {
+        m_blocks.push_back(std::unique_ptr<char[]>(new char[kBlockSize]));
+        m_cur = m_blocks.back().get();
+        m_remaining = kBlockSize;
+    }
+    char* ptr = m_cur;
+    m_cur += size;
+    m_remaining -= size;
+    return ptr;
+}
+
+}  // namespace Dive
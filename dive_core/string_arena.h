@@ -0,0 +1,61 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace Dive
+{
+
+//--------------------------------------------------------------------------------------------------
+// Monotonic storage for null-terminated strings. Strings are copied into large blocks, and are only
+// freed all at once when the arena is cleared or destroyed. This avoids one heap allocation per
+// string when creating millions of short strings that all share the same lifetime
+class StringArena
+{
+ public:
+    StringArena() = default;
+    StringArena(StringArena&& other) noexcept;
+    StringArena& operator=(StringArena&& other) noexcept;
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    // Copy the string into the arena. The returned string is valid for the lifetime of the arena
+    const char* Add(std::string_view str);
+
+    // Same as Add(), except that identical strings share the same copy
+    const char* Intern(std::string_view str);
+
+    void Clear();
+
+ private:
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    char* Allocate(size_t size);
+
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    char* m_cur = nullptr;
+    size_t m_remaining = 0;
+
+    // Views of the strings in the arena itself, so they stay valid across moves
+    std::unordered_set<std::string_view> m_interned;
+};
+
+}  // namespace Dive
@@ -0,0 +1,272 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "dive_core/capture_metadata_cache.h"
+#include "dive_core/data_core.h"
+#include "gtest/gtest.h"
+#include "pm4_info.h"
+
+namespace Dive
+{
+namespace
+{
+
+const char kCaptureFileName[] = TEST_DATA_DIR "/bloom-frame-0080-compressed.rd";
+
+void ExpectSameTopology(const SharedNodeTopology& expected, const SharedNodeTopology& actual)
+{
+    ASSERT_EQ(expected.GetNumNodes(), actual.GetNumNodes());
+    for (uint64_t node_index = 0; node_index < expected.GetNumNodes(); ++node_index)
+    {
+        EXPECT_EQ(expected.GetParentNodeIndex(node_index), actual.GetParentNodeIndex(node_index));
+        EXPECT_EQ(expected.GetChildIndex(node_index), actual.GetChildIndex(node_index));
+        ASSERT_EQ(expected.GetNumChildren(node_index), actual.GetNumChildren(node_index));
+        for (uint64_t child = 0; child < expected.GetNumChildren(node_index); ++child)
+        {
+            EXPECT_EQ(expected.GetChildNodeIndex(node_index, child),
+                      actual.GetChildNodeIndex(node_index, child));
+        }
+        ASSERT_EQ(expected.GetNumSharedChildren(node_index),
+                  actual.GetNumSharedChildren(node_index));
+        for (uint64_t child = 0; child < expected.GetNumSharedChildren(node_index); ++child)
+        {
+            EXPECT_EQ(expected.GetSharedChildNodeIndex(node_index, child),
+                      actual.GetSharedChildNodeIndex(node_index, child));
+        }
+    }
+}
+
+class CaptureMetadataCacheTest : public ::testing::Test
+{
+ protected:
+    void SetUp() override
+    {
+        Pm4InfoInit();
+        m_cache_file_name =
+            (std::filesystem::temp_directory_path() / "capture_metadata_cache_test.divecache")
+                .string();
+
+        // DataCore is large, so it is heap-allocated
+        m_data_core = std::make_unique<DataCore>();
+        ASSERT_EQ(m_data_core->LoadPm4CaptureData(kCaptureFileName),
+                  CaptureData::LoadResult::kSuccess);
+        ASSERT_TRUE(m_data_core->ParsePm4CaptureData());
+    }
+
+    void TearDown() override { std::filesystem::remove(m_cache_file_name); }
+
+    const IMemoryManager& GetMemoryManager() const
+    {
+        return m_data_core->GetPm4CaptureData().GetMemoryManager();
+    }
+
+    std::string m_cache_file_name;
+    std::unique_ptr<DataCore> m_data_core;
+};
+
+TEST_F(CaptureMetadataCacheTest, LoadMatchesParsedMetadata)
+{
+    const CaptureMetadata& expected = m_data_core->GetCaptureMetadata();
+    ASSERT_TRUE(CaptureMetadataCache::Save(m_cache_file_name, 1234, expected));
+
+    auto actual = std::make_unique<CaptureMetadata>();
+    ASSERT_TRUE(CaptureMetadataCache::Load(m_cache_file_name, 1234, GetMemoryManager(), *actual));
+
+    EXPECT_EQ(expected.m_num_pm4_packets, actual->m_num_pm4_packets);
+
+    const CommandHierarchy& expected_hierarchy = expected.m_command_hierarchy;
+    const CommandHierarchy& actual_hierarchy = actual->m_command_hierarchy;
+    ASSERT_EQ(expected_hierarchy.size(), actual_hierarchy.size());
+    for (uint64_t node_index = 0; node_index < expected_hierarchy.size(); ++node_index)
+    {
+        EXPECT_EQ(expected_hierarchy.GetNodeType(node_index),
+                  actual_hierarchy.GetNodeType(node_index));
+        EXPECT_EQ(std::string(expected_hierarchy.GetNodeDesc(node_index)),
+                  std::string(actual_hierarchy.GetNodeDesc(node_index)));
+        EXPECT_EQ(expected_hierarchy.GetEventIndex(node_index),
+                  actual_hierarchy.GetEventIndex(node_index));
+    }
+    ExpectSameTopology(expected_hierarchy.GetSubmitHierarchyTopology(),
+                       actual_hierarchy.GetSubmitHierarchyTopology());
+    ExpectSameTopology(expected_hierarchy.GetAllEventHierarchyTopology(),
+                       actual_hierarchy.GetAllEventHierarchyTopology());
+
+    ASSERT_EQ(expected.m_event_info.size(), actual->m_event_info.size());
+    for (size_t event_index = 0; event_index < expected.m_event_info.size(); ++event_index)
+    {
+        const EventInfo& expected_info = expected.m_event_info[event_index];
+        const EventInfo& actual_info = actual->m_event_info[event_index];
+        EXPECT_EQ(expected_info.m_num_indices, actual_info.m_num_indices);
+        EXPECT_EQ(expected_info.m_submit_index, actual_info.m_submit_index);
+        EXPECT_EQ(expected_info.m_type, actual_info.m_type);
+        EXPECT_EQ(expected_info.m_render_mode, actual_info.m_render_mode);
+        EXPECT_EQ(expected_info.m_str, actual_info.m_str);
+        EXPECT_EQ(expected_info.m_shader_references.size(),
+                  actual_info.m_shader_references.size());
+    }
+
+    ASSERT_EQ(expected.m_shaders.size(), actual->m_shaders.size());
+    for (size_t shader_index = 0; shader_index < expected.m_shaders.size(); ++shader_index)
+    {
+        EXPECT_EQ(expected.m_shaders[shader_index].GetShaderAddr(),
+                  actual->m_shaders[shader_index].GetShaderAddr());
+    }
+
+    ASSERT_EQ(expected.m_event_state.size(), actual->m_event_state.size());
+    for (uint32_t event_index = 0; event_index < expected.m_event_state.size(); ++event_index)
+    {
+        auto expected_state = expected.m_event_state.find(EventStateInfo::Id(event_index));
+        auto actual_state = actual->m_event_state.find(EventStateInfo::Id(event_index));
+        EXPECT_EQ(expected_state->IsTopologySet(), actual_state->IsTopologySet());
+        EXPECT_EQ(expected_state->Topology(), actual_state->Topology());
+        EXPECT_EQ(expected_state->IsDepthTestEnabledSet(), actual_state->IsDepthTestEnabledSet());
+        EXPECT_EQ(expected_state->DepthTestEnabled(), actual_state->DepthTestEnabled());
+    }
+}
+
+TEST_F(CaptureMetadataCacheTest, MismatchedHashIsNotLoaded)
+{
+    ASSERT_TRUE(
+        CaptureMetadataCache::Save(m_cache_file_name, 1234, m_data_core->GetCaptureMetadata()));
+
+    auto metadata = std::make_unique<CaptureMetadata>();
+    EXPECT_FALSE(
+        CaptureMetadataCache::Load(m_cache_file_name, 4321, GetMemoryManager(), *metadata));
+    EXPECT_EQ(metadata->m_command_hierarchy.size(), 0u);
+}
+
+TEST_F(CaptureMetadataCacheTest, TruncatedFileIsNotLoaded)
+{
+    ASSERT_TRUE(
+        CaptureMetadataCache::Save(m_cache_file_name, 1234, m_data_core->GetCaptureMetadata()));
+    std::filesystem::resize_file(m_cache_file_name,
+                                 std::filesystem::file_size(m_cache_file_name) / 2);
+
+    auto metadata = std::make_unique<CaptureMetadata>();
+    EXPECT_FALSE(
+        CaptureMetadataCache::Load(m_cache_file_name, 1234, GetMemoryManager(), *metadata));
+    EXPECT_EQ(metadata->m_command_hierarchy.size(), 0u);
+}
+
+TEST_F(CaptureMetadataCacheTest, OutOfRangeIndexIsNotLoaded)
+{
+    const CaptureMetadata& expected = m_data_core->GetCaptureMetadata();
+    ASSERT_TRUE(CaptureMetadataCache::Save(m_cache_file_name, 1234, expected));
+    ASSERT_FALSE(expected.m_event_info.empty());
+
+    // The file starts with the header, the number of packets, then the node types, the aux info and
+    // the event node indices, each array preceded by its size
+    uint64_t num_nodes = expected.m_command_hierarchy.size();
+    uint64_t offset =
+        32 + 8 + 8 + (num_nodes * sizeof(NodeType) + 7) / 8 * 8 + 8 + num_nodes * 8 + 8;
+    {
+        std::fstream file(m_cache_file_name, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(reinterpret_cast<const char*>(&num_nodes), sizeof(num_nodes));
+    }
+
+    auto metadata = std::make_unique<CaptureMetadata>();
+    EXPECT_FALSE(
+        CaptureMetadataCache::Load(m_cache_file_name, 1234, GetMemoryManager(), *metadata));
+    EXPECT_EQ(metadata->m_command_hierarchy.size(), 0u);
+}
+
+TEST_F(CaptureMetadataCacheTest, TrimRemovesLeastRecentlyUsed)
+{
+    std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "capture_metadata_cache_test";
+    std::filesystem::remove_all(directory);
+    auto file_name = [&](int index) {
+        return (directory / ("capture" + std::to_string(index) + ".divecache")).string();
+    };
+    const CaptureMetadata& metadata = m_data_core->GetCaptureMetadata();
+    for (int index = 1; index <= 3; ++index)
+    {
+        ASSERT_TRUE(CaptureMetadataCache::Save(file_name(index), 1234, metadata));
+    }
+
+    // Make the files last used in the order of their names
+    auto now = std::filesystem::file_time_type::clock::now();
+    for (int index = 1; index <= 3; ++index)
+    {
+        std::filesystem::last_write_time(file_name(index), now - std::chrono::hours(10 - index));
+    }
+    uint64_t file_size = std::filesystem::file_size(file_name(1));
+
+    // Using a file makes it the most recently used
+    auto loaded = std::make_unique<CaptureMetadata>();
+    ASSERT_TRUE(CaptureMetadataCache::Load(file_name(1), 1234, GetMemoryManager(), *loaded));
+    CaptureMetadataCache::Trim(directory.string(), 2 * file_size);
+    EXPECT_TRUE(std::filesystem::exists(file_name(1)));
+    EXPECT_FALSE(std::filesystem::exists(file_name(2)));
+    EXPECT_TRUE(std::filesystem::exists(file_name(3)));
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(CaptureMetadataCacheFileTest, CacheFileIsPerCapturePath)
+{
+    const std::string directory = CaptureMetadataCache::GetDefaultDirectory();
+    std::string cache_file_name =
+        CaptureMetadataCache::GetCacheFileName(directory, kCaptureFileName);
+    EXPECT_EQ(cache_file_name, CaptureMetadataCache::GetCacheFileName(directory, kCaptureFileName));
+    EXPECT_NE(cache_file_name.find("bloom-frame-0080-compressed.rd"), std::string::npos);
+    EXPECT_EQ(std::filesystem::path(cache_file_name).parent_path(),
+              std::filesystem::path(directory));
+
+    std::filesystem::path other_path = std::filesystem::temp_directory_path() /
+                                       "bloom-frame-0080-compressed.rd";
+    EXPECT_NE(cache_file_name,
+              CaptureMetadataCache::GetCacheFileName(directory, other_path.string()));
+}
+
+TEST(CaptureMetadataCacheFileTest, HashChangesWithFile)
+{
+    std::string file_name =
+        (std::filesystem::temp_directory_path() / "capture_metadata_cache_test.rd").string();
+    auto write_file = [&](char first, size_t size) {
+        std::string contents(size, 'x');
+        contents[0] = first;
+        std::ofstream(file_name, std::ios::binary | std::ios::trunc) << contents;
+    };
+
+    write_file('a', 100);
+    std::optional<uint64_t> hash = CaptureMetadataCache::HashFiles({file_name});
+    ASSERT_TRUE(hash.has_value());
+    EXPECT_EQ(hash, CaptureMetadataCache::HashFiles({file_name}));
+    EXPECT_NE(hash, CaptureMetadataCache::HashFiles({file_name, file_name}));
+
+    // Same size, but different contents
+    write_file('b', 100);
+    std::optional<uint64_t> other_hash = CaptureMetadataCache::HashFiles({file_name});
+    EXPECT_NE(hash, other_hash);
+
+    write_file('b', 101);
+    EXPECT_NE(other_hash, CaptureMetadataCache::HashFiles({file_name}));
+
+    std::filesystem::remove(file_name);
+    EXPECT_FALSE(CaptureMetadataCache::HashFiles({file_name}));
+}
+
+}  // namespace
+}  // namespace Dive
@@ -0,0 +1,186 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "dive_core/command_hierarchy.h"
+
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "dive_core/data_core.h"
+#include "gtest/gtest.h"
+#include "pm4_info.h"
+
+namespace Dive
+{
+namespace
+{
+
+const char kCaptureFileName[] = TEST_DATA_DIR "/bloom-frame-0080-compressed.rd";
+
+// Keeps the number of rows a view of the all-event topology would have for each node, from the
+// rows it is told are inserted
+class ViewRowsListener : public ChunkAppendListener
+{
+ public:
+    explicit ViewRowsListener(const CommandHierarchy& command_hierarchy)
+        : m_topology(command_hierarchy.GetAllEventHierarchyTopology())
+    {
+    }
+
+    void BeginAppendChildren(uint64_t node_index, uint64_t first_child_index,
+                             uint64_t num_children) override
+    {
+        EXPECT_EQ(GetNumRows(node_index), first_child_index);
+        EXPECT_EQ(m_topology.GetNumChildren(node_index), first_child_index);
+        m_node_index = node_index;
+        m_num_children = num_children;
+    }
+
+    void EndAppendChildren() override
+    {
+        uint64_t num_rows = GetNumRows(m_node_index);
+        ASSERT_EQ(m_topology.GetNumChildren(m_node_index), num_rows + m_num_children);
+        m_num_rows[m_node_index] = num_rows + m_num_children;
+        // The view reads the inserted nodes, and all their children
+        for (uint64_t child = num_rows; child < num_rows + m_num_children; ++child)
+        {
+            AddSubtree(m_topology.GetChildNodeIndex(m_node_index, child));
+        }
+    }
+
+    uint64_t GetNumRows(uint64_t node_index) const
+    {
+        auto it = m_num_rows.find(node_index);
+        return it == m_num_rows.end() ? 0 : it->second;
+    }
+
+ private:
+    void AddSubtree(uint64_t node_index)
+    {
+        m_num_rows[node_index] = m_topology.GetNumChildren(node_index);
+        for (uint64_t child = 0; child < m_topology.GetNumChildren(node_index); ++child)
+        {
+            AddSubtree(m_topology.GetChildNodeIndex(node_index, child));
+        }
+    }
+
+    const SharedNodeTopology& m_topology;
+    std::unordered_map<uint64_t, uint64_t> m_num_rows;
+    uint64_t m_node_index = 0;
+    uint64_t m_num_children = 0;
+};
+
+// Parses the capture, appending the chunks created along the way to loaded_hierarchy
+std::unique_ptr<DataCore> ParseCapture(uint32_t num_parse_threads,
+                                       CommandHierarchy& loaded_hierarchy, size_t& num_chunks,
+                                       ChunkAppendListener* listener = nullptr)
+{
+    // DataCore is large, so it is heap-allocated
+    auto data_core = std::make_unique<DataCore>();
+    data_core->SetNumParseThreads(num_parse_threads);
+    // A chunk per submit
+    data_core->SetCommandHierarchyChunkCallback(
+        [&loaded_hierarchy, &num_chunks,
+         listener](std::shared_ptr<const CommandHierarchyChunk> chunk) {
+            loaded_hierarchy.AppendChunk(*chunk, listener);
+            ++num_chunks;
+        },
+        std::chrono::milliseconds(0));
+    if (data_core->LoadPm4CaptureData(kCaptureFileName) != CaptureData::LoadResult::kSuccess ||
+        !data_core->ParsePm4CaptureData())
+    {
+        return nullptr;
+    }
+    return data_core;
+}
+
+void ExpectPrefixOfCommandHierarchy(const CommandHierarchy& loaded_hierarchy,
+                                    const CommandHierarchy& command_hierarchy)
+{
+    ASSERT_GT(loaded_hierarchy.size(), 0u);
+    ASSERT_LE(loaded_hierarchy.size(), command_hierarchy.size());
+    for (uint64_t node_index = 0; node_index < loaded_hierarchy.size(); ++node_index)
+    {
+        ASSERT_EQ(loaded_hierarchy.GetNodeType(node_index),
+                  command_hierarchy.GetNodeType(node_index));
+        ASSERT_EQ(loaded_hierarchy.GetNodeDesc(node_index),
+                  command_hierarchy.GetNodeDesc(node_index));
+        ASSERT_EQ(loaded_hierarchy.GetEventIndex(node_index),
+                  command_hierarchy.GetEventIndex(node_index));
+    }
+
+    // The children of each node are the first ones it has in the final hierarchy
+    const SharedNodeTopology& loaded_topology = loaded_hierarchy.GetAllEventHierarchyTopology();
+    const SharedNodeTopology& topology = command_hierarchy.GetAllEventHierarchyTopology();
+    ASSERT_EQ(loaded_topology.GetNumNodes(), loaded_hierarchy.size());
+    ASSERT_GT(loaded_topology.GetNumChildren(Topology::kRootNodeIndex), 0u);
+    for (uint64_t node_index = 0; node_index < loaded_hierarchy.size(); ++node_index)
+    {
+        uint64_t num_children = loaded_topology.GetNumChildren(node_index);
+        ASSERT_LE(num_children, topology.GetNumChildren(node_index));
+        for (uint64_t child = 0; child < num_children; ++child)
+        {
+            uint64_t child_node_index = loaded_topology.GetChildNodeIndex(node_index, child);
+            ASSERT_EQ(child_node_index, topology.GetChildNodeIndex(node_index, child));
+            ASSERT_EQ(loaded_topology.GetParentNodeIndex(child_node_index), node_index);
+            ASSERT_EQ(loaded_topology.GetChildIndex(child_node_index), child);
+        }
+    }
+}
+
+TEST(CommandHierarchyChunkTest, ChunksAddUpToTheCommandHierarchy)
+{
+    Pm4InfoInit();
+    for (uint32_t num_parse_threads : {1u, 4u})
+    {
+        CommandHierarchy loaded_hierarchy;
+        size_t num_chunks = 0;
+        std::unique_ptr<DataCore> data_core =
+            ParseCapture(num_parse_threads, loaded_hierarchy, num_chunks);
+        ASSERT_NE(data_core, nullptr);
+        EXPECT_GT(num_chunks, 0u);
+        ExpectPrefixOfCommandHierarchy(loaded_hierarchy, data_core->GetCommandHierarchy());
+    }
+}
+
+TEST(CommandHierarchyChunkTest, ListenerIsToldOfEveryShownChild)
+{
+    Pm4InfoInit();
+    CommandHierarchy loaded_hierarchy;
+    ViewRowsListener listener(loaded_hierarchy);
+    size_t num_chunks = 0;
+    std::unique_ptr<DataCore> data_core = ParseCapture(1, loaded_hierarchy, num_chunks, &listener);
+    ASSERT_NE(data_core, nullptr);
+
+    // Every node under the root has as many rows in the view as it has children
+    const SharedNodeTopology& topology = loaded_hierarchy.GetAllEventHierarchyTopology();
+    std::vector<uint64_t> node_indices = {Topology::kRootNodeIndex};
+    while (!node_indices.empty())
+    {
+        uint64_t node_index = node_indices.back();
+        node_indices.pop_back();
+        ASSERT_EQ(listener.GetNumRows(node_index), topology.GetNumChildren(node_index));
+        for (uint64_t child = 0; child < topology.GetNumChildren(node_index); ++child)
+        {
+            node_indices.push_back(topology.GetChildNodeIndex(node_index, child));
+        }
+    }
+}
+
+}  // namespace
+}  // namespace Dive
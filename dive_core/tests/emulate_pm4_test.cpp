@@ -0,0 +1,233 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "dive_core/common/emulate_pm4.h"
+#include "dive_core/pm4_capture_data.h"
+#include "gtest/gtest.h"
+
+namespace Dive
+{
+namespace
+{
+
+constexpr uint64_t kIbAddr = 0x1000;
+constexpr uint32_t kNumPackets = 4;
+constexpr uint32_t kCpNop = 0x10;
+
+uint32_t CalcParity(uint32_t val)
+{
+    val ^= val >> 16;
+    val ^= val >> 8;
+    val ^= val >> 4;
+    val &= 0xf;
+    return (~0x6996 >> val) & 1;
+}
+
+uint32_t MakeType7Header(uint32_t opcode, uint32_t count)
+{
+    Pm4Header header = {};
+    header.type7.type = 7;
+    header.type7.opcode = opcode;
+    header.type7.opcode_parity = CalcParity(opcode);
+    header.type7.count = count;
+    header.type7.count_parity = CalcParity(count);
+    return header.u32All;
+}
+
+// Records the order in which it is called
+class RecordingCallbacks : public EmulateCallbacksBase
+{
+ public:
+    ~RecordingCallbacks() override = default;
+
+    bool OnIbStart(uint32_t submit_index, uint32_t ib_index, const IndirectBufferInfo& ib_info,
+                   IbType type) override
+    {
+        m_events.push_back("ib_start");
+        return EmulateCallbacksBase::OnIbStart(submit_index, ib_index, ib_info, type);
+    }
+
+    bool OnIbEnd(uint32_t submit_index, uint32_t ib_index,
+                 const IndirectBufferInfo& ib_info) override
+    {
+        m_events.push_back("ib_end");
+        return EmulateCallbacksBase::OnIbEnd(submit_index, ib_index, ib_info);
+    }
+
+    bool OnPacket(const IMemoryManager& mem_manager, uint32_t submit_index, uint32_t ib_index,
+                  uint64_t va_addr, const Pm4Packet& packet) override
+    {
+        m_events.push_back("packet " + std::to_string(va_addr));
+        m_packet_dwords.emplace_back(packet.GetDwords(),
+                                     packet.GetDwords() + packet.GetSizeInDwords());
+        if (m_num_packets_until_abort && --*m_num_packets_until_abort == 0) return false;
+        return EmulateCallbacksBase::OnPacket(mem_manager, submit_index, ib_index, va_addr,
+                                              packet);
+    }
+
+    void OnSubmitStart(uint32_t submit_index, const SubmitInfo& submit_info) override
+    {
+        m_events.push_back("submit_start " + std::to_string(submit_index));
+    }
+
+    void OnSubmitEnd(uint32_t submit_index, const SubmitInfo& submit_info) override
+    {
+        m_events.push_back("submit_end " + std::to_string(submit_index));
+    }
+
+    std::vector<std::string> m_events;
+    std::vector<std::vector<uint32_t>> m_packet_dwords;
+    std::optional<uint32_t> m_num_packets_until_abort;
+};
+
+class EmulateCallbacksCompositeTest : public ::testing::Test
+{
+ protected:
+    void SetUp() override
+    {
+        // A single IB of NOP packets, shared by all submits
+        for (uint32_t submit_index = 0; submit_index < 2; ++submit_index)
+        {
+            MemoryData data;
+            data.m_data_size = kNumPackets * sizeof(uint32_t);
+            data.m_data_ptr = new uint8_t[data.m_data_size];
+            uint32_t nop = MakeType7Header(kCpNop, 0);
+            for (uint32_t i = 0; i < kNumPackets; ++i)
+            {
+                std::memcpy(data.m_data_ptr + i * sizeof(uint32_t), &nop, sizeof(nop));
+            }
+            m_mem.AddMemoryBlock(submit_index, kIbAddr, std::move(data));
+
+            IndirectBufferInfo ib_info = {};
+            ib_info.m_va_addr = kIbAddr;
+            ib_info.m_size_in_dwords = kNumPackets;
+            ib_info.m_enable_mask = 0x7;
+            DiveVector<IndirectBufferInfo> ibs;
+            ibs.push_back(ib_info);
+            m_submits.push_back(SubmitInfo(EngineType::kUniversal, QueueType::kUniversal, 0,
+                                           false, std::move(ibs)));
+        }
+        m_mem.Finalize(true, false);
+    }
+
+    MemoryManager m_mem;
+    DiveVector<SubmitInfo> m_submits;
+};
+
+TEST_F(EmulateCallbacksCompositeTest, ConsumersSeeSameWalk)
+{
+    // The callbacks are heap-allocated, since their state trackers are large
+    auto alone = std::make_unique<RecordingCallbacks>();
+    ASSERT_TRUE(alone->ProcessSubmits(m_submits, m_mem));
+    ASSERT_EQ(alone->m_events.size(), 2u * (kNumPackets + 4));
+
+    auto first = std::make_unique<RecordingCallbacks>();
+    auto second = std::make_unique<RecordingCallbacks>();
+    auto composite = std::make_unique<EmulateCallbacksComposite>();
+    composite->AddCallbacks(*first);
+    composite->AddCallbacks(*second);
+    ASSERT_TRUE(composite->ProcessSubmits(m_submits, m_mem));
+
+    EXPECT_EQ(first->m_events, alone->m_events);
+    EXPECT_EQ(second->m_events, alone->m_events);
+}
+
+TEST_F(EmulateCallbacksCompositeTest, PacketAbortStopsLaterConsumers)
+{
+    auto first = std::make_unique<RecordingCallbacks>();
+    auto second = std::make_unique<RecordingCallbacks>();
+    first->m_num_packets_until_abort = 2;
+
+    auto composite = std::make_unique<EmulateCallbacksComposite>();
+    composite->AddCallbacks(*first);
+    composite->AddCallbacks(*second);
+    EXPECT_FALSE(composite->ProcessSubmits(m_submits, m_mem));
+
+    // The second consumer never sees the packet that the first one aborted on
+    auto num_packets = [](const RecordingCallbacks& callbacks) {
+        uint32_t count = 0;
+        for (const std::string& event : callbacks.m_events)
+        {
+            if (event.rfind("packet", 0) == 0) ++count;
+        }
+        return count;
+    };
+    EXPECT_EQ(num_packets(*first), 2u);
+    EXPECT_EQ(num_packets(*second), 1u);
+}
+
+// The packets are read in place when the IB is in a single memory block, and copied when it is
+// split across blocks, including in the middle of a packet
+TEST(EmulatePm4Test, PacketDwordsMatchMemory)
+{
+    constexpr uint32_t kPayloadSize = 3;
+    std::vector<uint32_t> ib_dwords;
+    for (uint32_t i = 0; i < kNumPackets; ++i)
+    {
+        ib_dwords.push_back(MakeType7Header(kCpNop, kPayloadSize));
+        for (uint32_t j = 0; j < kPayloadSize; ++j)
+        {
+            ib_dwords.push_back(0x100 * i + j);
+        }
+    }
+    uint32_t ib_size = static_cast<uint32_t>(ib_dwords.size() * sizeof(uint32_t));
+
+    for (uint32_t split_offset : { ib_size, 6u * uint32_t(sizeof(uint32_t)) })
+    {
+        MemoryManager mem;
+        auto add_block = [&](uint32_t begin, uint32_t end) {
+            if (begin == end) return;
+            MemoryData data;
+            data.m_data_size = end - begin;
+            data.m_data_ptr = new uint8_t[data.m_data_size];
+            std::memcpy(data.m_data_ptr, (const uint8_t*)ib_dwords.data() + begin,
+                        data.m_data_size);
+            mem.AddMemoryBlock(0, kIbAddr + begin, std::move(data));
+        };
+        add_block(0, split_offset);
+        add_block(split_offset, ib_size);
+        mem.Finalize(true, false);
+
+        IndirectBufferInfo ib_info = {};
+        ib_info.m_va_addr = kIbAddr;
+        ib_info.m_size_in_dwords = static_cast<uint32_t>(ib_dwords.size());
+        ib_info.m_enable_mask = 0x7;
+        DiveVector<IndirectBufferInfo> ibs;
+        ibs.push_back(ib_info);
+        DiveVector<SubmitInfo> submits;
+        submits.push_back(
+            SubmitInfo(EngineType::kUniversal, QueueType::kUniversal, 0, false, std::move(ibs)));
+
+        auto callbacks = std::make_unique<RecordingCallbacks>();
+        ASSERT_TRUE(callbacks->ProcessSubmits(submits, mem));
+        ASSERT_EQ(callbacks->m_packet_dwords.size(), kNumPackets);
+        for (uint32_t i = 0; i < kNumPackets; ++i)
+        {
+            auto packet_begin = ib_dwords.begin() + i * (kPayloadSize + 1);
+            EXPECT_EQ(callbacks->m_packet_dwords[i],
+                      std::vector<uint32_t>(packet_begin, packet_begin + kPayloadSize + 1));
+        }
+    }
+}
+
+}  // namespace
+}  // namespace Dive
@@ -0,0 +1,78 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "dive_core/event_state.h"
+#include "gtest/gtest.h"
+
+namespace Dive
+{
+namespace
+{
+
+TEST(EventStateInfoTest, AppendCopiesValuesAndSetFields)
+{
+    EventStateInfo event_state;
+    event_state.Add()->SetTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+    event_state.Add();
+
+    VkViewport viewport = {1.0f, 2.0f, 3.0f, 4.0f, 0.0f, 1.0f};
+    EventStateInfo other;
+    other.Add()->SetLineWidth(2.0f).SetViewport(1, viewport);
+    other.Add();
+
+    event_state.Append(other);
+    ASSERT_EQ(event_state.size(), 4u);
+
+    EXPECT_TRUE(event_state[EventStateId(0)].IsTopologySet());
+    EXPECT_EQ(event_state[EventStateId(0)].Topology(), VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+    EXPECT_FALSE(event_state[EventStateId(1)].IsTopologySet());
+
+    EventStateInfo::ConstRef appended = event_state[EventStateId(2)];
+    EXPECT_FALSE(appended.IsTopologySet());
+    EXPECT_TRUE(appended.IsLineWidthSet());
+    EXPECT_EQ(appended.LineWidth(), 2.0f);
+    EXPECT_FALSE(appended.IsViewportSet(0));
+    EXPECT_TRUE(appended.IsViewportSet(1));
+    EXPECT_EQ(appended.Viewport(1).width, 3.0f);
+
+    EventStateInfo::ConstRef last = event_state[EventStateId(3)];
+    EXPECT_FALSE(last.IsLineWidthSet());
+    EXPECT_FALSE(last.IsViewportSet(1));
+}
+
+TEST(EventStateInfoTest, AppendManyGrowsCapacity)
+{
+    EventStateInfo event_state;
+    EventStateInfo other;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        other.Add()->SetPatchControlPoints(i);
+    }
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        event_state.Append(other);
+    }
+    ASSERT_EQ(event_state.size(), 300u);
+    for (uint32_t i = 0; i < 300; ++i)
+    {
+        EventStateInfo::ConstRef ref = event_state[EventStateId(i)];
+        EXPECT_TRUE(ref.IsPatchControlPointsSet());
+        EXPECT_EQ(ref.PatchControlPoints(), i % 100);
+    }
+}
+
+}  // namespace
+}  // namespace Dive
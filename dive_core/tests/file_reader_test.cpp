@@ -0,0 +1,142 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "dive_core/pm4_capture_data.h"
+#include "gtest/gtest.h"
+
+namespace Dive
+{
+namespace
+{
+
+const char kCompressedCaptureFileName[] = TEST_DATA_DIR "/bloom-frame-0080-compressed.rd";
+
+std::vector<char> MakeContents()
+{
+    std::vector<char> contents(3000);
+    for (size_t i = 0; i < contents.size(); ++i)
+    {
+        contents[i] = static_cast<char>(i * 7);
+    }
+    return contents;
+}
+
+// Wraps the contents in a ustar archive with a single file
+std::vector<char> MakeTar(const std::vector<char>& contents)
+{
+    char header[512] = {};
+    snprintf(header, 100, "capture.rd");
+    snprintf(header + 100, 8, "%07o", 0644);
+    snprintf(header + 108, 8, "%07o", 0);
+    snprintf(header + 116, 8, "%07o", 0);
+    snprintf(header + 124, 12, "%011o", static_cast<unsigned>(contents.size()));
+    snprintf(header + 136, 12, "%011o", 0);
+    header[156] = '0';
+    std::memcpy(header + 257, "ustar", 6);
+    std::memcpy(header + 263, "00", 2);
+
+    // The checksum is computed with its own field set to spaces
+    std::memset(header + 148, ' ', 8);
+    unsigned checksum = 0;
+    for (char c : header)
+    {
+        checksum += static_cast<unsigned char>(c);
+    }
+    snprintf(header + 148, 8, "%06o", checksum);
+
+    std::vector<char> tar(header, header + sizeof(header));
+    tar.insert(tar.end(), contents.begin(), contents.end());
+    tar.resize((tar.size() + 511) / 512 * 512 + 1024, '\0');
+    return tar;
+}
+
+class FileReaderTest : public ::testing::Test
+{
+ protected:
+    void TearDown() override
+    {
+        if (!m_file_name.empty()) std::filesystem::remove(m_file_name);
+    }
+
+    const char* WriteFile(const char* name, const std::vector<char>& data)
+    {
+        m_file_name = (std::filesystem::temp_directory_path() / name).string();
+        std::ofstream file(m_file_name, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        return m_file_name.c_str();
+    }
+
+    std::string m_file_name;
+};
+
+TEST_F(FileReaderTest, RawFileIsMapped)
+{
+    std::vector<char> contents = MakeContents();
+    FileReader reader(WriteFile("file_reader_test.rd", contents));
+    ASSERT_EQ(reader.Open(), 0);
+    ASSERT_TRUE(reader.IsMapped());
+
+    char buffer[100];
+    ASSERT_EQ(reader.Read(buffer, sizeof(buffer)), static_cast<int64_t>(sizeof(buffer)));
+    EXPECT_EQ(std::memcmp(buffer, contents.data(), sizeof(buffer)), 0);
+
+    const uint8_t* data_ptr = reader.ReadInPlace(200);
+    ASSERT_NE(data_ptr, nullptr);
+    EXPECT_EQ(std::memcmp(data_ptr, contents.data() + 100, 200), 0);
+
+    // Past the end of the file
+    EXPECT_EQ(reader.ReadInPlace(contents.size()), nullptr);
+    std::vector<char> rest(contents.size());
+    EXPECT_EQ(reader.Read(rest.data(), rest.size()), static_cast<int64_t>(contents.size() - 300));
+    EXPECT_EQ(reader.Close(), 0);
+}
+
+TEST_F(FileReaderTest, ArchiveIsReadThroughLibarchive)
+{
+    std::vector<char> contents = MakeContents();
+    FileReader reader(WriteFile("file_reader_test.tar", MakeTar(contents)));
+    ASSERT_EQ(reader.Open(), 0);
+    EXPECT_FALSE(reader.IsMapped());
+    EXPECT_EQ(reader.ReadInPlace(1), nullptr);
+
+    // The contents of the file in the archive, not the archive itself
+    std::vector<char> data(contents.size() + 100);
+    ASSERT_EQ(reader.Read(data.data(), data.size()), static_cast<int64_t>(contents.size()));
+    data.resize(contents.size());
+    EXPECT_EQ(data, contents);
+    EXPECT_EQ(reader.Close(), 0);
+}
+
+TEST_F(FileReaderTest, CompressedFileIsReadThroughLibarchive)
+{
+    FileReader reader(kCompressedCaptureFileName);
+    ASSERT_EQ(reader.Open(), 0);
+    EXPECT_FALSE(reader.IsMapped());
+
+    char buffer[100];
+    EXPECT_EQ(reader.Read(buffer, sizeof(buffer)), static_cast<int64_t>(sizeof(buffer)));
+    EXPECT_EQ(reader.Close(), 0);
+}
+
+}  // namespace
+}  // namespace Dive
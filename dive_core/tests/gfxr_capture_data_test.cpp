@@ -179,5 +179,90 @@ TEST(GfxrCaptureDataTest, AllLoadedBlocksAreValid)
     ASSERT_TRUE(capture_data.GetMutableGfxrData()->TraverseBlocks(block_validator));
 }
 
+TEST(GfxrCaptureDataTest, DecodesCommandArgsOnDemand)
+{
+    GfxrCaptureData capture_data;
+    ASSERT_EQ(capture_data.LoadCaptureFile(TEST_DATA_DIR
+                                           "/com.google.bigwheels.project_sample_01_triangle.debug_"
+                                           "trim_trigger_20250718T132545.gfxr"),
+              CaptureData::LoadResult::kSuccess);
+
+    const DiveBlockData& block_data = *capture_data.GetMutableGfxrData();
+    int decoded_count = 0;
+    for (const auto& submit : capture_data.GetGfxrSubmits())
+    {
+        // Only the commands read from the GFXR file itself can be decoded again
+        for (const auto& vk_cmd_info : submit->none_cmd_vk_commands)
+        {
+            std::string_view name =
+                capture_data.GetVulkanCommandTable().GetName(vk_cmd_info.command_id);
+            GfxrCommandArgsCache::Args args = capture_data.GetCommandArgs(vk_cmd_info.block_index);
+            bool in_asset_file = block_data.IsOriginalBlockInAssetFile(vk_cmd_info.block_index);
+            EXPECT_EQ(args == nullptr, in_asset_file) << name;
+        }
+
+        for (uint64_t handle : submit->vk_command_buffer_handles)
+        {
+            for (const auto& vk_cmd_info : capture_data.GetGfxrCommandBuffers(handle))
+            {
+                std::string_view name =
+                    capture_data.GetVulkanCommandTable().GetName(vk_cmd_info.command_id);
+                GfxrCommandArgsCache::Args args =
+                    capture_data.GetCommandArgs(vk_cmd_info.block_index);
+                ASSERT_NE(args, nullptr) << name;
+                EXPECT_EQ(args->at("commandBuffer").get<uint64_t>(), handle) << name;
+                ++decoded_count;
+            }
+        }
+    }
+    EXPECT_GT(decoded_count, 0);
+}
+
+TEST(GfxrCaptureDataTest, LoadsTheSameWithAnyNumberOfThreads)
+{
+    constexpr const char* kTestFile = TEST_DATA_DIR
+        "/com.google.bigwheels.project_sample_01_triangle.debug_"
+        "trim_trigger_20250718T132545.gfxr";
+    GfxrCaptureData single_thread_data;
+    single_thread_data.SetNumLoadThreads(1);
+    ASSERT_EQ(single_thread_data.LoadCaptureFile(kTestFile), CaptureData::LoadResult::kSuccess);
+    GfxrCaptureData multi_thread_data;
+    multi_thread_data.SetNumLoadThreads(4);
+    ASSERT_EQ(multi_thread_data.LoadCaptureFile(kTestFile), CaptureData::LoadResult::kSuccess);
+
+    auto expect_same_commands =
+        [&](const std::vector<DiveAnnotationProcessor::VulkanCommandInfo>& expected,
+            const std::vector<DiveAnnotationProcessor::VulkanCommandInfo>& actual) {
+            ASSERT_EQ(actual.size(), expected.size());
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                EXPECT_EQ(multi_thread_data.GetVulkanCommandTable().GetName(actual[i].command_id),
+                          single_thread_data.GetVulkanCommandTable().GetName(
+                              expected[i].command_id));
+                EXPECT_EQ(actual[i].index, expected[i].index);
+                EXPECT_EQ(actual[i].block_index, expected[i].block_index);
+            }
+        };
+
+    const auto& expected_submits = single_thread_data.GetGfxrSubmits();
+    const auto& actual_submits = multi_thread_data.GetGfxrSubmits();
+    ASSERT_EQ(actual_submits.size(), expected_submits.size());
+    for (size_t i = 0; i < expected_submits.size(); ++i)
+    {
+        EXPECT_EQ(actual_submits[i]->name, expected_submits[i]->name);
+        expect_same_commands(expected_submits[i]->none_cmd_vk_commands,
+                             actual_submits[i]->none_cmd_vk_commands);
+        ASSERT_EQ(actual_submits[i]->vk_command_buffer_handles,
+                  expected_submits[i]->vk_command_buffer_handles);
+        for (uint64_t handle : expected_submits[i]->vk_command_buffer_handles)
+        {
+            expect_same_commands(single_thread_data.GetGfxrCommandBuffers(handle),
+                                 multi_thread_data.GetGfxrCommandBuffers(handle));
+            EXPECT_EQ(multi_thread_data.GetDrawCallCounts(handle).render_pass_draw_call_counts,
+                      single_thread_data.GetDrawCallCounts(handle).render_pass_draw_call_counts);
+        }
+    }
+}
+
 }  // namespace
 }  // namespace Dive
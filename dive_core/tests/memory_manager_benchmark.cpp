@@ -0,0 +1,111 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "dive_core/pm4_capture_data.h"
+
+namespace Dive
+{
+namespace
+{
+
+constexpr uint32_t kNumSubmits = 10;
+constexpr uint32_t kBlockSize = 256;
+constexpr uint64_t kBlockStride = 4096;
+constexpr uint32_t kNumQueries = 1024;
+
+// Synthetic capture: kBlockSize-byte blocks spread evenly over kNumSubmits submits, with a gap
+// between consecutive blocks so that contiguous-size queries stop at each block boundary
+std::unique_ptr<MemoryManager> CreateMemoryManager(uint32_t num_blocks)
+{
+    auto mem = std::make_unique<MemoryManager>();
+    uint32_t blocks_per_submit = num_blocks / kNumSubmits;
+    for (uint32_t submit = 0; submit < kNumSubmits; ++submit)
+    {
+        for (uint32_t block = 0; block < blocks_per_submit; ++block)
+        {
+            MemoryData data;
+            data.m_data_size = kBlockSize;
+            data.m_data_ptr = new uint8_t[kBlockSize]();
+            mem->AddMemoryBlock(submit, block * kBlockStride, std::move(data));
+        }
+    }
+    mem->Finalize(true, false);
+    return mem;
+}
+
+struct Query
+{
+    uint32_t m_submit_index;
+    uint64_t m_va_addr;
+};
+
+// Random queries, so that the last-used block cache in MemoryManager mostly misses
+std::vector<Query> CreateQueries(uint32_t num_blocks)
+{
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<uint32_t> submit_dist(0, kNumSubmits - 1);
+    std::uniform_int_distribution<uint32_t> block_dist(0, num_blocks / kNumSubmits - 1);
+    std::vector<Query> queries(kNumQueries);
+    for (Query& query : queries)
+    {
+        query.m_submit_index = submit_dist(rng);
+        query.m_va_addr = block_dist(rng) * kBlockStride + 16;
+    }
+    return queries;
+}
+
+void BM_RetrieveMemoryData(benchmark::State& state)
+{
+    uint32_t num_blocks = static_cast<uint32_t>(state.range(0));
+    std::unique_ptr<MemoryManager> mem = CreateMemoryManager(num_blocks);
+    std::vector<Query> queries = CreateQueries(num_blocks);
+
+    uint32_t query_index = 0;
+    uint32_t dwords[4];
+    for (auto _ : state)
+    {
+        const Query& query = queries[query_index++ % kNumQueries];
+        benchmark::DoNotOptimize(
+            mem->RetrieveMemoryData(dwords, query.m_submit_index, query.m_va_addr, sizeof(dwords)));
+    }
+}
+
+void BM_GetMaxContiguousSize(benchmark::State& state)
+{
+    uint32_t num_blocks = static_cast<uint32_t>(state.range(0));
+    std::unique_ptr<MemoryManager> mem = CreateMemoryManager(num_blocks);
+    std::vector<Query> queries = CreateQueries(num_blocks);
+
+    uint32_t query_index = 0;
+    for (auto _ : state)
+    {
+        const Query& query = queries[query_index++ % kNumQueries];
+        benchmark::DoNotOptimize(
+            mem->GetMaxContiguousSize(query.m_submit_index, query.m_va_addr));
+    }
+}
+
+BENCHMARK(BM_RetrieveMemoryData)->RangeMultiplier(10)->Range(1000, 100000)->Arg(500000);
+BENCHMARK(BM_GetMaxContiguousSize)->RangeMultiplier(10)->Range(1000, 100000)->Arg(500000);
+
+}  // namespace
+}  // namespace Dive
@@ -0,0 +1,176 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <cstring>
+#include <vector>
+
+#include "dive_core/pm4_capture_data.h"
+#include "gtest/gtest.h"
+
+namespace Dive
+{
+namespace
+{
+
+// Adds a block whose bytes are (fill + offset) so that the source of each byte can be verified
+void AddBlock(MemoryManager& mem, uint32_t submit_index, uint64_t va_addr, uint32_t size,
+              uint8_t fill)
+{
+    MemoryData data;
+    data.m_data_size = size;
+    data.m_data_ptr = new uint8_t[size];
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        data.m_data_ptr[i] = static_cast<uint8_t>(fill + i);
+    }
+    mem.AddMemoryBlock(submit_index, va_addr, std::move(data));
+}
+
+bool CountBytes(const void* data_ptr, uint64_t va_addr, uint64_t size, void* user_ptr)
+{
+    *static_cast<uint64_t*>(user_ptr) += size;
+    return true;
+}
+
+TEST(MemoryManager, RetrieveMemoryDataSameSubmit)
+{
+    MemoryManager mem;
+    // Added out of order on purpose, Finalize() is expected to sort them
+    AddBlock(mem, 1, 0x2000, 0x100, 0x10);
+    AddBlock(mem, 0, 0x1100, 0x100, 0x20);
+    AddBlock(mem, 0, 0x1000, 0x100, 0x30);
+    mem.Finalize(true, false);
+
+    uint8_t buffer[0x10] = {};
+    ASSERT_TRUE(mem.RetrieveMemoryData(buffer, 0, 0x1000, sizeof(buffer)));
+    EXPECT_EQ(buffer[0], 0x30);
+
+    // Spans two contiguous blocks
+    ASSERT_TRUE(mem.RetrieveMemoryData(buffer, 0, 0x10F8, sizeof(buffer)));
+    EXPECT_EQ(buffer[0], static_cast<uint8_t>(0x30 + 0xF8));
+    EXPECT_EQ(buffer[8], 0x20);
+
+    // Blocks from other submits are not visible
+    EXPECT_FALSE(mem.RetrieveMemoryData(buffer, 0, 0x2000, sizeof(buffer)));
+    ASSERT_TRUE(mem.RetrieveMemoryData(buffer, 1, 0x2000, sizeof(buffer)));
+    EXPECT_EQ(buffer[0], 0x10);
+
+    // Unknown submit, and addresses outside of any block
+    EXPECT_FALSE(mem.RetrieveMemoryData(buffer, 2, 0x1000, sizeof(buffer)));
+    EXPECT_FALSE(mem.RetrieveMemoryData(buffer, 0, 0x0FF8, sizeof(buffer)));
+    EXPECT_FALSE(mem.RetrieveMemoryData(buffer, 0, 0x11F8, sizeof(buffer)));
+}
+
+TEST(MemoryManager, GetMemoryPointer)
+{
+    MemoryManager mem;
+    AddBlock(mem, 0, 0x1000, 0x100, 0x30);
+    AddBlock(mem, 0, 0x1100, 0x100, 0x20);
+    AddBlock(mem, 1, 0x1000, 0x100, 0x10);
+    mem.Finalize(true, false);
+
+    const uint8_t* data_ptr = static_cast<const uint8_t*>(mem.GetMemoryPointer(0, 0x1010, 0x10));
+    ASSERT_NE(data_ptr, nullptr);
+    EXPECT_EQ(data_ptr[0], 0x40);
+    data_ptr = static_cast<const uint8_t*>(mem.GetMemoryPointer(0, 0x1100, 0x100));
+    ASSERT_NE(data_ptr, nullptr);
+    EXPECT_EQ(data_ptr[0], 0x20);
+    data_ptr = static_cast<const uint8_t*>(mem.GetMemoryPointer(1, 0x1000, 0x10));
+    ASSERT_NE(data_ptr, nullptr);
+    EXPECT_EQ(data_ptr[0], 0x10);
+
+    // Ranges that span blocks, or are not fully in memory, have to be copied
+    EXPECT_EQ(mem.GetMemoryPointer(0, 0x10F8, 0x10), nullptr);
+    EXPECT_EQ(mem.GetMemoryPointer(0, 0x11F8, 0x10), nullptr);
+    EXPECT_EQ(mem.GetMemoryPointer(1, 0x1100, 0x10), nullptr);
+    EXPECT_EQ(mem.GetMemoryPointer(2, 0x1000, 0x10), nullptr);
+}
+
+TEST(MemoryManager, GetMaxContiguousSize)
+{
+    MemoryManager mem;
+    AddBlock(mem, 0, 0x1000, 0x100, 0);
+    AddBlock(mem, 0, 0x1100, 0x100, 0);
+    AddBlock(mem, 0, 0x1300, 0x100, 0);
+    AddBlock(mem, 1, 0x1200, 0x100, 0);
+    mem.Finalize(true, false);
+
+    EXPECT_EQ(mem.GetMaxContiguousSize(0, 0x1000), 0x200u);
+    EXPECT_EQ(mem.GetMaxContiguousSize(0, 0x1180), 0x80u);
+    EXPECT_EQ(mem.GetMaxContiguousSize(0, 0x1200), 0u);
+    EXPECT_EQ(mem.GetMaxContiguousSize(0, 0x1310), 0xF0u);
+    EXPECT_EQ(mem.GetMaxContiguousSize(1, 0x1200), 0x100u);
+    EXPECT_TRUE(mem.IsValid(0, 0x1000, 0x200));
+    EXPECT_FALSE(mem.IsValid(0, 0x1000, 0x201));
+
+    uint64_t total_size = 0;
+    EXPECT_TRUE(mem.GetMemoryOfUnknownSizeViaCallback(0, 0x1010, CountBytes, &total_size));
+    EXPECT_EQ(total_size, 0x1F0u);
+}
+
+TEST(MemoryManager, FlattenedSubmits)
+{
+    MemoryManager mem;
+    AddBlock(mem, 0, 0x1000, 0x100, 0x40);
+    AddBlock(mem, 3, 0x1100, 0x100, 0x50);
+    mem.Finalize(false, false);
+
+    // Memory from any submit is visible when not restricted to the same submit
+    uint8_t buffer[0x10] = {};
+    ASSERT_TRUE(mem.RetrieveMemoryData(buffer, 7, 0x10F8, sizeof(buffer)));
+    EXPECT_EQ(buffer[0], static_cast<uint8_t>(0x40 + 0xF8));
+    EXPECT_EQ(buffer[8], 0x50);
+    EXPECT_EQ(mem.GetMaxContiguousSize(7, 0x1000), 0x200u);
+}
+
+TEST(MemoryManager, ManyBlocks)
+{
+    constexpr uint32_t kNumSubmits = 4;
+    constexpr uint32_t kBlocksPerSubmit = 1000;
+    constexpr uint32_t kBlockSize = 0x40;
+    constexpr uint64_t kStride = 0x100;
+
+    MemoryManager mem;
+    for (uint32_t submit = 0; submit < kNumSubmits; ++submit)
+    {
+        for (uint32_t block = 0; block < kBlocksPerSubmit; ++block)
+        {
+            AddBlock(mem, submit, block * kStride, kBlockSize, static_cast<uint8_t>(block));
+        }
+    }
+    mem.Finalize(true, false);
+
+    uint32_t value = 0;
+    for (uint32_t submit = 0; submit < kNumSubmits; ++submit)
+    {
+        for (uint32_t block = 0; block < kBlocksPerSubmit; block += 7)
+        {
+            uint64_t va_addr = block * kStride + 4;
+            ASSERT_TRUE(mem.RetrieveMemoryData(&value, submit, va_addr, sizeof(value)));
+            uint8_t expected[sizeof(value)];
+            for (uint32_t i = 0; i < sizeof(value); ++i)
+            {
+                expected[i] = static_cast<uint8_t>(block + 4 + i);
+            }
+            EXPECT_EQ(memcmp(&value, expected, sizeof(value)), 0);
+            EXPECT_EQ(mem.GetMaxContiguousSize(submit, va_addr), kBlockSize - 4);
+            EXPECT_EQ(mem.GetMaxContiguousSize(submit, va_addr + kBlockSize), 0u);
+        }
+    }
+}
+
+}  // namespace
+}  // namespace Dive
@@ -0,0 +1,152 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "dive_core/node_search_index.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/ascii.h"
+#include "dive_core/data_core.h"
+#include "gtest/gtest.h"
+#include "pm4_info.h"
+
+namespace Dive
+{
+namespace
+{
+
+const char kCaptureFileName[] = TEST_DATA_DIR "/bloom-frame-0080-compressed.rd";
+
+// Searches the way the UI does without an index: each node, in pre-order
+void SearchAllNodes(const CommandHierarchy& command_hierarchy, const Topology& topology,
+                    uint64_t node_index, const std::string& lower_text,
+                    std::vector<uint64_t>& results)
+{
+    for (uint64_t child = 0; child < topology.GetNumChildren(node_index); ++child)
+    {
+        uint64_t child_node_index = topology.GetChildNodeIndex(node_index, child);
+        std::string desc = absl::AsciiStrToLower(command_hierarchy.GetNodeDesc(child_node_index));
+        if (desc.find(lower_text) != std::string::npos)
+        {
+            results.push_back(child_node_index);
+        }
+        SearchAllNodes(command_hierarchy, topology, child_node_index, lower_text, results);
+    }
+}
+
+class NodeSearchIndexTest : public ::testing::Test
+{
+ protected:
+    void SetUp() override
+    {
+        Pm4InfoInit();
+        // DataCore is large, so it is heap-allocated
+        m_data_core = std::make_unique<DataCore>();
+        ASSERT_EQ(m_data_core->LoadPm4CaptureData(kCaptureFileName),
+                  CaptureData::LoadResult::kSuccess);
+        ASSERT_TRUE(m_data_core->ParsePm4CaptureData());
+    }
+
+    const CommandHierarchy& GetCommandHierarchy() const
+    {
+        return m_data_core->GetCommandHierarchy();
+    }
+
+    std::unique_ptr<DataCore> m_data_core;
+};
+
+TEST_F(NodeSearchIndexTest, FindsTheSameNodesAsSearchingEachNode)
+{
+    const CommandHierarchy& command_hierarchy = GetCommandHierarchy();
+    const Topology* topologies[] = {&command_hierarchy.GetSubmitHierarchyTopology(),
+                                    &command_hierarchy.GetAllEventHierarchyTopology()};
+    for (const Topology* topology : topologies)
+    {
+        NodeSearchIndex index;
+        ASSERT_TRUE(index.Build(command_hierarchy, *topology));
+        EXPECT_EQ(index.GetNumNodes(), topology->GetNumNodes() - 1);
+
+        for (const char* text : {"d", "Dr", "DRAW", "draw", "Submit", "CP_EVENT_WRITE", "IB:",
+                                 "not in any description"})
+        {
+            std::vector<uint64_t> expected;
+            SearchAllNodes(command_hierarchy, *topology, Topology::kRootNodeIndex,
+                           absl::AsciiStrToLower(text), expected);
+            EXPECT_EQ(index.Search(text), expected) << "Searching for " << text;
+        }
+        EXPECT_TRUE(index.Search("").empty());
+    }
+}
+
+TEST_F(NodeSearchIndexTest, ReportsResultsInBatches)
+{
+    const CommandHierarchy& command_hierarchy = GetCommandHierarchy();
+    NodeSearchIndex index;
+    ASSERT_TRUE(index.Build(command_hierarchy, command_hierarchy.GetAllEventHierarchyTopology()));
+
+    // A single character is in most descriptions
+    std::vector<uint64_t> all_results = index.Search("e");
+    ASSERT_GT(all_results.size(), NodeSearchIndex::kResultBatchSize);
+
+    std::vector<uint64_t> results;
+    int num_batches = 0;
+    bool completed = index.Search("e", [&](const std::vector<uint64_t>& node_indices) {
+        EXPECT_LE(node_indices.size(), NodeSearchIndex::kResultBatchSize);
+        results.insert(results.end(), node_indices.begin(), node_indices.end());
+        ++num_batches;
+        return true;
+    });
+    EXPECT_TRUE(completed);
+    EXPECT_GT(num_batches, 1);
+    EXPECT_EQ(results, all_results);
+
+    // Returning false stops the search after the first batch
+    num_batches = 0;
+    completed = index.Search("e", [&](const std::vector<uint64_t>& node_indices) {
+        ++num_batches;
+        return false;
+    });
+    EXPECT_FALSE(completed);
+    EXPECT_EQ(num_batches, 1);
+}
+
+TEST_F(NodeSearchIndexTest, StopsWhenCancelled)
+{
+    const CommandHierarchy& command_hierarchy = GetCommandHierarchy();
+    const Topology& topology = command_hierarchy.GetAllEventHierarchyTopology();
+    std::atomic<bool> cancel(true);
+
+    NodeSearchIndex index;
+    EXPECT_FALSE(index.Build(command_hierarchy, topology, &cancel));
+    EXPECT_EQ(index.GetNumNodes(), 0u);
+
+    ASSERT_TRUE(index.Build(command_hierarchy, topology));
+    bool called = false;
+    EXPECT_FALSE(index.Search(
+        "e",
+        [&called](const std::vector<uint64_t>& node_indices) {
+            called = true;
+            return true;
+        },
+        &cancel));
+    EXPECT_FALSE(called);
+}
+
+}  // namespace
+}  // namespace Dive
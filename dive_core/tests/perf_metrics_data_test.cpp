@@ -74,6 +74,17 @@ MATCHER_P(PerfMetricsRecordEq, expected, "has the correct perf metrics record fi
     return true;
 }
 
+// The records along with their metric values
+std::vector<PerfMetricsRecord> GetFullRecords(const PerfMetricsData& perf_metrics_data)
+{
+    std::vector<PerfMetricsRecord> records;
+    for (size_t i = 0; i < perf_metrics_data.GetRecords().size(); ++i)
+    {
+        records.push_back(perf_metrics_data.GetRecord(i));
+    }
+    return records;
+}
+
 TEST(PerfMetricsData, LoadFromCsv)
 {
     auto available_metrics =
@@ -84,7 +95,7 @@ TEST(PerfMetricsData, LoadFromCsv)
         TEST_DATA_DIR "/mock_perf_metrics_data.csv", *available_metrics);
     ASSERT_NE(perf_metrics_data, nullptr);
 
-    const auto& records = perf_metrics_data->GetRecords();
+    const auto records = GetFullRecords(*perf_metrics_data);
     EXPECT_THAT(
         records,
         ElementsAre(
@@ -145,6 +156,8 @@ TEST(PerfMetricsData, LoadFromCsv)
                         ElementsAre(DoubleEq(1104), DoubleEq(1.104))))));
 
     ASSERT_THAT(perf_metrics_data->GetMetricNames(), ElementsAre("COUNTER_A", "COUNTER_B"));
+    EXPECT_THAT(perf_metrics_data->GetMetricValues(0), SizeIs(records.size()));
+    EXPECT_THAT(perf_metrics_data->GetMetricValues(1), SizeIs(records.size()));
 
     const auto& metric_infos = perf_metrics_data->GetMetricInfos();
     ASSERT_THAT(metric_infos, SizeIs(2));
@@ -165,7 +178,7 @@ TEST(PerfMetricsData, LoadFromCsvMalformedRowSkipped)
         TEST_DATA_DIR "/mock_perf_metrics_data_malformed.csv", *available_metrics);
     ASSERT_NE(perf_metrics_data, nullptr);
     ASSERT_THAT(perf_metrics_data->GetRecords(), SizeIs(1));
-    EXPECT_THAT(perf_metrics_data->GetRecords(),
+    EXPECT_THAT(GetFullRecords(*perf_metrics_data),
                 ElementsAre(AllOf(
                     PerfMetricsRecordEq(PerfMetricsRecord{2, 200, 2000, 20000, 2, 2, 2, 2, 2, {}}),
                     Field(&PerfMetricsRecord::m_metric_values,
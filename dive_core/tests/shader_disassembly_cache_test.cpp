@@ -0,0 +1,201 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "dive_core/shader_disassembly_cache.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "dive_core/pm4_capture_data.h"
+#include "gtest/gtest.h"
+
+namespace Dive
+{
+namespace
+{
+
+// Encodings of a few instructions (see ir3-cat0.xml)
+constexpr uint64_t kNop = 0;
+constexpr uint64_t kEnd = 0x6ull << 55;
+constexpr uint64_t kChsh = 0xaull << 55;
+constexpr uint64_t kBkt = 1ull << 49;  // Same opcode bits as nop, but with the high opcode bit set
+constexpr uint64_t kSyFlag = 1ull << 60;
+constexpr uint64_t kDontCareBit = 1ull << 51;
+constexpr uint64_t kCat1 = 1ull << 61;
+
+uint64_t GetCodeSize(const std::vector<uint64_t>& instructions)
+{
+    return GetShaderCodeSize(reinterpret_cast<const uint8_t*>(instructions.data()),
+                             instructions.size() * sizeof(uint64_t));
+}
+
+void AddShader(MemoryManager& mem, uint64_t va_addr, const std::vector<uint64_t>& instructions)
+{
+    MemoryData data;
+    data.m_data_size = static_cast<uint32_t>(instructions.size() * sizeof(uint64_t));
+    data.m_data_ptr = new uint8_t[data.m_data_size];
+    std::memcpy(data.m_data_ptr, instructions.data(), data.m_data_size);
+    mem.AddMemoryBlock(0, va_addr, std::move(data));
+}
+
+TEST(ShaderCodeTest, EndsAtFourthNopAfterEnd)
+{
+    // Nops that are before the first end, or fewer than 4 in a row, do not end the code
+    std::vector<uint64_t> instructions = {kCat1, kNop, kNop, kNop, kNop,  kNop,
+                                          kEnd,  kNop, kNop, kNop, kCat1, kEnd | kSyFlag,
+                                          kNop,  kNop, kNop, kNop, kCat1, kCat1};
+    EXPECT_EQ(GetCodeSize(instructions), 16 * sizeof(uint64_t));
+
+    EXPECT_EQ(GetCodeSize({kCat1, kChsh, kCat1}), 2 * sizeof(uint64_t));
+    EXPECT_EQ(GetCodeSize({kCat1, kEnd, kNop, kNop}), 4 * sizeof(uint64_t));
+    EXPECT_EQ(GetCodeSize({}), 0u);
+}
+
+TEST(ShaderCodeTest, OnlyOpcodeBitsTellNopsApart)
+{
+    // bkt is not a nop, so it restarts the count of nops
+    std::vector<uint64_t> instructions = {kCat1, kEnd, kNop, kNop, kNop, kBkt,
+                                          kNop,  kNop, kNop, kNop, kCat1};
+    EXPECT_EQ(GetCodeSize(instructions), 10 * sizeof(uint64_t));
+
+    // Bit 51 is a don't-care, so this is still a nop
+    instructions = {kCat1, kEnd, kNop, kNop, kNop, kNop | kDontCareBit, kCat1};
+    EXPECT_EQ(GetCodeSize(instructions), 6 * sizeof(uint64_t));
+}
+
+TEST(ShaderCodeTest, CopiesOfAShaderHaveTheSameCode)
+{
+    std::vector<uint64_t> code = {kCat1, kCat1 + 1, kEnd, kNop, kNop, kNop, kNop};
+    std::vector<uint64_t> copy = code;
+    copy.push_back(kCat1 + 2);  // Memory following the code is not part of it
+    std::vector<uint64_t> other = code;
+    other[1] = kCat1 + 3;
+
+    MemoryManager mem;
+    AddShader(mem, 0x1000, code);
+    AddShader(mem, 0x2000, copy);
+    AddShader(mem, 0x3000, other);
+    mem.Finalize(true, false);
+
+    ShaderCode shader_code = GetShaderCode(mem, 0, 0x1000);
+    ShaderCode copy_code = GetShaderCode(mem, 0, 0x2000);
+    ShaderCode other_code = GetShaderCode(mem, 0, 0x3000);
+    EXPECT_EQ(shader_code.m_size, code.size() * sizeof(uint64_t));
+    EXPECT_EQ(copy_code.m_size, shader_code.m_size);
+    EXPECT_EQ(copy_code.m_hash, shader_code.m_hash);
+    EXPECT_EQ(other_code.m_size, shader_code.m_size);
+    EXPECT_NE(other_code.m_hash, shader_code.m_hash);
+    EXPECT_EQ(GetShaderCode(mem, 0, 0x4000).m_size, 0u);
+
+    // A copy keeps its own address, but shares the disassembly
+    Disassembly shader(mem, 0, 0x1000, shader_code);
+    Disassembly shader_copy(0, 0x2000, shader);
+    EXPECT_EQ(shader_copy.GetShaderAddr(), 0x2000u);
+    EXPECT_EQ(shader_copy.GetCode().m_hash, shader.GetCode().m_hash);
+    ASSERT_EQ(shader_copy.GetNumInstructions(), shader.GetNumInstructions());
+    ASSERT_NE(shader.GetNumInstructions(), 0u);
+    EXPECT_EQ(&shader_copy.GetInstructionText(0), &shader.GetInstructionText(0));
+}
+
+class ShaderDisassemblyCacheTest : public ::testing::Test
+{
+ protected:
+    void SetUp() override
+    {
+        m_directory = std::filesystem::temp_directory_path() / "shader_disassembly_cache_test";
+        std::filesystem::remove_all(m_directory);
+
+        m_data.m_listing = "listing";
+        m_data.m_instructions_text = {"mov.f32f32 r0.x, r0.y", "", "end"};
+        m_data.m_instructions_raw = {kCat1, kNop, kEnd};
+        m_data.m_gpr_count = 3;
+    }
+
+    void TearDown() override { std::filesystem::remove_all(m_directory); }
+
+    std::filesystem::path m_directory;
+    Disassembly::DisassembledData m_data;
+};
+
+TEST_F(ShaderDisassemblyCacheTest, LoadMatchesSaved)
+{
+    const uint8_t code[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    ShaderDisassemblyCache cache(m_directory.string());
+    Disassembly::DisassembledData data;
+    EXPECT_FALSE(cache.Load(630, code, sizeof(code), 1234, data));
+    ASSERT_TRUE(cache.Save(630, code, sizeof(code), 1234, m_data));
+
+    // Other instances share the same directory
+    ShaderDisassemblyCache other_cache(m_directory.string());
+    ASSERT_TRUE(other_cache.Load(630, code, sizeof(code), 1234, data));
+    EXPECT_EQ(data.m_listing, m_data.m_listing);
+    EXPECT_EQ(data.m_instructions_text, m_data.m_instructions_text);
+    EXPECT_EQ(data.m_instructions_raw, m_data.m_instructions_raw);
+    EXPECT_EQ(data.m_gpr_count, m_data.m_gpr_count);
+}
+
+TEST_F(ShaderDisassemblyCacheTest, MismatchIsAMiss)
+{
+    const uint8_t code[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    const uint8_t other_code[] = {1, 2, 3, 4, 5, 6, 7, 9};
+    ShaderDisassemblyCache cache(m_directory.string());
+    ASSERT_TRUE(cache.Save(630, code, sizeof(code), 1234, m_data));
+
+    Disassembly::DisassembledData data;
+    EXPECT_FALSE(cache.Load(750, code, sizeof(code), 1234, data));
+    EXPECT_FALSE(cache.Load(630, code, sizeof(code), 5678, data));
+    EXPECT_FALSE(cache.Load(630, code, sizeof(code) - 1, 1234, data));
+    // Same hash, but different code
+    EXPECT_FALSE(cache.Load(630, other_code, sizeof(other_code), 1234, data));
+    EXPECT_TRUE(data.m_listing.empty());
+}
+
+TEST_F(ShaderDisassemblyCacheTest, TrimRemovesLeastRecentlyUsed)
+{
+    const uint8_t code[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    ShaderDisassemblyCache cache(m_directory.string());
+    for (uint64_t hash = 1; hash <= 3; ++hash)
+    {
+        ASSERT_TRUE(cache.Save(630, code, sizeof(code), hash, m_data));
+    }
+
+    // Make the files last used in the order of their hashes
+    uint64_t file_size = 0;
+    auto now = std::filesystem::file_time_type::clock::now();
+    for (const std::filesystem::directory_entry& entry :
+         std::filesystem::directory_iterator(m_directory))
+    {
+        std::string name = entry.path().filename().string();
+        uint64_t hash = name[name.find('.') - 1] - '0';
+        std::filesystem::last_write_time(entry.path(), now - std::chrono::hours(10 - hash));
+        file_size = entry.file_size();
+    }
+
+    // Using a file makes it the most recently used
+    ShaderDisassemblyCache small_cache(m_directory.string(), 2 * file_size);
+    Disassembly::DisassembledData data;
+    ASSERT_TRUE(small_cache.Load(630, code, sizeof(code), 1, data));
+    small_cache.Trim();
+    EXPECT_TRUE(small_cache.Load(630, code, sizeof(code), 1, data));
+    EXPECT_FALSE(small_cache.Load(630, code, sizeof(code), 2, data));
+    EXPECT_TRUE(small_cache.Load(630, code, sizeof(code), 3, data));
+}
+
+}  // namespace
+}  // namespace Dive
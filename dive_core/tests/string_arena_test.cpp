@@ -0,0 +1,104 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dive_core/command_hierarchy.h"
+#include "dive_core/string_arena.h"
+#include "gtest/gtest.h"
+
+namespace Dive
+{
+namespace
+{
+
+TEST(StringArenaTest, AddCopiesStrings)
+{
+    StringArena arena;
+    std::string str = "CP_DRAW_INDX_OFFSET 0x70380003";
+    const char* copy = arena.Add(str);
+    str[0] = 'X';
+    EXPECT_STREQ(copy, "CP_DRAW_INDX_OFFSET 0x70380003");
+    EXPECT_STREQ(arena.Add(""), "");
+}
+
+TEST(StringArenaTest, InternSharesIdenticalStrings)
+{
+    StringArena arena;
+    const char* a = arena.Intern("SP_VS_CTRL_REG0");
+    const char* b = arena.Intern(std::string("SP_VS_CTRL_REG0"));
+    const char* c = arena.Intern("SP_FS_CTRL_REG0");
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_NE(a, arena.Add("SP_VS_CTRL_REG0"));
+}
+
+TEST(StringArenaTest, StringsOutliveBlocksAndMoves)
+{
+    StringArena arena;
+    std::vector<std::pair<std::string, const char*>> strings;
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        std::string str = "node " + std::to_string(i);
+        strings.emplace_back(str, arena.Intern(str));
+    }
+    std::string big(100000, 'x');
+    const char* big_copy = arena.Add(big);
+
+    StringArena moved = std::move(arena);
+    for (const auto& [str, copy] : strings)
+    {
+        EXPECT_EQ(str, copy);
+        EXPECT_EQ(moved.Intern(str), copy);
+    }
+    EXPECT_EQ(big, big_copy);
+}
+
+TEST(NodeChildrenListsTest, GroupKeepsInsertionOrder)
+{
+    NodeChildrenLists lists;
+    lists.AddChild(2, 10);
+    lists.AddChild(0, 11);
+    lists.AddChild(2, 12);
+    lists.AddChild(0, 13);
+    lists.AddChild(3, 14);
+
+    DiveVector<uint64_t> children;
+    lists.GetChildrenSince(2, 0, &children);
+    ASSERT_EQ(children.size(), 2u);
+    EXPECT_EQ(children[0], 10u);
+    EXPECT_EQ(children[1], 12u);
+    lists.GetChildrenSince(2, 1, &children);
+    ASSERT_EQ(children.size(), 1u);
+    EXPECT_EQ(children[0], 12u);
+
+    lists.Group(5);
+    EXPECT_EQ(lists.GetNumNodes(), 5u);
+    EXPECT_EQ(lists.GetTotalNumChildren(), 5u);
+
+    std::vector<std::vector<uint64_t>> expected = {{11, 13}, {}, {10, 12}, {14}, {}};
+    for (uint64_t node_index = 0; node_index < expected.size(); ++node_index)
+    {
+        const uint64_t* begin = lists.GetChildren(node_index);
+        std::vector<uint64_t> actual(begin, begin + lists.GetNumChildren(node_index));
+        EXPECT_EQ(actual, expected[node_index]) << "node " << node_index;
+    }
+}
+
+}  // namespace
+}  // namespace Dive
@@ -0,0 +1,96 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include "user_cache_directory.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+
+namespace Dive
+{
+
+//--------------------------------------------------------------------------------------------------
+std::string GetUserCacheDirectory(const char* name)
+{
+    std::filesystem::path base_path;
+#ifdef _WIN32
+    if (const char* local_app_data = std::getenv("LOCALAPPDATA"))
+    {
+        base_path = local_app_data;
+    }
+#else
+    if (const char* cache_home = std::getenv("XDG_CACHE_HOME"); cache_home && *cache_home)
+    {
+        base_path = cache_home;
+    }
+    else if (const char* home_dir = std::getenv("HOME"))
+    {
+        base_path = std::filesystem::path(home_dir) / ".cache";
+    }
+#endif
+    if (base_path.empty())
+    {
+        std::error_code error;
+        base_path = std::filesystem::temp_directory_path(error);
+    }
+    return (base_path / "dive" / name).string();
+}
+
+//--------------------------------------------------------------------------------------------------
+void TrimCacheDirectory(const std::string& directory, const char* file_extension,
+                        uint64_t max_size)
+{
+    struct CacheFile
+    {
+        std::filesystem::file_time_type m_last_used;
+        uint64_t m_size;
+        std::filesystem::path m_path;
+    };
+    std::vector<CacheFile> files;
+    uint64_t total_size = 0;
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end;
+         it.increment(error))
+    {
+        // Other files, such as temporary ones, are only counted, since they may be being written by
+        // another process
+        std::error_code file_error;
+        uint64_t size = it->file_size(file_error);
+        if (file_error) continue;
+        total_size += size;
+        if (it->path().extension() != file_extension) continue;
+        std::filesystem::file_time_type last_used = it->last_write_time(file_error);
+        if (file_error) continue;
+        files.push_back({last_used, size, it->path()});
+    }
+    if (total_size <= max_size) return;
+
+    std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) {
+        return a.m_last_used < b.m_last_used;
+    });
+    for (const CacheFile& file : files)
+    {
+        if (total_size <= max_size) break;
+
+        // Files can fail to be removed while another process is using them
+        std::error_code remove_error;
+        if (std::filesystem::remove(file.m_path, remove_error)) total_size -= file.m_size;
+    }
+}
+
+}  // namespace Dive
@@ -0,0 +1,34 @@
+/*
+ Copyright 2026 Google LLC
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace Dive
+{
+
+// The directory with the given name in Dive's part of the per-user cache directory of the
+// platform, or of the temporary directory if there is none. The directory is not created
+std::string GetUserCacheDirectory(const char* name);
+
+// Remove the least recently written files with the given extension from the directory, until the
+// size of all its files is within max_size. Caches update the modification time of the files they
+// use, so that it is when they were last used
+void TrimCacheDirectory(const std::string& directory, const char* file_extension,
+                        uint64_t max_size);
+
+}  // namespace Dive
@@ -18,20 +18,125 @@
 
 #include <cstdint>
 #include <ostream>
+#include <sstream>
+#include <string>
 
 #include "decode/api_decoder.h"
 #include "util/logging.h"
 #include "util/output_stream.h"
 
+using gfxrecon::decode::DiveVulkanCommandTable;
+using gfxrecon::decode::DiveVulkanCommandType;
+
+namespace
+{
+
+// Counts shown in the description of a draw call node
+struct DrawCallCounts
+{
+    uint64_t index_count = 0;
+    uint64_t vertex_count = 0;
+    uint64_t instance_count = 0;
+};
+
+// The counts can be nested in the arguments, such as in the pVertexInfo of vkCmdDrawMultiEXT
+void FindDrawCallCounts(const nlohmann::ordered_json& json_args, DrawCallCounts& counts)
+{
+    if (json_args.is_array())
+    {
+        for (const auto& element : json_args)
+        {
+            FindDrawCallCounts(element, counts);
+        }
+        return;
+    }
+    if (!json_args.is_object())
+    {
+        return;
+    }
+    for (const auto& [key, val] : json_args.items())
+    {
+        if (val.is_object() || val.is_array())
+        {
+            FindDrawCallCounts(val, counts);
+        }
+        else if (val.is_number_integer())
+        {
+            if (key == "indexCount")
+            {
+                counts.index_count = val.get<uint64_t>();
+            }
+            else if (key == "vertexCount")
+            {
+                counts.vertex_count = val.get<uint64_t>();
+            }
+            else if (key == "instanceCount")
+            {
+                counts.instance_count = val.get<uint64_t>();
+            }
+        }
+    }
+}
+
+// Forms string of drawcall info, some examples:
+//
+// vkCmdDraw: "(vertexCount:#,instanceCount:#)"
+// vkCmdDrawIndexed: "(indexCount:#,instanceCount:#)"
+// vkCmdDrawMultiEXT: "(instanceCount:#)"
+// vkCmdDraw* without instanceCount parameter: ""
+std::string GetDrawCallString(const nlohmann::ordered_json& args)
+{
+    DrawCallCounts counts;
+    FindDrawCallCounts(args, counts);
+    if (counts.instance_count == 0)
+    {
+        return "";
+    }
+
+    std::ostringstream s;
+    s << "(";
+    if (counts.index_count > 0)
+    {
+        s << "indexCount:" << counts.index_count << ",";
+    }
+    else if (counts.vertex_count > 0)
+    {
+        s << "vertexCount:" << counts.vertex_count << ",";
+    }
+    s << "instanceCount:" << counts.instance_count << ")";
+    return s.str();
+}
+
+}  // namespace
+
 void DiveAnnotationProcessor::WriteBlockEnd(const gfxrecon::util::DiveFunctionData& function_data)
 {
-    std::string function_name = function_data.GetFunctionName();
+    ProcessFunctionRecord(MakeFunctionRecord(function_data, m_command_table));
+}
+
+DiveAnnotationProcessor::FunctionRecord DiveAnnotationProcessor::MakeFunctionRecord(
+    const gfxrecon::util::DiveFunctionData& function_data, DiveVulkanCommandTable& command_table)
+{
     const auto& args = function_data.GetArgs();
+    FunctionRecord record;
+    record.command_id = command_table.GetId(function_data.GetFunctionName());
+    record.cmd_buffer_index = function_data.GetCmdBufferIndex();
+    record.block_index = function_data.GetBlockIndex();
 
-    if (function_name == "vkQueueSubmit" || function_name == "vkQueueSubmit2")
+    DiveVulkanCommandType command_type = command_table.GetType(record.command_id);
+    if (command_type == DiveVulkanCommandType::kDraw)
+    {
+        record.details = GetDrawCallString(args);
+    }
+    else if (command_type == DiveVulkanCommandType::kBeginDebugUtilsLabel &&
+             args.contains("pLabelInfo") && args["pLabelInfo"].contains("pLabelName") &&
+             args["pLabelInfo"]["pLabelName"].is_string())
     {
-        std::unique_ptr<SubmitInfo> submit_ptr = std::make_unique<SubmitInfo>(function_name);
+        record.details = args["pLabelInfo"]["pLabelName"].get<std::string>();
+    }
 
+    if (command_type == DiveVulkanCommandType::kQueueSubmit)
+    {
         if (args.count("submitCount"))
         {
             const auto& submits = args["pSubmits"];
@@ -42,34 +147,51 @@ void DiveAnnotationProcessor::WriteBlockEnd(const gfxrecon::util::DiveFunctionDa
                     const auto& command_buffers = submit["pCommandBuffers"];
                     for (const auto& cmd_buffer : command_buffers)
                     {
-                        submit_ptr->vk_command_buffer_handles.push_back(cmd_buffer);
+                        record.submitted_command_buffers.push_back(cmd_buffer);
                     }
                 }
             }
         }
+    }
+    else if (args.count("commandBuffer") != 0)
+    {
+        record.command_buffer = args["commandBuffer"].get<uint64_t>();
+    }
+    return record;
+}
+
+void DiveAnnotationProcessor::ProcessFunctionRecord(const FunctionRecord& record)
+{
+    DiveVulkanCommandType command_type = m_command_table.GetType(record.command_id);
+
+    if (command_type == DiveVulkanCommandType::kQueueSubmit)
+    {
+        std::unique_ptr<SubmitInfo> submit_ptr =
+            std::make_unique<SubmitInfo>(std::string(m_command_table.GetName(record.command_id)));
+        submit_ptr->vk_command_buffer_handles = record.submitted_command_buffers;
         submit_ptr->none_cmd_vk_commands = std::move(m_none_cmd_vk_commands_per_submit_cache);
         m_submits.push_back(std::move(submit_ptr));
     }
     else
     {
-        VulkanCommandInfo vkCmd(function_data);
-        if (args.count("commandBuffer") != 0)
+        VulkanCommandInfo vkCmd(record);
+        if (record.command_buffer)
         {
-            uint64_t cmd_handle = args["commandBuffer"];
+            uint64_t cmd_handle = *record.command_buffer;
 
-            if (vkCmd.name.find("vkBeginCommandBuffer") != std::string::npos)
+            if (command_type == DiveVulkanCommandType::kBeginCommandBuffer)
             {
                 m_cmd_vk_commands_cache[cmd_handle].clear();
                 m_draw_call_counts_map[cmd_handle].begin_command_buffer_draw_call_count = 0;
             }
-            else if (vkCmd.name.find("vkCmdBeginRenderPass") != std::string::npos)
+            else if (command_type == DiveVulkanCommandType::kBeginRenderPass)
             {
                 m_draw_call_counts_map[cmd_handle].render_pass_draw_call_counts.push_back(0);
             }
 
             m_cmd_vk_commands_cache[cmd_handle].push_back(vkCmd);
 
-            if (vkCmd.name.find("vkCmdDraw") != std::string::npos)
+            if (command_type == DiveVulkanCommandType::kDraw)
             {
                 m_draw_call_counts_map[cmd_handle].begin_command_buffer_draw_call_count++;
                 if (!m_draw_call_counts_map[cmd_handle].render_pass_draw_call_counts.empty())
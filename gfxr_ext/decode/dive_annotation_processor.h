@@ -16,29 +16,57 @@
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "decode/annotation_handler.h"
+#include "dive_vulkan_command_table.h"
 #include "util/defines.h"
 #include "util/platform.h"
 
 // The DiveAnnotationProcessor is used by the VulkanExportDiveConsumer on each WriteBlockEnd call
 // made when processing the vulkan commands. WriteBlockEnd is called passing the function data
-// (name, command buffer index, args) and then DiveAnnotationProcessor converts the data to
-// SubmitInfo for vkQueueSubmits or VulkanCommandInfo for vulkan commands. These structs are then
-// used to construct the command hierarchy displayed in the Dive UI.
+// (name, command buffer index, block index, args) and then DiveAnnotationProcessor converts the
+// data to SubmitInfo for vkQueueSubmits or VulkanCommandInfo for vulkan commands. These structs are
+// then used to construct the command hierarchy displayed in the Dive UI.
 class DiveAnnotationProcessor : public gfxrecon::decode::AnnotationHandler
 {
  public:
+    // The part of the function data that is needed to build the command hierarchy. Unlike the
+    // function data, it is small enough to be buffered for a whole capture, so that the blocks can
+    // be decoded on several threads and the records processed in block order afterwards
+    struct FunctionRecord
+    {
+        gfxrecon::decode::DiveVulkanCommandTable::Id command_id = 0;
+        uint32_t cmd_buffer_index = 0;
+        uint64_t block_index = 0;
+        // The commandBuffer argument, if there is one
+        std::optional<uint64_t> command_buffer;
+        // The command buffers submitted by a vkQueueSubmit
+        std::vector<uint64_t> submitted_command_buffers;
+        // See VulkanCommandInfo::details
+        std::string details;
+    };
+
+    // The arguments are not kept, since they take far more memory than the commands themselves.
+    // They are decoded again from the block when needed (see Dive::GfxrCommandArgsCache). The name
+    // and type of the command are looked up from command_id in the command table
     struct VulkanCommandInfo
     {
-        explicit VulkanCommandInfo(const gfxrecon::util::DiveFunctionData& data)
-            : args(data.GetArgs()), name(data.GetFunctionName()), index(data.GetCmdBufferIndex())
+        explicit VulkanCommandInfo(const FunctionRecord& record)
+            : command_id(record.command_id),
+              index(record.cmd_buffer_index),
+              block_index(record.block_index),
+              details(record.details)
         {
         }
 
-        nlohmann::ordered_json args;
-        std::string name = "";
+        gfxrecon::decode::DiveVulkanCommandTable::Id command_id = 0;
         uint32_t index = 0;
+        uint64_t block_index = 0;
+        // The few arguments that are shown in the command hierarchy, formatted when loading since
+        // the arguments are not kept: the label name of a vkCmdBeginDebugUtilsLabelEXT, or the
+        // counts of a draw, such as "(indexCount:3,instanceCount:1)". Empty for other commands
+        std::string details;
     };
 
     struct SubmitInfo
@@ -67,6 +95,14 @@ class DiveAnnotationProcessor : public gfxrecon::decode::AnnotationHandler
     // Finalize the current block and stream it out.
     void WriteBlockEnd(const gfxrecon::util::DiveFunctionData& function_data) override;
 
+    // The command id of the record is looked up in command_table
+    static FunctionRecord MakeFunctionRecord(
+        const gfxrecon::util::DiveFunctionData& function_data,
+        gfxrecon::decode::DiveVulkanCommandTable& command_table);
+
+    // Same as WriteBlockEnd(), for a record whose command id is from GetCommandTable()
+    void ProcessFunctionRecord(const FunctionRecord& record);
+
     // @brief Convert annotations, which are simple {type:enum, key:string, value:string} objects.
     virtual void ProcessAnnotation(uint64_t block_index, gfxrecon::format::AnnotationType type,
                                    const std::string& label, const std::string& data) override
@@ -82,6 +118,11 @@ class DiveAnnotationProcessor : public gfxrecon::decode::AnnotationHandler
     {
         return std::move(m_draw_call_counts_map);
     }
+    gfxrecon::decode::DiveVulkanCommandTable& GetCommandTable() { return m_command_table; }
+    gfxrecon::decode::DiveVulkanCommandTable TakeCommandTable()
+    {
+        return std::move(m_command_table);
+    }
 
  private:
     // This is a per submit cache that keeps all vk commands that are not in any command buffer
@@ -90,4 +131,5 @@ class DiveAnnotationProcessor : public gfxrecon::decode::AnnotationHandler
     std::unordered_map<uint64_t, std::vector<VulkanCommandInfo>> m_cmd_vk_commands_cache;
     std::unordered_map<uint64_t, DrawCallCounts> m_draw_call_counts_map;
     std::vector<std::unique_ptr<SubmitInfo>> m_submits;
+    gfxrecon::decode::DiveVulkanCommandTable m_command_table;
 };
@@ -27,11 +27,12 @@ namespace gfxrecon::decode
 namespace
 {
 
-MATCHER_P3(VulkanCommandInfoEqual, expected_name, expected_index, expected_args, "")
+MATCHER_P4(VulkanCommandInfoEqual, command_table, expected_name, expected_index,
+           expected_block_index, "")
 {
-    EXPECT_EQ(arg.name, expected_name);
+    EXPECT_EQ(command_table->GetName(arg.command_id), expected_name);
     EXPECT_EQ(arg.index, expected_index);
-    EXPECT_EQ(arg.args, expected_args);
+    EXPECT_EQ(arg.block_index, expected_block_index);
     return true;
 }
 
@@ -141,29 +142,30 @@ TEST(WriteBlockEndTest, MultipleSubmitsWithCommandsCreatesSubmitsWithCorrectComm
 
     // Verify command cache
     auto vk_commands_cache = processor.TakeVkCommandsCache();
+    auto command_table = processor.TakeCommandTable();
     ASSERT_THAT(vk_commands_cache, SizeIs(2));
 
     // Verify commands for command buffer 1001
     ASSERT_TRUE(vk_commands_cache.count(1001));
     ASSERT_THAT(vk_commands_cache[1001], SizeIs(4));
     EXPECT_THAT(vk_commands_cache[1001][0],
-                VulkanCommandInfoEqual(cmd_data_1.GetFunctionName(), 0, args_cmd_1));
+                VulkanCommandInfoEqual(&command_table, cmd_data_1.GetFunctionName(), 0, 6));
     EXPECT_THAT(vk_commands_cache[1001][1],
-                VulkanCommandInfoEqual(cmd_data_2.GetFunctionName(), 1, args_cmd_2));
+                VulkanCommandInfoEqual(&command_table, cmd_data_2.GetFunctionName(), 1, 7));
     EXPECT_THAT(vk_commands_cache[1001][2],
-                VulkanCommandInfoEqual(cmd_data_3.GetFunctionName(), 2, args_cmd_3));
+                VulkanCommandInfoEqual(&command_table, cmd_data_3.GetFunctionName(), 2, 9));
     EXPECT_THAT(vk_commands_cache[1001][3],
-                VulkanCommandInfoEqual(cmd_data_4.GetFunctionName(), 0, args_cmd_4));
+                VulkanCommandInfoEqual(&command_table, cmd_data_4.GetFunctionName(), 0, 8));
 
     // Verify commands for command buffer 1002
     ASSERT_TRUE(vk_commands_cache.count(1002));
     ASSERT_THAT(vk_commands_cache[1002], SizeIs(3));
     EXPECT_THAT(vk_commands_cache[1002][0],
-                VulkanCommandInfoEqual(cmd_data_5.GetFunctionName(), 0, args_cmd_5));
+                VulkanCommandInfoEqual(&command_table, cmd_data_5.GetFunctionName(), 0, 6));
     EXPECT_THAT(vk_commands_cache[1002][1],
-                VulkanCommandInfoEqual(cmd_data_6.GetFunctionName(), 1, args_cmd_6));
+                VulkanCommandInfoEqual(&command_table, cmd_data_6.GetFunctionName(), 1, 9));
     EXPECT_THAT(vk_commands_cache[1002][2],
-                VulkanCommandInfoEqual(cmd_data_7.GetFunctionName(), 0, args_cmd_7));
+                VulkanCommandInfoEqual(&command_table, cmd_data_7.GetFunctionName(), 0, 6));
 }
 
 TEST(WriteBlockEndTest,
@@ -351,5 +353,32 @@ TEST(WriteBlockEndTest, DrawCallsAreCorrectlyCountedInMultipleRenderPasses)
                 testing::ElementsAre(2, 3));
 }
 
+TEST(WriteBlockEndTest, DrawsAndDebugLabelsKeepTheirDetails)
+{
+    DiveAnnotationProcessor processor;
+    uint64_t handle = 1001;
+
+    processor.WriteBlockEnd(CreateCommandData("vkBeginCommandBuffer", handle, 0, 1));
+    nlohmann::ordered_json label_args = {{"commandBuffer", handle},
+                                         {"pLabelInfo", {{"pLabelName", "Shadow pass"}}}};
+    processor.WriteBlockEnd(
+        gfxrecon::util::DiveFunctionData("vkCmdBeginDebugUtilsLabelEXT", 1, 2, label_args));
+    nlohmann::ordered_json draw_args = {
+        {"commandBuffer", handle}, {"indexCount", 36}, {"instanceCount", 2}, {"firstIndex", 0}};
+    processor.WriteBlockEnd(gfxrecon::util::DiveFunctionData("vkCmdDrawIndexed", 2, 3, draw_args));
+    nlohmann::ordered_json no_instances_args = {
+        {"commandBuffer", handle}, {"vertexCount", 3}, {"instanceCount", 0}};
+    processor.WriteBlockEnd(gfxrecon::util::DiveFunctionData("vkCmdDraw", 3, 4, no_instances_args));
+    processor.WriteBlockEnd(CreateCommandData("vkCmdDispatch", handle, 4, 5));
+
+    auto vk_commands_cache = processor.TakeVkCommandsCache();
+    ASSERT_THAT(vk_commands_cache[handle], SizeIs(5));
+    EXPECT_EQ(vk_commands_cache[handle][0].details, "");
+    EXPECT_EQ(vk_commands_cache[handle][1].details, "Shadow pass");
+    EXPECT_EQ(vk_commands_cache[handle][2].details, "(indexCount:36,instanceCount:2)");
+    EXPECT_EQ(vk_commands_cache[handle][3].details, "");
+    EXPECT_EQ(vk_commands_cache[handle][4].details, "");
+}
+
 }  // namespace
 }  // namespace gfxrecon::decode
@@ -16,16 +16,50 @@ limitations under the License.
 
 #include "dive_block_data.h"
 
+#if defined(__linux__)
+#include <errno.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
+
 #include <algorithm>
 #include <cinttypes>
 #include <fstream>
 #include <memory>
+#include <utility>
 
 #include "util/logging.h"
+#include "util/platform.h"
 
 GFXRECON_BEGIN_NAMESPACE(gfxrecon)
 GFXRECON_BEGIN_NAMESPACE(decode)
 
+namespace
+{
+
+#if defined(__linux__)
+// Copy up to size bytes at offset in in_fd to the current position of out_fd, within the kernel.
+// Returns the number of bytes copied, or -1 if the kernel can't copy between these files
+ssize_t KernelCopy(int in_fd, uint64_t offset, int out_fd, uint64_t size)
+{
+    // Both calls copy at most about 2GB at a time
+    size_t len = static_cast<size_t>(std::min<uint64_t>(size, 1ull << 30));
+    off_t in_offset = static_cast<off_t>(offset);
+#if !defined(__ANDROID__)
+    ssize_t copied = copy_file_range(in_fd, &in_offset, out_fd, nullptr, len, 0);
+    if (copied >= 0 ||
+        (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP))
+    {
+        return copied;
+    }
+    in_offset = static_cast<off_t>(offset);
+#endif
+    return sendfile(out_fd, in_fd, &in_offset, len);
+}
+#endif
+
+}  // namespace
+
 bool TestBlockVisitor::Visit(const DiveOriginalBlock& block)
 {
     std::string descrip = "original, offset:" + std::to_string(block.offset_) +
@@ -55,24 +89,19 @@ bool WriterBlockVisitor::Visit(const DiveOriginalBlock& block)
         // Found empty block in original file, presumably a block in the asset file, no need to copy
         return true;
     }
-    if (!util::platform::FileSeek(original_file_ptr_, block.offset_, util::platform::FileSeekSet))
+
+    // Most blocks are left untouched, so runs of them are copied at once
+    if (pending_size_ != 0 && block.offset_ == pending_offset_ + pending_size_)
     {
-        GFXRECON_LOG_ERROR("Could not seek block at offset %d in original file", block.offset_);
-        return false;
+        pending_size_ += block.size_;
+        return true;
     }
-    uint64_t bytes_left_to_copy = block.size_;
-    while (bytes_left_to_copy > 0)
+    if (!Flush())
     {
-        uint64_t bytes_to_copy = bytes_left_to_copy;
-        if (bytes_left_to_copy > kDiveBlockBufferSize)
-        {
-            bytes_to_copy = kDiveBlockBufferSize;
-        }
-        bytes_left_to_copy -= bytes_to_copy;
-
-        util::platform::FileRead(copy_buffer_, bytes_to_copy, original_file_ptr_);
-        util::platform::FileWrite(copy_buffer_, bytes_to_copy, new_file_ptr_);
+        return false;
     }
+    pending_offset_ = block.offset_;
+    pending_size_ = block.size_;
     return true;
 }
 
@@ -83,15 +112,96 @@ bool WriterBlockVisitor::Visit(const DiveModificationBlock& block)
         GFXRECON_LOG_ERROR("WriterBlockVisitor encountered empty modification block");
         return false;
     }
+    if (!Flush())
+    {
+        return false;
+    }
     if (!util::platform::FileWrite(block.blob_ptr_->data(), block.blob_ptr_->size(), new_file_ptr_))
     {
         GFXRECON_LOG_ERROR("Writing modified block, could not write to new file");
         return false;
     }
+    bytes_written_ += block.blob_ptr_->size();
+    return true;
+}
+
+bool WriterBlockVisitor::Flush()
+{
+    if (pending_size_ == 0)
+    {
+        return true;
+    }
+    if (!CopyOriginalRange(pending_offset_, pending_size_))
+    {
+        return false;
+    }
+    bytes_written_ += pending_size_;
+    pending_size_ = 0;
     return true;
 }
 
-bool DiveBlockData::AddOriginalBlock(size_t index, uint64_t offset)
+bool WriterBlockVisitor::CopyOriginalRange(uint64_t offset, uint64_t size)
+{
+#if defined(__linux__)
+    // Let the kernel copy the range without going through user space. The new file is then written
+    // both through new_file_ptr_ and its descriptor, so the stdio buffer is flushed before, and the
+    // stdio position is moved past the copied data after
+    if (fflush(new_file_ptr_) == 0)
+    {
+        int original_fd = fileno(original_file_ptr_);
+        int new_fd = fileno(new_file_ptr_);
+        uint64_t copied = 0;
+        while (copied < size)
+        {
+            ssize_t result = KernelCopy(original_fd, offset + copied, new_fd, size - copied);
+            if (result <= 0)
+            {
+                break;
+            }
+            copied += static_cast<uint64_t>(result);
+        }
+        if (copied != 0 &&
+            !util::platform::FileSeek(new_file_ptr_, 0, util::platform::FileSeekEnd))
+        {
+            GFXRECON_LOG_ERROR("Could not seek to the end of the new file");
+            return false;
+        }
+
+        // Whatever the kernel could not copy is copied through the buffer below
+        offset += copied;
+        size -= copied;
+        if (size == 0)
+        {
+            return true;
+        }
+    }
+#endif
+
+    if (!util::platform::FileSeek(original_file_ptr_, offset, util::platform::FileSeekSet))
+    {
+        GFXRECON_LOG_ERROR("Could not seek block at offset %" PRIu64 " in original file", offset);
+        return false;
+    }
+    if (copy_buffer_ == nullptr)
+    {
+        copy_buffer_ = std::make_unique<char[]>(kDiveBlockBufferSize);
+    }
+    while (size > 0)
+    {
+        size_t bytes_to_copy = static_cast<size_t>(std::min<uint64_t>(size, kDiveBlockBufferSize));
+        if (!util::platform::FileRead(copy_buffer_.get(), bytes_to_copy, original_file_ptr_) ||
+            !util::platform::FileWrite(copy_buffer_.get(), bytes_to_copy, new_file_ptr_))
+        {
+            GFXRECON_LOG_ERROR("Could not copy original blocks at offset %" PRIu64, offset);
+            return false;
+        }
+        offset += bytes_to_copy;
+        size -= bytes_to_copy;
+    }
+    return true;
+}
+
+bool DiveBlockData::AddOriginalBlock(size_t index, uint64_t offset, bool in_asset_file)
 {
     if (original_blocks_map_locked_)
     {
@@ -106,11 +216,26 @@ bool DiveBlockData::AddOriginalBlock(size_t index, uint64_t offset)
         return false;
     }
 
-    original_blocks_map_.emplace_back(std::make_shared<DiveOriginalBlock>(offset));
+    original_blocks_map_.emplace_back(offset);
+    original_blocks_in_asset_file_.push_back(in_asset_file);
 
     return true;
 }
 
+std::optional<uint64_t> DiveBlockData::GetOriginalBlockOffset(size_t index) const
+{
+    if (index >= original_blocks_map_.size())
+    {
+        return std::nullopt;
+    }
+    return original_blocks_map_[index].offset_;
+}
+
+bool DiveBlockData::IsOriginalBlockInAssetFile(size_t index) const
+{
+    return index < original_blocks_in_asset_file_.size() && original_blocks_in_asset_file_[index];
+}
+
 bool DiveBlockData::FinalizeOriginalBlocksMapSizes(uint64_t file_size)
 {
     if (original_blocks_map_locked_)
@@ -126,7 +251,7 @@ bool DiveBlockData::FinalizeOriginalBlocksMapSizes(uint64_t file_size)
 
     // Calculating block size for header (before block id 0)
     original_header_block_.offset_ = 0;
-    original_header_block_.size_ = original_blocks_map_[0]->offset_;
+    original_header_block_.size_ = original_blocks_map_[0].offset_;
 
     // Calculating block sizes
     std::vector<uint64_t> block_sizes;
@@ -134,8 +259,8 @@ bool DiveBlockData::FinalizeOriginalBlocksMapSizes(uint64_t file_size)
     uint64_t n_blocks_exceeding_buffer_size = 0;
     for (size_t i = 0; i < original_blocks_map_.size() - 1; i++)
     {
-        uint64_t current_block_start = original_blocks_map_[i]->offset_;
-        uint64_t current_block_end = original_blocks_map_[i + 1]->offset_;
+        uint64_t current_block_start = original_blocks_map_[i].offset_;
+        uint64_t current_block_end = original_blocks_map_[i + 1].offset_;
         if (current_block_start > current_block_end)
         {
             GFXRECON_LOG_ERROR("Original block with id (%d) has invalid offsets (%d-%d)", i,
@@ -151,10 +276,10 @@ bool DiveBlockData::FinalizeOriginalBlocksMapSizes(uint64_t file_size)
             n_blocks_exceeding_buffer_size++;
         }
 
-        original_blocks_map_[i]->size_ = size;
+        original_blocks_map_[i].size_ = size;
     }
 
-    DiveOriginalBlock& last_block = *original_blocks_map_.back();
+    DiveOriginalBlock& last_block = original_blocks_map_.back();
     last_block.size_ = file_size - last_block.offset_;
 
     // Gather last block data for stats
@@ -177,17 +302,22 @@ bool DiveBlockData::FinalizeOriginalBlocksMapSizes(uint64_t file_size)
     return true;
 }
 
+std::vector<DiveBlockData::Modification>::const_iterator DiveBlockData::FindModification(
+    uint32_t primary_id, int32_t secondary_id) const
+{
+    return std::lower_bound(modifications_.begin(), modifications_.end(),
+                            std::make_pair(primary_id, secondary_id),
+                            [](const Modification& modification, std::pair<uint32_t, int32_t> ids) {
+                                return std::make_pair(modification.primary_id,
+                                                      modification.secondary_id) < ids;
+                            });
+}
+
 bool DiveBlockData::ModificationExists(uint32_t primary_id, int32_t secondary_id) const
 {
-    if (modifications_map_.count(primary_id) != 1)
-    {
-        return false;
-    }
-    if (modifications_map_.at(primary_id).count(secondary_id) != 1)
-    {
-        return false;
-    }
-    return true;
+    auto it = FindModification(primary_id, secondary_id);
+    return it != modifications_.end() && it->primary_id == primary_id &&
+           it->secondary_id == secondary_id;
 }
 
 bool DiveBlockData::AddModification(uint32_t primary_id, int32_t secondary_id,
@@ -215,24 +345,18 @@ bool DiveBlockData::AddModification(uint32_t primary_id, int32_t secondary_id,
         return false;
     }
 
-    if (blob_ptr == nullptr)
+    // The only time an empty blob is used is to indicate a deletion modficiation of the original
+    // block
+    if (blob_ptr == nullptr && secondary_id != 0)
     {
-        if (secondary_id != 0)
-        {
-            GFXRECON_LOG_ERROR("Invalid blob provided for modification at: (%d, %d)", primary_id,
-                               secondary_id);
-            return false;
-        }
-        // The only time an empty blob is used is to indicate a deletion modficiation of the
-        // original block
-        modifications_map_[primary_id][secondary_id] = nullptr;
-        return true;
+        GFXRECON_LOG_ERROR("Invalid blob provided for modification at: (%d, %d)", primary_id,
+                           secondary_id);
+        return false;
     }
 
-    auto new_block_ptr = std::make_shared<DiveModificationBlock>(blob_ptr);
-
-    modifications_map_[primary_id][secondary_id] = std::move(new_block_ptr);
-
+    auto it = FindModification(primary_id, secondary_id);
+    modifications_.insert(it, Modification{primary_id, secondary_id,
+                                           DiveModificationBlock(std::move(blob_ptr))});
     return true;
 }
 
@@ -245,45 +369,60 @@ bool DiveBlockData::RemoveModification(uint32_t primary_id, int32_t secondary_id
         return false;
     }
 
-    modifications_map_[primary_id].erase(secondary_id);
+    modifications_.erase(FindModification(primary_id, secondary_id));
     return true;
 }
 
 bool DiveBlockData::TraverseBlocks(BlockVisitor& visitor) const
 {
-    // Go through block-by-block in order of primary_id
+    // Go through block-by-block in order of primary_id, and for a given primary_id in order of
+    // secondary_id. Both the original blocks and the modifications are sorted this way, so they are
+    // merged as they are walked
+    auto modification = modifications_.begin();
     for (uint32_t primary_id = 0; primary_id < original_blocks_map_.size(); primary_id++)
     {
-        std::map<int32_t, std::shared_ptr<IDiveBlock>> blocks_to_write = {};
-        if (modifications_map_.count(primary_id) > 0)
-        {
-            // Copy all the modifications relating to the original block with primary_id
-            blocks_to_write = modifications_map_.at(primary_id);
-        }
-
-        // If there is no modification of the original block, insert a pointer to the original block
-        // into the map of blocks ordered by secondary_id
-        if (blocks_to_write.count(0) == 0)
+        bool original_replaced = false;
+        for (; modification != modifications_.end() && modification->primary_id == primary_id &&
+               modification->secondary_id < 0;
+             ++modification)
         {
-            blocks_to_write[0] = original_blocks_map_.at(primary_id);
+            if (!modification->block.Accept(visitor))
+            {
+                GFXRECON_LOG_ERROR("Couldn't write block with ids (%d, %d)", primary_id,
+                                   modification->secondary_id);
+                return false;
+            }
         }
 
-        // For a given primary_id, go through block-by-block in order of secondary_id
-        for (auto it = blocks_to_write.begin(); it != blocks_to_write.end(); ++it)
+        if (modification != modifications_.end() && modification->primary_id == primary_id &&
+            modification->secondary_id == 0)
         {
-            int32_t secondary_id = it->first;
-            std::shared_ptr<IDiveBlock> current_modification_ptr = it->second;
-
-            if (current_modification_ptr == nullptr)
+            original_replaced = true;
+            if (modification->block.blob_ptr_ == nullptr)
             {
                 GFXRECON_LOG_INFO("Original block (%d) was marked for deletion", primary_id);
-                continue;
             }
+            else if (!modification->block.Accept(visitor))
+            {
+                GFXRECON_LOG_ERROR("Couldn't write block with ids (%d, %d)", primary_id, 0);
+                return false;
+            }
+            ++modification;
+        }
+
+        if (!original_replaced && !original_blocks_map_[primary_id].Accept(visitor))
+        {
+            GFXRECON_LOG_ERROR("Couldn't write block with ids (%d, %d)", primary_id, 0);
+            return false;
+        }
 
-            if (!current_modification_ptr->Accept(visitor))
+        for (; modification != modifications_.end() && modification->primary_id == primary_id;
+             ++modification)
+        {
+            if (!modification->block.Accept(visitor))
             {
                 GFXRECON_LOG_ERROR("Couldn't write block with ids (%d, %d)", primary_id,
-                                   secondary_id);
+                                   modification->secondary_id);
                 return false;
             }
         }
@@ -325,7 +464,7 @@ bool DiveBlockData::WriteGFXRFile(const std::string& original_file_path,
         return false;
     }
 
-    if (!TraverseBlocks(writer))
+    if (!TraverseBlocks(writer) || !writer.Flush())
     {
         GFXRECON_LOG_ERROR("Could not copy blocks in order");
         return false;
@@ -343,7 +482,8 @@ bool DiveBlockData::WriteGFXRFile(const std::string& original_file_path,
         return false;
     }
 
-    GFXRECON_LOG_INFO("Wrote new gfxr file: %s", new_file_path.c_str());
+    GFXRECON_LOG_INFO("Wrote new gfxr file: %s (%" PRIu64 " bytes)", new_file_path.c_str(),
+                      writer.GetBytesWritten());
     return true;
 }
 
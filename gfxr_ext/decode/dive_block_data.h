@@ -22,14 +22,15 @@ limitations under the License.
 #ifndef GFXRECON_DECODE_DIVE_BLOCK_DATA_H
 #define GFXRECON_DECODE_DIVE_BLOCK_DATA_H
 
-#include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "util/defines.h"
 
-static constexpr size_t kDiveBlockBufferSize = 4096;
+// Size of the buffer used to copy original blocks when the copy can't be done by the OS
+static constexpr size_t kDiveBlockBufferSize = 4 * 1024 * 1024;
 
 GFXRECON_BEGIN_NAMESPACE(gfxrecon)
 GFXRECON_BEGIN_NAMESPACE(decode)
@@ -37,7 +38,7 @@ GFXRECON_BEGIN_NAMESPACE(decode)
 class DiveOriginalBlock;
 class DiveModificationBlock;
 
-// Abstract class representing a visitor for IDiveBlock objects
+// Abstract class representing a visitor for the blocks of a GFXR file
 class BlockVisitor
 {
  public:
@@ -58,6 +59,8 @@ class TestBlockVisitor : public BlockVisitor
 };
 
 // A visitor that writes out a IDiveBlock into a provided file new_file_ptr_
+// Consecutive original blocks that are also contiguous in the original file are copied as a single
+// range, so Flush() must be called after visiting the last block
 class WriterBlockVisitor : public BlockVisitor
 {
  public:
@@ -69,29 +72,34 @@ class WriterBlockVisitor : public BlockVisitor
     bool Visit(const DiveOriginalBlock& block) override;
     bool Visit(const DiveModificationBlock& block) override;
 
+    // Copy the pending range of original blocks into the new file
+    bool Flush();
+
+    uint64_t GetBytesWritten() const { return bytes_written_; }
+
  private:
+    bool CopyOriginalRange(uint64_t offset, uint64_t size);
+
     FILE* original_file_ptr_ = nullptr;
     FILE* new_file_ptr_ = nullptr;
-    char copy_buffer_[kDiveBlockBufferSize] = {};
-};
 
-// Abstract class representing a single binary block encoded in .gfxr format
-class IDiveBlock
-{
- public:
-    IDiveBlock() {}
-    virtual ~IDiveBlock() {}
-    virtual bool Accept(BlockVisitor& visitor) const = 0;
+    // Range of the original file that has been visited but not copied yet
+    uint64_t pending_offset_ = 0;
+    uint64_t pending_size_ = 0;
+
+    uint64_t bytes_written_ = 0;
+    std::unique_ptr<char[]> copy_buffer_ = nullptr;  // Allocated on first use
 };
 
 // Representing a gfxr-encoded block with data stored in the original file
-class DiveOriginalBlock : public IDiveBlock
+// Captures can have tens of millions of blocks, so this is kept to a plain offset & size that is
+// stored by value in a contiguous array
+class DiveOriginalBlock
 {
  public:
     DiveOriginalBlock() {}
     DiveOriginalBlock(uint64_t offset) : offset_(offset) {}
-    ~DiveOriginalBlock() override {}
-    bool Accept(BlockVisitor& visitor) const override { return visitor.Visit(*this); }
+    bool Accept(BlockVisitor& visitor) const { return visitor.Visit(*this); }
 
     uint64_t offset_ = 0;
     uint64_t size_ = 0;
@@ -100,13 +108,12 @@ class DiveOriginalBlock : public IDiveBlock
 // Representing a gfxr-encoded block with data stored in a buffer
 // If blob_ptr is undefined, that is interpreted as an empty block
 // blob_ptr_ is expected to point at a non-empty vector at the time of traversal
-class DiveModificationBlock : public IDiveBlock
+class DiveModificationBlock
 {
  public:
     DiveModificationBlock() {}
     DiveModificationBlock(std::shared_ptr<std::vector<char>> blob_ptr) : blob_ptr_(blob_ptr) {}
-    ~DiveModificationBlock() override {}
-    bool Accept(BlockVisitor& visitor) const override { return visitor.Visit(*this); }
+    bool Accept(BlockVisitor& visitor) const { return visitor.Visit(*this); }
 
     std::shared_ptr<std::vector<char>> blob_ptr_ = nullptr;
 };
@@ -114,19 +121,26 @@ class DiveModificationBlock : public IDiveBlock
 class DiveBlockData
 {
  public:
-    // Add info for the next block in the original GFXR file
-    bool AddOriginalBlock(size_t index, uint64_t offset);
+    // Add info for the next block in the original GFXR file. A block read from an asset file has
+    // no data in the GFXR file, and is recorded at the offset of the next block of the GFXR file
+    bool AddOriginalBlock(size_t index, uint64_t offset, bool in_asset_file = false);
 
     // Calculate block sizes, drop the file-end block and lock the map
     bool FinalizeOriginalBlocksMapSizes(uint64_t file_size);
     bool IsOriginalBlocksMapLocked() const { return original_blocks_map_locked_; }
 
+    // Offset of the original block with the given index in the original GFXR file
+    std::optional<uint64_t> GetOriginalBlockOffset(size_t index) const;
+
+    // Whether the original block with the given index was read from an asset file
+    bool IsOriginalBlockInAssetFile(size_t index) const;
+
     // Add or edit modifications
     bool ModificationExists(uint32_t primary_id, int32_t secondary_id) const;
     bool AddModification(uint32_t primary_id, int32_t secondary_id,
                          std::shared_ptr<std::vector<char>> blob_ptr);
     bool RemoveModification(uint32_t primary_id, int32_t secondary_id);
-    void ClearAllModifications() { modifications_map_.clear(); }
+    void ClearAllModifications() { modifications_.clear(); }
 
     // Write modified GFXR file at the specified path
     bool TraverseBlocks(BlockVisitor& visitor) const;
@@ -134,25 +148,34 @@ class DiveBlockData
                        const std::string& new_file_path) const;
 
  private:
+    struct Modification
+    {
+        uint32_t primary_id = 0;
+        int32_t secondary_id = 0;
+        DiveModificationBlock block;
+    };
+
+    // Find the modification with the given ids, or the position where it would be inserted
+    std::vector<Modification>::const_iterator FindModification(uint32_t primary_id,
+                                                               int32_t secondary_id) const;
+
     // Info for the blocks in the original GFXR file
-    std::vector<std::shared_ptr<DiveOriginalBlock>>
-        original_blocks_map_;  // Starting block index of 0
+    std::vector<DiveOriginalBlock> original_blocks_map_;  // Starting block index of 0
+    std::vector<bool> original_blocks_in_asset_file_;     // Indexed like original_blocks_map_
     DiveOriginalBlock original_header_block_;
     bool original_blocks_map_locked_ = false;
 
-    // Info for modifications
+    // Info for modifications, sorted by primary_id then secondary_id
     //
-    // The first key (uint32_t) is the primary_id which is the original_id. Valid values:
-    // [0...original_blocks_map_.size()-1]
+    // The primary_id is the original_id. Valid values: [0...original_blocks_map_.size()-1]
     //
-    // The second key (int32_t) is the secondary_id which represents the position of
-    // this modified block relative to the primary_id block, with negative values coming before the
-    // original block and positive values after. A secondary_id of 0 represents a modification
-    // overwriting the original block, and only these modifications are allowed to have a value of
-    // nullptr.
+    // The secondary_id represents the position of this modified block relative to the primary_id
+    // block, with negative values coming before the original block and positive values after. A
+    // secondary_id of 0 represents a modification overwriting the original block, and only these
+    // modifications are allowed to have a blob_ptr_ of nullptr, which deletes the original block.
     //
     // Each modification has an unique pair of primary_id and secondary_id.
-    std::map<uint32_t, std::map<int32_t, std::shared_ptr<IDiveBlock>>> modifications_map_;
+    std::vector<Modification> modifications_;
 };
 
 GFXRECON_END_NAMESPACE(decode)
@@ -18,6 +18,10 @@
 
 #include <gtest/gtest.h>
 
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
 namespace gfxrecon::decode
 {
 namespace
@@ -107,6 +111,26 @@ TEST_F(DiveBlockDataTestFixture, AddOriginalBlock_WrongIndex_Fail)
     EXPECT_FALSE(d.AddOriginalBlock(1, 1));
 }
 
+TEST_F(DiveBlockDataTestFixture, GetOriginalBlockOffset)
+{
+    d.AddOriginalBlock(0, 16);
+    d.AddOriginalBlock(1, 40);
+    EXPECT_EQ(d.GetOriginalBlockOffset(0), 16u);
+    EXPECT_EQ(d.GetOriginalBlockOffset(1), 40u);
+    EXPECT_EQ(d.GetOriginalBlockOffset(2), std::nullopt);
+}
+
+TEST_F(DiveBlockDataTestFixture, IsOriginalBlockInAssetFile)
+{
+    d.AddOriginalBlock(0, 16);
+    d.AddOriginalBlock(1, 40, /*in_asset_file=*/true);
+    d.AddOriginalBlock(2, 40);
+    EXPECT_FALSE(d.IsOriginalBlockInAssetFile(0));
+    EXPECT_TRUE(d.IsOriginalBlockInAssetFile(1));
+    EXPECT_FALSE(d.IsOriginalBlockInAssetFile(2));
+    EXPECT_FALSE(d.IsOriginalBlockInAssetFile(3));
+}
+
 TEST_F(DiveBlockDataTestFixture, FinalizeOriginalBlocksMapSizes_Success)
 {
     LockExampleOriginals();
@@ -294,5 +318,66 @@ TEST_F(DiveBlockDataTestFixture, TraverseBlocks_OrderSecondary)
     EXPECT_EQ(GetExampleString(o[2]), traversed_strings[6]);
 }
 
+TEST_F(DiveBlockDataTestFixture, TraverseBlocks_ModificationsAddedOutOfOrder)
+{
+    LockExampleOriginals();
+    PopulateExampleModifications();
+
+    // Add modifications in no particular order, and remove one of them
+    EXPECT_TRUE(d.AddModification(2, 1, m[1]));
+    EXPECT_TRUE(d.AddModification(0, -1, m[2]));
+    EXPECT_TRUE(d.AddModification(2, 0, nullptr));
+    EXPECT_TRUE(d.AddModification(1, 3, m[3]));
+    EXPECT_TRUE(d.AddModification(0, 0, m[4]));
+    EXPECT_TRUE(d.AddModification(1, -2, m[5]));
+    EXPECT_TRUE(d.RemoveModification(0, 0));
+    EXPECT_FALSE(d.ModificationExists(0, 0));
+    EXPECT_TRUE(d.ModificationExists(1, 3));
+
+    // Traverse and check order
+    EXPECT_TRUE(d.TraverseBlocks(v));
+    std::vector<std::string> traversed_strings = v.GetTraversedPathString();
+    EXPECT_EQ(6, traversed_strings.size());
+    EXPECT_EQ(GetExampleString(m[2]), traversed_strings[0]);
+    EXPECT_EQ(GetExampleString(o[0]), traversed_strings[1]);
+    EXPECT_EQ(GetExampleString(m[5]), traversed_strings[2]);
+    EXPECT_EQ(GetExampleString(o[1]), traversed_strings[3]);
+    EXPECT_EQ(GetExampleString(m[3]), traversed_strings[4]);
+    EXPECT_EQ(GetExampleString(m[1]), traversed_strings[5]);
+}
+
+TEST_F(DiveBlockDataTestFixture, WriteGFXRFile_CopiesRangesAndModifications)
+{
+    // Every byte of the original file tells where it came from
+    std::string original(file_size, '\0');
+    for (uint32_t i = 0; i < file_size; i++)
+    {
+        original[i] = static_cast<char>(i);
+    }
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string original_path = (dir / "dive_block_data_test_original.gfxr").string();
+    std::string new_path = (dir / "dive_block_data_test_new.gfxr").string();
+    std::ofstream(original_path, std::ios::binary) << original;
+
+    LockExampleOriginals();
+    PopulateExampleModifications();
+    EXPECT_TRUE(d.AddModification(1, 0, nullptr));
+    EXPECT_TRUE(d.AddModification(2, -1, m[3]));
+
+    ASSERT_TRUE(d.WriteGFXRFile(original_path, new_path));
+    std::ifstream new_file(new_path, std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(new_file)),
+                        std::istreambuf_iterator<char>());
+
+    // Header and block 0, then the modification, then block 2
+    std::string expected = original.substr(0, o[1].first) + "123" +
+                           original.substr(o[2].first, o[2].second);
+    EXPECT_EQ(expected, written);
+
+    new_file.close();
+    std::filesystem::remove(original_path);
+    std::filesystem::remove(new_path);
+}
+
 }  // namespace
 }  // namespace gfxrecon::decode
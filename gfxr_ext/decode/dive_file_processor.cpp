@@ -25,6 +25,7 @@ limitations under the License.
 #include "dive_block_data.h"
 #include "dive_pm4_capture.h"
 #include "dive_renderdoc.h"
+#include "format/format_util.h"
 #include "util/logging.h"
 #include "util/platform.h"
 
@@ -59,6 +60,11 @@ void DiveFileProcessor::SetDiveBlockData(std::shared_ptr<DiveBlockData> p_block_
     run_without_decoders_ = true;
 }
 
+void DiveFileProcessor::SetDeferFunctionCalls(bool defer_function_calls)
+{
+    defer_function_calls_ = defer_function_calls;
+}
+
 bool DiveFileProcessor::WriteFile(const std::string& name, const std::string& content)
 {
     std::string new_file_path = absolute_path_ + "/" + name;
@@ -218,7 +224,34 @@ void DiveFileProcessor::StoreBlockInfo()
 
     int64_t offset = gfxr_file->FileTell();
     GFXRECON_ASSERT(offset > 0);
-    dive_block_data_->AddOriginalBlock(block_index_, static_cast<uint64_t>(offset));
+    bool in_asset_file = file_stack_.back().active_file != gfxr_file;
+    dive_block_data_->AddOriginalBlock(block_index_, static_cast<uint64_t>(offset), in_asset_file);
+}
+
+bool DiveFileProcessor::GetBlockBuffer(BlockParser& parser, BlockBuffer& block_buffer)
+{
+    skip_block_processing_ = false;
+
+    FileInputStreamPtr active_file = file_stack_.back().active_file;
+    int64_t offset = active_file->FileTell();
+    if (!FileProcessor::GetBlockBuffer(parser, block_buffer))
+    {
+        return false;
+    }
+
+    if (!defer_function_calls_ || active_file != gfxr_file_.lock())
+    {
+        return true;
+    }
+
+    format::BlockType block_type = format::RemoveCompressedBlockBit(block_buffer.Header().type);
+    if (block_type == format::BlockType::kFunctionCallBlock ||
+        block_type == format::BlockType::kMethodCallBlock)
+    {
+        skip_block_processing_ = true;
+        deferred_blocks_.push_back({.block_index = block_index_, .offset = offset});
+    }
+    return true;
 }
 
 GFXRECON_END_NAMESPACE(decode)
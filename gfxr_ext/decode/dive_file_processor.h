@@ -16,12 +16,14 @@ limitations under the License.
 
 // Implementing a custom file processor is necessary to support these changes:
 // - Loop a single frame for N times, or infinitely
+// - Defer decoding the function calls, so that they can be decoded on several threads
 
 // NOLINT(build/header_guard)
 #ifndef GFXRECON_DECODE_DIVE_FILE_PROCESSOR_H
 #define GFXRECON_DECODE_DIVE_FILE_PROCESSOR_H
 
 #include <memory>
+#include <vector>
 
 #include "decode/block_parser.h"
 #include "decode/file_processor.h"
@@ -41,6 +43,22 @@ class DiveFileProcessor : public FileProcessor
     // overwriting existing file if present
     bool WriteFile(const std::string& name, const std::string& content);
 
+    // A function or method call block of the GFXR file that was not decoded
+    struct DeferredBlock
+    {
+        uint64_t block_index = 0;
+        int64_t offset = 0;
+    };
+
+    // When set, the function and method calls read from the GFXR file are not decoded. They are
+    // recorded instead, so that they can be decoded later with ProcessBlockAtOffset(), possibly by
+    // other file processors on other threads. The calls read from an asset file are decoded as
+    // usual, since they can't be found again from an offset in the GFXR file.
+    void SetDeferFunctionCalls(bool defer_function_calls);
+
+    // In block order
+    std::vector<DeferredBlock> TakeDeferredBlocks() { return std::move(deferred_blocks_); }
+
  protected:
     bool ProcessFrameDelimiter(const FrameEndMarkerArgs& end_frame) override;
 
@@ -48,7 +66,11 @@ class DiveFileProcessor : public FileProcessor
 
     void StoreBlockInfo() override;
 
+    bool GetBlockBuffer(BlockParser& parser, BlockBuffer& block_buffer) override;
+
  private:
+    bool SkipBlockProcessing() override { return skip_block_processing_; }
+
     // The block index of the state end marker
     uint64_t state_end_marker_block_index_{0};
     // Application will terminate after the single frame has been looped loop_single_frame_count_
@@ -65,6 +87,11 @@ class DiveFileProcessor : public FileProcessor
     // Need to store this because the active file is sometimes the .gfxa one. Since the parent class
     // "owns" this value, avoid sharing ownership and accidentally extending lifetime beyond use.
     std::weak_ptr<FileInputStream> gfxr_file_;
+
+    bool defer_function_calls_{false};
+    // Whether the block that was just read is deferred
+    bool skip_block_processing_{false};
+    std::vector<DeferredBlock> deferred_blocks_;
 };
 
 GFXRECON_END_NAMESPACE(decode)
@@ -0,0 +1,440 @@
+/*
+Copyright 2026 Google Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "dive_vulkan_command_table.h"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+
+#include "util/logging.h"
+
+GFXRECON_BEGIN_NAMESPACE(gfxrecon)
+GFXRECON_BEGIN_NAMESPACE(decode)
+
+namespace
+{
+
+// Classifies a command by its name, with the same rules for the commands listed below and for any
+// other command, so that a command missing from the list is still handled as its family
+constexpr DiveVulkanCommandType ClassifyVulkanCommand(std::string_view name)
+{
+    auto starts_with = [name](std::string_view prefix) {
+        return name.substr(0, prefix.size()) == prefix;
+    };
+    auto contains = [name](std::string_view part) {
+        return name.find(part) != std::string_view::npos;
+    };
+
+    if (starts_with("vkQueueSubmit"))
+    {
+        return DiveVulkanCommandType::kQueueSubmit;
+    }
+    if (name == "vkBeginCommandBuffer")
+    {
+        return DiveVulkanCommandType::kBeginCommandBuffer;
+    }
+    if (name == "vkEndCommandBuffer")
+    {
+        return DiveVulkanCommandType::kEndCommandBuffer;
+    }
+    if (contains("BeginDebugUtilsLabelEXT"))
+    {
+        return DiveVulkanCommandType::kBeginDebugUtilsLabel;
+    }
+    if (contains("EndDebugUtilsLabelEXT"))
+    {
+        return DiveVulkanCommandType::kEndDebugUtilsLabel;
+    }
+    if (starts_with("vkCmdDraw"))
+    {
+        return DiveVulkanCommandType::kDraw;
+    }
+    if (starts_with("vkCmdDispatch"))
+    {
+        return DiveVulkanCommandType::kDispatch;
+    }
+    if (starts_with("vkCmdBeginRenderPass"))
+    {
+        return DiveVulkanCommandType::kBeginRenderPass;
+    }
+    if (starts_with("vkCmdEndRenderPass"))
+    {
+        return DiveVulkanCommandType::kEndRenderPass;
+    }
+    if (starts_with("vkCmdCopyBuffer"))
+    {
+        return DiveVulkanCommandType::kCopyBuffer;
+    }
+    if (starts_with("vkCmdClearAttachments"))
+    {
+        return DiveVulkanCommandType::kClearAttachments;
+    }
+    if (starts_with("vkCmdClearColorImage"))
+    {
+        return DiveVulkanCommandType::kClearColorImage;
+    }
+    if (starts_with("vkCmdClearDepthStencilImage"))
+    {
+        return DiveVulkanCommandType::kClearDepthStencilImage;
+    }
+    if (starts_with("vkCmdResolveImage"))
+    {
+        return DiveVulkanCommandType::kResolveImage;
+    }
+    return DiveVulkanCommandType::kOther;
+}
+
+// All the commands written out by the VulkanExportDiveConsumer, sorted by name. They only fix the
+// ids of the commands; any command missing from here gets an id when it is first seen
+constexpr std::string_view kKnownVulkanCommands[] = {
+    "vkBeginCommandBuffer",
+    "vkCmdBeginConditionalRenderingEXT",
+    "vkCmdBeginDebugUtilsLabelEXT",
+    "vkCmdBeginPerTileExecutionQCOM",
+    "vkCmdBeginQuery",
+    "vkCmdBeginQueryIndexedEXT",
+    "vkCmdBeginRenderPass",
+    "vkCmdBeginRenderPass2",
+    "vkCmdBeginRenderPass2KHR",
+    "vkCmdBeginRendering",
+    "vkCmdBeginRenderingKHR",
+    "vkCmdBeginTransformFeedbackEXT",
+    "vkCmdBeginVideoCodingKHR",
+    "vkCmdBindDescriptorBufferEmbeddedSamplers2EXT",
+    "vkCmdBindDescriptorSets",
+    "vkCmdBindDescriptorSets2",
+    "vkCmdBindDescriptorSets2KHR",
+    "vkCmdBindIndexBuffer",
+    "vkCmdBindIndexBuffer2",
+    "vkCmdBindIndexBuffer2KHR",
+    "vkCmdBindInvocationMaskHUAWEI",
+    "vkCmdBindPipeline",
+    "vkCmdBindPipelineShaderGroupNV",
+    "vkCmdBindShadersEXT",
+    "vkCmdBindShadingRateImageNV",
+    "vkCmdBindTileMemoryQCOM",
+    "vkCmdBindTransformFeedbackBuffersEXT",
+    "vkCmdBindVertexBuffers",
+    "vkCmdBindVertexBuffers2",
+    "vkCmdBindVertexBuffers2EXT",
+    "vkCmdBlitImage",
+    "vkCmdBlitImage2",
+    "vkCmdBlitImage2KHR",
+    "vkCmdBuildAccelerationStructureNV",
+    "vkCmdBuildAccelerationStructuresIndirectKHR",
+    "vkCmdBuildAccelerationStructuresKHR",
+    "vkCmdBuildMicromapsEXT",
+    "vkCmdBuildPartitionedAccelerationStructuresNV",
+    "vkCmdClearAttachments",
+    "vkCmdClearColorImage",
+    "vkCmdClearDepthStencilImage",
+    "vkCmdControlVideoCodingKHR",
+    "vkCmdConvertCooperativeVectorMatrixNV",
+    "vkCmdCopyAccelerationStructureKHR",
+    "vkCmdCopyAccelerationStructureNV",
+    "vkCmdCopyAccelerationStructureToMemoryKHR",
+    "vkCmdCopyBuffer",
+    "vkCmdCopyBuffer2",
+    "vkCmdCopyBuffer2KHR",
+    "vkCmdCopyBufferToImage",
+    "vkCmdCopyBufferToImage2",
+    "vkCmdCopyBufferToImage2KHR",
+    "vkCmdCopyImage",
+    "vkCmdCopyImage2",
+    "vkCmdCopyImage2KHR",
+    "vkCmdCopyImageToBuffer",
+    "vkCmdCopyImageToBuffer2",
+    "vkCmdCopyImageToBuffer2KHR",
+    "vkCmdCopyMemoryToAccelerationStructureKHR",
+    "vkCmdCopyMemoryToMicromapEXT",
+    "vkCmdCopyMicromapEXT",
+    "vkCmdCopyMicromapToMemoryEXT",
+    "vkCmdCopyQueryPoolResults",
+    "vkCmdDebugMarkerBeginEXT",
+    "vkCmdDebugMarkerEndEXT",
+    "vkCmdDebugMarkerInsertEXT",
+    "vkCmdDecodeVideoKHR",
+    "vkCmdDispatch",
+    "vkCmdDispatchBase",
+    "vkCmdDispatchBaseKHR",
+    "vkCmdDispatchIndirect",
+    "vkCmdDispatchTileQCOM",
+    "vkCmdDraw",
+    "vkCmdDrawClusterHUAWEI",
+    "vkCmdDrawClusterIndirectHUAWEI",
+    "vkCmdDrawIndexed",
+    "vkCmdDrawIndexedIndirect",
+    "vkCmdDrawIndexedIndirectCount",
+    "vkCmdDrawIndexedIndirectCountAMD",
+    "vkCmdDrawIndexedIndirectCountKHR",
+    "vkCmdDrawIndirect",
+    "vkCmdDrawIndirectByteCountEXT",
+    "vkCmdDrawIndirectCount",
+    "vkCmdDrawIndirectCountAMD",
+    "vkCmdDrawIndirectCountKHR",
+    "vkCmdDrawMeshTasksEXT",
+    "vkCmdDrawMeshTasksIndirectCountEXT",
+    "vkCmdDrawMeshTasksIndirectCountNV",
+    "vkCmdDrawMeshTasksIndirectEXT",
+    "vkCmdDrawMeshTasksIndirectNV",
+    "vkCmdDrawMeshTasksNV",
+    "vkCmdDrawMultiEXT",
+    "vkCmdDrawMultiIndexedEXT",
+    "vkCmdEncodeVideoKHR",
+    "vkCmdEndConditionalRenderingEXT",
+    "vkCmdEndDebugUtilsLabelEXT",
+    "vkCmdEndPerTileExecutionQCOM",
+    "vkCmdEndQuery",
+    "vkCmdEndQueryIndexedEXT",
+    "vkCmdEndRenderPass",
+    "vkCmdEndRenderPass2",
+    "vkCmdEndRenderPass2KHR",
+    "vkCmdEndRendering",
+    "vkCmdEndRendering2EXT",
+    "vkCmdEndRenderingKHR",
+    "vkCmdEndTransformFeedbackEXT",
+    "vkCmdEndVideoCodingKHR",
+    "vkCmdExecuteCommands",
+    "vkCmdExecuteGeneratedCommandsEXT",
+    "vkCmdExecuteGeneratedCommandsNV",
+    "vkCmdFillBuffer",
+    "vkCmdInsertDebugUtilsLabelEXT",
+    "vkCmdNextSubpass",
+    "vkCmdNextSubpass2",
+    "vkCmdNextSubpass2KHR",
+    "vkCmdOpticalFlowExecuteNV",
+    "vkCmdPipelineBarrier",
+    "vkCmdPipelineBarrier2",
+    "vkCmdPipelineBarrier2KHR",
+    "vkCmdPreprocessGeneratedCommandsEXT",
+    "vkCmdPreprocessGeneratedCommandsNV",
+    "vkCmdPushConstants",
+    "vkCmdPushConstants2",
+    "vkCmdPushConstants2KHR",
+    "vkCmdPushDescriptorSet",
+    "vkCmdPushDescriptorSet2",
+    "vkCmdPushDescriptorSet2KHR",
+    "vkCmdPushDescriptorSetKHR",
+    "vkCmdPushDescriptorSetWithTemplate2KHR",
+    "vkCmdPushDescriptorSetWithTemplateKHR",
+    "vkCmdResetEvent",
+    "vkCmdResetEvent2",
+    "vkCmdResetEvent2KHR",
+    "vkCmdResetQueryPool",
+    "vkCmdResolveImage",
+    "vkCmdResolveImage2",
+    "vkCmdResolveImage2KHR",
+    "vkCmdSetAlphaToCoverageEnableEXT",
+    "vkCmdSetAlphaToOneEnableEXT",
+    "vkCmdSetAttachmentFeedbackLoopEnableEXT",
+    "vkCmdSetBlendConstants",
+    "vkCmdSetCheckpointNV",
+    "vkCmdSetCoarseSampleOrderNV",
+    "vkCmdSetColorBlendAdvancedEXT",
+    "vkCmdSetColorBlendEnableEXT",
+    "vkCmdSetColorBlendEquationEXT",
+    "vkCmdSetColorWriteEnableEXT",
+    "vkCmdSetColorWriteMaskEXT",
+    "vkCmdSetConservativeRasterizationModeEXT",
+    "vkCmdSetCoverageModulationModeNV",
+    "vkCmdSetCoverageModulationTableEnableNV",
+    "vkCmdSetCoverageModulationTableNV",
+    "vkCmdSetCoverageReductionModeNV",
+    "vkCmdSetCoverageToColorEnableNV",
+    "vkCmdSetCoverageToColorLocationNV",
+    "vkCmdSetCullMode",
+    "vkCmdSetCullModeEXT",
+    "vkCmdSetDepthBias",
+    "vkCmdSetDepthBias2EXT",
+    "vkCmdSetDepthBiasEnable",
+    "vkCmdSetDepthBiasEnableEXT",
+    "vkCmdSetDepthBounds",
+    "vkCmdSetDepthBoundsTestEnable",
+    "vkCmdSetDepthBoundsTestEnableEXT",
+    "vkCmdSetDepthClampEnableEXT",
+    "vkCmdSetDepthClampRangeEXT",
+    "vkCmdSetDepthClipEnableEXT",
+    "vkCmdSetDepthClipNegativeOneToOneEXT",
+    "vkCmdSetDepthCompareOp",
+    "vkCmdSetDepthCompareOpEXT",
+    "vkCmdSetDepthTestEnable",
+    "vkCmdSetDepthTestEnableEXT",
+    "vkCmdSetDepthWriteEnable",
+    "vkCmdSetDepthWriteEnableEXT",
+    "vkCmdSetDescriptorBufferOffsets2EXT",
+    "vkCmdSetDeviceMask",
+    "vkCmdSetDeviceMaskKHR",
+    "vkCmdSetDiscardRectangleEXT",
+    "vkCmdSetDiscardRectangleEnableEXT",
+    "vkCmdSetDiscardRectangleModeEXT",
+    "vkCmdSetEvent",
+    "vkCmdSetEvent2",
+    "vkCmdSetEvent2KHR",
+    "vkCmdSetExclusiveScissorEnableNV",
+    "vkCmdSetExclusiveScissorNV",
+    "vkCmdSetExtraPrimitiveOverestimationSizeEXT",
+    "vkCmdSetFragmentShadingRateEnumNV",
+    "vkCmdSetFragmentShadingRateKHR",
+    "vkCmdSetFrontFace",
+    "vkCmdSetFrontFaceEXT",
+    "vkCmdSetLineRasterizationModeEXT",
+    "vkCmdSetLineStipple",
+    "vkCmdSetLineStippleEXT",
+    "vkCmdSetLineStippleEnableEXT",
+    "vkCmdSetLineStippleKHR",
+    "vkCmdSetLineWidth",
+    "vkCmdSetLogicOpEXT",
+    "vkCmdSetLogicOpEnableEXT",
+    "vkCmdSetPatchControlPointsEXT",
+    "vkCmdSetPerformanceMarkerINTEL",
+    "vkCmdSetPerformanceOverrideINTEL",
+    "vkCmdSetPerformanceStreamMarkerINTEL",
+    "vkCmdSetPolygonModeEXT",
+    "vkCmdSetPrimitiveRestartEnable",
+    "vkCmdSetPrimitiveRestartEnableEXT",
+    "vkCmdSetPrimitiveTopology",
+    "vkCmdSetPrimitiveTopologyEXT",
+    "vkCmdSetProvokingVertexModeEXT",
+    "vkCmdSetRasterizationSamplesEXT",
+    "vkCmdSetRasterizationStreamEXT",
+    "vkCmdSetRasterizerDiscardEnable",
+    "vkCmdSetRasterizerDiscardEnableEXT",
+    "vkCmdSetRayTracingPipelineStackSizeKHR",
+    "vkCmdSetRenderingAttachmentLocations",
+    "vkCmdSetRenderingAttachmentLocationsKHR",
+    "vkCmdSetRenderingInputAttachmentIndices",
+    "vkCmdSetRenderingInputAttachmentIndicesKHR",
+    "vkCmdSetRepresentativeFragmentTestEnableNV",
+    "vkCmdSetSampleLocationsEXT",
+    "vkCmdSetSampleLocationsEnableEXT",
+    "vkCmdSetSampleMaskEXT",
+    "vkCmdSetScissor",
+    "vkCmdSetScissorWithCount",
+    "vkCmdSetScissorWithCountEXT",
+    "vkCmdSetShadingRateImageEnableNV",
+    "vkCmdSetStencilCompareMask",
+    "vkCmdSetStencilOp",
+    "vkCmdSetStencilOpEXT",
+    "vkCmdSetStencilReference",
+    "vkCmdSetStencilTestEnable",
+    "vkCmdSetStencilTestEnableEXT",
+    "vkCmdSetStencilWriteMask",
+    "vkCmdSetTessellationDomainOriginEXT",
+    "vkCmdSetVertexInputEXT",
+    "vkCmdSetViewport",
+    "vkCmdSetViewportShadingRatePaletteNV",
+    "vkCmdSetViewportSwizzleNV",
+    "vkCmdSetViewportWScalingEnableNV",
+    "vkCmdSetViewportWScalingNV",
+    "vkCmdSetViewportWithCount",
+    "vkCmdSetViewportWithCountEXT",
+    "vkCmdTraceRaysIndirect2KHR",
+    "vkCmdTraceRaysIndirectKHR",
+    "vkCmdTraceRaysKHR",
+    "vkCmdTraceRaysNV",
+    "vkCmdUpdateBuffer",
+    "vkCmdUpdatePipelineIndirectBufferNV",
+    "vkCmdWaitEvents",
+    "vkCmdWaitEvents2",
+    "vkCmdWaitEvents2KHR",
+    "vkCmdWriteAccelerationStructuresPropertiesKHR",
+    "vkCmdWriteAccelerationStructuresPropertiesNV",
+    "vkCmdWriteBufferMarker2AMD",
+    "vkCmdWriteBufferMarkerAMD",
+    "vkCmdWriteMicromapsPropertiesEXT",
+    "vkCmdWriteTimestamp",
+    "vkCmdWriteTimestamp2",
+    "vkCmdWriteTimestamp2KHR",
+    "vkEndCommandBuffer",
+    "vkQueueSubmit",
+    "vkQueueSubmit2",
+    "vkQueueSubmit2KHR",
+};
+
+constexpr bool IsSortedAndUnique()
+{
+    for (size_t i = 1; i < std::size(kKnownVulkanCommands); ++i)
+    {
+        if (!(kKnownVulkanCommands[i - 1] < kKnownVulkanCommands[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(IsSortedAndUnique(), "kKnownVulkanCommands must be sorted by name");
+
+constexpr std::array<DiveVulkanCommandType, std::size(kKnownVulkanCommands)> ClassifyKnownCommands()
+{
+    std::array<DiveVulkanCommandType, std::size(kKnownVulkanCommands)> types = {};
+    for (size_t i = 0; i < types.size(); ++i)
+    {
+        types[i] = ClassifyVulkanCommand(kKnownVulkanCommands[i]);
+    }
+    return types;
+}
+constexpr std::array<DiveVulkanCommandType, std::size(kKnownVulkanCommands)>
+    kKnownVulkanCommandTypes = ClassifyKnownCommands();
+
+}  // namespace
+
+const DiveVulkanCommandTable::Id DiveVulkanCommandTable::kKnownCommandCount =
+    static_cast<DiveVulkanCommandTable::Id>(std::size(kKnownVulkanCommands));
+
+DiveVulkanCommandTable::Id DiveVulkanCommandTable::GetId(std::string_view name)
+{
+    auto known =
+        std::lower_bound(std::begin(kKnownVulkanCommands), std::end(kKnownVulkanCommands), name);
+    if (known != std::end(kKnownVulkanCommands) && *known == name)
+    {
+        return static_cast<Id>(known - std::begin(kKnownVulkanCommands));
+    }
+
+    auto [other, inserted] = m_other_ids.try_emplace(
+        std::string(name), kKnownCommandCount + static_cast<Id>(m_other_names.size()));
+    if (inserted)
+    {
+        GFXRECON_LOG_DEBUG("Vulkan command %s is not in the known command table",
+                           other->first.c_str());
+        m_other_names.push_back(&other->first);
+        m_other_types.push_back(ClassifyVulkanCommand(other->first));
+    }
+    return other->second;
+}
+
+std::string_view DiveVulkanCommandTable::GetName(Id id) const
+{
+    if (id < kKnownCommandCount)
+    {
+        return kKnownVulkanCommands[id];
+    }
+    GFXRECON_ASSERT(id - kKnownCommandCount < m_other_names.size());
+    return *m_other_names[id - kKnownCommandCount];
+}
+
+DiveVulkanCommandType DiveVulkanCommandTable::GetType(Id id) const
+{
+    if (id < kKnownCommandCount)
+    {
+        return kKnownVulkanCommandTypes[id];
+    }
+    GFXRECON_ASSERT(id - kKnownCommandCount < m_other_types.size());
+    return m_other_types[id - kKnownCommandCount];
+}
+
+GFXRECON_END_NAMESPACE(decode)
+GFXRECON_END_NAMESPACE(gfxrecon)
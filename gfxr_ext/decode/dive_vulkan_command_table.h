@@ -0,0 +1,93 @@
+/*
+Copyright 2026 Google Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Captures can have millions of Vulkan commands, so each command refers to its name by an id
+// rather than keeping a copy of it. The commands that the VulkanExportDiveConsumer writes out are
+// known at compile time, and are classified there once and for all. Any other command is
+// classified by the same rules the first time it is seen.
+
+// NOLINT(build/header_guard)
+#ifndef GFXRECON_DECODE_DIVE_VULKAN_COMMAND_TABLE_H
+#define GFXRECON_DECODE_DIVE_VULKAN_COMMAND_TABLE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "util/defines.h"
+
+GFXRECON_BEGIN_NAMESPACE(gfxrecon)
+GFXRECON_BEGIN_NAMESPACE(decode)
+
+// The kinds of Vulkan commands that Dive handles differently. Commands that Dive treats alike
+// share a type, such as all the variants of vkCmdDraw
+enum class DiveVulkanCommandType : uint8_t
+{
+    kOther,
+    kQueueSubmit,
+    kBeginCommandBuffer,
+    kEndCommandBuffer,
+    kBeginDebugUtilsLabel,
+    kEndDebugUtilsLabel,
+    kDraw,
+    kDispatch,
+    kBeginRenderPass,
+    kEndRenderPass,
+    kCopyBuffer,
+    kClearAttachments,
+    kClearColorImage,
+    kClearDepthStencilImage,
+    kResolveImage,
+};
+
+// Maps the names of Vulkan commands to ids. The ids of the commands known at compile time are
+// fixed, and any other name gets the next free id the first time it is seen
+class DiveVulkanCommandTable
+{
+ public:
+    using Id = uint32_t;
+
+    // Number of commands known at compile time, whose ids are [0, kKnownCommandCount)
+    static const Id kKnownCommandCount;
+
+    DiveVulkanCommandTable() = default;
+    DiveVulkanCommandTable(DiveVulkanCommandTable&&) = default;
+    DiveVulkanCommandTable& operator=(DiveVulkanCommandTable&&) = default;
+    // Not copyable, since the names of the other commands are referred to by pointer
+    DiveVulkanCommandTable(const DiveVulkanCommandTable&) = delete;
+    DiveVulkanCommandTable& operator=(const DiveVulkanCommandTable&) = delete;
+
+    // Returns the id of the command with the given name, adding it if it is not known yet
+    Id GetId(std::string_view name);
+
+    // The id must have been returned by GetId()
+    std::string_view GetName(Id id) const;
+    DiveVulkanCommandType GetType(Id id) const;
+
+ private:
+    // Commands that are not known at compile time, which have an id of kKnownCommandCount + index
+    // in m_other_names and m_other_types. The names point at the keys of m_other_ids
+    std::unordered_map<std::string, Id> m_other_ids;
+    std::vector<const std::string*> m_other_names;
+    std::vector<DiveVulkanCommandType> m_other_types;
+};
+
+GFXRECON_END_NAMESPACE(decode)
+GFXRECON_END_NAMESPACE(gfxrecon)
+
+#endif  // GFXRECON_DECODE_DIVE_VULKAN_COMMAND_TABLE_H
@@ -0,0 +1,91 @@
+/*
+Copyright 2026 Google Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "dive_vulkan_command_table.h"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+
+namespace gfxrecon::decode
+{
+namespace
+{
+
+TEST(DiveVulkanCommandTableTest, KnownCommandsHaveFixedIds)
+{
+    DiveVulkanCommandTable table;
+    DiveVulkanCommandTable other_table;
+    DiveVulkanCommandTable::Id id = table.GetId("vkCmdDrawIndexed");
+    EXPECT_LT(id, DiveVulkanCommandTable::kKnownCommandCount);
+    EXPECT_EQ(other_table.GetId("vkCmdDrawIndexed"), id);
+    EXPECT_EQ(table.GetName(id), "vkCmdDrawIndexed");
+}
+
+TEST(DiveVulkanCommandTableTest, KnownCommandsAreClassified)
+{
+    DiveVulkanCommandTable table;
+    auto type_of = [&table](const char* name) { return table.GetType(table.GetId(name)); };
+    EXPECT_EQ(type_of("vkQueueSubmit"), DiveVulkanCommandType::kQueueSubmit);
+    EXPECT_EQ(type_of("vkQueueSubmit2"), DiveVulkanCommandType::kQueueSubmit);
+    EXPECT_EQ(type_of("vkQueueSubmit2KHR"), DiveVulkanCommandType::kQueueSubmit);
+    EXPECT_EQ(type_of("vkBeginCommandBuffer"), DiveVulkanCommandType::kBeginCommandBuffer);
+    EXPECT_EQ(type_of("vkEndCommandBuffer"), DiveVulkanCommandType::kEndCommandBuffer);
+    EXPECT_EQ(type_of("vkCmdBeginDebugUtilsLabelEXT"),
+              DiveVulkanCommandType::kBeginDebugUtilsLabel);
+    EXPECT_EQ(type_of("vkCmdEndDebugUtilsLabelEXT"), DiveVulkanCommandType::kEndDebugUtilsLabel);
+    EXPECT_EQ(type_of("vkCmdDraw"), DiveVulkanCommandType::kDraw);
+    EXPECT_EQ(type_of("vkCmdDrawMeshTasksIndirectCountEXT"), DiveVulkanCommandType::kDraw);
+    EXPECT_EQ(type_of("vkCmdDispatchIndirect"), DiveVulkanCommandType::kDispatch);
+    EXPECT_EQ(type_of("vkCmdBeginRenderPass2KHR"), DiveVulkanCommandType::kBeginRenderPass);
+    EXPECT_EQ(type_of("vkCmdEndRenderPass2"), DiveVulkanCommandType::kEndRenderPass);
+    EXPECT_EQ(type_of("vkCmdCopyBuffer2"), DiveVulkanCommandType::kCopyBuffer);
+    EXPECT_EQ(type_of("vkCmdClearAttachments"), DiveVulkanCommandType::kClearAttachments);
+    EXPECT_EQ(type_of("vkCmdClearColorImage"), DiveVulkanCommandType::kClearColorImage);
+    EXPECT_EQ(type_of("vkCmdClearDepthStencilImage"),
+              DiveVulkanCommandType::kClearDepthStencilImage);
+    EXPECT_EQ(type_of("vkCmdResolveImage2KHR"), DiveVulkanCommandType::kResolveImage);
+    EXPECT_EQ(type_of("vkCmdBindPipeline"), DiveVulkanCommandType::kOther);
+}
+
+TEST(DiveVulkanCommandTableTest, OtherCommandsGetNewIds)
+{
+    DiveVulkanCommandTable table;
+    DiveVulkanCommandTable::Id first = table.GetId("vkCmdDoSomethingNEW");
+    DiveVulkanCommandTable::Id second = table.GetId("vkCmdDoSomethingElseNEW");
+    EXPECT_EQ(first, DiveVulkanCommandTable::kKnownCommandCount);
+    EXPECT_EQ(second, DiveVulkanCommandTable::kKnownCommandCount + 1);
+    EXPECT_EQ(table.GetId("vkCmdDoSomethingNEW"), first);
+    EXPECT_EQ(table.GetType(first), DiveVulkanCommandType::kOther);
+
+    // The names must survive the table being moved
+    DiveVulkanCommandTable moved_table = std::move(table);
+    EXPECT_EQ(moved_table.GetName(first), "vkCmdDoSomethingNEW");
+    EXPECT_EQ(moved_table.GetName(second), "vkCmdDoSomethingElseNEW");
+}
+
+TEST(DiveVulkanCommandTableTest, OtherCommandsAreClassifiedByName)
+{
+    DiveVulkanCommandTable table;
+    auto type_of = [&table](const char* name) { return table.GetType(table.GetId(name)); };
+    EXPECT_EQ(type_of("vkCmdDrawSomethingNEW"), DiveVulkanCommandType::kDraw);
+    EXPECT_EQ(type_of("vkCmdDispatchSomethingNEW"), DiveVulkanCommandType::kDispatch);
+    EXPECT_EQ(type_of("vkCmdBeginRenderPass3NEW"), DiveVulkanCommandType::kBeginRenderPass);
+    EXPECT_EQ(type_of("vkCmdDoSomethingNEW"), DiveVulkanCommandType::kOther);
+}
+
+}  // namespace
+}  // namespace gfxrecon::decode
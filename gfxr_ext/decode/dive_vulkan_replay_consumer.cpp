@@ -423,6 +423,18 @@ void DiveVulkanReplayConsumer::Process_vkQueueSubmit(
     uint32_t submitCount, StructPointerDecoder<Decoded_VkSubmitInfo>* pSubmits,
     format::HandleId fence)
 {
+    // GPUTime needs the command buffers before they reach the queue, which is before the base
+    // class maps their handles
+    MapStructArrayHandles(pSubmits->GetMetaStructPointer(), pSubmits->GetLength(),
+                          GetObjectInfoTable());
+    Dive::GPUTime::GpuTimeStatus status =
+        gpu_time_.OnBeforeQueueSubmit(submitCount, pSubmits->GetPointer(), pfn_vkDeviceWaitIdle_,
+                                      pfn_vkResetQueryPool_, pfn_vkGetQueryPoolResults_);
+    if (!status.success)
+    {
+        GFXRECON_LOG_ERROR(status.message.c_str());
+    }
+
     VulkanReplayConsumer::Process_vkQueueSubmit(call_info, returnValue, queue, submitCount,
                                                 pSubmits, fence);
 
@@ -430,45 +442,6 @@ void DiveVulkanReplayConsumer::Process_vkQueueSubmit(
     auto submit_status = gpu_time_.OnQueueSubmit(submitCount, submit_infos, pfn_vkDeviceWaitIdle_,
                                                  pfn_vkResetQueryPool_, pfn_vkGetQueryPoolResults_);
 
-    auto IsFrameBoundary = [](Decoded_VkSubmitInfo* submit_info_data, uint32_t submit_count,
-                              CommonObjectInfoTable& object_info_table) -> bool {
-        if (submit_info_data == nullptr)
-        {
-            return false;
-        }
-
-        for (uint32_t i = 0; i < submit_count; ++i)
-        {
-            size_t command_buffer_count = submit_info_data[i].pCommandBuffers.GetLength();
-            const auto command_buffer_ids = submit_info_data[i].pCommandBuffers.GetPointer();
-
-            for (uint32_t j = 0; j < command_buffer_count; ++j)
-            {
-                auto command_buffer_info =
-                    object_info_table.GetVkCommandBufferInfo(command_buffer_ids[j]);
-
-                if (command_buffer_info->is_frame_boundary)
-                {
-                    return true;
-                }
-            }
-        }
-
-        return false;
-    };
-
-    bool is_frame_boundary =
-        IsFrameBoundary(pSubmits->GetMetaStructPointer(), submitCount, GetObjectInfoTable());
-
-    // vkDeviceWaitIdle is needed since when we loop the frame, we do not double/triple buffer cmds.
-    // If the CPU is too fast, it might start to write to cmd while GPU is using it which would
-    // cause random crashes. (No need to add device wait idle when gpu time is enabled since it is
-    // called in GPUTime::OnQueueSubmit)
-    if (!gpu_time_.IsEnabled() && is_frame_boundary)
-    {
-        pfn_vkDeviceWaitIdle_(device_);
-    }
-
     if (!submit_status.gpu_time_status.success)
     {
         if (submit_status.contains_frame_boundary)
@@ -506,26 +479,6 @@ void DiveVulkanReplayConsumer::Process_vkQueuePresentKHR(
         GFXRECON_LOG_INFO(gpu_time_.GetStatsString().c_str());
         gpu_time_stats_csv_str_ = gpu_time_.GetStatsCSVString();
     }
-
-    /********************************************************************************************/
-    // Fix for VUID-vkQueueSubmit-fence-00064
-    // This error occurs when we try to use a VkFence in vkQueueSubmit while that fence is already
-    // active (submitted but not yet signaled). By calling vkDeviceWaitIdle, we force the CPU to
-    // wait until the GPU is completely finished with everything. Once the GPU is idle, that fence
-    // is guaranteed to be signaled.
-
-    // This also fixes VUID-vkQueueSubmit-pSignalSemaphores-00067
-    // This error is because without vkDeviceWaitIdle, the replay attempts to re-signal the
-    // semaphore for the image while the previous iteration's presentation of this image is still
-    // pending in the driver.
-
-    // TODO(wangra): vkDeviceWaitIdle might be too heavy as it will flush all gpu caches. this might
-    // have performance impact. Maybe we should consider waiting for VkFence
-    if (!gpu_time_.IsEnabled())
-    {
-        pfn_vkDeviceWaitIdle_(device_);
-    }
-    /********************************************************************************************/
 }
 
 void DiveVulkanReplayConsumer::Process_vkGetDeviceQueue2(
@@ -969,6 +922,22 @@ void DiveVulkanReplayConsumer::ProcessStateEndMarker(uint64_t frame_number)
 
 void DiveVulkanReplayConsumer::ProcessFrameEndMarker(uint64_t frame_number)
 {
+    // The frame is about to be replayed again, reusing its command buffers, fences and semaphores
+    // without the double/triple buffering of the application, so the gpu must be done with them
+    // first. Waiting here, once per loop, also makes the fence status checked below final. It
+    // fixes:
+    // - Command buffers being recorded again while the gpu still uses them, which would cause
+    //   random crashes
+    // - VUID-vkQueueSubmit-fence-00064, submitting with a fence that is still active
+    // - VUID-vkQueueSubmit-pSignalSemaphores-00067, re-signaling the semaphore of an image whose
+    //   presentation from the previous loop is still pending
+    // TODO(wangra): vkDeviceWaitIdle might be too heavy as it will flush all gpu caches. this might
+    // have performance impact. Maybe we should consider waiting for VkFence
+    if (device_ != VK_NULL_HANDLE)
+    {
+        pfn_vkDeviceWaitIdle_(device_);
+    }
+
     std::vector<VkFence> reset_fence_list = {};
 
     // We try to bring back the initial status for all fences at the end of each loop
@@ -35,9 +35,12 @@ namespace Dive
 
 GPUTime::~GPUTime()
 {
-    if (m_query_pool != VK_NULL_HANDLE)
+    for (VkQueryPool query_pool : m_query_pools)
     {
-        m_destroy_query_pool(m_device, m_query_pool, m_allocator);
+        if (query_pool != VK_NULL_HANDLE)
+        {
+            m_destroy_query_pool(m_device, query_pool, m_allocator);
+        }
     }
 }
 
@@ -113,6 +116,22 @@ void GPUTime::TimeStampSlotAllocator::FreeSlots(const std::vector<uint32_t>& slo
     }
 }
 
+GPUTime::CommandBufferShard& GPUTime::GetShard(VkCommandBuffer command_buffer) const
+{
+    // Handles are usually pointers with mostly identical low and high bits, so they are mixed with
+    // a multiplicative hash before picking a shard
+    uint64_t key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(command_buffer));
+    return m_cmd_shards[((key * 0x9E3779B97F4A7C15ull) >> 32) % kNumCommandBufferShards];
+}
+
+GPUTime::CommandBufferInfo* GPUTime::FindCmd(VkCommandBuffer command_buffer) const
+{
+    CommandBufferShard& shard = GetShard(command_buffer);
+    std::shared_lock lock(shard.mutex);
+    auto iter = shard.cmds.find(command_buffer);
+    return (iter != shard.cmds.end()) ? iter->second.get() : nullptr;
+}
+
 void GPUTime::FrameMetrics::AddFrameData(double frame_time, const std::vector<double>& cmd_time_vec,
                                          const std::vector<double>& renderpass_time_vec,
                                          const std::vector<size_t>& cmd_renderpass_count_vec)
@@ -362,23 +381,35 @@ GPUTime::GpuTimeStatus GPUTime::OnCreateDevice(VkDevice device,
     m_timestamp_period = timestamp_period;
     m_destroy_query_pool = pfn_destroy_query_pool;
 
-    // Create a query pool for timestamps
+    // Create the ring of query pools for timestamps
     VkQueryPoolCreateInfo queryPoolInfo{};
     queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
     queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
     queryPoolInfo.queryCount = TimeStampSlotAllocator::kTotalSlots;
 
-    VkResult result = pfn_create_query_pool(m_device, &queryPoolInfo, m_allocator, &m_query_pool);
-    if (result != VK_SUCCESS)
+    for (VkQueryPool& query_pool : m_query_pools)
     {
-        absl::MutexLock lock(&m_mutex);
-        m_valid_frame = false;
-        return GPUTime::GpuTimeStatus{
-            "vkCreateQueryPool failed with VkResult: " + std::to_string(static_cast<int>(result)),
-            false};
+        VkResult result = pfn_create_query_pool(m_device, &queryPoolInfo, m_allocator, &query_pool);
+        if (result != VK_SUCCESS)
+        {
+            query_pool = VK_NULL_HANDLE;
+            for (VkQueryPool& created_query_pool : m_query_pools)
+            {
+                if (created_query_pool != VK_NULL_HANDLE)
+                {
+                    m_destroy_query_pool(m_device, created_query_pool, m_allocator);
+                    created_query_pool = VK_NULL_HANDLE;
+                }
+            }
+            absl::MutexLock lock(&m_mutex);
+            m_valid_frame = false;
+            return GPUTime::GpuTimeStatus{"vkCreateQueryPool failed with VkResult: " +
+                                              std::to_string(static_cast<int>(result)),
+                                          false};
+        }
+        pfn_reset_query_pool(m_device, query_pool, 0, TimeStampSlotAllocator::kTotalSlots);
     }
-
-    pfn_reset_query_pool(m_device, m_query_pool, 0, TimeStampSlotAllocator::kTotalSlots);
+    m_recording_query_pool_index.store(0, std::memory_order_release);
     return GPUTime::GpuTimeStatus();
 }
 
@@ -390,8 +421,9 @@ GPUTime::GpuTimeStatus GPUTime::OnDestroyDevice(VkDevice device,
         return GPUTime::GpuTimeStatus{"Not destroying the cached device!"};
     }
 
-    if ((m_device != VK_NULL_HANDLE) && (m_query_pool != VK_NULL_HANDLE))
+    if ((m_device != VK_NULL_HANDLE) && (m_query_pools[0] != VK_NULL_HANDLE))
     {
+        absl::MutexLock boundary_lock(&m_boundary_mutex);
         absl::MutexLock lock(&m_mutex);
         if (m_queues.empty())
         {
@@ -404,8 +436,12 @@ GPUTime::GpuTimeStatus GPUTime::OnDestroyDevice(VkDevice device,
         }
         m_queues.clear();
 
-        m_destroy_query_pool(m_device, m_query_pool, m_allocator);
-        m_query_pool = VK_NULL_HANDLE;
+        for (VkQueryPool& query_pool : m_query_pools)
+        {
+            m_destroy_query_pool(m_device, query_pool, m_allocator);
+            query_pool = VK_NULL_HANDLE;
+        }
+        m_pending_frames.clear();
         m_allocator = nullptr;
     }
     m_device = VK_NULL_HANDLE;
@@ -421,22 +457,26 @@ GPUTime::GpuTimeStatus GPUTime::OnDestroyCommandPool(VkCommandPool command_pool)
     }
 
     absl::MutexLock lock(&m_mutex);
-    auto it = m_cmds.begin();
-    while (it != m_cmds.end())
+    for (CommandBufferShard& shard : m_cmd_shards)
     {
-        const VkCommandBuffer command_buffer = it->first;
-        const CommandBufferInfo& info = it->second;
-
-        if (info.pool == command_pool)
-        {
-            m_timestamp_allocator.FreeSlots(
-                {info.begin_timestamp_offset, info.end_timestamp_offset});
-            RemoveCmdFromFrameCache(command_buffer);
-            it = m_cmds.erase(it);
-        }
-        else
+        std::unique_lock shard_lock(shard.mutex);
+        auto it = shard.cmds.begin();
+        while (it != shard.cmds.end())
         {
-            ++it;
+            const VkCommandBuffer command_buffer = it->first;
+            CommandBufferInfo& info = *it->second;
+
+            if (info.pool == command_pool)
+            {
+                m_timestamp_allocator.FreeSlots(
+                    {info.begin_timestamp_offset, info.end_timestamp_offset});
+                RemoveCmdFromFrameCache(command_buffer, info);
+                it = shard.cmds.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
         }
     }
     return GPUTime::GpuTimeStatus();
@@ -453,11 +493,11 @@ GPUTime::GpuTimeStatus GPUTime::OnAllocateCommandBuffers(
         return GPUTime::GpuTimeStatus();
     }
 
-    absl::MutexLock lock(&m_mutex);
     for (uint32_t i = 0; i < allocate_info_ptr->commandBufferCount; ++i)
     {
-        if (m_cmds.find(command_buffers_ptr[i]) != m_cmds.end())
+        if (FindCmd(command_buffers_ptr[i]) != nullptr)
         {
+            absl::MutexLock lock(&m_mutex);
             m_valid_frame = false;
             std::stringstream ss;
             ss << static_cast<void*>(command_buffers_ptr[i]) << " has been already added!";
@@ -473,13 +513,14 @@ GPUTime::GpuTimeStatus GPUTime::OnAllocateCommandBuffers(
             return GPUTime::GpuTimeStatus{"Exceeded maximum number of query slots.", false};
         }
 
-        m_cmds.insert({command_buffers_ptr[i],
-                       {.renderpass_slots = {},
-                        .pool = allocate_info_ptr->commandPool,
-                        .begin_timestamp_offset = begin_slot,
-                        .end_timestamp_offset = end_slot,
-                        .usage_one_submit = false,
-                        .reusable = false}});
+        auto info = std::make_unique<CommandBufferInfo>();
+        info->pool = allocate_info_ptr->commandPool;
+        info->begin_timestamp_offset = begin_slot;
+        info->end_timestamp_offset = end_slot;
+
+        CommandBufferShard& shard = GetShard(command_buffers_ptr[i]);
+        std::unique_lock shard_lock(shard.mutex);
+        shard.cmds.emplace(command_buffers_ptr[i], std::move(info));
     }
     return GPUTime::GpuTimeStatus();
 }
@@ -492,15 +533,18 @@ GPUTime::GpuTimeStatus GPUTime::OnFreeCommandBuffers(uint32_t command_buffer_cou
     absl::MutexLock lock(&m_mutex);
     for (uint32_t i = 0; i < command_buffer_count; ++i)
     {
-        if (m_cmds.find(command_buffers_ptr[i]) == m_cmds.end())
+        CommandBufferShard& shard = GetShard(command_buffers_ptr[i]);
+        std::unique_lock shard_lock(shard.mutex);
+        auto iter = shard.cmds.find(command_buffers_ptr[i]);
+        if (iter == shard.cmds.end())
         {
             // The cache doesn't contain secondary command buffers
             continue;
         }
-        m_timestamp_allocator.FreeSlots({m_cmds[command_buffers_ptr[i]].begin_timestamp_offset,
-                                         m_cmds[command_buffers_ptr[i]].end_timestamp_offset});
-        RemoveCmdFromFrameCache(command_buffers_ptr[i]);
-        m_cmds.erase(command_buffers_ptr[i]);
+        CommandBufferInfo& info = *iter->second;
+        m_timestamp_allocator.FreeSlots({info.begin_timestamp_offset, info.end_timestamp_offset});
+        RemoveCmdFromFrameCache(command_buffers_ptr[i], info);
+        shard.cmds.erase(iter);
     }
     return GPUTime::GpuTimeStatus();
 }
@@ -509,13 +553,14 @@ GPUTime::GpuTimeStatus GPUTime::OnResetCommandBuffer(VkCommandBuffer command_buf
 {
     m_boundary_detector.OnResetCommandBuffer(command_buffer);
 
-    absl::MutexLock lock(&m_mutex);
-    if (m_cmds.find(command_buffer) == m_cmds.end())
+    CommandBufferInfo* info = FindCmd(command_buffer);
+    if (info == nullptr)
     {
         // The cache doesn't contain secondary command buffers
         return GPUTime::GpuTimeStatus();
     }
-    RemoveCmdFromFrameCache(command_buffer);
+    absl::MutexLock lock(&m_mutex);
+    RemoveCmdFromFrameCache(command_buffer, *info);
     return GPUTime::GpuTimeStatus();
 }
 
@@ -524,11 +569,15 @@ GPUTime::GpuTimeStatus GPUTime::OnResetCommandPool(VkCommandPool command_pool)
     m_boundary_detector.OnResetCommandPool(command_pool);
 
     absl::MutexLock lock(&m_mutex);
-    for (auto& cmd : m_cmds)
+    for (CommandBufferShard& shard : m_cmd_shards)
     {
-        if (cmd.second.pool == command_pool)
+        std::shared_lock shard_lock(shard.mutex);
+        for (auto& [command_buffer, info] : shard.cmds)
         {
-            RemoveCmdFromFrameCache(cmd.first);
+            if (info->pool == command_pool)
+            {
+                RemoveCmdFromFrameCache(command_buffer, *info);
+            }
         }
     }
     return GPUTime::GpuTimeStatus();
@@ -543,15 +592,15 @@ GPUTime::GpuTimeStatus GPUTime::OnBeginCommandBuffer(
         return GPUTime::GpuTimeStatus();
     }
 
-    absl::MutexLock lock(&m_mutex);
-    auto iter = m_cmds.find(command_buffer);
-    if (iter == m_cmds.end())
+    CommandBufferInfo* info_ptr = FindCmd(command_buffer);
+    if (info_ptr == nullptr)
     {
         // We do not insert timestamps into secondary command buffers
         return GPUTime::GpuTimeStatus();
     }
 
-    CommandBufferInfo& info = iter->second;
+    CommandBufferInfo& info = *info_ptr;
+    std::lock_guard lock(info.mutex);
 
     m_timestamp_allocator.FreeSlots(info.renderpass_slots);
     info.renderpass_slots.clear();
@@ -565,8 +614,11 @@ GPUTime::GpuTimeStatus GPUTime::OnBeginCommandBuffer(
 
     info.reusable = ((flags & VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT) != 0);
 
-    pfn_cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_query_pool,
-                            info.begin_timestamp_offset);
+    info.query_pool_index = m_recording_query_pool_index.load(std::memory_order_acquire);
+    info.first_submit_frame_index = CommandBufferInfo::kNotSubmitted;
+
+    pfn_cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                            m_query_pools[info.query_pool_index], info.begin_timestamp_offset);
     return GPUTime::GpuTimeStatus();
 }
 
@@ -578,277 +630,349 @@ GPUTime::GpuTimeStatus GPUTime::OnEndCommandBuffer(VkCommandBuffer command_buffe
         return GPUTime::GpuTimeStatus();
     }
 
-    absl::MutexLock lock(&m_mutex);
-    auto iter = m_cmds.find(command_buffer);
-    if (iter == m_cmds.end())
+    const CommandBufferInfo* info = FindCmd(command_buffer);
+    if (info == nullptr)
     {
         // We do not insert timestamps into secondary command buffers
         return GPUTime::GpuTimeStatus();
     }
 
-    CommandBufferInfo& info = iter->second;
-
-    pfn_cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_query_pool,
-                            info.end_timestamp_offset);
+    std::lock_guard lock(info->mutex);
+    if (info->query_pool_index == kInvalidQueryPoolIndex)
+    {
+        // The begin timestamp was not written
+        return GPUTime::GpuTimeStatus();
+    }
+    pfn_cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                            m_query_pools[info->query_pool_index], info->end_timestamp_offset);
     return GPUTime::GpuTimeStatus();
 }
 
-GPUTime::GpuTimeStatus GPUTime::OnFrameBoundary(
-    PFN_vkResetQueryPool pfn_reset_query_pool, PFN_vkGetQueryPoolResults pfn_get_query_pool_results)
+GPUTime::FrameBoundaryWork GPUTime::BeginFrameBoundary()
 {
-    GPUTime::GpuTimeStatus update_status;
     if (m_valid_frame)
     {
-        update_status = UpdateFrameMetrics(pfn_get_query_pool_results);
+        bool has_timestamps = std::any_of(m_frame_cmds.begin(), m_frame_cmds.end(),
+                                          [](const SubmittedCmd& submitted_cmd) {
+                                              return submitted_cmd.query_pool_index !=
+                                                     kInvalidQueryPoolIndex;
+                                          });
+        if (has_timestamps)
+        {
+            m_pending_frames.push_back(
+                PendingFrame{.frame_index = m_frame_index, .cmds = std::move(m_frame_cmds)});
+        }
     }
 
     m_frame_index++;
     m_frame_cmds.clear();
-
-    pfn_reset_query_pool(m_device, m_query_pool, 0, TimeStampSlotAllocator::kTotalSlots);
     m_valid_frame = true;
-    return update_status;
+
+    const uint32_t recording_index = m_recording_query_pool_index.load(std::memory_order_relaxed);
+    FrameBoundaryWork work;
+    work.next_query_pool_index = (recording_index + 1) % kNumQueryPools;
+
+    // The next pool of the ring must be read back and reset before the next frame records to it.
+    // Command buffers submitted again without being re-recorded have their slots reset by
+    // OnBeforeQueueSubmit instead
+    work.must_complete_pools[work.next_query_pool_index] = true;
+    return work;
 }
 
-GPUTime::GpuTimeStatus GPUTime::UpdateFrameMetrics(
+GPUTime::GpuTimeStatus GPUTime::FinishFrameBoundary(
+    const FrameBoundaryWork& work, PFN_vkDeviceWaitIdle pfn_device_wait_idle,
+    PFN_vkResetQueryPool pfn_reset_query_pool,
     PFN_vkGetQueryPoolResults pfn_get_query_pool_results)
 {
-    constexpr size_t data_per_query = sizeof(uint64_t);          // For the result itself
-    constexpr size_t availability_per_query = sizeof(uint64_t);  // For the availability status
-    VkDeviceSize data_size =
-        TimeStampSlotAllocator::kTotalSlots * (data_per_query + availability_per_query);
-    constexpr VkDeviceSize stride = data_per_query + availability_per_query;
-
-    VkResult result =
-        pfn_get_query_pool_results(m_device, m_query_pool, 0, TimeStampSlotAllocator::kTotalSlots,
-                                   data_size, m_timestamps_with_availability, stride,
-                                   VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    GPUTime::GpuTimeStatus status;
+    if (!HarvestFrames(work.must_complete_pools, pfn_get_query_pool_results, status))
+    {
+        // A frame was dropped while the gpu may still write to its queries, which must not
+        // happen once they are reset
+        pfn_device_wait_idle(m_device);
+    }
 
-    if (result != VK_SUCCESS)
+    for (uint32_t i = 0; i < kNumQueryPools; ++i)
     {
-        if (result == VK_NOT_READY)
+        if (work.must_complete_pools[i])
         {
-            // Make sure all timestamps are available
-            // vkDeviceWaitIdle is used to force gpu to finish all tasks
-            // But there is still a delay on the data being transfered from register to mem
-            // Some timestamp might still not be available even after vkDeviceWaitIdle is called
-            // result could also be VK_NOT_READY since we have a ring buffer to keep all timestamps
-            // We allocate slot to all allocated cmd buffers, and it is possible that some cmds
-            // are allocated but never submitted in current frame
-            // Since we dont know how much the delay is, use kMaxQueryCount to wait for 5 frames to
-            // make sure all results are transfered back to mem
-            constexpr uint32_t kMaxQueryCount = 5;
-            uint32_t query_count = 0;
-            bool all_timestamp_available = true;
-            do
-            {
-                all_timestamp_available = true;
-                for (const auto& cmd : m_frame_cmds)
-                {
-                    // cmd may not be in the m_cmds when some cmds got deleted before submitting the
-                    // frame boundary cmd
-                    if (m_cmds.find(cmd) != m_cmds.end())
-                    {
-                        const uint32_t begin_timestamp_offset = m_cmds[cmd].begin_timestamp_offset;
-                        const uint32_t end_timestamp_offset = m_cmds[cmd].end_timestamp_offset;
-
-                        if (begin_timestamp_offset == TimeStampSlotAllocator::kInvalidIndex ||
-                            end_timestamp_offset == TimeStampSlotAllocator::kInvalidIndex)
-                        {
-                            continue;
-                        }
-
-                        uint64_t availability_end =
-                            m_timestamps_with_availability[end_timestamp_offset * 2 + 1];
-                        uint64_t availability_begin =
-                            m_timestamps_with_availability[begin_timestamp_offset * 2 + 1];
+            pfn_reset_query_pool(m_device, m_query_pools[i], 0,
+                                 TimeStampSlotAllocator::kTotalSlots);
+        }
+    }
+    m_recording_query_pool_index.store(work.next_query_pool_index, std::memory_order_release);
+    return status;
+}
 
-                        if ((availability_begin == 0) || (availability_end == 0))
-                        {
-                            all_timestamp_available = false;
-                            // sleep for 14ms (assume 72fps, so ~14ms per frame)
-                            // and hope the result would be available
-                            std::this_thread::sleep_for(std::chrono::milliseconds(14));
-                            result = pfn_get_query_pool_results(
-                                m_device, m_query_pool, 0, TimeStampSlotAllocator::kTotalSlots,
-                                data_size, m_timestamps_with_availability, stride,
-                                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
-                            ++query_count;
-                            break;
-                        }
-                    }
-                }
-            } while (!all_timestamp_available && query_count < kMaxQueryCount);
+bool GPUTime::HarvestFrames(const bool (&must_complete_pools)[kNumQueryPools],
+                            PFN_vkGetQueryPoolResults pfn_get_query_pool_results,
+                            GpuTimeStatus& status)
+{
+    // The gpu has been asked to finish the frame a whole ring of frames ago, so it is only
+    // expected to take long here when the gpu is far behind
+    constexpr uint32_t kMaxPollCount = 100;
+    constexpr auto kPollInterval = std::chrono::milliseconds(1);
+
+    auto UsesMustCompletePool = [&](const PendingFrame& frame) {
+        return std::any_of(frame.cmds.begin(), frame.cmds.end(),
+                           [&](const SubmittedCmd& submitted_cmd) {
+                               return submitted_cmd.query_pool_index != kInvalidQueryPoolIndex &&
+                                      must_complete_pools[submitted_cmd.query_pool_index];
+                           });
+    };
+    // Frames are read back in submission order, so every frame up to the last one using a pool
+    // that is about to be reset has to complete
+    size_t must_complete_count = 0;
+    for (size_t i = 0; i < m_pending_frames.size(); ++i)
+    {
+        if (UsesMustCompletePool(m_pending_frames[i]))
+        {
+            must_complete_count = i + 1;
+        }
+    }
 
-            if (!all_timestamp_available && query_count >= kMaxQueryCount)
-            {
-                m_valid_frame = false;
-                // Keep only the last 4 digits of each handle since there seems to be a limit amount
-                // of chars logcat could output
-                auto ToHexString = [](VkCommandBuffer cmd) -> std::string {
-                    std::stringstream ss;
-                    ss << std::hex << std::setw(4) << std::setfill('0')
-                       << (reinterpret_cast<uintptr_t>(cmd) & 0xFFFF);
-                    return ss.str();
-                };
-
-                std::stringstream ss;
-                ss << std::to_string(m_frame_cmds.size()) << " cmds:" << std::endl;
-                size_t cmd_index = 0;
-                for (const auto& cmd : m_frame_cmds)
-                {
-                    const uint32_t begin_timestamp_offset = m_cmds[cmd].begin_timestamp_offset;
-                    const uint32_t end_timestamp_offset = m_cmds[cmd].end_timestamp_offset;
+    bool all_harvested = true;
+    std::vector<std::vector<uint64_t>> timestamps;
+    while (!m_pending_frames.empty())
+    {
+        const PendingFrame& frame = m_pending_frames.front();
+        const bool must_complete = (must_complete_count > 0);
+
+        ReadbackResult result =
+            ReadFrameTimestamps(frame, pfn_get_query_pool_results, timestamps);
+        for (uint32_t poll_count = 0;
+             must_complete && result == ReadbackResult::kNotReady && poll_count < kMaxPollCount;
+             ++poll_count)
+        {
+            std::this_thread::sleep_for(kPollInterval);
+            result = ReadFrameTimestamps(frame, pfn_get_query_pool_results, timestamps);
+        }
 
-                    uint64_t availability_end = 0;
-                    uint64_t availability_begin = 0;
+        if (result == ReadbackResult::kNotReady && !must_complete)
+        {
+            // Later frames were submitted after this one, so they are not ready either
+            break;
+        }
 
-                    if (begin_timestamp_offset != TimeStampSlotAllocator::kInvalidIndex &&
-                        end_timestamp_offset != TimeStampSlotAllocator::kInvalidIndex)
-                    {
-                        availability_end =
-                            m_timestamps_with_availability[end_timestamp_offset * 2 + 1];
-                        availability_begin =
-                            m_timestamps_with_availability[begin_timestamp_offset * 2 + 1];
-                    }
+        if (result == ReadbackResult::kAvailable)
+        {
+            absl::MutexLock lock(&m_mutex);
+            AddFrameMetrics(frame, timestamps);
+        }
+        else
+        {
+            all_harvested = false;
+            std::stringstream ss;
+            ss << "Query results of frame " << frame.frame_index << " ("
+               << frame.cmds.size() << " cmds) are "
+               << ((result == ReadbackResult::kNotReady) ? "still not available" : "not readable")
+               << ", dropping the frame";
+            status = GPUTime::GpuTimeStatus{ss.str(), false};
+        }
+        m_pending_frames.pop_front();
+        if (must_complete_count > 0)
+        {
+            --must_complete_count;
+        }
+    }
+    return all_harvested;
+}
 
-                    ss << std::to_string(cmd_index);
-                    if ((availability_begin == 0) || (availability_end == 0))
-                    {
-                        ss << "_NA: ";
-                    }
-                    else
-                    {
-                        ss << "_A : ";
-                    }
+GPUTime::ReadbackResult GPUTime::ReadFrameTimestamps(
+    const PendingFrame& frame, PFN_vkGetQueryPoolResults pfn_get_query_pool_results,
+    std::vector<std::vector<uint64_t>>& timestamps)
+{
+    constexpr size_t data_per_query = sizeof(uint64_t);          // For the result itself
+    constexpr size_t availability_per_query = sizeof(uint64_t);  // For the availability status
+    constexpr VkDeviceSize stride = data_per_query + availability_per_query;
 
-                    ss << "0x" << ToHexString(cmd) << " : S"
-                       << std::to_string(static_cast<uint32_t>(begin_timestamp_offset)) << " : E"
-                       << std::to_string(static_cast<uint32_t>(end_timestamp_offset)) << std::endl;
-                    ++cmd_index;
-                }
+    timestamps.resize(frame.cmds.size());
+    std::vector<uint32_t> pool_slots;
+    for (uint32_t pool_index = 0; pool_index < kNumQueryPools; ++pool_index)
+    {
+        pool_slots.clear();
+        for (const SubmittedCmd& submitted_cmd : frame.cmds)
+        {
+            if (submitted_cmd.query_pool_index == pool_index)
+            {
+                pool_slots.insert(pool_slots.end(), submitted_cmd.slots.begin(),
+                                  submitted_cmd.slots.end());
+            }
+        }
+        if (pool_slots.empty())
+        {
+            continue;
+        }
+        std::sort(pool_slots.begin(), pool_slots.end());
+        pool_slots.erase(std::unique(pool_slots.begin(), pool_slots.end()), pool_slots.end());
 
-                return GPUTime::GpuTimeStatus{ss.str(), false};
+        // Only read back the slots used by the frame, one run of consecutive slots at a time
+        for (size_t run_begin = 0; run_begin < pool_slots.size();)
+        {
+            size_t run_end = run_begin + 1;
+            while (run_end < pool_slots.size() &&
+                   pool_slots[run_end] == pool_slots[run_end - 1] + 1)
+            {
+                ++run_end;
+            }
+            const uint32_t first_query = pool_slots[run_begin];
+            const uint32_t query_count = static_cast<uint32_t>(run_end - run_begin);
+            VkResult result = pfn_get_query_pool_results(
+                m_device, m_query_pools[pool_index], first_query, query_count,
+                query_count * stride, &m_timestamps_with_availability[first_query * 2], stride,
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+            if (result != VK_SUCCESS && result != VK_NOT_READY)
+            {
+                return ReadbackResult::kError;
             }
+            run_begin = run_end;
         }
-        else
+
+        for (size_t cmd_index = 0; cmd_index < frame.cmds.size(); ++cmd_index)
         {
-            m_valid_frame = false;
-            return GPUTime::GpuTimeStatus{"vkGetQueryPoolResults failed with VkResult: " +
-                                              std::to_string(static_cast<int>(result)),
-                                          false};
+            const SubmittedCmd& submitted_cmd = frame.cmds[cmd_index];
+            if (submitted_cmd.query_pool_index != pool_index)
+            {
+                continue;
+            }
+            std::vector<uint64_t>& cmd_timestamps = timestamps[cmd_index];
+            cmd_timestamps.clear();
+            for (uint32_t slot : submitted_cmd.slots)
+            {
+                if (m_timestamps_with_availability[slot * 2 + 1] == 0)
+                {
+                    return ReadbackResult::kNotReady;
+                }
+                cmd_timestamps.push_back(m_timestamps_with_availability[slot * 2]);
+            }
         }
     }
+    return ReadbackResult::kAvailable;
+}
+
+void GPUTime::AddFrameMetrics(const PendingFrame& frame,
+                              const std::vector<std::vector<uint64_t>>& timestamps)
+{
+    // m_timestamp_period is the number of nanoseconds per timestamp increment.
+    const double kNanoToMilli = 1.0 / 1000000.0;
+    auto GetTimeDuration = [&](uint64_t begin_timestamp, uint64_t end_timestamp) -> double {
+        uint64_t elapsed_timestamp_increments = end_timestamp - begin_timestamp;
+        return static_cast<double>(elapsed_timestamp_increments) * m_timestamp_period *
+               kNanoToMilli;
+    };
 
     double frame_time = 0.0;
     std::vector<double> cmds_time;
     std::vector<double> renderpasses_time;
     std::vector<size_t> cmd_renderpass_count_vec;
-
-    auto GetTimeDuration = [&](uint32_t begin_offset, uint32_t end_offset,
-                               uint64_t timestamps_with_availability[]) -> std::optional<double> {
-        if (begin_offset == TimeStampSlotAllocator::kInvalidIndex ||
-            end_offset == TimeStampSlotAllocator::kInvalidIndex)
+    for (size_t cmd_index = 0; cmd_index < frame.cmds.size(); ++cmd_index)
+    {
+        if (frame.cmds[cmd_index].query_pool_index == kInvalidQueryPoolIndex)
         {
-            return std::nullopt;
+            continue;
         }
-
-        uint64_t availability_end = timestamps_with_availability[end_offset * 2 + 1];
-        uint64_t availability_begin = timestamps_with_availability[begin_offset * 2 + 1];
-
-        if ((availability_begin == 0) || (availability_end == 0))
+        const std::vector<uint64_t>& cmd_timestamps = timestamps[cmd_index];
+        double elapsed_time_in_ms = GetTimeDuration(cmd_timestamps[0], cmd_timestamps[1]);
+        cmds_time.push_back(elapsed_time_in_ms);
+        frame_time += elapsed_time_in_ms;
+
+        const size_t renderpass_count = (cmd_timestamps.size() - 2) / 2;
+        cmd_renderpass_count_vec.push_back(renderpass_count);
+        for (size_t r = 2; r + 1 < cmd_timestamps.size(); r = r + 2)
         {
-            // Return an empty optional to signal an invalid result
-            return std::nullopt;
+            renderpasses_time.push_back(GetTimeDuration(cmd_timestamps[r], cmd_timestamps[r + 1]));
         }
+    }
 
-        // Calculate the elapsed time in nanoseconds
-        uint64_t elapsed_timestamp_increments = timestamps_with_availability[end_offset * 2] -
-                                                timestamps_with_availability[begin_offset * 2];
-        // m_timestamp_period is the number of nanoseconds per timestamp increment.
-        const double kNanoToMilli = 1.0 / 1000000.0;
-        double elapsed_time_in_ms =
-            static_cast<double>(elapsed_timestamp_increments) * m_timestamp_period * kNanoToMilli;
-
-        return elapsed_time_in_ms;
-    };
+    m_metrics.AddFrameData(frame_time, cmds_time, renderpasses_time, cmd_renderpass_count_vec);
+}
 
-    for (const auto& cmd : m_frame_cmds)
+void GPUTime::RemoveCmdFromFrameCache(VkCommandBuffer cmd, CommandBufferInfo& info)
+{
     {
-        // cmd may not be in the m_cmds when some cmds got deleted before submitting the frame
-        // boundary cmd
-        if (m_cmds.find(cmd) != m_cmds.end())
-        {
-            const uint32_t begin_timestamp_offset = m_cmds[cmd].begin_timestamp_offset;
-            const uint32_t end_timestamp_offset = m_cmds[cmd].end_timestamp_offset;
+        std::lock_guard lock(info.mutex);
 
-            auto elapsed_time_in_ms = GetTimeDuration(begin_timestamp_offset, end_timestamp_offset,
-                                                      m_timestamps_with_availability);
+        // Free any slots that were used for render pass timings within this command buffer
+        m_timestamp_allocator.FreeSlots(info.renderpass_slots);
+        info.renderpass_slots.clear();
+        info.Reset();
+    }
+    auto& vec = m_frame_cmds;
+    vec.erase(std::remove_if(vec.begin(), vec.end(),
+                             [cmd](const SubmittedCmd& submitted_cmd) {
+                                 return submitted_cmd.command_buffer == cmd;
+                             }),
+              vec.end());
+}
 
-            if (!elapsed_time_in_ms)
+std::vector<GPUTime::CommandBufferInfo*> GPUTime::FindResubmittedCmds(
+    uint32_t submit_count, const VkSubmitInfo* submits_ptr) const
+{
+    std::vector<CommandBufferInfo*> resubmitted_cmds;
+    for (uint32_t i = 0; i < submit_count; i++)
+    {
+        for (uint32_t c = 0; c < submits_ptr[i].commandBufferCount; ++c)
+        {
+            CommandBufferInfo* info = FindCmd(submits_ptr[i].pCommandBuffers[c]);
+            if (info == nullptr)
             {
-                frame_time = 0.0;
-                m_valid_frame = false;
-                std::stringstream ss;
-                ss << "Query result is not available for cmd " << static_cast<void*>(cmd)
-                   << " Begin Offset:" << begin_timestamp_offset
-                   << " End Offset:" << end_timestamp_offset;
-                return GPUTime::GpuTimeStatus{ss.str(), false};
+                // OnQueueSubmit reports the command buffers that are not in the cache
+                continue;
             }
-
-            cmds_time.push_back(elapsed_time_in_ms.value());
-            frame_time += elapsed_time_in_ms.value();
-
-            const size_t renderpass_count = m_cmds[cmd].renderpass_slots.size();
-            cmd_renderpass_count_vec.push_back(renderpass_count / 2);
-            for (size_t r = 0; r < renderpass_count; r = r + 2)
+            std::lock_guard info_lock(info->mutex);
+            if ((info->query_pool_index != kInvalidQueryPoolIndex) &&
+                (info->first_submit_frame_index != CommandBufferInfo::kNotSubmitted) &&
+                (info->first_submit_frame_index != m_frame_index))
             {
-                const uint32_t renderpass_begin_timestamp_offset = m_cmds[cmd].renderpass_slots[r];
-                const uint32_t renderpass_end_timestamp_offset =
-                    m_cmds[cmd].renderpass_slots[r + 1];
-
-                auto renderpass_elapsed_time_in_ms = GetTimeDuration(
-                    renderpass_begin_timestamp_offset, renderpass_end_timestamp_offset,
-                    m_timestamps_with_availability);
-
-                if (!renderpass_elapsed_time_in_ms)
-                {
-                    frame_time = 0.0;
-                    m_valid_frame = false;
-                    std::stringstream ss;
-                    ss << "Query result is not available for renderpass " << r << " in the cmd "
-                       << static_cast<void*>(cmd) << " Begin Offset:" << begin_timestamp_offset
-                       << " End Offset:" << end_timestamp_offset;
-                    return GPUTime::GpuTimeStatus{ss.str(), false};
-                }
-                renderpasses_time.push_back(renderpass_elapsed_time_in_ms.value());
+                resubmitted_cmds.push_back(info);
             }
         }
     }
+    return resubmitted_cmds;
+}
 
-    if (m_valid_frame)
+GPUTime::GpuTimeStatus GPUTime::OnBeforeQueueSubmit(
+    uint32_t submit_count, const VkSubmitInfo* submits_ptr,
+    PFN_vkDeviceWaitIdle pfn_device_wait_idle, PFN_vkResetQueryPool pfn_reset_query_pool,
+    PFN_vkGetQueryPoolResults pfn_get_query_pool_results)
+{
+    if (!m_enable || (submits_ptr == nullptr))
     {
-        m_metrics.AddFrameData(frame_time, cmds_time, renderpasses_time, cmd_renderpass_count_vec);
+        return GPUTime::GpuTimeStatus();
     }
 
-    return GPUTime::GpuTimeStatus();
-}
-
-void GPUTime::RemoveCmdFromFrameCache(VkCommandBuffer cmd)
-{
-    auto iter = m_cmds.find(cmd);
-    if (iter == m_cmds.end())
     {
-        return;
+        absl::MutexLock lock(&m_mutex);
+        if (FindResubmittedCmds(submit_count, submits_ptr).empty())
+        {
+            return GPUTime::GpuTimeStatus();
+        }
     }
-    CommandBufferInfo& info = iter->second;
 
-    // Free any slots that were used for render pass timings within this command buffer
-    m_timestamp_allocator.FreeSlots(info.renderpass_slots);
-    info.renderpass_slots.clear();
-    info.Reset();
-    auto& vec = m_frame_cmds;
-    vec.erase(std::remove(vec.begin(), vec.end(), cmd), vec.end());
+    // The slots still hold the timestamps of the frame the command buffer was last submitted in,
+    // and the gpu may still be writing them, so the frames are read back first. Holding
+    // m_boundary_mutex keeps frame boundaries from moving more frames to the pending frames
+    absl::MutexLock boundary_lock(&m_boundary_mutex);
+    pfn_device_wait_idle(m_device);
+    bool all_pools[kNumQueryPools];
+    std::fill(std::begin(all_pools), std::end(all_pools), true);
+    GPUTime::GpuTimeStatus status;
+    HarvestFrames(all_pools, pfn_get_query_pool_results, status);
+
+    absl::MutexLock lock(&m_mutex);
+    for (CommandBufferInfo* info : FindResubmittedCmds(submit_count, submits_ptr))
+    {
+        std::lock_guard info_lock(info->mutex);
+        VkQueryPool query_pool = m_query_pools[info->query_pool_index];
+        pfn_reset_query_pool(m_device, query_pool, info->begin_timestamp_offset, 1);
+        pfn_reset_query_pool(m_device, query_pool, info->end_timestamp_offset, 1);
+        for (uint32_t slot : info->renderpass_slots)
+        {
+            pfn_reset_query_pool(m_device, query_pool, slot, 1);
+        }
+        info->first_submit_frame_index = CommandBufferInfo::kNotSubmitted;
+    }
+    return status;
 }
 
 GPUTime::SubmitStatus GPUTime::OnQueueSubmit(uint32_t submit_count, const VkSubmitInfo* submits_ptr,
@@ -863,9 +987,11 @@ GPUTime::SubmitStatus GPUTime::OnQueueSubmit(uint32_t submit_count, const VkSubm
 
     bool is_frame_boundary = m_boundary_detector.ContainsFrameBoundary(submit_count, submits_ptr);
 
-    // Take the lock at the beginning of the function to treat the submit
-    // and subsequent frame boundary logic as a single transaction.
-    absl::MutexLock lock(&m_mutex);
+    // Take the locks at the beginning of the function to treat the submit and the start of the
+    // subsequent frame boundary logic as a single transaction. The rest of the frame boundary
+    // logic only holds m_boundary_mutex, so that other threads can keep submitting
+    absl::MutexLockMaybe boundary_lock(is_frame_boundary ? &m_boundary_mutex : nullptr);
+    absl::ReleasableMutexLock lock(&m_mutex);
 
     if ((submits_ptr != nullptr) && (submits_ptr->pCommandBuffers != nullptr))
     {
@@ -875,7 +1001,8 @@ GPUTime::SubmitStatus GPUTime::OnQueueSubmit(uint32_t submit_count, const VkSubm
             for (uint32_t c = 0; c < num_command_buffers; ++c)
             {
                 const auto& cmd = submits_ptr[i].pCommandBuffers[c];
-                if (m_cmds.find(cmd) == m_cmds.end())
+                CommandBufferInfo* info = FindCmd(cmd);
+                if (info == nullptr)
                 {
                     // We do not submit secondary command buffer
                     // All primary command buffers should be in the cache
@@ -885,7 +1012,28 @@ GPUTime::SubmitStatus GPUTime::OnQueueSubmit(uint32_t submit_count, const VkSubm
                     return {GPUTime::GpuTimeStatus{ss.str(), false}, false};
                 }
 
-                if (m_cmds[cmd].reusable)
+                SubmittedCmd submitted_cmd;
+                submitted_cmd.command_buffer = cmd;
+                bool reusable = false;
+                {
+                    std::lock_guard info_lock(info->mutex);
+                    reusable = info->reusable;
+                    if (info->query_pool_index != kInvalidQueryPoolIndex)
+                    {
+                        submitted_cmd.query_pool_index = info->query_pool_index;
+                        submitted_cmd.slots.reserve(2 + info->renderpass_slots.size());
+                        submitted_cmd.slots.push_back(info->begin_timestamp_offset);
+                        submitted_cmd.slots.push_back(info->end_timestamp_offset);
+                        submitted_cmd.slots.insert(submitted_cmd.slots.end(),
+                                                   info->renderpass_slots.begin(),
+                                                   info->renderpass_slots.end());
+                        if (info->first_submit_frame_index == CommandBufferInfo::kNotSubmitted)
+                        {
+                            info->first_submit_frame_index = m_frame_index;
+                        }
+                    }
+                }
+                if (reusable)
                 {
                     m_valid_frame = false;
                     std::stringstream ss;
@@ -908,24 +1056,17 @@ GPUTime::SubmitStatus GPUTime::OnQueueSubmit(uint32_t submit_count, const VkSubm
                 {
                     m_frame_cmds.push_back(cmd);
                 }*/
-                m_frame_cmds.push_back(cmd);
+                m_frame_cmds.push_back(std::move(submitted_cmd));
             }
         }
     }
 
     if (is_frame_boundary)
     {
-        // Manually unlock the underlying mutex around the blocking wait
-        // to prevent holding up other threads, then immediately reacquire.
-        m_mutex.Unlock();
-
-        //  force sync to make sure the gpu is done with this frame
-        pfn_device_wait_idle(m_device);
-
-        m_mutex.Lock();
-
-        GPUTime::GpuTimeStatus update_status =
-            OnFrameBoundary(pfn_reset_query_pool, pfn_get_query_pool_results);
+        FrameBoundaryWork work = BeginFrameBoundary();
+        lock.Release();
+        GPUTime::GpuTimeStatus update_status = FinishFrameBoundary(
+            work, pfn_device_wait_idle, pfn_reset_query_pool, pfn_get_query_pool_results);
 
         if (!update_status.success)
         {
@@ -943,11 +1084,15 @@ GPUTime::GpuTimeStatus GPUTime::OnQueuePresent(PFN_vkDeviceWaitIdle pfn_device_w
     {
         return GPUTime::GpuTimeStatus();
     }
-    //  force sync to make sure the gpu is done with this frame
-    pfn_device_wait_idle(m_device);
 
-    absl::MutexLock lock(&m_mutex);
-    return OnFrameBoundary(pfn_reset_query_pool, pfn_get_query_pool_results);
+    absl::MutexLock boundary_lock(&m_boundary_mutex);
+    FrameBoundaryWork work;
+    {
+        absl::MutexLock lock(&m_mutex);
+        work = BeginFrameBoundary();
+    }
+    return FinishFrameBoundary(work, pfn_device_wait_idle, pfn_reset_query_pool,
+                               pfn_get_query_pool_results);
 }
 
 GPUTime::GpuTimeStatus GPUTime::OnGetDeviceQueue2(VkQueue* pQueue)
@@ -1026,18 +1171,21 @@ GPUTime::GpuTimeStatus GPUTime::BeginRenderPass(VkCommandBuffer command_buffer,
         return GPUTime::GpuTimeStatus();
     }
 
-    absl::MutexLock lock(&m_mutex);
-    auto iter = m_cmds.find(command_buffer);
-    if (iter == m_cmds.end())
+    CommandBufferInfo* info = FindCmd(command_buffer);
+    if (info == nullptr)
     {
         return GPUTime::GpuTimeStatus();
     }
 
-    CommandBufferInfo& info = iter->second;
+    std::lock_guard lock(info->mutex);
+    if (info->query_pool_index == kInvalidQueryPoolIndex)
+    {
+        return GPUTime::GpuTimeStatus();
+    }
     uint32_t slot = m_timestamp_allocator.AllocateSlot();
-
-    info.renderpass_slots.push_back(slot);
-    pfn_cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_query_pool, slot);
+    info->renderpass_slots.push_back(slot);
+    pfn_cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                            m_query_pools[info->query_pool_index], slot);
     return GPUTime::GpuTimeStatus();
 }
 
@@ -1049,19 +1197,21 @@ GPUTime::GpuTimeStatus GPUTime::EndRenderPass(VkCommandBuffer command_buffer,
         return GPUTime::GpuTimeStatus();
     }
 
-    absl::MutexLock lock(&m_mutex);
-    auto iter = m_cmds.find(command_buffer);
-    if (iter == m_cmds.end())
+    CommandBufferInfo* info = FindCmd(command_buffer);
+    if (info == nullptr)
     {
         return GPUTime::GpuTimeStatus();
     }
 
-    CommandBufferInfo& info = iter->second;
+    std::lock_guard lock(info->mutex);
+    if (info->query_pool_index == kInvalidQueryPoolIndex)
+    {
+        return GPUTime::GpuTimeStatus();
+    }
     uint32_t slot = m_timestamp_allocator.AllocateSlot();
-
-    info.renderpass_slots.push_back(slot);
-    pfn_cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_query_pool,
-                            slot);
+    info->renderpass_slots.push_back(slot);
+    pfn_cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                            m_query_pools[info->query_pool_index], slot);
     return GPUTime::GpuTimeStatus();
 }
 
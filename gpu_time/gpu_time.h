@@ -21,7 +21,10 @@ limitations under the License.
 #include <atomic>
 #include <deque>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -36,7 +39,11 @@ namespace Dive
 // To use GPUTime, make sure to
 //     - Disable system gpu preemption
 //     - Insert "vr-marker,frame_end,type,application" as frame boundary
-// Note that the performance will drop due to vkDeviceWaitIdle
+// The timestamps of a frame are written to one of a ring of query pools, and read back at a later
+// frame boundary once the gpu has made them available, so measuring does not stall the frame.
+// Command buffers submitted again in a later frame without being re-recorded keep writing to the
+// query slots they were recorded with, so their submits wait for the device to be idle and reset
+// those slots first
 class GPUTime
 {
  public:
@@ -102,6 +109,16 @@ class GPUTime
                                      PFN_vkCmdWriteTimestamp pfn_cmd_write_timestamp)
         ABSL_LOCKS_EXCLUDED(m_mutex);
 
+    // Must be called before the submit reaches the queue, unlike OnQueueSubmit. If a command buffer
+    // is submitted again in a later frame without being re-recorded, this waits for the device,
+    // reads back the pending frames and resets the query slots of the command buffer, which would
+    // otherwise be written twice without a reset in between
+    GpuTimeStatus OnBeforeQueueSubmit(uint32_t submit_count, const VkSubmitInfo* submits_ptr,
+                                      PFN_vkDeviceWaitIdle pfn_device_wait_idle,
+                                      PFN_vkResetQueryPool pfn_reset_query_pool,
+                                      PFN_vkGetQueryPoolResults pfn_get_query_pool_results)
+        ABSL_LOCKS_EXCLUDED(m_boundary_mutex, m_mutex);
+
     SubmitStatus OnQueueSubmit(uint32_t submit_count, const VkSubmitInfo* submits_ptr,
                                PFN_vkDeviceWaitIdle pfn_device_wait_idle,
                                PFN_vkResetQueryPool pfn_reset_query_pool,
@@ -200,6 +217,9 @@ class GPUTime
         std::vector<std::deque<double>> m_renderpass_time_vec;
     };
 
+    static constexpr uint32_t kNumQueryPools = 4;
+    static constexpr uint32_t kInvalidQueryPoolIndex = static_cast<uint32_t>(-1);
+
     class TimeStampSlotAllocator
     {
      public:
@@ -219,6 +239,8 @@ class GPUTime
         std::atomic<uint32_t> m_cur = 0;
     };
 
+    // Vulkan requires the recording of a command buffer to be externally synchronized, so the
+    // mutex of a command buffer is only contended when a submit or a present reads its state
     struct CommandBufferInfo
     {
         void Reset()
@@ -228,25 +250,116 @@ class GPUTime
             // - OnResetCommandBuffer
             usage_one_submit = false;
             reusable = false;
+            query_pool_index = kInvalidQueryPoolIndex;
+            first_submit_frame_index = kNotSubmitted;
         }
         static constexpr uint32_t kInvalidTimeStampOffset = static_cast<uint32_t>(-1);
+        static constexpr uint64_t kNotSubmitted = static_cast<uint64_t>(-1);
 
-        std::vector<uint32_t> renderpass_slots;
+        // Set when the command buffer is allocated, and constant after that
         VkCommandPool pool = VK_NULL_HANDLE;
         uint32_t begin_timestamp_offset = kInvalidTimeStampOffset;
         uint32_t end_timestamp_offset = kInvalidTimeStampOffset;
+
+        // Guards the following members
+        mutable std::mutex mutex;
+        std::vector<uint32_t> renderpass_slots;
+        // Query pool the timestamps are written to, set when recording begins
+        uint32_t query_pool_index = kInvalidQueryPoolIndex;
+        // Frame in which the command buffer was first submitted since it was recorded or since
+        // OnBeforeQueueSubmit reset its query slots
+        uint64_t first_submit_frame_index = kNotSubmitted;
         bool usage_one_submit = false;
         bool reusable = false;
     };
 
-    GpuTimeStatus OnFrameBoundary(PFN_vkResetQueryPool pfn_reset_query_pool,
-                                  PFN_vkGetQueryPoolResults pfn_get_query_pool_results)
+    // The timestamps written by one submitted command buffer, captured at submit time since the
+    // command buffer may be recorded again before they are read back
+    struct SubmittedCmd
+    {
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        uint32_t query_pool_index = kInvalidQueryPoolIndex;
+        // Begin and end, followed by the begin and end of each render pass
+        std::vector<uint32_t> slots;
+    };
+
+    // A frame whose timestamps have not been read back yet
+    struct PendingFrame
+    {
+        uint64_t frame_index = 0;
+        std::vector<SubmittedCmd> cmds;
+    };
+
+    enum class ReadbackResult
+    {
+        kAvailable,
+        kNotReady,
+        kError,
+    };
+
+    // The command buffers are spread over several maps, each with its own lock, so that threads
+    // recording different command buffers don't serialize on the lookup. The infos are heap
+    // allocated so that they stay in place while other command buffers of the shard are added or
+    // removed
+    struct alignas(64) CommandBufferShard
+    {
+        std::shared_mutex mutex;
+        std::unordered_map<VkCommandBuffer, std::unique_ptr<CommandBufferInfo>> cmds;
+    };
+    static constexpr size_t kNumCommandBufferShards = 16;
+
+    CommandBufferShard& GetShard(VkCommandBuffer command_buffer) const;
+
+    // Returns nullptr if the command buffer is not tracked (e.g. a secondary command buffer)
+    CommandBufferInfo* FindCmd(VkCommandBuffer command_buffer) const;
+
+    // The command buffers of the submits that were submitted in an earlier frame and have not been
+    // recorded since, so submitting them writes to query slots that have not been reset
+    std::vector<CommandBufferInfo*> FindResubmittedCmds(uint32_t submit_count,
+                                                        const VkSubmitInfo* submits_ptr) const
         ABSL_EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
 
-    GpuTimeStatus UpdateFrameMetrics(PFN_vkGetQueryPoolResults pfn_get_query_pool_results)
+    // What a frame boundary does once m_mutex is released
+    struct FrameBoundaryWork
+    {
+        // The query pools to read back and reset
+        bool must_complete_pools[kNumQueryPools] = {};
+        uint32_t next_query_pool_index = 0;
+    };
+
+    // Frame boundaries are split in two, so that waiting for the gpu is done without holding
+    // m_mutex, which would block the submits of other threads. The first part moves the frame to
+    // the pending frames, and the second one reads back and resets the query pools
+    FrameBoundaryWork BeginFrameBoundary()
+        ABSL_EXCLUSIVE_LOCKS_REQUIRED(m_boundary_mutex, m_mutex);
+    GpuTimeStatus FinishFrameBoundary(const FrameBoundaryWork& work,
+                                      PFN_vkDeviceWaitIdle pfn_device_wait_idle,
+                                      PFN_vkResetQueryPool pfn_reset_query_pool,
+                                      PFN_vkGetQueryPoolResults pfn_get_query_pool_results)
+        ABSL_EXCLUSIVE_LOCKS_REQUIRED(m_boundary_mutex) ABSL_LOCKS_EXCLUDED(m_mutex);
+
+    // Read back the pending frames in order, stopping at the first one that is not available yet
+    // unless it, or a later frame, uses a query pool in must_complete_pools. Those are polled for a
+    // bounded time and dropped if they still aren't available. Returns false if a frame was
+    // dropped, with the reason in status
+    bool HarvestFrames(const bool (&must_complete_pools)[kNumQueryPools],
+                       PFN_vkGetQueryPoolResults pfn_get_query_pool_results,
+                       GpuTimeStatus& status) ABSL_EXCLUSIVE_LOCKS_REQUIRED(m_boundary_mutex)
+        ABSL_LOCKS_EXCLUDED(m_mutex);
+
+    // Read the timestamps of the slots used by the frame, one range of consecutive slots at a
+    // time. On success, timestamps[i] holds the values of the slots of frame.cmds[i]
+    ReadbackResult ReadFrameTimestamps(const PendingFrame& frame,
+                                       PFN_vkGetQueryPoolResults pfn_get_query_pool_results,
+                                       std::vector<std::vector<uint64_t>>& timestamps)
+        ABSL_EXCLUSIVE_LOCKS_REQUIRED(m_boundary_mutex);
+
+    void AddFrameMetrics(const PendingFrame& frame,
+                         const std::vector<std::vector<uint64_t>>& timestamps)
         ABSL_EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
 
-    void RemoveCmdFromFrameCache(VkCommandBuffer cmd) ABSL_EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void RemoveCmdFromFrameCache(VkCommandBuffer cmd, CommandBufferInfo& info)
+        ABSL_EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
 
     GpuTimeStatus BeginRenderPass(VkCommandBuffer command_buffer,
                                   PFN_vkCmdWriteTimestamp pfn_cmd_write_timestamp)
@@ -258,23 +371,34 @@ class GPUTime
 
     FrameBoundaryDetector m_boundary_detector;
 
+    // Serializes the frame boundaries, and is held while they read back and reset the query pools
+    absl::Mutex m_boundary_mutex ABSL_ACQUIRED_BEFORE(m_mutex);
     mutable absl::Mutex m_mutex;
 
     // Keep the timestamp results *2 for VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
     uint64_t m_timestamps_with_availability[TimeStampSlotAllocator::kTotalSlots *
-                                            2] ABSL_GUARDED_BY(m_mutex) = {};
+                                            2] ABSL_GUARDED_BY(m_boundary_mutex) = {};
+    std::deque<PendingFrame> m_pending_frames ABSL_GUARDED_BY(m_boundary_mutex);
+
     FrameMetrics m_metrics ABSL_GUARDED_BY(m_mutex);
     std::set<VkQueue> m_queues ABSL_GUARDED_BY(m_mutex);
-    std::unordered_map<VkCommandBuffer, CommandBufferInfo> m_cmds ABSL_GUARDED_BY(m_mutex);
-    std::vector<VkCommandBuffer> m_frame_cmds ABSL_GUARDED_BY(m_mutex);
-    TimeStampSlotAllocator m_timestamp_allocator ABSL_GUARDED_BY(m_mutex);
+    std::vector<SubmittedCmd> m_frame_cmds ABSL_GUARDED_BY(m_mutex);
+
+    // Index in m_query_pools of the pool that command buffers beginning now record to
+    std::atomic<uint32_t> m_recording_query_pool_index = 0;
+
+    // Taken after m_mutex when both are needed
+    mutable CommandBufferShard m_cmd_shards[kNumCommandBufferShards];
+
+    // Lock-free, so slots can be allocated while recording without taking m_mutex
+    TimeStampSlotAllocator m_timestamp_allocator;
 
     // The following variables are initialized once during OnCreateDevice and are not
     // expected to be modified in a multi-threaded context. Therefore, they do not
     // require mutex protection.
     VkDevice m_device = VK_NULL_HANDLE;
     const VkAllocationCallbacks* m_allocator = nullptr;
-    VkQueryPool m_query_pool = VK_NULL_HANDLE;
+    VkQueryPool m_query_pools[kNumQueryPools] = {};
     PFN_vkDestroyQueryPool m_destroy_query_pool = nullptr;
     float m_timestamp_period = 0.0f;
 
@@ -78,21 +78,39 @@ struct GlobalSetup
 void BM_RecordCommandBuffers(benchmark::State& state)
 {
     VkCommandBuffer cmd = g_cmds[state.thread_index()];
+    const int64_t renderpass_count = state.range(0);
 
     for (auto _ : state)
     {
         g_gpu_time.OnBeginCommandBuffer(cmd, 0, MockCmdWriteTimestamp);
-        g_gpu_time.OnCmdBeginRenderPass(cmd, MockCmdWriteTimestamp);
+        for (int64_t i = 0; i < renderpass_count; ++i)
+        {
+            g_gpu_time.OnCmdBeginRenderPass(cmd, MockCmdWriteTimestamp);
 
-        // Simulate CPU overhead of doing actual Vulkan command binding/drawing
-        benchmark::ClobberMemory();
+            // Simulate CPU overhead of doing actual Vulkan command binding/drawing
+            benchmark::ClobberMemory();
 
-        g_gpu_time.OnCmdEndRenderPass(cmd, MockCmdWriteTimestamp);
+            g_gpu_time.OnCmdEndRenderPass(cmd, MockCmdWriteTimestamp);
+        }
         g_gpu_time.OnEndCommandBuffer(cmd, MockCmdWriteTimestamp);
     }
+
+    // Each thread records its own command buffer, so with real time the number of command buffers
+    // recorded per second should grow with the thread count when the hooks don't serialize
+    state.SetItemsProcessed(state.iterations());
 }
 
-BENCHMARK(BM_RecordCommandBuffers)->ThreadRange(1, max_thread_count)->UseRealTime();
+BENCHMARK(BM_RecordCommandBuffers)
+    ->ArgName("renderpasses")
+    ->Arg(1)
+    ->Arg(8)
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->Threads(12)
+    ->Threads(max_thread_count)
+    ->UseRealTime();
 
 }  // namespace
 }  // namespace Dive
@@ -19,6 +19,14 @@ limitations under the License.
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
 namespace Dive
 {
 namespace
@@ -41,17 +49,25 @@ MOCK_HANDLE(VkCommandPool, MOCK_COMMAND_POOL, 0x3);
 MOCK_HANDLE(VkCommandBuffer, MOCK_COMMAND_BUFFER_1, 0x10);
 MOCK_HANDLE(VkCommandBuffer, MOCK_COMMAND_BUFFER_2, 0x20);
 MOCK_HANDLE(VkCommandBuffer, MOCK_COMMAND_BUFFER_3, 0x30);
-MOCK_HANDLE(VkQueryPool, MOCK_QUERY_POOL, 0x4);
 
+constexpr uintptr_t kMockQueryPoolStart = 0x100;
 constexpr float kMockTimestampPeriod = 1.0f;
 
 // Mock implementations of the Vulkan functions that GPUTime calls.
 // These functions allow us to control the behavior and return values during tests.
 
+// The timestamps recorded into each command buffer, as (query pool, query) pairs
+std::map<VkCommandBuffer, std::vector<std::pair<VkQueryPool, uint32_t>>> g_mock_recorded_writes;
+// The queries written by the gpu since they were last reset
+std::set<std::pair<VkQueryPool, uint32_t>> g_mock_written_queries;
+uint32_t g_mock_query_pool_count = 0;
+
 VkResult MockCreateQueryPool(VkDevice device, const VkQueryPoolCreateInfo* pCreateInfo,
                              const VkAllocationCallbacks* pAllocator, VkQueryPool* pQueryPool)
 {
-    *pQueryPool = MOCK_QUERY_POOL;
+    // Each query pool gets its own handle, so that the queries of different pools are told apart
+    *pQueryPool = reinterpret_cast<VkQueryPool>(
+        static_cast<uintptr_t>(kMockQueryPoolStart + g_mock_query_pool_count++));
     return VK_SUCCESS;
 }
 
@@ -64,45 +80,42 @@ void MockDestroyQueryPool(VkDevice device, VkQueryPool queryPool,
 void MockResetQueryPool(VkDevice device, VkQueryPool queryPool, uint32_t firstQuery,
                         uint32_t queryCount)
 {
-    // No-op for testing
+    g_mock_written_queries.erase(g_mock_written_queries.lower_bound({queryPool, firstQuery}),
+                                 g_mock_written_queries.lower_bound(
+                                     {queryPool, firstQuery + queryCount}));
 }
 
 void MockCmdWriteTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits pipelineStage,
                            VkQueryPool queryPool, uint32_t query)
 {
-    // No-op for testing
+    g_mock_recorded_writes[commandBuffer].emplace_back(queryPool, query);
 }
 
+// Timestamps of the query slots, in nanoseconds. The slots are allocated in order, so command
+// buffer N (starting at 0) uses slots 2N and 2N+1.
+// - 10ms for the first command buffer: 10ms = 10,000,000 ns
+// - 20ms for the second command buffer
+// - 30ms for the third command buffer
+constexpr uint64_t kMockTimestamps[] = {1000000000, 1010000000, 2000000000,
+                                        2020000000, 3000000000, 3030000000};
+
+// Whether MockGetQueryPoolResults reports the queries as available
+bool g_mock_results_available = true;
+uint32_t g_mock_device_wait_idle_count = 0;
+
 VkResult MockGetQueryPoolResults(VkDevice device, VkQueryPool queryPool, uint32_t firstQuery,
                                  uint32_t queryCount, size_t dataSize, void* pData,
                                  VkDeviceSize stride, VkQueryResultFlags flags)
 {
-    // Simulate returning some timestamp data.
     // Each query result consists of a timestamp (uint64_t) and an availability flag (uint64_t).
-    uint64_t* timestamps = static_cast<uint64_t*>(pData);
-
-    // Simulate a 10ms duration for the first command buffer (queries 0 and 1)
-    // Timestamp values are in nanoseconds. 10ms = 10,000,000 ns
-    timestamps[0] = 1000000000;  // Start time for cmd 1
-    timestamps[1] = 1;           // Availability
-    timestamps[2] = 1010000000;  // End time for cmd 1
-    timestamps[3] = 1;           // Availability
-
-    // Simulate a 20ms duration for the second command buffer (queries 2 and 3)
-    // 20ms = 20,000,000 ns
-    timestamps[4] = 2000000000;  // Start time for cmd 2
-    timestamps[5] = 1;           // Availability
-    timestamps[6] = 2020000000;  // End time for cmd 2
-    timestamps[7] = 1;           // Availability
-
-    // Simulate a 30ms duration for the third command buffer (queries 4 and 5)
-    // 30ms = 30,000,000 ns
-    timestamps[8] = 3000000000;   // Start time for cmd 3
-    timestamps[9] = 1;            // Availability
-    timestamps[10] = 3030000000;  // End time for cmd 3
-    timestamps[11] = 1;           // Availability
-
-    return VK_SUCCESS;
+    for (uint32_t i = 0; i < queryCount; ++i)
+    {
+        const uint32_t query = firstQuery + i;
+        uint64_t* result = reinterpret_cast<uint64_t*>(static_cast<uint8_t*>(pData) + i * stride);
+        result[0] = (query < std::size(kMockTimestamps)) ? kMockTimestamps[query] : 0;
+        result[1] = g_mock_results_available ? 1 : 0;
+    }
+    return g_mock_results_available ? VK_SUCCESS : VK_NOT_READY;
 }
 
 VKAPI_ATTR VkResult VKAPI_CALL MockQueueWaitIdle(VkQueue queue)
@@ -113,12 +126,17 @@ VKAPI_ATTR VkResult VKAPI_CALL MockQueueWaitIdle(VkQueue queue)
 
 VKAPI_ATTR VkResult VKAPI_CALL MockDeviceWaitIdle(VkDevice device)
 {
-    // No-op for testing
+    ++g_mock_device_wait_idle_count;
     return VK_SUCCESS;
 }
 
 void CreateGPUTime(GPUTime& gpu_time, float timestamp_period)
 {
+    g_mock_results_available = true;
+    g_mock_device_wait_idle_count = 0;
+    g_mock_recorded_writes.clear();
+    g_mock_written_queries.clear();
+    g_mock_query_pool_count = 0;
     ASSERT_TRUE(gpu_time
                     .OnCreateDevice(MOCK_DEVICE,
                                     /*allocator=*/nullptr, timestamp_period, MockCreateQueryPool,
@@ -133,6 +151,37 @@ void DestroyGPUTime(GPUTime& gpu_time)
     ASSERT_TRUE(gpu_time.OnDestroyDevice(MOCK_DEVICE, MockQueueWaitIdle).success);
 }
 
+// Timestamps are only written, and so only read back, for recorded command buffers
+void RecordCommandBuffer(GPUTime& gpu_time, VkCommandBuffer cmd)
+{
+    g_mock_recorded_writes[cmd].clear();
+    ASSERT_TRUE(gpu_time.OnBeginCommandBuffer(cmd, 0, MockCmdWriteTimestamp).success);
+    ASSERT_TRUE(gpu_time.OnEndCommandBuffer(cmd, MockCmdWriteTimestamp).success);
+}
+
+// Submit the command buffers the way the layer does, around the timestamps being written by the
+// gpu, and check that no query is written twice without being reset in between
+// (VUID-vkCmdWriteTimestamp-None-00830)
+void SubmitCommandBuffers(GPUTime& gpu_time, const VkSubmitInfo& submit_info)
+{
+    ASSERT_TRUE(gpu_time
+                    .OnBeforeQueueSubmit(1, &submit_info, MockDeviceWaitIdle, MockResetQueryPool,
+                                         MockGetQueryPoolResults)
+                    .success);
+    for (uint32_t i = 0; i < submit_info.commandBufferCount; ++i)
+    {
+        for (const auto& query : g_mock_recorded_writes[submit_info.pCommandBuffers[i]])
+        {
+            EXPECT_TRUE(g_mock_written_queries.insert(query).second)
+                << "Query " << query.second << " is written twice without a reset";
+        }
+    }
+    ASSERT_TRUE(gpu_time
+                    .OnQueueSubmit(1, &submit_info, MockDeviceWaitIdle, MockResetQueryPool,
+                                   MockGetQueryPoolResults)
+                    .gpu_time_status.success);
+}
+
 MATCHER_P(StatsEq, expected, "")
 {
     EXPECT_DOUBLE_EQ(arg.average, expected.average);
@@ -261,6 +310,7 @@ TEST(GPUTimeTest, SingleCommandBufferFrameUpdatesMetricsCorrectly)
     VkDebugUtilsLabelEXT label = {};
     label.pLabelName = GPUTime::kVulkanVrFrameDelimiterString;
     ASSERT_TRUE(gpu_time.OnCmdInsertDebugUtilsLabelEXT(cmd, &label).success);
+    ASSERT_NO_FATAL_FAILURE(RecordCommandBuffer(gpu_time, cmd));
 
     // This should trigger the frame boundary logic.
     VkSubmitInfo submit_info = {};
@@ -303,6 +353,8 @@ TEST(GPUTimeTest, MultiCommandBufferSingleFrameAggregatesTimeCorrectly)
     VkDebugUtilsLabelEXT label = {};
     label.pLabelName = GPUTime::kVulkanVrFrameDelimiterString;
     gpu_time.OnCmdInsertDebugUtilsLabelEXT(MOCK_COMMAND_BUFFER_2, &label);
+    ASSERT_NO_FATAL_FAILURE(RecordCommandBuffer(gpu_time, MOCK_COMMAND_BUFFER_1));
+    ASSERT_NO_FATAL_FAILURE(RecordCommandBuffer(gpu_time, MOCK_COMMAND_BUFFER_2));
 
     VkSubmitInfo submit_info = {};
     submit_info.commandBufferCount = 2;
@@ -373,6 +425,7 @@ TEST(GPUTimeTest, MultipleFramesUpdateMetricsCorrectly)
 
     // --- Submit Frame 1 (10ms) ---
     gpu_time.OnCmdInsertDebugUtilsLabelEXT(MOCK_COMMAND_BUFFER_1, &label);
+    ASSERT_NO_FATAL_FAILURE(RecordCommandBuffer(gpu_time, MOCK_COMMAND_BUFFER_1));
     submit_info.pCommandBuffers = &MOCK_COMMAND_BUFFER_1;
     ASSERT_TRUE(gpu_time
                     .OnQueueSubmit(1, &submit_info, MockDeviceWaitIdle, MockResetQueryPool,
@@ -381,6 +434,7 @@ TEST(GPUTimeTest, MultipleFramesUpdateMetricsCorrectly)
 
     // --- Submit Frame 2 (20ms) ---
     gpu_time.OnCmdInsertDebugUtilsLabelEXT(MOCK_COMMAND_BUFFER_2, &label);
+    ASSERT_NO_FATAL_FAILURE(RecordCommandBuffer(gpu_time, MOCK_COMMAND_BUFFER_2));
     submit_info.pCommandBuffers = &MOCK_COMMAND_BUFFER_2;
     ASSERT_TRUE(gpu_time
                     .OnQueueSubmit(1, &submit_info, MockDeviceWaitIdle, MockResetQueryPool,
@@ -389,6 +443,7 @@ TEST(GPUTimeTest, MultipleFramesUpdateMetricsCorrectly)
 
     // --- Submit Frame 3 (30ms) ---
     gpu_time.OnCmdInsertDebugUtilsLabelEXT(MOCK_COMMAND_BUFFER_3, &label);
+    ASSERT_NO_FATAL_FAILURE(RecordCommandBuffer(gpu_time, MOCK_COMMAND_BUFFER_3));
     submit_info.pCommandBuffers = &MOCK_COMMAND_BUFFER_3;
     ASSERT_TRUE(gpu_time
                     .OnQueueSubmit(1, &submit_info, MockDeviceWaitIdle, MockResetQueryPool,
@@ -413,6 +468,142 @@ TEST(GPUTimeTest, MultipleFramesUpdateMetricsCorrectly)
     ASSERT_NO_FATAL_FAILURE(DestroyGPUTime(gpu_time));
 }
 
+// Test that timestamps which are not available at a frame boundary are read back at a later one,
+// without waiting for the device.
+TEST(GPUTimeTest, LateResultsAreReadBackAtLaterFrameBoundary)
+{
+    GPUTime gpu_time;
+    gpu_time.SetEnable(true);
+    ASSERT_NO_FATAL_FAILURE(CreateGPUTime(gpu_time, kMockTimestampPeriod));
+
+    VkCommandBufferAllocateInfo alloc_info = {};
+    alloc_info.commandPool = MOCK_COMMAND_POOL;
+    alloc_info.commandBufferCount = 2;
+    VkCommandBuffer cmdBufs[] = {MOCK_COMMAND_BUFFER_1, MOCK_COMMAND_BUFFER_2};
+    gpu_time.OnAllocateCommandBuffers(&alloc_info, cmdBufs);
+
+    VkDebugUtilsLabelEXT label = {};
+    label.pLabelName = GPUTime::kVulkanVrFrameDelimiterString;
+    VkSubmitInfo submit_info = {};
+    submit_info.commandBufferCount = 1;
+
+    // --- Submit Frame 1 (10ms), whose results are not available yet ---
+    g_mock_results_available = false;
+    gpu_time.OnCmdInsertDebugUtilsLabelEXT(MOCK_COMMAND_BUFFER_1, &label);
+    ASSERT_NO_FATAL_FAILURE(RecordCommandBuffer(gpu_time, MOCK_COMMAND_BUFFER_1));
+    submit_info.pCommandBuffers = &MOCK_COMMAND_BUFFER_1;
+    ASSERT_TRUE(gpu_time
+                    .OnQueueSubmit(1, &submit_info, MockDeviceWaitIdle, MockResetQueryPool,
+                                   MockGetQueryPoolResults)
+                    .gpu_time_status.success);
+    EXPECT_EQ(gpu_time.GetFrameTimeStats().max, std::numeric_limits<double>::lowest());
+
+    // --- Submit Frame 2 (20ms), after which the results of both frames are available ---
+    g_mock_results_available = true;
+    gpu_time.OnCmdInsertDebugUtilsLabelEXT(MOCK_COMMAND_BUFFER_2, &label);
+    ASSERT_NO_FATAL_FAILURE(RecordCommandBuffer(gpu_time, MOCK_COMMAND_BUFFER_2));
+    submit_info.pCommandBuffers = &MOCK_COMMAND_BUFFER_2;
+    ASSERT_TRUE(gpu_time
+                    .OnQueueSubmit(1, &submit_info, MockDeviceWaitIdle, MockResetQueryPool,
+                                   MockGetQueryPoolResults)
+                    .gpu_time_status.success);
+
+    GPUTime::Stats expected_stats;
+    expected_stats.average = 15.0;
+    expected_stats.median = 15.0;
+    expected_stats.min = 10.0;
+    expected_stats.max = 20.0;
+    expected_stats.stddev = std::sqrt(50.0);
+    EXPECT_THAT(gpu_time.GetFrameTimeStats(), StatsEq(expected_stats));
+    EXPECT_EQ(g_mock_device_wait_idle_count, 0u);
+
+    ASSERT_NO_FATAL_FAILURE(DestroyGPUTime(gpu_time));
+}
+
+// Test that submitting a command buffer again in a later frame without recording it again resets
+// its queries before they are written, after reading back the frame they were written in.
+TEST(GPUTimeTest, ResubmittedCommandBufferQueriesAreResetBeforeSubmit)
+{
+    GPUTime gpu_time;
+    gpu_time.SetEnable(true);
+    ASSERT_NO_FATAL_FAILURE(CreateGPUTime(gpu_time, kMockTimestampPeriod));
+
+    VkCommandBufferAllocateInfo alloc_info = {};
+    alloc_info.commandPool = MOCK_COMMAND_POOL;
+    alloc_info.commandBufferCount = 1;
+    VkCommandBuffer cmd = MOCK_COMMAND_BUFFER_1;
+    ASSERT_TRUE(gpu_time.OnAllocateCommandBuffers(&alloc_info, &cmd).success);
+
+    VkDebugUtilsLabelEXT label = {};
+    label.pLabelName = GPUTime::kVulkanVrFrameDelimiterString;
+    ASSERT_TRUE(gpu_time.OnCmdInsertDebugUtilsLabelEXT(cmd, &label).success);
+    ASSERT_NO_FATAL_FAILURE(RecordCommandBuffer(gpu_time, cmd));
+
+    // The results of the first frame are not available at its frame boundary, so they are still
+    // pending when the command buffer is submitted again
+    g_mock_results_available = false;
+    VkSubmitInfo submit_info = {};
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &cmd;
+    constexpr uint32_t kFrameCount = 3;
+    for (uint32_t i = 0; i < kFrameCount; ++i)
+    {
+        ASSERT_NO_FATAL_FAILURE(SubmitCommandBuffers(gpu_time, submit_info));
+        EXPECT_EQ(g_mock_device_wait_idle_count, i);
+        g_mock_results_available = true;
+    }
+
+    GPUTime::Stats expected_stats;
+    expected_stats.average = 10.0;
+    expected_stats.median = 10.0;
+    expected_stats.min = 10.0;
+    expected_stats.max = 10.0;
+    expected_stats.stddev = 0.0;
+    EXPECT_THAT(gpu_time.GetFrameTimeStats(), StatsEq(expected_stats));
+
+    ASSERT_NO_FATAL_FAILURE(DestroyGPUTime(gpu_time));
+}
+
+// Test that command buffers recorded again every frame write to freshly reset queries without
+// waiting for the device, including after having been submitted again without being recorded.
+TEST(GPUTimeTest, RecordedCommandBufferDoesNotWaitForDeviceIdle)
+{
+    GPUTime gpu_time;
+    gpu_time.SetEnable(true);
+    ASSERT_NO_FATAL_FAILURE(CreateGPUTime(gpu_time, kMockTimestampPeriod));
+
+    VkCommandBufferAllocateInfo alloc_info = {};
+    alloc_info.commandPool = MOCK_COMMAND_POOL;
+    alloc_info.commandBufferCount = 1;
+    VkCommandBuffer cmd = MOCK_COMMAND_BUFFER_1;
+    ASSERT_TRUE(gpu_time.OnAllocateCommandBuffers(&alloc_info, &cmd).success);
+
+    VkDebugUtilsLabelEXT label = {};
+    label.pLabelName = GPUTime::kVulkanVrFrameDelimiterString;
+    ASSERT_TRUE(gpu_time.OnCmdInsertDebugUtilsLabelEXT(cmd, &label).success);
+    ASSERT_NO_FATAL_FAILURE(RecordCommandBuffer(gpu_time, cmd));
+
+    VkSubmitInfo submit_info = {};
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &cmd;
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        ASSERT_NO_FATAL_FAILURE(SubmitCommandBuffers(gpu_time, submit_info));
+    }
+    EXPECT_EQ(g_mock_device_wait_idle_count, 1u);
+
+    // More frames than query pools, so that every pool of the ring is reused
+    constexpr uint32_t kFrameCount = 6;
+    for (uint32_t i = 0; i < kFrameCount; ++i)
+    {
+        ASSERT_NO_FATAL_FAILURE(RecordCommandBuffer(gpu_time, cmd));
+        ASSERT_NO_FATAL_FAILURE(SubmitCommandBuffers(gpu_time, submit_info));
+    }
+    EXPECT_EQ(g_mock_device_wait_idle_count, 1u);
+
+    ASSERT_NO_FATAL_FAILURE(DestroyGPUTime(gpu_time));
+}
+
 TEST(GPUTimeTest, BeginCommandBufferForUnknownCmdDoesNotCrash)
 {
     GPUTime gpu_time;
@@ -460,6 +651,11 @@ TEST(GPUTimeTest, UpdateFrameMetricsExceedMaxQuerySlotsDoesNotCrash)
         }
     }
 
+    for (VkCommandBuffer cmd : cmds)
+    {
+        ASSERT_NO_FATAL_FAILURE(RecordCommandBuffer(gpu_time, cmd));
+    }
+
     // Some should have failed allocation.
     ASSERT_LT(cmds.size(), kCommandBufferCount);
     ASSERT_NE(failed_cmd, VK_NULL_HANDLE);
@@ -480,7 +676,7 @@ TEST(GPUTimeTest, UpdateFrameMetricsExceedMaxQuerySlotsDoesNotCrash)
     submit_info.commandBufferCount = static_cast<uint32_t>(submit_cmds.size());
     submit_info.pCommandBuffers = submit_cmds.data();
 
-    // This calls UpdateFrameMetrics. It should not crash.
+    // This reads back the timestamps of the frame. It should not crash.
     gpu_time.OnQueueSubmit(1, &submit_info, MockDeviceWaitIdle, MockResetQueryPool,
                            MockGetQueryPoolResults);
 
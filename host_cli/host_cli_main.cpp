@@ -17,6 +17,8 @@
 // TODO: Eventually the .dive file support and the raw data support in `cli/` will be migrated here
 // and the old cli will be deprecated
 
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <string>
 
@@ -156,12 +158,25 @@ int main(int argc, char** argv)
             return 0;
         }
 
-        if (absl::Status res = data_core.WriteNewGfxrFile(absl::GetFlag(FLAGS_output_gfxr_path));
-            !res.ok())
+        std::string output_gfxr_path = absl::GetFlag(FLAGS_output_gfxr_path);
+        auto write_start = std::chrono::steady_clock::now();
+        if (absl::Status res = data_core.WriteNewGfxrFile(output_gfxr_path); !res.ok())
         {
             std::cout << res << std::endl;
             return 1;
         }
+        std::chrono::duration<double> write_time = std::chrono::steady_clock::now() - write_start;
+
+        std::error_code ec;
+        uintmax_t output_size = std::filesystem::file_size(output_gfxr_path, ec);
+        if (!ec)
+        {
+            double megabytes = static_cast<double>(output_size) / (1024.0 * 1024.0);
+            std::cout << absl::StrFormat("Wrote %s: %.2f MB in %.3f s (%.1f MB/s)",
+                                         output_gfxr_path, megabytes, write_time.count(),
+                                         megabytes / std::max(write_time.count(), 1e-9))
+                      << std::endl;
+        }
         return 0;
     }
 
@@ -0,0 +1,222 @@
+/*
+Copyright 2026 Google Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace DiveLayer
+{
+
+// Maps the loader dispatch pointer of a dispatchable handle (see DataKey) to the layer data of its
+// instance or device. Every intercepted call looks its data up, from any thread, while entries are
+// only added and removed when an instance or device is created or destroyed. So lookups go through
+// an open addressing table without taking a lock, and only the rare changes are serialized.
+//
+// The table doubles in size once half of it holds entries. The previous tables are kept until the
+// map is destroyed, since a lookup on another thread may still be probing them, so the memory used
+// stays below twice the size of the current table.
+//
+// Erasing an entry frees its data, since Vulkan does not allow an instance or device to be used
+// while it is destroyed. Data replaced by a later insertion with the same key (the loader may reuse
+// the dispatch table of a device whose destruction was not seen) is kept alive instead, since a
+// call on another thread may still be using it.
+template <typename T, size_t kInitialCapacity = 16>
+class DispatchKeyMap
+{
+    static_assert((kInitialCapacity & (kInitialCapacity - 1)) == 0,
+                  "kInitialCapacity must be a power of 2");
+
+ public:
+    DispatchKeyMap()
+    {
+        m_tables.push_back(std::make_unique<Table>(kInitialCapacity));
+        m_table.store(m_tables.back().get(), std::memory_order_release);
+    }
+
+    // Returns nullptr if there is no data for the key
+    T* Find(uintptr_t key) const
+    {
+        const Table& table = *m_table.load(std::memory_order_acquire);
+        size_t index = table.Hash(key);
+        for (size_t probe = 0; probe < table.capacity; ++probe)
+        {
+            const Slot& slot = table.slots[index];
+            uintptr_t slot_key = slot.key.load(std::memory_order_acquire);
+            if (slot_key == key)
+            {
+                return slot.value.load(std::memory_order_acquire);
+            }
+            if (slot_key == kEmptyKey)
+            {
+                return nullptr;
+            }
+            index = (index + 1) & (table.capacity - 1);
+        }
+        return nullptr;
+    }
+
+    // Takes ownership of the data, and returns a pointer to it
+    T* Insert(uintptr_t key, std::unique_ptr<T> data)
+    {
+        T* value = data.get();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_owned.push_back(std::move(data));
+
+        if (Slot* slot = FindSlot(*m_table.load(std::memory_order_relaxed), key))
+        {
+            slot->value.store(value, std::memory_order_release);
+            return value;
+        }
+
+        if ((m_num_entries + 1) * 2 > m_table.load(std::memory_order_relaxed)->capacity)
+        {
+            Grow();
+        }
+        // Erased slots are reused, since lookups of other keys probe past them either way
+        Table& table = *m_table.load(std::memory_order_relaxed);
+        size_t index = table.Hash(key);
+        for (uintptr_t slot_key = table.slots[index].key.load(std::memory_order_relaxed);
+             slot_key != kEmptyKey && slot_key != kErasedKey;
+             slot_key = table.slots[index].key.load(std::memory_order_relaxed))
+        {
+            index = (index + 1) & (table.capacity - 1);
+        }
+        // The value is published before the key, so that a lookup finding the key also finds its
+        // value
+        table.slots[index].value.store(value, std::memory_order_relaxed);
+        table.slots[index].key.store(key, std::memory_order_release);
+        ++m_num_entries;
+        return value;
+    }
+
+    // Removes the entry of the key, if any, and frees its data
+    void Erase(uintptr_t key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Slot* slot = FindSlot(*m_table.load(std::memory_order_relaxed), key);
+        if (slot == nullptr)
+        {
+            return;
+        }
+        T* value = slot->value.load(std::memory_order_relaxed);
+        // Lookups of other keys keep probing past the slot
+        slot->key.store(kErasedKey, std::memory_order_release);
+        slot->value.store(nullptr, std::memory_order_relaxed);
+        --m_num_entries;
+
+        m_owned.erase(std::remove_if(m_owned.begin(), m_owned.end(),
+                                     [value](const std::unique_ptr<T>& owned) {
+                                         return owned.get() == value;
+                                     }),
+                      m_owned.end());
+    }
+
+ private:
+    static constexpr uintptr_t kEmptyKey = 0;
+    // Dispatch tables are pointer aligned, so this is never a key
+    static constexpr uintptr_t kErasedKey = 1;
+
+    struct Slot
+    {
+        std::atomic<uintptr_t> key = kEmptyKey;
+        std::atomic<T*> value = nullptr;
+    };
+
+    struct Table
+    {
+        explicit Table(size_t table_capacity)
+            : capacity(table_capacity), slots(std::make_unique<Slot[]>(table_capacity))
+        {
+        }
+
+        size_t Hash(uintptr_t key) const
+        {
+            // The keys are pointers to heap allocated tables, so the low bits carry little entropy
+            constexpr uint64_t kMultiplier = 0x9E3779B97F4A7C15ull;
+            return static_cast<size_t>((static_cast<uint64_t>(key) * kMultiplier) >> 32) &
+                   (capacity - 1);
+        }
+
+        size_t capacity;
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    // Must be called with m_mutex held
+    Slot* FindSlot(Table& table, uintptr_t key)
+    {
+        size_t index = table.Hash(key);
+        for (size_t probe = 0; probe < table.capacity; ++probe)
+        {
+            Slot& slot = table.slots[index];
+            uintptr_t slot_key = slot.key.load(std::memory_order_relaxed);
+            if (slot_key == key)
+            {
+                return &slot;
+            }
+            if (slot_key == kEmptyKey)
+            {
+                return nullptr;
+            }
+            index = (index + 1) & (table.capacity - 1);
+        }
+        return nullptr;
+    }
+
+    // Copies the entries to a table twice as large, dropping the erased slots. Must be called with
+    // m_mutex held
+    void Grow()
+    {
+        const Table& table = *m_table.load(std::memory_order_relaxed);
+        auto new_table = std::make_unique<Table>(table.capacity * 2);
+        for (size_t i = 0; i < table.capacity; ++i)
+        {
+            uintptr_t key = table.slots[i].key.load(std::memory_order_relaxed);
+            if (key == kEmptyKey || key == kErasedKey)
+            {
+                continue;
+            }
+            size_t index = new_table->Hash(key);
+            while (new_table->slots[index].key.load(std::memory_order_relaxed) != kEmptyKey)
+            {
+                index = (index + 1) & (new_table->capacity - 1);
+            }
+            new_table->slots[index].value.store(
+                table.slots[i].value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            new_table->slots[index].key.store(key, std::memory_order_relaxed);
+        }
+
+        // The whole table is published at once, so lookups see all of its entries
+        m_table.store(new_table.get(), std::memory_order_release);
+        m_tables.push_back(std::move(new_table));
+    }
+
+    std::atomic<Table*> m_table = nullptr;
+
+    std::mutex m_mutex;
+    // The current table and all the previous ones
+    std::vector<std::unique_ptr<Table>> m_tables;
+    std::vector<std::unique_ptr<T>> m_owned;
+    size_t m_num_entries = 0;
+};
+
+}  // namespace DiveLayer
@@ -0,0 +1,173 @@
+/*
+Copyright 2026 Google Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "dispatch_key_map.h"
+#include "layer_common.h"
+
+namespace DiveLayer
+{
+namespace
+{
+
+// Measures the overhead a layer intercept adds to a vkCmdDraw: looking up the device data from the
+// loader dispatch pointer of the command buffer, and calling down the chain through its dispatch
+// table. The command buffers of several devices are drawn to in turn, as in a multi-threaded
+// application with several devices or command buffers.
+
+constexpr int kMaxDevices = 16;
+
+using PFN_CmdDraw = void (*)(void* command_buffer, uint32_t vertex_count);
+
+void NextCmdDraw(void* command_buffer, uint32_t vertex_count)
+{
+    benchmark::DoNotOptimize(command_buffer);
+    benchmark::DoNotOptimize(vertex_count);
+}
+
+struct DeviceData
+{
+    PFN_CmdDraw cmd_draw = NextCmdDraw;
+};
+
+// A dispatchable handle starts with the loader dispatch pointer, which is shared by all the
+// handles of a device
+struct LoaderDispatch
+{
+    void* table[8] = {};
+};
+
+struct FakeCommandBuffer
+{
+    LoaderDispatch* loader_dispatch = nullptr;
+};
+
+struct FakeDevices
+{
+    FakeDevices()
+    {
+        for (int i = 0; i < kMaxDevices; ++i)
+        {
+            dispatches.push_back(std::make_unique<LoaderDispatch>());
+            command_buffers.push_back(
+                std::make_unique<FakeCommandBuffer>(FakeCommandBuffer{dispatches.back().get()}));
+        }
+    }
+
+    std::vector<std::unique_ptr<LoaderDispatch>> dispatches;
+    std::vector<std::unique_ptr<FakeCommandBuffer>> command_buffers;
+};
+
+const FakeDevices& GetFakeDevices()
+{
+    static FakeDevices devices;
+    return devices;
+}
+
+// The lookup the layers used before DispatchKeyMap
+namespace locked
+{
+thread_local DeviceData* last_used_device_data = nullptr;
+thread_local uintptr_t last_used_key = 0;
+std::mutex g_device_mutex;
+std::unordered_map<uintptr_t, std::unique_ptr<DeviceData>> g_device_data;
+
+DeviceData* GetDeviceLayerData(uintptr_t key)
+{
+    if (last_used_device_data && last_used_key == key)
+    {
+        return last_used_device_data;
+    }
+
+    std::lock_guard<std::mutex> lock(g_device_mutex);
+    last_used_device_data = g_device_data[key].get();
+    last_used_key = key;
+    return last_used_device_data;
+}
+
+void Register(uintptr_t key)
+{
+    std::lock_guard<std::mutex> lock(g_device_mutex);
+    if (!g_device_data[key])
+    {
+        g_device_data[key] = std::make_unique<DeviceData>();
+    }
+}
+}  // namespace locked
+
+DispatchKeyMap<DeviceData> g_device_data;
+
+void RegisterDevices()
+{
+    static std::once_flag once;
+    std::call_once(once, [] {
+        for (const auto& command_buffer : GetFakeDevices().command_buffers)
+        {
+            uintptr_t key = DataKey(command_buffer.get());
+            locked::Register(key);
+            g_device_data.Insert(key, std::make_unique<DeviceData>());
+        }
+    });
+}
+
+template <DeviceData* (*GetDeviceLayerData)(uintptr_t)>
+void BM_InterceptCmdDraw(benchmark::State& state)
+{
+    RegisterDevices();
+    const int num_devices = static_cast<int>(state.range(0));
+    const auto& command_buffers = GetFakeDevices().command_buffers;
+
+    // Each thread starts on a different device so that the threads don't all agree on the last one
+    int device = state.thread_index() % num_devices;
+    for (auto _ : state)
+    {
+        void* command_buffer = command_buffers[device].get();
+        DeviceData* layer_data = GetDeviceLayerData(DataKey(command_buffer));
+        layer_data->cmd_draw(command_buffer, 3);
+        device = (device + 1 == num_devices) ? 0 : device + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+DeviceData* FindInDispatchKeyMap(uintptr_t key) { return g_device_data.Find(key); }
+
+BENCHMARK(BM_InterceptCmdDraw<locked::GetDeviceLayerData>)
+    ->Name("BM_InterceptCmdDraw/MutexAndMap")
+    ->ArgName("devices")
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(kMaxDevices)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+BENCHMARK(BM_InterceptCmdDraw<FindInDispatchKeyMap>)
+    ->Name("BM_InterceptCmdDraw/DispatchKeyMap")
+    ->ArgName("devices")
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(kMaxDevices)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace DiveLayer
@@ -27,6 +27,7 @@ void InitInstanceDispatchTable(VkInstance instance, PFN_vkGetInstanceProcAddr pa
     LOGI("InitInstanceDispatchTable");
 
     dt->pfn_get_instance_proc_addr = pa;
+    dt->DestroyInstance = (PFN_vkDestroyInstance)pa(instance, "vkDestroyInstance");
     dt->CreateDevice = (PFN_vkCreateDevice)pa(instance, "vkCreateDevice");
     dt->EnumerateDeviceLayerProperties =
         (PFN_vkEnumerateDeviceLayerProperties)pa(instance, "vkEnumerateDeviceLayerProperties");
@@ -40,6 +41,7 @@ void InitDeviceDispatchTable(VkDevice device, PFN_vkGetDeviceProcAddr pa, Device
     LOGI("InitDeviceDispatchTable");
     dt->pfn_get_device_proc_addr = pa;
     dt->QueuePresentKHR = (PFN_vkQueuePresentKHR)pa(device, "vkQueuePresentKHR");
+    dt->DestroyDevice = (PFN_vkDestroyDevice)pa(device, "vkDestroyDevice");
 }
 
 }  // namespace DiveLayer
\ No newline at end of file
@@ -22,13 +22,12 @@ limitations under the License.
 #include <cstdio>
 #include <cstring>
 #include <memory>
-#include <mutex>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
 #include "capture_service/server.h"
 #include "common/log.h"
+#include "dispatch_key_map.h"
 #include "layer_common.h"
 #include "vk_dispatch.h"
 #include "vk_layer_impl.h"
@@ -52,16 +51,8 @@ struct DeviceData
 
 namespace
 {
-// Generally we expect to get the same device and instance, so we keep them
-// handy
-static thread_local InstanceData* last_used_instance_data = nullptr;
-static thread_local DeviceData* last_used_device_data = nullptr;
-
-std::mutex g_instance_mutex;
-std::unordered_map<uintptr_t, std::unique_ptr<InstanceData>> g_instance_data;
-
-std::mutex g_device_mutex;
-std::unordered_map<uintptr_t, std::unique_ptr<DeviceData>> g_device_data;
+DispatchKeyMap<InstanceData> g_instance_data;
+DispatchKeyMap<DeviceData> g_device_data;
 
 constexpr VkLayerProperties layer_properties = {
     "VK_LAYER_Dive", VK_MAKE_VERSION(1, 0, VK_HEADER_VERSION), 1, "Dive capture layer for xr."};
@@ -77,29 +68,9 @@ static constexpr std::array<VkExtensionProperties, 1> device_extensions{{
 
 }  // namespace
 
-InstanceData* GetInstanceLayerData(uintptr_t key)
-{
-    if (last_used_instance_data && DataKey(last_used_instance_data->instance) == key)
-    {
-        return last_used_instance_data;
-    }
-
-    std::lock_guard<std::mutex> lock(g_instance_mutex);
-    last_used_instance_data = g_instance_data[key].get();
-    return last_used_instance_data;
-}
-
-DeviceData* GetDeviceLayerData(uintptr_t key)
-{
-    if (last_used_device_data && DataKey(last_used_device_data->device) == key)
-    {
-        return last_used_device_data;
-    }
+InstanceData* GetInstanceLayerData(uintptr_t key) { return g_instance_data.Find(key); }
 
-    std::lock_guard<std::mutex> lock(g_device_mutex);
-    last_used_device_data = g_device_data[key].get();
-    return last_used_device_data;
-}
+DeviceData* GetDeviceLayerData(uintptr_t key) { return g_device_data.Find(key); }
 
 struct VkStruct
 {
@@ -191,16 +162,21 @@ VkResult DiveInterceptCreateInstance(const VkInstanceCreateInfo* pCreateInfo,
     id->instance = *pInstance;
     InitInstanceDispatchTable(*pInstance, pfn_get_instance_proc_addr, &id->dispatch_table);
 
-    {
-        std::lock_guard<std::mutex> lock(g_instance_mutex);
-        auto key = (uintptr_t)(*(void**)(*pInstance));
-        g_instance_data[key] = std::move(id);
-    }
+    g_instance_data.Insert(DataKey(*pInstance), std::move(id));
     SetLayerStatusLoaded();
 
     return result;
 }
 
+void DiveInterceptDestroyInstance(VkInstance instance, const VkAllocationCallbacks* pAllocator)
+{
+    // The key is read from the instance, so it must be taken before the instance is destroyed
+    uintptr_t key = DataKey(instance);
+    auto instance_data = GetInstanceLayerData(key);
+    instance_data->dispatch_table.DestroyInstance(instance, pAllocator);
+    g_instance_data.Erase(key);
+}
+
 VkResult DiveInterceptCreateDevice(VkPhysicalDevice gpu, const VkDeviceCreateInfo* pCreateInfo,
                                    const VkAllocationCallbacks* pAllocator, VkDevice* pDevice)
 {
@@ -232,15 +208,20 @@ VkResult DiveInterceptCreateDevice(VkPhysicalDevice gpu, const VkDeviceCreateInf
     dd->device = *pDevice;
     InitDeviceDispatchTable(*pDevice, pfn_next_device_proc_addr, &dd->dispatch_table);
 
-    {
-        std::lock_guard<std::mutex> lock(g_device_mutex);
-        auto key = (uintptr_t)(*(void**)(*pDevice));
-        g_device_data[key] = std::move(dd);
-    }
+    g_device_data.Insert(DataKey(*pDevice), std::move(dd));
 
     return result;
 }
 
+void DiveInterceptDestroyDevice(VkDevice device, const VkAllocationCallbacks* pAllocator)
+{
+    // The key is read from the device, so it must be taken before the device is destroyed
+    uintptr_t key = DataKey(device);
+    auto layer_data = GetDeviceLayerData(key);
+    layer_data->dispatch_table.DestroyDevice(device, pAllocator);
+    g_device_data.Erase(key);
+}
+
 extern "C"
 {
     VKAPI_ATTR VkResult VKAPI_CALL DiveInterceptEnumerateInstanceLayerProperties(
@@ -468,6 +449,8 @@ extern "C"
         if (!strcmp(func, "vkGetDeviceProcAddr"))
             return (PFN_vkVoidFunction)&VK_LAYER_DiveGetDeviceProcAddr;
         if (!strcmp(func, "vkCreateDevice")) return (PFN_vkVoidFunction)&DiveInterceptCreateDevice;
+        if (0 == strcmp(func, "vkDestroyDevice"))
+            return (PFN_vkVoidFunction)&DiveInterceptDestroyDevice;
         if (0 == strcmp(func, "vkQueuePresentKHR"))
             return (PFN_vkVoidFunction)DiveInterceptQueuePresentKHR;
         auto layer_data = GetDeviceLayerData(DataKey(dev));
@@ -487,6 +470,9 @@ extern "C"
             return (PFN_vkVoidFunction)&DiveInterceptCreateInstance;
         if (inst == VK_NULL_HANDLE) return NULL;
 
+        if (0 == strcmp(func, "vkDestroyInstance"))
+            return (PFN_vkVoidFunction)&DiveInterceptDestroyInstance;
+
         if (0 == strcmp(func, "vkEnumerateDeviceLayerProperties"))
             return (PFN_vkVoidFunction)DiveInterceptEnumerateDeviceLayerProperties;
         if (0 == strcmp(func, "vkEnumerateDeviceExtensionProperties"))
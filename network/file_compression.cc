@@ -0,0 +1,135 @@
+/*
+Copyright 2026 Google Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "file_compression.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "absl/strings/str_cat.h"
+#include "dive/common/status.h"
+
+#if defined(DIVE_NETWORK_HAS_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace Network
+{
+
+namespace
+{
+
+#if defined(DIVE_NETWORK_HAS_ZLIB)
+// Captures are compressed on the device while they are sent, so the fastest level is used: the
+// ratio of higher levels is not worth the time on a phone CPU.
+constexpr int kZlibLevel = Z_BEST_SPEED;
+#endif
+
+}  // namespace
+
+bool IsFileCompressionSupported(FileCompression compression)
+{
+    switch (compression)
+    {
+        case FileCompression::NONE:
+            return true;
+        case FileCompression::ZLIB:
+#if defined(DIVE_NETWORK_HAS_ZLIB)
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+absl::Status CompressChunk(FileCompression compression, const uint8_t* src, size_t src_size,
+                           std::vector<uint8_t>& dest)
+{
+    switch (compression)
+    {
+        case FileCompression::NONE:
+            dest.assign(src, src + src_size);
+            return Dive::OkStatus();
+        case FileCompression::ZLIB:
+        {
+#if defined(DIVE_NETWORK_HAS_ZLIB)
+            if (src_size > std::numeric_limits<uLong>::max())
+            {
+                return Dive::InvalidArgumentError("CompressChunk: Chunk is too large.");
+            }
+            uLongf dest_size = compressBound(static_cast<uLong>(src_size));
+            dest.resize(dest_size);
+            int ret = compress2(dest.data(), &dest_size, src, static_cast<uLong>(src_size),
+                                kZlibLevel);
+            if (ret != Z_OK)
+            {
+                return Dive::InternalError(
+                    absl::StrCat("CompressChunk: compress2() failed: ", ret));
+            }
+            dest.resize(dest_size);
+            return Dive::OkStatus();
+#else
+            break;
+#endif
+        }
+    }
+    return Dive::UnimplementedError(absl::StrCat("CompressChunk: Unsupported compression ",
+                                                 static_cast<uint32_t>(compression)));
+}
+
+absl::Status DecompressChunk(FileCompression compression, const uint8_t* src, size_t src_size,
+                             uint8_t* dest, size_t dest_size)
+{
+    switch (compression)
+    {
+        case FileCompression::NONE:
+            if (src_size != dest_size)
+            {
+                return Dive::DataLossError("DecompressChunk: Chunk has an unexpected size.");
+            }
+            std::copy(src, src + src_size, dest);
+            return Dive::OkStatus();
+        case FileCompression::ZLIB:
+        {
+#if defined(DIVE_NETWORK_HAS_ZLIB)
+            if (src_size > std::numeric_limits<uLong>::max() ||
+                dest_size > std::numeric_limits<uLong>::max())
+            {
+                return Dive::InvalidArgumentError("DecompressChunk: Chunk is too large.");
+            }
+            uLongf uncompressed_size = static_cast<uLongf>(dest_size);
+            int ret = uncompress(dest, &uncompressed_size, src, static_cast<uLong>(src_size));
+            if (ret != Z_OK)
+            {
+                return Dive::DataLossError(
+                    absl::StrCat("DecompressChunk: uncompress() failed: ", ret));
+            }
+            if (uncompressed_size != dest_size)
+            {
+                return Dive::DataLossError("DecompressChunk: Chunk has an unexpected size.");
+            }
+            return Dive::OkStatus();
+#else
+            break;
+#endif
+        }
+    }
+    return Dive::UnimplementedError(absl::StrCat("DecompressChunk: Unsupported compression ",
+                                                 static_cast<uint32_t>(compression)));
+}
+
+}  // namespace Network
@@ -0,0 +1,48 @@
+/*
+Copyright 2026 Google Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/status/status.h"
+
+namespace Network
+{
+
+// How SocketConnection encodes the bytes of a file it sends. It is agreed on for a connection
+// during the handshake.
+enum class FileCompression : uint32_t
+{
+    NONE = 0,
+    // The file is sent as a sequence of chunks, each deflated independently.
+    ZLIB = 1,
+};
+
+// Returns whether this build can compress and decompress files with the given compression.
+bool IsFileCompressionSupported(FileCompression compression);
+
+// Compresses the src_size bytes at src, replacing the contents of dest.
+absl::Status CompressChunk(FileCompression compression, const uint8_t* src, size_t src_size,
+                           std::vector<uint8_t>& dest);
+
+// Decompresses the src_size bytes at src, which must expand to exactly dest_size bytes.
+absl::Status DecompressChunk(FileCompression compression, const uint8_t* src, size_t src_size,
+                             uint8_t* dest, size_t dest_size);
+
+}  // namespace Network
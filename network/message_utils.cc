@@ -16,8 +16,10 @@ limitations under the License.
 
 #include "message_utils.h"
 
+#include <chrono>
 #include <filesystem>
 
+#include "dive/common/macros.h"
 #include "dive/common/status.h"
 
 namespace Network
@@ -34,7 +36,16 @@ absl::Status Handshake(Network::HandshakeRequest* request, Network::SocketConnec
     Network::HandshakeResponse response;
     response.SetMajorVersion(request->GetMajorVersion());
     response.SetMinorVersion(request->GetMinorVersion());
-    return Network::SendSocketMessage(client_conn, response);
+    // Files are sent uncompressed to a client asking for a compression this build lacks
+    Network::FileCompression compression = request->GetFileCompression();
+    if (!Network::IsFileCompressionSupported(compression))
+    {
+        compression = Network::FileCompression::NONE;
+    }
+    response.SetFileCompression(compression);
+    RETURN_IF_ERROR(Network::SendSocketMessage(client_conn, response));
+    client_conn->SetFileCompression(compression);
+    return Dive::OkStatus();
 }
 
 absl::Status DownloadFile(Network::DownloadFileRequest* request,
@@ -46,11 +57,29 @@ absl::Status DownloadFile(Network::DownloadFileRequest* request,
 
     if (std::filesystem::is_regular_file(file_path, ec))
     {
-        if (auto file_size = std::filesystem::file_size(file_path, ec); !ec)
+        uint64_t file_size = std::filesystem::file_size(file_path, ec);
+        std::filesystem::file_time_type modification_time;
+        if (!ec)
+        {
+            modification_time = std::filesystem::last_write_time(file_path, ec);
+        }
+        if (!ec)
         {
+            uint64_t modification_time_ns = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    modification_time.time_since_epoch())
+                    .count());
             response.SetFound(true);
             response.SetFilePath(file_path);
             response.SetFileSize(file_size);
+            response.SetModificationTime(modification_time_ns);
+            // A resumed download starts over if the partial data is from another version of the
+            // file, such as an earlier capture saved to the same path
+            bool same_file = request->GetFileSize() == file_size &&
+                             request->GetModificationTime() == modification_time_ns;
+            response.SetOffset((same_file && request->GetOffset() <= file_size)
+                                   ? request->GetOffset()
+                                   : 0);
         }
         else
         {
@@ -74,7 +103,7 @@ absl::Status DownloadFile(Network::DownloadFileRequest* request,
         return Dive::NotFoundError(response.GetErrorReason());
     }
 
-    return client_conn->SendFile(file_path);
+    return client_conn->SendFile(file_path, response.GetOffset());
 }
 
 absl::Status GetFileSize(Network::FileSizeRequest* request, Network::SocketConnection* client_conn)
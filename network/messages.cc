@@ -95,6 +95,7 @@ absl::Status HandshakeMessage::Serialize(Buffer& dest) const
     dest.clear();
     WriteUint32ToBuffer(m_major_version, dest);
     WriteUint32ToBuffer(m_minor_version, dest);
+    WriteUint32ToBuffer(static_cast<uint32_t>(m_file_compression), dest);
     return Dive::OkStatus();
 }
 
@@ -103,6 +104,9 @@ absl::Status HandshakeMessage::Deserialize(const Buffer& src)
     size_t offset = 0;
     ASSIGN_OR_RETURN(m_major_version, ReadUint32FromBuffer(src, offset));
     ASSIGN_OR_RETURN(m_minor_version, ReadUint32FromBuffer(src, offset));
+    uint32_t file_compression = 0;
+    ASSIGN_OR_RETURN(file_compression, ReadUint32FromBuffer(src, offset));
+    m_file_compression = static_cast<FileCompression>(file_compression);
     if (offset != src.size())
     {
         return Dive::InvalidArgumentError("Handshake message has unexpected trailing data.");
@@ -149,6 +153,33 @@ absl::Status RemoveFileResponse::Deserialize(const Buffer& src)
     return Dive::OkStatus();
 }
 
+absl::Status DownloadFileRequest::Serialize(Buffer& dest) const
+{
+    dest.clear();
+    WriteStringToBuffer(GetString(), dest);
+    WriteUint64ToBuffer(m_offset, dest);
+    WriteUint64ToBuffer(m_file_size, dest);
+    WriteUint64ToBuffer(m_modification_time, dest);
+
+    return Dive::OkStatus();
+}
+
+absl::Status DownloadFileRequest::Deserialize(const Buffer& src)
+{
+    size_t offset = 0;
+    std::string file_path;
+    ASSIGN_OR_RETURN(file_path, ReadStringFromBuffer(src, offset));
+    SetString(std::move(file_path));
+    ASSIGN_OR_RETURN(m_offset, ReadUint64FromBuffer(src, offset));
+    ASSIGN_OR_RETURN(m_file_size, ReadUint64FromBuffer(src, offset));
+    ASSIGN_OR_RETURN(m_modification_time, ReadUint64FromBuffer(src, offset));
+    if (offset != src.size())
+    {
+        return Dive::InvalidArgumentError("DownloadFileRequest has unexpected trailing data.");
+    }
+    return Dive::OkStatus();
+}
+
 absl::Status DownloadFileResponse::Serialize(Buffer& dest) const
 {
     dest.clear();
@@ -156,6 +187,8 @@ absl::Status DownloadFileResponse::Serialize(Buffer& dest) const
     WriteStringToBuffer(m_error_reason, dest);
     WriteStringToBuffer(m_file_path, dest);
     WriteUint64ToBuffer(m_file_size, dest);
+    WriteUint64ToBuffer(m_offset, dest);
+    WriteUint64ToBuffer(m_modification_time, dest);
 
     return Dive::OkStatus();
 }
@@ -167,6 +200,8 @@ absl::Status DownloadFileResponse::Deserialize(const Buffer& src)
     ASSIGN_OR_RETURN(m_error_reason, ReadStringFromBuffer(src, offset));
     ASSIGN_OR_RETURN(m_file_path, ReadStringFromBuffer(src, offset));
     ASSIGN_OR_RETURN(m_file_size, ReadUint64FromBuffer(src, offset));
+    ASSIGN_OR_RETURN(m_offset, ReadUint64FromBuffer(src, offset));
+    ASSIGN_OR_RETURN(m_modification_time, ReadUint64FromBuffer(src, offset));
     if (offset != src.size())
     {
         return Dive::InvalidArgumentError("Message has unexpected trailing data.");
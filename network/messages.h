@@ -83,9 +83,16 @@ class HandshakeMessage : public ISerializable
     void SetMajorVersion(uint32_t major) { m_major_version = major; }
     void SetMinorVersion(uint32_t minor) { m_minor_version = minor; }
 
+    FileCompression GetFileCompression() const { return m_file_compression; }
+    void SetFileCompression(FileCompression compression) { m_file_compression = compression; }
+
  private:
     uint32_t m_major_version{};
     uint32_t m_minor_version{};
+    // In a request, the compression the client asks to download files with. In a response, the
+    // compression the server sends files with, which is NONE if it does not support the requested
+    // one.
+    FileCompression m_file_compression = FileCompression::NONE;
 };
 
 class EmptyMessage : public ISerializable
@@ -171,11 +178,31 @@ class PongMessage : public EmptyMessage
     MessageType GetMessageType() const override { return MessageType::PONG_MESSAGE; }
 };
 
-// DownloadFileRequest uses the string message as the file path to download.
+// DownloadFileRequest uses the string message as the file path to download, followed by the offset
+// to start downloading from, so that an interrupted download can be resumed. The download only
+// resumes if the file still has the size and modification time it had when the partial data was
+// downloaded, which the client sends along with the offset.
 class DownloadFileRequest : public StringMessage
 {
  public:
     MessageType GetMessageType() const override { return MessageType::DOWNLOAD_FILE_REQUEST; }
+    absl::Status Serialize(Buffer& dest) const override;
+    absl::Status Deserialize(const Buffer& src) override;
+
+    uint64_t GetOffset() const { return m_offset; }
+    void SetOffset(uint64_t offset) { m_offset = offset; }
+
+    uint64_t GetFileSize() const { return m_file_size; }
+    void SetFileSize(uint64_t file_size) { m_file_size = file_size; }
+
+    uint64_t GetModificationTime() const { return m_modification_time; }
+    void SetModificationTime(uint64_t time) { m_modification_time = time; }
+
+ private:
+    uint64_t m_offset{};
+    // The file the partial data was downloaded from. Unused if the offset is 0.
+    uint64_t m_file_size{};
+    uint64_t m_modification_time{};
 };
 
 // If successful, DownloadFileResponse returns the file path and size of the requested capture;
@@ -199,6 +226,12 @@ class DownloadFileResponse : public ISerializable
     uint64_t GetFileSize() const { return m_file_size; }
     void SetFileSize(uint64_t file_size) { m_file_size = file_size; }
 
+    uint64_t GetOffset() const { return m_offset; }
+    void SetOffset(uint64_t offset) { m_offset = offset; }
+
+    uint64_t GetModificationTime() const { return m_modification_time; }
+    void SetModificationTime(uint64_t time) { m_modification_time = time; }
+
  private:
     // Flag indicating whether the requested file was found on the server.
     bool m_found = false;
@@ -209,6 +242,12 @@ class DownloadFileResponse : public ISerializable
     std::string m_file_path;
     // The downloaded file's size.
     uint64_t m_file_size{};
+    // The offset the file is sent from. It is the requested offset, or 0 if that is past the end
+    // of the file or the file is not the one the partial data was downloaded from.
+    uint64_t m_offset{};
+    // The last modification time of the file, in nanoseconds since the epoch of the server's file
+    // clock. Only meant to be compared with the time sent by the same server.
+    uint64_t m_modification_time{};
 };
 
 // FileSizeRequest uses the string message as the file path for which we want to determine the size.
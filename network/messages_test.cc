@@ -120,6 +120,7 @@ TEST(MessagesTest, HandShakeMessage)
     Network::HandshakeRequest request;
     request.SetMajorVersion(345612);
     request.SetMinorVersion(567348);
+    request.SetFileCompression(Network::FileCompression::ZLIB);
     Network::Buffer buf;
     auto status = request.Serialize(buf);
     ASSERT_TRUE(status.ok());
@@ -132,6 +133,7 @@ TEST(MessagesTest, HandShakeMessage)
 
     ASSERT_EQ(request.GetMajorVersion(), response.GetMajorVersion());
     ASSERT_EQ(request.GetMinorVersion(), response.GetMinorVersion());
+    ASSERT_EQ(request.GetFileCompression(), response.GetFileCompression());
 }
 
 TEST(MessagesTest, PingPongMessage)
@@ -175,6 +177,9 @@ TEST(MessagesTest, DownloadFileMessage)
 {
     Network::DownloadFileRequest req_serialize;
     req_serialize.SetString("/sdcard/captures/dive_capture_0456.rd");
+    req_serialize.SetOffset(123456789012);
+    req_serialize.SetFileSize(234567890123);
+    req_serialize.SetModificationTime(1760000000123456789);
     Network::Buffer buf;
     auto status = req_serialize.Serialize(buf);
     ASSERT_TRUE(status.ok());
@@ -184,12 +189,17 @@ TEST(MessagesTest, DownloadFileMessage)
     ASSERT_TRUE(status.ok());
     ASSERT_EQ(req_deserialize.GetMessageType(), Network::MessageType::DOWNLOAD_FILE_REQUEST);
     ASSERT_EQ(req_serialize.GetString(), req_deserialize.GetString());
+    ASSERT_EQ(req_serialize.GetOffset(), req_deserialize.GetOffset());
+    ASSERT_EQ(req_serialize.GetFileSize(), req_deserialize.GetFileSize());
+    ASSERT_EQ(req_serialize.GetModificationTime(), req_deserialize.GetModificationTime());
 
     Network::DownloadFileResponse res_serialize;
     res_serialize.SetFound(false);
     res_serialize.SetErrorReason("File not found!");
     res_serialize.SetFilePath("/sdcard/captures/other_capture_0456.rd");
     res_serialize.SetFileSize(std::numeric_limits<uint64_t>::max());
+    res_serialize.SetOffset(4096);
+    res_serialize.SetModificationTime(1760000000123456789);
     buf.clear();
     status = res_serialize.Serialize(buf);
     ASSERT_TRUE(status.ok());
@@ -202,6 +212,8 @@ TEST(MessagesTest, DownloadFileMessage)
     ASSERT_EQ(res_serialize.GetErrorReason(), res_deserialize.GetErrorReason());
     ASSERT_EQ(res_serialize.GetFilePath(), res_deserialize.GetFilePath());
     ASSERT_EQ(res_serialize.GetFileSize(), res_deserialize.GetFileSize());
+    ASSERT_EQ(res_serialize.GetOffset(), res_deserialize.GetOffset());
+    ASSERT_EQ(res_serialize.GetModificationTime(), res_deserialize.GetModificationTime());
 }
 
 TEST(MessagesTest, FileSizeMessage)
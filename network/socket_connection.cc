@@ -16,16 +16,150 @@ limitations under the License.
 
 #include "socket_connection.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <future>
 #include <string>
 #include <vector>
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/sendfile.h>
+#include <time.h>
+#endif
+
 #include "absl/strings/str_cat.h"
+#include "dive/common/macros.h"
 #include "dive/common/status.h"
 
 namespace Network
 {
 
+namespace
+{
+
+// Large enough that a transfer is not bound by the per-call overhead of the buffered path
+constexpr size_t kFileTransferChunkSize = 1 << 20;
+
+// A compressed file is sent as a sequence of chunks, each starting with a header holding the size
+// of its data in the file, then the size of the payload following the header. A payload of the same
+// size as the data is the data itself, for a chunk that does not compress.
+constexpr size_t kCompressedChunkHeaderSize = 2 * sizeof(uint32_t);
+
+void WriteCompressedChunkHeader(uint32_t data_size, uint32_t payload_size, uint8_t* header)
+{
+    const uint32_t net_sizes[2] = {htonl(data_size), htonl(payload_size)};
+    memcpy(header, net_sizes, kCompressedChunkHeaderSize);
+}
+
+void ReadCompressedChunkHeader(const uint8_t* header, uint32_t& data_size, uint32_t& payload_size)
+{
+    uint32_t net_sizes[2];
+    memcpy(net_sizes, header, kCompressedChunkHeaderSize);
+    data_size = ntohl(net_sizes[0]);
+    payload_size = ntohl(net_sizes[1]);
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start_time)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+#if defined(__linux__)
+// sendfile() can't be given MSG_NOSIGNAL like send(), so SIGPIPE is blocked on the calling thread
+// while it runs, and a SIGPIPE it raised is discarded before unblocking
+class ScopedSigpipeBlock
+{
+ public:
+    ScopedSigpipeBlock()
+    {
+        sigset_t sigpipe_set;
+        sigemptyset(&sigpipe_set);
+        sigaddset(&sigpipe_set, SIGPIPE);
+        sigset_t pending;
+        sigpending(&pending);
+        m_was_pending = sigismember(&pending, SIGPIPE);
+        m_was_blocked =
+            (pthread_sigmask(SIG_BLOCK, &sigpipe_set, &m_old_set) == 0) &&
+            sigismember(&m_old_set, SIGPIPE);
+    }
+
+    ~ScopedSigpipeBlock()
+    {
+        if (m_was_blocked)
+        {
+            return;
+        }
+        sigset_t sigpipe_set;
+        sigemptyset(&sigpipe_set);
+        sigaddset(&sigpipe_set, SIGPIPE);
+        if (!m_was_pending)
+        {
+            const timespec no_wait = {0, 0};
+            while (sigtimedwait(&sigpipe_set, nullptr, &no_wait) == -1 && errno == EINTR)
+            {
+            }
+        }
+        pthread_sigmask(SIG_SETMASK, &m_old_set, nullptr);
+    }
+
+ private:
+    sigset_t m_old_set;
+    bool m_was_pending = false;
+    bool m_was_blocked = false;
+};
+
+// Sends the file from offset using sendfile(). Returns the offset it stopped at, which is before
+// file_size if the file can't be sent by the kernel (e.g. on a file system without support for it)
+absl::StatusOr<uint64_t> SendFileWithKernelCopy(int socket, int file_fd, uint64_t offset,
+                                                uint64_t file_size)
+{
+    // Bounded so that a single call does not hold the socket for too long
+    constexpr size_t kMaxSendfileSize = 64 << 20;
+
+    ScopedSigpipeBlock sigpipe_block;
+    off_t file_offset = static_cast<off_t>(offset);
+    while (static_cast<uint64_t>(file_offset) < file_size)
+    {
+        size_t to_send = static_cast<size_t>(
+            std::min<uint64_t>(kMaxSendfileSize, file_size - static_cast<uint64_t>(file_offset)));
+        ssize_t sent = ::sendfile(socket, file_fd, &file_offset, to_send);
+        if (sent < 0)
+        {
+            int e = errno;
+            if (e == EINTR)
+            {
+                continue;
+            }
+            if ((e == EINVAL || e == ENOSYS) && static_cast<uint64_t>(file_offset) == offset)
+            {
+                return offset;
+            }
+            if (e == EAGAIN || e == EWOULDBLOCK)
+            {
+                return Dive::UnavailableError("sendfile: Operation would block.");
+            }
+            if (e == EPIPE || e == ECONNRESET)
+            {
+                return Dive::AbortedError("sendfile: Connection reset by peer (EPIPE/ECONNRESET).");
+            }
+            return Dive::InternalError(absl::StrCat("sendfile() failed: ", strerror(e)));
+        }
+        if (sent == 0)
+        {
+            return Dive::DataLossError("sendfile: File ended before its expected size.");
+        }
+    }
+    return static_cast<uint64_t>(file_offset);
+}
+#endif
+
+}  // namespace
+
 NetworkInitializer::NetworkInitializer() : m_initialized(false)
 {
 #ifdef WIN32
@@ -418,75 +552,270 @@ absl::StatusOr<std::string> SocketConnection::ReceiveString()
     }
 }
 
-absl::Status SocketConnection::SendFile(const std::string& file_path)
+absl::Status SocketConnection::SendFile(const std::string& file_path, uint64_t offset)
 {
-    std::ifstream file_stream(file_path, std::ios::binary | std::ios::ate);
-    if (!file_stream)
+    std::error_code ec;
+    const uint64_t file_size = std::filesystem::file_size(file_path, ec);
+    if (ec)
     {
-        return Dive::NotFoundError(absl::StrCat("SendFile: Failed to open file '", file_path, "'"));
+        return Dive::NotFoundError(absl::StrCat("SendFile: Failed to determine size of file '",
+                                                file_path, "': ", ec.message()));
     }
-    std::streamsize file_size = file_stream.tellg();
-    if (file_size < 0)
+    if (offset > file_size)
     {
-        file_stream.close();
-        return Dive::InternalError(
-            absl::StrCat("SendFile: Failed to determine size of file '", file_path, "'"));
+        return Dive::OutOfRangeError(absl::StrCat("SendFile: Offset ", offset,
+                                                  " is past the end of file '", file_path, "'"));
     }
 
-    file_stream.seekg(0);
-    const size_t CHUNK_SIZE = 4096;
-    std::vector<char> buffer(CHUNK_SIZE);
-    std::streamsize total_sent = 0;
-    while (total_sent < file_size)
+    const auto start_time = std::chrono::steady_clock::now();
+    uint64_t wire_bytes = file_size - offset;
+    if (m_file_compression == FileCompression::NONE)
+    {
+        RETURN_IF_ERROR(SendUncompressedFile(file_path, offset, file_size));
+    }
+    else
+    {
+        ASSIGN_OR_RETURN(wire_bytes, SendCompressedFile(file_path, offset, file_size));
+    }
+    m_last_file_transfer_stats = {
+        .file_bytes = file_size - offset,
+        .wire_bytes = wire_bytes,
+        .seconds = SecondsSince(start_time),
+    };
+    return Dive::OkStatus();
+}
+
+absl::Status SocketConnection::SendUncompressedFile(const std::string& file_path, uint64_t offset,
+                                                    uint64_t file_size)
+{
+#if defined(__linux__)
+    if (!IsOpen() || m_is_listening)
+    {
+        return Dive::FailedPreconditionError(
+            "SendFile: Socket is invalid or operation not supported on a listening socket.");
+    }
+    int file_fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_fd < 0)
     {
-        std::streamsize to_read =
-            std::min(static_cast<std::streamsize>(CHUNK_SIZE), file_size - total_sent);
-        if (!file_stream.read(buffer.data(), to_read))
+        return Dive::NotFoundError(
+            absl::StrCat("SendFile: Failed to open file '", file_path, "': ", strerror(errno)));
+    }
+    absl::StatusOr<uint64_t> sent = SendFileWithKernelCopy(m_socket, file_fd, offset, file_size);
+    ::close(file_fd);
+    if (!sent.ok())
+    {
+        if (absl::IsAborted(sent.status()))
         {
-            file_stream.close();
-            return Dive::InternalError(
-                absl::StrCat("SendFile: Failed to read chunk from file '", file_path, "'"));
+            Close();
         }
-        size_t current_read = static_cast<size_t>(file_stream.gcount());
-        if (current_read == 0)
+        return Dive::StatusWithContext(sent.status(),
+                                       absl::StrCat("SendFile: Failed to send file '", file_path,
+                                                    "'"));
+    }
+    // The kernel can't send from every kind of file, in which case the rest of the file is sent
+    // through a buffer
+    offset = *sent;
+    if (offset == file_size)
+    {
+        return Dive::OkStatus();
+    }
+#endif
+
+    std::ifstream file_stream(file_path, std::ios::binary);
+    if (!file_stream || !file_stream.seekg(static_cast<std::streamoff>(offset)))
+    {
+        return Dive::NotFoundError(absl::StrCat("SendFile: Failed to open file '", file_path, "'"));
+    }
+
+    std::vector<char> buffer(kFileTransferChunkSize);
+    uint64_t total_sent = offset;
+    while (total_sent < file_size)
+    {
+        size_t to_read =
+            static_cast<size_t>(std::min<uint64_t>(buffer.size(), file_size - total_sent));
+        if (!file_stream.read(buffer.data(), static_cast<std::streamsize>(to_read)))
         {
-            file_stream.close();
             return Dive::DataLossError(
-                absl::StrCat("SendFile: File size mismatch. Read 0 bytes "
-                             "before reaching expected end of file '",
-                             file_path, "'"));
+                absl::StrCat("SendFile: Failed to read chunk from file '", file_path, "'"));
         }
-        absl::Status ret = this->Send(reinterpret_cast<uint8_t*>(buffer.data()), current_read);
+        absl::Status ret = this->Send(reinterpret_cast<uint8_t*>(buffer.data()), to_read);
         if (!ret.ok())
         {
             return Dive::StatusWithContext(
                 ret, absl::StrCat("SendFile: Failed to send chunk for file '", file_path, "'"));
         }
-        total_sent += static_cast<std::streamsize>(current_read);
+        total_sent += to_read;
     }
-    file_stream.close();
     return Dive::OkStatus();
 }
 
+absl::StatusOr<uint64_t> SocketConnection::SendCompressedFile(const std::string& file_path,
+                                                              uint64_t offset, uint64_t file_size)
+{
+    std::ifstream file_stream(file_path, std::ios::binary);
+    if (!file_stream || !file_stream.seekg(static_cast<std::streamoff>(offset)))
+    {
+        return Dive::NotFoundError(absl::StrCat("SendFile: Failed to open file '", file_path, "'"));
+    }
+
+    struct Chunk
+    {
+        std::vector<uint8_t> data;
+        std::vector<uint8_t> compressed;
+        bool is_compressed = false;
+        uint8_t header[kCompressedChunkHeaderSize];
+    };
+    // Compressing a chunk that does not compress, e.g. of a file compressed already, takes longer
+    // than sending it. So after such a chunk the next few are sent as is without trying.
+    constexpr int kChunksToSkipAfterIncompressible = 7;
+    int chunks_to_skip = 0;
+    const FileCompression compression = m_file_compression;
+    auto read_chunk = [&file_stream, &file_path, &chunks_to_skip, compression](
+                          Chunk& chunk, size_t size) -> absl::Status {
+        chunk.data.resize(size);
+        if (!file_stream.read(reinterpret_cast<char*>(chunk.data.data()),
+                              static_cast<std::streamsize>(size)))
+        {
+            return Dive::DataLossError(
+                absl::StrCat("SendFile: Failed to read chunk from file '", file_path, "'"));
+        }
+        chunk.is_compressed = false;
+        if (chunks_to_skip > 0)
+        {
+            --chunks_to_skip;
+        }
+        else
+        {
+            RETURN_IF_ERROR(CompressChunk(compression, chunk.data.data(), size, chunk.compressed));
+            chunk.is_compressed = chunk.compressed.size() < size;
+            if (chunk.compressed.size() > size - size / 8)
+            {
+                chunks_to_skip = kChunksToSkipAfterIncompressible;
+            }
+        }
+        const size_t payload_size = chunk.is_compressed ? chunk.compressed.size() : size;
+        WriteCompressedChunkHeader(static_cast<uint32_t>(size),
+                                   static_cast<uint32_t>(payload_size), chunk.header);
+        return Dive::OkStatus();
+    };
+    auto chunk_size = [file_size](uint64_t chunk_offset) {
+        return static_cast<size_t>(
+            std::min<uint64_t>(kFileTransferChunkSize, file_size - chunk_offset));
+    };
+
+    // The next chunk is read and compressed while the current one is sent, so that the time spent
+    // compressing is hidden behind the transfer. Only one chunk is read at a time.
+    Chunk chunks[2];
+    int current = 0;
+    uint64_t chunk_offset = offset;
+    uint64_t wire_bytes = 0;
+    if (chunk_offset < file_size)
+    {
+        RETURN_IF_ERROR(read_chunk(chunks[current], chunk_size(chunk_offset)));
+    }
+    while (chunk_offset < file_size)
+    {
+        Chunk& chunk = chunks[current];
+        const uint64_t next_chunk_offset = chunk_offset + chunk.data.size();
+        std::future<absl::Status> next_chunk;
+        if (next_chunk_offset < file_size)
+        {
+            next_chunk = std::async(std::launch::async, read_chunk, std::ref(chunks[1 - current]),
+                                    chunk_size(next_chunk_offset));
+        }
+
+        const std::vector<uint8_t>& payload = chunk.is_compressed ? chunk.compressed : chunk.data;
+        absl::Status send_status = Send(chunk.header, kCompressedChunkHeaderSize);
+        if (send_status.ok())
+        {
+            send_status = Send(payload.data(), payload.size());
+        }
+        absl::Status next_chunk_status = next_chunk.valid() ? next_chunk.get() : Dive::OkStatus();
+        if (!send_status.ok())
+        {
+            return Dive::StatusWithContext(
+                send_status,
+                absl::StrCat("SendFile: Failed to send chunk for file '", file_path, "'"));
+        }
+        RETURN_IF_ERROR(next_chunk_status);
+
+        wire_bytes += kCompressedChunkHeaderSize + payload.size();
+        chunk_offset = next_chunk_offset;
+        current = 1 - current;
+    }
+    return wire_bytes;
+}
+
 absl::Status SocketConnection::ReceiveFile(const std::string& file_path, size_t file_size,
-                                           std::function<void(size_t)> progress_callback)
+                                           std::function<void(size_t)> progress_callback,
+                                           uint64_t offset)
 {
-    std::ofstream file_stream(file_path, std::ios::binary | std::ios::trunc);
-    if (!file_stream)
+    if (offset > file_size)
+    {
+        return Dive::OutOfRangeError(
+            absl::StrCat("ReceiveFile: Offset ", offset, " is past the end of file '", file_path,
+                         "' of ", file_size, " bytes."));
+    }
+
+    std::ios::openmode mode = std::ios::binary | std::ios::trunc;
+    if (offset > 0)
+    {
+        // Keep the bytes received before, and drop anything after them
+        std::error_code ec;
+        std::filesystem::resize_file(file_path, offset, ec);
+        if (ec)
+        {
+            return Dive::PermissionDeniedError(absl::StrCat(
+                "ReceiveFile: Failed to resume file '", file_path, "': ", ec.message()));
+        }
+        mode = std::ios::binary | std::ios::in | std::ios::out;
+    }
+    std::ofstream file_stream(file_path, mode);
+    if (!file_stream || !file_stream.seekp(static_cast<std::streamoff>(offset)))
     {
         return Dive::PermissionDeniedError(
             absl::StrCat("ReceiveFile: Failed to open file '", file_path, "' for writing."));
     }
-    const size_t CHUNK_SIZE = 4096;
-    std::vector<uint8_t> buffer(CHUNK_SIZE);
-    size_t total_received = 0;
+
+    const auto start_time = std::chrono::steady_clock::now();
+    uint64_t wire_bytes = file_size - offset;
+    if (m_file_compression == FileCompression::NONE)
+    {
+        RETURN_IF_ERROR(ReceiveUncompressedFile(file_stream, file_path, file_size,
+                                                static_cast<size_t>(offset), progress_callback));
+    }
+    else
+    {
+        ASSIGN_OR_RETURN(wire_bytes,
+                         ReceiveCompressedFile(file_stream, file_path, file_size,
+                                               static_cast<size_t>(offset), progress_callback));
+    }
+    file_stream.close();
+    if (!file_stream)
+    {
+        return Dive::InternalError(
+            absl::StrCat("ReceiveFile: Failed to write to file '", file_path, "'"));
+    }
+    m_last_file_transfer_stats = {
+        .file_bytes = file_size - offset,
+        .wire_bytes = wire_bytes,
+        .seconds = SecondsSince(start_time),
+    };
+    return Dive::OkStatus();
+}
+
+absl::Status SocketConnection::ReceiveUncompressedFile(
+    std::ostream& file_stream, const std::string& file_path, size_t file_size, size_t offset,
+    const std::function<void(size_t)>& progress_callback)
+{
+    std::vector<uint8_t> buffer(kFileTransferChunkSize);
+    size_t total_received = offset;
     while (total_received < file_size)
     {
-        size_t to_receive = std::min(CHUNK_SIZE, file_size - total_received);
+        size_t to_receive = std::min(buffer.size(), file_size - total_received);
         auto ret = this->Recv(buffer.data(), to_receive);
         if (!ret.ok())
         {
-            file_stream.close();
             return Dive::StatusWithContext(
                 ret.status(),
                 absl::StrCat("ReceiveFile: Failed to receive chunk for '", file_path, "'"));
@@ -494,7 +823,6 @@ absl::Status SocketConnection::ReceiveFile(const std::string& file_path, size_t
         size_t current_received = ret.value();
         if (!file_stream.write(reinterpret_cast<char*>(buffer.data()), current_received))
         {
-            file_stream.close();
             return Dive::InternalError(
                 absl::StrCat("ReceiveFile: Failed to write to file '", file_path, "'"));
         }
@@ -504,10 +832,73 @@ absl::Status SocketConnection::ReceiveFile(const std::string& file_path, size_t
             progress_callback(total_received);
         }
     }
-    file_stream.close();
     return Dive::OkStatus();
 }
 
+absl::StatusOr<uint64_t> SocketConnection::ReceiveCompressedFile(
+    std::ostream& file_stream, const std::string& file_path, size_t file_size, size_t offset,
+    const std::function<void(size_t)>& progress_callback)
+{
+    std::vector<uint8_t> data(kFileTransferChunkSize);
+    std::vector<uint8_t> compressed(kFileTransferChunkSize);
+    size_t total_received = offset;
+    uint64_t wire_bytes = 0;
+    while (total_received < file_size)
+    {
+        uint8_t header[kCompressedChunkHeaderSize];
+        auto ret = this->Recv(header, kCompressedChunkHeaderSize);
+        if (!ret.ok())
+        {
+            return Dive::StatusWithContext(
+                ret.status(),
+                absl::StrCat("ReceiveFile: Failed to receive chunk for '", file_path, "'"));
+        }
+        uint32_t data_size = 0;
+        uint32_t payload_size = 0;
+        ReadCompressedChunkHeader(header, data_size, payload_size);
+        if (data_size == 0 || data_size > std::min(data.size(), file_size - total_received) ||
+            payload_size > data_size)
+        {
+            return Dive::DataLossError(
+                absl::StrCat("ReceiveFile: Invalid chunk header for '", file_path, "'"));
+        }
+
+        // A payload of the same size as the data is the data itself
+        const bool is_compressed = payload_size < data_size;
+        uint8_t* payload = is_compressed ? compressed.data() : data.data();
+        ret = this->Recv(payload, payload_size);
+        if (!ret.ok())
+        {
+            return Dive::StatusWithContext(
+                ret.status(),
+                absl::StrCat("ReceiveFile: Failed to receive chunk for '", file_path, "'"));
+        }
+        if (is_compressed)
+        {
+            absl::Status status =
+                DecompressChunk(m_file_compression, payload, payload_size, data.data(), data_size);
+            if (!status.ok())
+            {
+                return Dive::StatusWithContext(
+                    status, absl::StrCat("ReceiveFile: Failed to decompress chunk for '",
+                                         file_path, "'"));
+            }
+        }
+        if (!file_stream.write(reinterpret_cast<char*>(data.data()), data_size))
+        {
+            return Dive::InternalError(
+                absl::StrCat("ReceiveFile: Failed to write to file '", file_path, "'"));
+        }
+        wire_bytes += kCompressedChunkHeaderSize + payload_size;
+        total_received += data_size;
+        if (progress_callback)
+        {
+            progress_callback(total_received);
+        }
+    }
+    return wire_bytes;
+}
+
 void SocketConnection::Close()
 {
     if (m_socket != kInvalidSocketValue)
@@ -16,10 +16,14 @@ limitations under the License.
 
 #pragma once
 
+#include <functional>
+#include <iosfwd>
 #include <memory>
+#include <string>
 #include <system_error>
 
 #include "absl/status/statusor.h"
+#include "file_compression.h"
 #include "platform_net.h"
 
 constexpr int kNoTimeout = -1;
@@ -65,9 +69,32 @@ class SocketConnection
     absl::StatusOr<size_t> Recv(uint8_t* data, size_t size, int timeout_ms = kNoTimeout);
     absl::Status SendString(const std::string& s);
     absl::StatusOr<std::string> ReceiveString();
-    absl::Status SendFile(const std::string& file_path);
+    // Sends the file from the given offset to its end. On Linux the file is sent by the kernel
+    // without being copied through user space.
+    absl::Status SendFile(const std::string& file_path, uint64_t offset = 0);
+    // Receives the bytes of a file of file_size bytes from the given offset, and writes them at
+    // that offset of the file. The first offset bytes of an existing file are kept, so that an
+    // interrupted download can be resumed. The progress callback is given the number of bytes of
+    // the file received so far, including the first offset bytes.
     absl::Status ReceiveFile(const std::string& file_path, size_t file_size,
-                             std::function<void(size_t)> progress_callback = nullptr);
+                             std::function<void(size_t)> progress_callback = nullptr,
+                             uint64_t offset = 0);
+
+    // Selects how SendFile encodes a file, and how ReceiveFile expects it to be encoded. Both ends
+    // of the connection must use the same compression, which they agree on during the handshake.
+    void SetFileCompression(FileCompression compression) { m_file_compression = compression; }
+    FileCompression GetFileCompression() const { return m_file_compression; }
+
+    struct FileTransferStats
+    {
+        // Bytes of the file sent or received, not counting those before the offset.
+        uint64_t file_bytes = 0;
+        // Bytes that went over the connection for them.
+        uint64_t wire_bytes = 0;
+        double seconds = 0.0;
+    };
+    // Returns the stats of the last file successfully sent or received.
+    const FileTransferStats& GetLastFileTransferStats() const { return m_last_file_transfer_stats; }
 
     void Close();
     bool IsOpen() const;
@@ -75,9 +102,24 @@ class SocketConnection
  private:
     explicit SocketConnection(SocketType initial_socket_value);
 
+    absl::Status SendUncompressedFile(const std::string& file_path, uint64_t offset,
+                                      uint64_t file_size);
+    // Returns the number of bytes sent.
+    absl::StatusOr<uint64_t> SendCompressedFile(const std::string& file_path, uint64_t offset,
+                                                uint64_t file_size);
+    absl::Status ReceiveUncompressedFile(std::ostream& file_stream, const std::string& file_path,
+                                         size_t file_size, size_t offset,
+                                         const std::function<void(size_t)>& progress_callback);
+    // Returns the number of bytes received.
+    absl::StatusOr<uint64_t> ReceiveCompressedFile(
+        std::ostream& file_stream, const std::string& file_path, size_t file_size, size_t offset,
+        const std::function<void(size_t)>& progress_callback);
+
     SocketType m_socket;
     bool m_is_listening;
     int m_accept_timout_ms;
+    FileCompression m_file_compression = FileCompression::NONE;
+    FileTransferStats m_last_file_transfer_stats;
 };
 
 }  // namespace Network
\ No newline at end of file
@@ -0,0 +1,231 @@
+/*
+Copyright 2026 Google Inc.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "socket_connection.h"
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// A connected pair of unix domain sockets stands in for the connection between the client and the
+// server.
+class SocketConnectionFileTest : public ::testing::Test
+{
+ protected:
+    void SetUp() override
+    {
+        int fds[2] = {};
+        ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        auto sender = Network::SocketConnection::Create(fds[0]);
+        auto receiver = Network::SocketConnection::Create(fds[1]);
+        ASSERT_TRUE(sender.ok());
+        ASSERT_TRUE(receiver.ok());
+        m_sender = *std::move(sender);
+        m_receiver = *std::move(receiver);
+
+        const std::string test_name =
+            ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        const std::filesystem::path temp_dir = std::filesystem::temp_directory_path();
+        m_source_path = (temp_dir / (test_name + "_source.rd")).string();
+        m_dest_path = (temp_dir / (test_name + "_dest.rd")).string();
+
+        // Not a multiple of the transfer chunk size, so that the last chunk is partial
+        m_contents.resize(3 * 1024 * 1024 + 123);
+        for (size_t i = 0; i < m_contents.size(); ++i)
+        {
+            m_contents[i] = static_cast<char>((i * 7919) >> 3);
+        }
+        WriteFile(m_source_path, m_contents);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove(m_source_path);
+        std::filesystem::remove(m_dest_path);
+    }
+
+    void UseFileCompression(Network::FileCompression compression)
+    {
+        m_sender->SetFileCompression(compression);
+        m_receiver->SetFileCompression(compression);
+    }
+
+    static void WriteFile(const std::string& path, const std::string& contents)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    }
+
+    static std::string ReadFile(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::unique_ptr<Network::SocketConnection> m_sender;
+    std::unique_ptr<Network::SocketConnection> m_receiver;
+    std::string m_source_path;
+    std::string m_dest_path;
+    std::string m_contents;
+};
+
+TEST_F(SocketConnectionFileTest, SendAndReceiveFile)
+{
+    absl::Status send_status;
+    std::thread sender([&]() { send_status = m_sender->SendFile(m_source_path); });
+
+    size_t last_progress = 0;
+    absl::Status receive_status =
+        m_receiver->ReceiveFile(m_dest_path, m_contents.size(),
+                                [&](size_t received) { last_progress = received; });
+    sender.join();
+
+    ASSERT_TRUE(send_status.ok()) << send_status;
+    ASSERT_TRUE(receive_status.ok()) << receive_status;
+    EXPECT_EQ(last_progress, m_contents.size());
+    EXPECT_EQ(ReadFile(m_dest_path), m_contents);
+}
+
+TEST_F(SocketConnectionFileTest, ResumeFromOffset)
+{
+    // An interrupted download left the first bytes of the file, followed by a partially written
+    // chunk which is overwritten
+    const size_t offset = 1024 * 1024 + 17;
+    WriteFile(m_dest_path, m_contents.substr(0, offset) + std::string(1000, 'x'));
+
+    absl::Status send_status;
+    std::thread sender([&]() { send_status = m_sender->SendFile(m_source_path, offset); });
+
+    size_t first_progress = 0;
+    absl::Status receive_status = m_receiver->ReceiveFile(
+        m_dest_path, m_contents.size(),
+        [&](size_t received) {
+            if (first_progress == 0)
+            {
+                first_progress = received;
+            }
+        },
+        offset);
+    sender.join();
+
+    ASSERT_TRUE(send_status.ok()) << send_status;
+    ASSERT_TRUE(receive_status.ok()) << receive_status;
+    EXPECT_GT(first_progress, offset);
+    EXPECT_EQ(ReadFile(m_dest_path), m_contents);
+}
+
+TEST_F(SocketConnectionFileTest, SendAndReceiveCompressedFile)
+{
+    if (!Network::IsFileCompressionSupported(Network::FileCompression::ZLIB))
+    {
+        GTEST_SKIP() << "Built without zlib";
+    }
+    UseFileCompression(Network::FileCompression::ZLIB);
+
+    absl::Status send_status;
+    std::thread sender([&]() { send_status = m_sender->SendFile(m_source_path); });
+    size_t last_progress = 0;
+    absl::Status receive_status =
+        m_receiver->ReceiveFile(m_dest_path, m_contents.size(),
+                                [&](size_t received) { last_progress = received; });
+    sender.join();
+
+    ASSERT_TRUE(send_status.ok()) << send_status;
+    ASSERT_TRUE(receive_status.ok()) << receive_status;
+    EXPECT_EQ(last_progress, m_contents.size());
+    EXPECT_EQ(ReadFile(m_dest_path), m_contents);
+
+    const auto& sent_stats = m_sender->GetLastFileTransferStats();
+    const auto& received_stats = m_receiver->GetLastFileTransferStats();
+    EXPECT_EQ(sent_stats.file_bytes, m_contents.size());
+    EXPECT_EQ(received_stats.file_bytes, m_contents.size());
+    EXPECT_EQ(sent_stats.wire_bytes, received_stats.wire_bytes);
+    EXPECT_LT(received_stats.wire_bytes, m_contents.size() / 2);
+}
+
+TEST_F(SocketConnectionFileTest, ResumeCompressedFromOffset)
+{
+    if (!Network::IsFileCompressionSupported(Network::FileCompression::ZLIB))
+    {
+        GTEST_SKIP() << "Built without zlib";
+    }
+    UseFileCompression(Network::FileCompression::ZLIB);
+    const size_t offset = 2 * 1024 * 1024 + 5;
+    WriteFile(m_dest_path, m_contents.substr(0, offset));
+
+    absl::Status send_status;
+    std::thread sender([&]() { send_status = m_sender->SendFile(m_source_path, offset); });
+    absl::Status receive_status =
+        m_receiver->ReceiveFile(m_dest_path, m_contents.size(), nullptr, offset);
+    sender.join();
+
+    ASSERT_TRUE(send_status.ok()) << send_status;
+    ASSERT_TRUE(receive_status.ok()) << receive_status;
+    EXPECT_EQ(m_receiver->GetLastFileTransferStats().file_bytes, m_contents.size() - offset);
+    EXPECT_EQ(ReadFile(m_dest_path), m_contents);
+}
+
+TEST_F(SocketConnectionFileTest, IncompressibleFileIsSentAsIs)
+{
+    if (!Network::IsFileCompressionSupported(Network::FileCompression::ZLIB))
+    {
+        GTEST_SKIP() << "Built without zlib";
+    }
+    UseFileCompression(Network::FileCompression::ZLIB);
+    std::mt19937 random(1234);
+    for (char& c : m_contents)
+    {
+        c = static_cast<char>(random());
+    }
+    WriteFile(m_source_path, m_contents);
+
+    absl::Status send_status;
+    std::thread sender([&]() { send_status = m_sender->SendFile(m_source_path); });
+    absl::Status receive_status = m_receiver->ReceiveFile(m_dest_path, m_contents.size());
+    sender.join();
+
+    ASSERT_TRUE(send_status.ok()) << send_status;
+    ASSERT_TRUE(receive_status.ok()) << receive_status;
+    EXPECT_EQ(ReadFile(m_dest_path), m_contents);
+    // Only the chunk headers are added
+    EXPECT_LT(m_receiver->GetLastFileTransferStats().wire_bytes, m_contents.size() + 64);
+}
+
+TEST_F(SocketConnectionFileTest, SendFileToClosedPeerFails)
+{
+    m_receiver->Close();
+    absl::Status send_status = m_sender->SendFile(m_source_path);
+    EXPECT_FALSE(send_status.ok());
+}
+
+TEST_F(SocketConnectionFileTest, SendMissingFileFails)
+{
+    EXPECT_TRUE(absl::IsNotFound(m_sender->SendFile(m_source_path + ".missing")));
+    EXPECT_TRUE(absl::IsOutOfRange(m_sender->SendFile(m_source_path, m_contents.size() + 1)));
+}
+
+}  // namespace
@@ -16,6 +16,8 @@ limitations under the License.
 #include "tcp_client.h"
 
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 
 #include "absl/strings/str_cat.h"
 #include "dive/common/status.h"
@@ -25,7 +27,30 @@ namespace
 constexpr uint32_t kKeepAliveIntervalSec = 2;
 constexpr uint32_t kPingTimeoutMs = 5000;
 constexpr uint32_t kHandshakeMajorVersion = 1;
-constexpr uint32_t kHandshakeMinorVersion = 0;
+constexpr uint32_t kHandshakeMinorVersion = 2;
+constexpr char kPartialDownloadSuffix[] = ".part";
+// Holds the size and modification time of the remote file the partial file is downloaded from
+constexpr char kPartialDownloadInfoSuffix[] = ".part.info";
+
+struct RemoteFileIdentity
+{
+    uint64_t file_size = 0;
+    uint64_t modification_time = 0;
+};
+
+bool ReadRemoteFileIdentity(const std::string& info_path, RemoteFileIdentity& identity)
+{
+    std::ifstream file(info_path);
+    return static_cast<bool>(file >> identity.file_size >> identity.modification_time);
+}
+
+bool WriteRemoteFileIdentity(const std::string& info_path, const RemoteFileIdentity& identity)
+{
+    std::ofstream file(info_path, std::ios::trunc);
+    file << identity.file_size << ' ' << identity.modification_time << '\n';
+    file.close();
+    return static_cast<bool>(file);
+}
 }  // namespace
 
 namespace Network
@@ -165,11 +190,35 @@ absl::Status TcpClient::DownloadFileFromServer(const std::string& remote_file_pa
         return Dive::FailedPreconditionError("DownloadFileFromServer: Client is not connected.");
     }
 
+    const std::string partial_save_path = local_save_path + kPartialDownloadSuffix;
+    const std::string partial_info_path = local_save_path + kPartialDownloadInfoSuffix;
+    // A partial file can only be resumed if it is known which version of the remote file it is
+    // from, since the server checks that the file has not changed since
+    uint64_t resume_offset = 0;
+    RemoteFileIdentity partial_identity;
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(partial_save_path, ec) &&
+        ReadRemoteFileIdentity(partial_info_path, partial_identity))
+    {
+        if (auto partial_size = std::filesystem::file_size(partial_save_path, ec); !ec)
+        {
+            resume_offset = partial_size;
+        }
+    }
+
     DownloadFileRequest download_request;
     download_request.SetString(remote_file_path);
+    download_request.SetOffset(resume_offset);
+    download_request.SetFileSize(partial_identity.file_size);
+    download_request.SetModificationTime(partial_identity.modification_time);
 
     std::cout << "Client: Requesting to download file from server '" << remote_file_path << "' to '"
-              << local_save_path << "'." << std::endl;
+              << local_save_path << "'";
+    if (resume_offset > 0)
+    {
+        std::cout << ", resuming from byte " << resume_offset;
+    }
+    std::cout << "." << std::endl;
     absl::Status send_status = SendSocketMessage(m_connection.get(), download_request);
     if (!send_status.ok())
     {
@@ -207,11 +256,19 @@ absl::Status TcpClient::DownloadFileFromServer(const std::string& remote_file_pa
     }
 
     size_t file_size = download_response->GetFileSize();
+    uint64_t offset = download_response->GetOffset();
     std::cout << "Client: Server offering file (size = " << file_size
-              << " bytes). Starting download." << std::endl;
+              << " bytes). Starting download from byte " << offset << "." << std::endl;
+
+    // Without the identity of the remote file, an interrupted download starts over next time
+    RemoteFileIdentity identity{file_size, download_response->GetModificationTime()};
+    if (!WriteRemoteFileIdentity(partial_info_path, identity))
+    {
+        std::filesystem::remove(partial_info_path, ec);
+    }
 
     absl::Status recv_status =
-        m_connection->ReceiveFile(local_save_path, file_size, progress_callback);
+        m_connection->ReceiveFile(partial_save_path, file_size, progress_callback, offset);
     if (!recv_status.ok())
     {
         return SetStatusAndReturnError(ClientStatus::CONNECTION_FAILED,
@@ -220,8 +277,26 @@ absl::Status TcpClient::DownloadFileFromServer(const std::string& remote_file_pa
                                                                "ReceiveFile fail"));
     }
 
+    std::filesystem::rename(partial_save_path, local_save_path, ec);
+    if (ec)
+    {
+        return Dive::InternalError(
+            absl::StrCat("DownloadFileFromServer: Failed to move '", partial_save_path, "' to '",
+                         local_save_path, "': ", ec.message()));
+    }
+    std::filesystem::remove(partial_info_path, ec);
+
     std::cout << "Client: File from server '" << download_request.GetString()
               << "' downloaded successfully to '" << local_save_path << "'." << std::endl;
+    const SocketConnection::FileTransferStats& stats = m_connection->GetLastFileTransferStats();
+    if (stats.wire_bytes > 0 && stats.seconds > 0.0)
+    {
+        std::cout << "Client: Received " << stats.file_bytes << " bytes as " << stats.wire_bytes
+                  << " bytes (ratio " << static_cast<double>(stats.file_bytes) / stats.wire_bytes
+                  << ") in " << stats.seconds << " s ("
+                  << stats.file_bytes / stats.seconds / (1024.0 * 1024.0) << " MiB/s)."
+                  << std::endl;
+    }
     return Dive::OkStatus();
 }
 
@@ -557,6 +632,10 @@ absl::Status TcpClient::PerformHandshake()
     HandshakeRequest hs_request;
     hs_request.SetMajorVersion(kHandshakeMajorVersion);
     hs_request.SetMinorVersion(kHandshakeMinorVersion);
+    if (IsFileCompressionSupported(m_requested_file_compression))
+    {
+        hs_request.SetFileCompression(m_requested_file_compression);
+    }
     std::cout << "Client: Sending Handshake (Client v" << hs_request.GetMajorVersion() << "."
               << hs_request.GetMinorVersion() << ")" << std::endl;
 
@@ -606,6 +685,17 @@ absl::Status TcpClient::PerformHandshake()
             " Client requires v", hs_request.GetMajorVersion(), ".", hs_request.GetMinorVersion()));
     }
     std::cout << "Client: Handshake versions compatible." << std::endl;
+
+    if (hs_response->GetFileCompression() != FileCompression::NONE &&
+        hs_response->GetFileCompression() != hs_request.GetFileCompression())
+    {
+        return Dive::FailedPreconditionError(absl::StrCat(
+            "PerformHandshake: Server selected unrequested file compression ",
+            static_cast<uint32_t>(hs_response->GetFileCompression())));
+    }
+    m_connection->SetFileCompression(hs_response->GetFileCompression());
+    std::cout << "Client: Files are downloaded with compression "
+              << static_cast<uint32_t>(hs_response->GetFileCompression()) << "." << std::endl;
     return Dive::OkStatus();
 }
 
@@ -42,6 +42,13 @@ class TcpClient
  public:
     ~TcpClient();
 
+    // Sets the compression to ask the server to send files with on the next Connect. The server
+    // sends them uncompressed if it does not support it.
+    void SetRequestedFileCompression(FileCompression compression)
+    {
+        m_requested_file_compression = compression;
+    }
+
     // Connects to the server and performs the handshake.
     // Returns absl::OkStatus() on success, or an error status on failure.
     absl::Status Connect(const std::string& host, int port);
@@ -57,7 +64,10 @@ class TcpClient
     // On failure, returns a status.
     absl::StatusOr<std::string> StartPm4Capture();
 
-    // Downloads a file from the server to a local path.
+    // Downloads a file from the server to a local path. The file is downloaded to a partial file
+    // next to the local path, which is renamed once complete. If a partial file is left by an
+    // interrupted download, the download resumes from its end, unless the remote file has changed
+    // since, in which case it starts over.
     absl::Status DownloadFileFromServer(const std::string& remote_file_path,
                                         const std::string& local_save_path,
                                         std::function<void(size_t)> progress_callback = nullptr);
@@ -104,6 +114,8 @@ class TcpClient
     std::mutex m_connection_mutex;
     ClientStatus m_status = ClientStatus::DISCONNECTED;
     mutable std::mutex m_status_mutex;
+    // Captures compress well, and are usually downloaded over a slow USB link
+    FileCompression m_requested_file_compression = FileCompression::ZLIB;
 
     // KeepAlive is used to check the connection with the server periodically via a ping-pong
     // mechanism.
@@ -27,6 +27,7 @@ void InitInstanceDispatchTable(VkInstance instance, PFN_vkGetInstanceProcAddr pa
     LOGI("InitInstanceDispatchTable");
 
     dt->pfn_get_instance_proc_addr = pa;
+    dt->DestroyInstance = (PFN_vkDestroyInstance)pa(instance, "vkDestroyInstance");
     dt->CreateDevice = (PFN_vkCreateDevice)pa(instance, "vkCreateDevice");
     dt->EnumerateDeviceLayerProperties =
         (PFN_vkEnumerateDeviceLayerProperties)pa(instance, "vkEnumerateDeviceLayerProperties");
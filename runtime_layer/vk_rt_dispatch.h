@@ -25,6 +25,7 @@ namespace DiveLayer
 struct InstanceDispatchTable
 {
     PFN_vkGetInstanceProcAddr pfn_get_instance_proc_addr = nullptr;
+    PFN_vkDestroyInstance DestroyInstance = nullptr;
     PFN_vkCreateDevice CreateDevice = nullptr;
     PFN_vkEnumerateDeviceLayerProperties EnumerateDeviceLayerProperties = nullptr;
     PFN_vkEnumerateDeviceExtensionProperties EnumerateDeviceExtensionProperties = nullptr;
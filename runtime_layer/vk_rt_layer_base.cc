@@ -24,13 +24,12 @@ limitations under the License.
 #include <cstring>
 #include <filesystem>
 #include <memory>
-#include <mutex>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
 #include "common/log.h"
 #include "dive/utils/device_resources_constants.h"
+#include "layer/dispatch_key_map.h"
 #include "network/unix_domain_server.h"
 #include "server_message_handler.h"
 #include "vk_rt_dispatch.h"
@@ -142,16 +141,8 @@ inline uintptr_t DataKey(const void* object) { return (uintptr_t)(*(void**)objec
 
 namespace
 {
-// Generally we expect to get the same device and instance, so we keep them
-// handy
-static thread_local InstanceData* last_used_instance_data = nullptr;
-static thread_local DeviceData* last_used_device_data = nullptr;
-
-std::mutex g_instance_mutex;
-std::unordered_map<uintptr_t, std::unique_ptr<InstanceData>> g_instance_data;
-
-std::mutex g_device_mutex;
-std::unordered_map<uintptr_t, std::unique_ptr<DeviceData>> g_device_data;
+DispatchKeyMap<InstanceData> g_instance_data;
+DispatchKeyMap<DeviceData> g_device_data;
 
 constexpr VkLayerProperties layer_properties = {
     "VK_LAYER_Dive", VK_MAKE_VERSION(1, 0, VK_HEADER_VERSION), 1, "Dive capture layer for xr."};
@@ -167,29 +158,9 @@ static constexpr std::array<VkExtensionProperties, 1> device_extensions{{
 
 }  // namespace
 
-InstanceData* GetInstanceLayerData(uintptr_t key)
-{
-    if (last_used_instance_data && DataKey(last_used_instance_data->instance) == key)
-    {
-        return last_used_instance_data;
-    }
+InstanceData* GetInstanceLayerData(uintptr_t key) { return g_instance_data.Find(key); }
 
-    std::lock_guard<std::mutex> lock(g_instance_mutex);
-    last_used_instance_data = g_instance_data[key].get();
-    return last_used_instance_data;
-}
-
-DeviceData* GetDeviceLayerData(uintptr_t key)
-{
-    if (last_used_device_data && DataKey(last_used_device_data->device) == key)
-    {
-        return last_used_device_data;
-    }
-
-    std::lock_guard<std::mutex> lock(g_device_mutex);
-    last_used_device_data = g_device_data[key].get();
-    return last_used_device_data;
-}
+DeviceData* GetDeviceLayerData(uintptr_t key) { return g_device_data.Find(key); }
 
 struct VkStruct
 {
@@ -600,11 +571,7 @@ VkResult DiveInterceptCreateInstance(const VkInstanceCreateInfo* pCreateInfo,
     id->instance = *pInstance;
     InitInstanceDispatchTable(*pInstance, pfn_get_instance_proc_addr, &id->dispatch_table);
 
-    {
-        std::lock_guard<std::mutex> lock(g_instance_mutex);
-        auto key = (uintptr_t)(*(void**)(*pInstance));
-        g_instance_data[key] = std::move(id);
-    }
+    g_instance_data.Insert(DataKey(*pInstance), std::move(id));
 
     LayerManager& layer_manager = LayerManager::Get();
     layer_manager.MarkLayerReady();
@@ -612,6 +579,15 @@ VkResult DiveInterceptCreateInstance(const VkInstanceCreateInfo* pCreateInfo,
     return result;
 }
 
+void DiveInterceptDestroyInstance(VkInstance instance, const VkAllocationCallbacks* pAllocator)
+{
+    // The key is read from the instance, so it must be taken before the instance is destroyed
+    uintptr_t key = DataKey(instance);
+    auto instance_data = GetInstanceLayerData(key);
+    instance_data->dispatch_table.DestroyInstance(instance, pAllocator);
+    g_instance_data.Erase(key);
+}
+
 VkResult DiveInterceptCreateDevice(VkPhysicalDevice gpu, const VkDeviceCreateInfo* pCreateInfo,
                                    const VkAllocationCallbacks* pAllocator, VkDevice* pDevice)
 {
@@ -663,11 +639,7 @@ VkResult DiveInterceptCreateDevice(VkPhysicalDevice gpu, const VkDeviceCreateInf
     dd->device = *pDevice;
     InitDeviceDispatchTable(*pDevice, pfn_next_device_proc_addr, &dd->dispatch_table);
 
-    {
-        std::lock_guard<std::mutex> lock(g_device_mutex);
-        auto key = (uintptr_t)(*(void**)(*pDevice));
-        g_device_data[key] = std::move(dd);
-    }
+    g_device_data.Insert(DataKey(*pDevice), std::move(dd));
 
     return result;
 }
@@ -676,9 +648,12 @@ void DiveInterceptDestroyDevice(VkDevice device, const VkAllocationCallbacks* pA
 {
     PFN_vkDestroyDevice pfn = nullptr;
 
-    auto layer_data = GetDeviceLayerData(DataKey(device));
+    // The key is read from the device, so it must be taken before the device is destroyed
+    uintptr_t key = DataKey(device);
+    auto layer_data = GetDeviceLayerData(key);
     pfn = layer_data->dispatch_table.DestroyDevice;
-    return sDiveRuntimeLayer.DestroyDevice(pfn, device, pAllocator);
+    sDiveRuntimeLayer.DestroyDevice(pfn, device, pAllocator);
+    g_device_data.Erase(key);
 }
 
 void DiveInterceptCmdInsertDebugUtilsLabel(VkCommandBuffer commandBuffer,
@@ -1117,6 +1092,9 @@ extern "C"
             return (PFN_vkVoidFunction)&DiveInterceptCreateInstance;
         if (inst == VK_NULL_HANDLE) return NULL;
 
+        if (0 == strcmp(func, "vkDestroyInstance"))
+            return (PFN_vkVoidFunction)&DiveInterceptDestroyInstance;
+
         // This is required since sometimes vkGetInstanceProcAddr is called for
         // vkCmdInsertDebugUtilsLabelEXT even it is a device func
         if (0 == strcmp(func, "vkCmdInsertDebugUtilsLabelEXT"))
@@ -696,6 +696,17 @@ VkResult DiveRuntimeLayer::AcquireNextImageKHR(PFN_vkAcquireNextImageKHR pfn, Vk
 VkResult DiveRuntimeLayer::QueueSubmit(PFN_vkQueueSubmit pfn, VkQueue queue, uint32_t submitCount,
                                        const VkSubmitInfo* pSubmits, VkFence fence)
 {
+    if (sEnableGPUTiming)
+    {
+        auto status =
+            m_gpu_time.OnBeforeQueueSubmit(submitCount, pSubmits, m_pfn_vkDeviceWaitIdle,
+                                           m_pfn_vkResetQueryPool, m_pfn_vkGetQueryPoolResults);
+        if (!status.success)
+        {
+            LOGE("%s", status.message.c_str());
+        }
+    }
+
     VkResult result = pfn(queue, submitCount, pSubmits, fence);
 
     if (result != VK_SUCCESS)
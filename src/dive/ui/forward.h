@@ -44,10 +44,12 @@ namespace Dive
 {
 
 class AvailableMetrics;
+class CommandHierarchy;
 class DataCore;
 class TraceStats;
 
 struct CaptureStats;
+struct CommandHierarchyChunk;
 struct ComponentFilePaths;
 
 }  // namespace Dive
@@ -26,7 +26,8 @@
 GFXRECON_BEGIN_NAMESPACE(gfxrecon)
 GFXRECON_BEGIN_NAMESPACE(decode)
 
-DecodeAllocator* DecodeAllocator::instance_{ nullptr };
+// GOOGLE: [parallel-load] One allocator per thread
+thread_local DecodeAllocator* DecodeAllocator::instance_{ nullptr };
 
 void DecodeAllocator::Begin()
 {
@@ -63,7 +63,9 @@ class DecodeAllocator
 
   private:
     static const size_t     kAllocatorBlockSize{ 64 * 1024 };
-    static DecodeAllocator* instance_;
+    // GOOGLE: [parallel-load] One allocator per thread, so that several file processors can decode
+    // blocks concurrently. DestroyInstance only destroys the allocator of the calling thread.
+    static thread_local DecodeAllocator* instance_;
 
     util::MonotonicAllocator allocator_;
     bool                     can_allocate_;
@@ -360,6 +360,53 @@ bool FileProcessor::ProcessBlocks()
     return success;
 }
 
+// GOOGLE: [lazy-args] Re-decode a single block at a known offset
+bool FileProcessor::ProcessBlockAtOffset(int64_t offset, uint64_t block_index)
+{
+    if (file_stack_.empty())
+    {
+        return false;
+    }
+
+    // GOOGLE: [parallel-load] Blocks are often decoded one after the other, so avoid dropping the
+    // read buffer with a seek when already there
+    if ((file_stack_.back().active_file->FileTell() != offset) &&
+        !SeekActiveFile(offset, util::platform::FileSeekSet))
+    {
+        return false;
+    }
+
+    BlockParser& block_parser = GetBlockParser();
+    BlockBuffer  block_buffer;
+    if (!ReadBlockBuffer(block_parser, block_buffer))
+    {
+        return false;
+    }
+
+    block_index_ = block_index;
+    for (auto decoder : decoders_)
+    {
+        decoder->SetCurrentBlockIndex(block_index_);
+    }
+
+    block_parser.SetBlockIndex(block_index_);
+    block_parser.SetFrameNumber(current_frame_number_);
+    ParsedBlock parsed_block = block_parser.ParseBlock(block_buffer);
+    if (!parsed_block.IsVisitable())
+    {
+        // NOTE: Warnings for unknown/invalid blocks are handled in the BlockParser
+        return true;
+    }
+    if (!parsed_block.Decompress(block_parser))
+    {
+        return false;
+    }
+
+    DispatchVisitor dispatch_visitor(decoders_, annotation_handler_);
+    std::visit(dispatch_visitor, parsed_block.GetArgs());
+    return true;
+}
+
 // While ReadBlockBuffer both reads the block header and the block body, checks for
 // the correct sizing of the block payload are done by the caller
 bool FileProcessor::ReadBlockBuffer(BlockParser& parser, BlockBuffer& block_buffer)
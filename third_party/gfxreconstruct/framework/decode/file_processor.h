@@ -128,6 +128,13 @@ class FileProcessor
     // Returns false if processing failed.  Use GetErrorState() to determine error condition for failure case.
     bool ProcessAllFrames();
 
+    // GOOGLE: [lazy-args] Decode the single block starting at the given offset of the active file and dispatch it to
+    // the decoders as the block with the given index, without any of the frame/state processing of ProcessBlocks.
+    // Used to decode the arguments of a command again after the whole file has been processed once.
+    // GOOGLE: [parallel-load] Like ProcessBlocks, blocks that can't be visited are skipped, and only read and
+    // decompression errors fail.
+    bool ProcessBlockAtOffset(int64_t offset, uint64_t block_index);
+
     const std::vector<format::FileOptionPair>& GetFileOptions() const { return file_options_; }
 
     uint64_t GetCurrentFrameNumber() const { return current_frame_number_; }
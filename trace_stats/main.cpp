@@ -14,6 +14,7 @@
  limitations under the License.
 */
 #include <array>
+#include <cstring>
 #include <iostream>
 #include <numeric>
 #include <optional>
@@ -22,6 +23,7 @@
 #include <vector>
 
 #include "dive/types/context.h"
+#include "dive_core/capture_metadata_cache.h"
 #include "dive_core/data_core.h"
 #include "pm4_info.h"
 #include "trace_stats.h"
@@ -31,10 +33,27 @@ int main(int argc, char** argv)
     Pm4InfoInit();
 
     // Handle args
+    bool use_shader_cache = true;
+    bool use_metadata_cache = true;
+    for (; argc > 1; --argc, ++argv)
+    {
+        if (strcmp(argv[1], "--no_shader_cache") == 0)
+        {
+            use_shader_cache = false;
+        }
+        else if (strcmp(argv[1], "--no_metadata_cache") == 0)
+        {
+            use_metadata_cache = false;
+        }
+        else
+        {
+            break;
+        }
+    }
     if ((argc != 2) && (argc != 3))
     {
-        std::cout << "You need to call: lrz_validator <input_file_name.rd> "
-                     "<output_details_file_name.txt>(optional)";
+        std::cout << "You need to call: trace_stats [--no_shader_cache] [--no_metadata_cache] "
+                     "<input_file_name.rd> <output_details_file_name.txt>(optional)";
         return 0;
     }
     char* input_file_name = argv[1];
@@ -47,6 +66,18 @@ int main(int argc, char** argv)
 
     // Load capture
     std::unique_ptr<Dive::DataCore> data_core = std::make_unique<Dive::DataCore>();
+    // Reuse the disassembly of shaders seen in previous runs, since disassembling them is most of
+    // the time spent gathering the stats
+    if (use_shader_cache)
+    {
+        data_core->SetShaderCacheDirectory(Dive::ShaderDisassemblyCache::GetDefaultDirectory());
+    }
+    // Reuse the metadata parsed in previous runs of the same capture, which is only kept when the
+    // command hierarchy is parsed along with it
+    if (use_metadata_cache)
+    {
+        data_core->SetMetadataCacheDirectory(Dive::CaptureMetadataCache::GetDefaultDirectory());
+    }
     Dive::CaptureData::LoadResult load_res = data_core->LoadPm4CaptureData(input_file_name);
     if (load_res != Dive::CaptureData::LoadResult::kSuccess)
     {
@@ -56,7 +87,7 @@ int main(int argc, char** argv)
     std::cout << "Capture file \"" << input_file_name << "\" is loaded!\n";
 
     // Create meta data
-    if (!data_core->CreatePm4MetaData())
+    if (use_metadata_cache ? !data_core->ParsePm4CaptureData() : !data_core->CreatePm4MetaData())
     {
         std::cout << "Failed to create meta data!";
         return 0;
@@ -51,7 +51,11 @@ LoadFileResult::Status ToLoadFileStatus(Dive::CaptureData::LoadResult result)
 }
 }  // namespace
 
-void CaptureFileManager::RegisterCustomMetaType() { qRegisterMetaType<LoadFileResult>(); }
+void CaptureFileManager::RegisterCustomMetaType()
+{
+    qRegisterMetaType<LoadFileResult>();
+    qRegisterMetaType<std::shared_ptr<const Dive::CommandHierarchyChunk>>();
+}
 
 CaptureFileManager::CaptureFileManager(QObject* parent) : QObject(parent)
 {
@@ -59,6 +63,8 @@ CaptureFileManager::CaptureFileManager(QObject* parent) : QObject(parent)
                      &CaptureFileManager::OnLoadFileDone);
     QObject::connect(this, &CaptureFileManager::GatherTraceStatsDone, this,
                      &CaptureFileManager::OnGatherTraceStatsDone);
+    QObject::connect(this, &CaptureFileManager::CommandHierarchyChunkDone, this,
+                     &CaptureFileManager::OnCommandHierarchyChunkDone);
 }
 
 CaptureFileManager::~CaptureFileManager()
@@ -69,6 +75,7 @@ CaptureFileManager::~CaptureFileManager()
     }
     m_thread->quit();
     m_thread->wait();
+    m_data_core->SetCommandHierarchyChunkCallback(nullptr);
 }
 
 void CaptureFileManager::Start(const std::shared_ptr<Dive::DataCore>& data_core)
@@ -79,6 +86,11 @@ void CaptureFileManager::Start(const std::shared_ptr<Dive::DataCore>& data_core)
     }
     m_data_core = data_core;
     m_capture_stats = std::make_unique<Dive::CaptureStats>();
+    // Called on the worker thread, so the chunk is passed to the main thread through a signal
+    m_data_core->SetCommandHierarchyChunkCallback(
+        [this](std::shared_ptr<const Dive::CommandHierarchyChunk> chunk) {
+            emit CommandHierarchyChunkDone(std::move(chunk));
+        });
 
     m_thread = new QThread(parent());
     m_worker = new QObject;
@@ -114,6 +126,17 @@ void CaptureFileManager::OnLoadFileDone(const LoadFileResult& loaded_file)
     emit FileLoadingFinished(loaded_file);
 }
 
+void CaptureFileManager::OnCommandHierarchyChunkDone(
+    std::shared_ptr<const Dive::CommandHierarchyChunk> chunk)
+{
+    if (m_pending_request)
+    {
+        // Discard it since the file it is from is about to be replaced.
+        return;
+    }
+    emit CommandHierarchyChunkLoaded(std::move(chunk));
+}
+
 Dive::ComponentFilePaths CaptureFileManager::ResolveComponents(const Dive::FilePath& reference)
 {
     if (Dive::IsGfxrFile(reference.value))
@@ -29,6 +29,7 @@ namespace Dive
 {
 class DataCore;
 struct CaptureStats;
+struct CommandHierarchyChunk;
 struct ComponentFilePaths;
 }  // namespace Dive
 
@@ -92,14 +93,19 @@ class CaptureFileManager : public QObject
  signals:
     void FileLoadingFinished(const LoadFileResult&);
     void TraceStatsUpdated();
+    // The nodes of the submits parsed since the previous chunk, while a capture with PM4 data is
+    // being loaded. They can be read while the data core is locked for loading
+    void CommandHierarchyChunkLoaded(std::shared_ptr<const Dive::CommandHierarchyChunk>);
 
     // private:
     void GatherTraceStatsDone();
     void LoadFileDone(const LoadFileResult&);
+    void CommandHierarchyChunkDone(std::shared_ptr<const Dive::CommandHierarchyChunk>);
 
  private slots:
     void OnGatherTraceStatsDone();
     void OnLoadFileDone(const LoadFileResult&);
+    void OnCommandHierarchyChunkDone(std::shared_ptr<const Dive::CommandHierarchyChunk>);
 
  private:
     struct LoadFileRequest
@@ -133,3 +139,4 @@ class CaptureFileManager : public QObject
 };
 
 Q_DECLARE_METATYPE(LoadFileResult)
+Q_DECLARE_METATYPE(std::shared_ptr<const Dive::CommandHierarchyChunk>)
@@ -132,7 +132,7 @@ QVariant CommandBufferModel::data(const QModelIndex& index, int role) const
                            << ")";
         return QString::fromStdString(addr_string_stream.str());
 #else
-        return QString(m_command_hierarchy.GetNodeDesc(node_index));
+        return QString::fromStdString(m_command_hierarchy.GetNodeDesc(node_index));
 #endif
     }
 }
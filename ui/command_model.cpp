@@ -20,6 +20,7 @@
 #include <QTreeWidget>
 
 #include "dive_core/command_hierarchy.h"
+#include "dive_core/node_search_index.h"
 #include "ui/color_utils.h"
 
 static_assert(sizeof(void*) == sizeof(uint64_t),
@@ -29,35 +30,83 @@ static_assert(sizeof(void*) == sizeof(uint64_t),
 // CommandModel
 // =================================================================================================
 CommandModel::CommandModel(const Dive::CommandHierarchy& command_hierarchy)
-    : m_command_hierarchy(command_hierarchy)
+    : m_command_hierarchy(&command_hierarchy)
 {
     m_topology_ptr = nullptr;
 }
 
 //--------------------------------------------------------------------------------------------------
-CommandModel::~CommandModel() {}
+CommandModel::~CommandModel() { StopBuildingSearchIndex(); }
 
 //--------------------------------------------------------------------------------------------------
 void CommandModel::Reset()
 {
+    StopBuildingSearchIndex();
     emit beginResetModel();
     m_topology_ptr = nullptr;
     emit endResetModel();
 }
 
 //--------------------------------------------------------------------------------------------------
-void CommandModel::BeginResetModel() { emit beginResetModel(); }
+void CommandModel::BeginResetModel()
+{
+    StopBuildingSearchIndex();
+    emit beginResetModel();
+}
 
 //--------------------------------------------------------------------------------------------------
 void CommandModel::EndResetModel() { emit endResetModel(); }
 
 //--------------------------------------------------------------------------------------------------
-void CommandModel::SetTopologyToView(const Dive::SharedNodeTopology* topology_ptr)
+void CommandModel::SetTopologyToView(const Dive::SharedNodeTopology* topology_ptr,
+                                     bool build_search_index)
 {
     BeginResetModel();
     m_topology_ptr = topology_ptr;
-    m_node_lookup.clear();
     EndResetModel();
+    if (build_search_index) StartBuildingSearchIndex();
+}
+
+//--------------------------------------------------------------------------------------------------
+void CommandModel::SetCommandHierarchy(const Dive::CommandHierarchy& command_hierarchy)
+{
+    BeginResetModel();
+    m_command_hierarchy = &command_hierarchy;
+    m_topology_ptr = nullptr;
+    EndResetModel();
+}
+
+//--------------------------------------------------------------------------------------------------
+void CommandModel::AppendChunk(Dive::CommandHierarchy& command_hierarchy,
+                               const Dive::CommandHierarchyChunk& chunk)
+{
+    // Inserts the rows of each node that gets new children, rather than changing the layout of the
+    // whole model, which would have the filter model map every node again
+    class RowInserter : public Dive::ChunkAppendListener
+    {
+     public:
+        explicit RowInserter(CommandModel& model) : m_model(model) {}
+
+        void BeginAppendChildren(uint64_t node_index, uint64_t first_child_index,
+                                 uint64_t num_children) override
+        {
+            // The root node isn't shown, so its children are at the root level of the model
+            QModelIndex parent = (node_index == Dive::Topology::kRootNodeIndex)
+                                     ? QModelIndex()
+                                     : m_model.findNode(node_index);
+            m_model.beginInsertRows(parent, first_child_index,
+                                    first_child_index + num_children - 1);
+        }
+        void EndAppendChildren() override { m_model.endInsertRows(); }
+
+     private:
+        CommandModel& m_model;
+    };
+
+    // The search index would miss the appended nodes
+    StopBuildingSearchIndex();
+    RowInserter row_inserter(*this);
+    command_hierarchy.AppendChunk(chunk, &row_inserter);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -71,12 +120,12 @@ QVariant CommandModel::data(const QModelIndex& index, int role) const
     {
         if (index.column() == 0)
         {
-            Dive::NodeType node_type = m_command_hierarchy.GetNodeType(node_index);
+            Dive::NodeType node_type = m_command_hierarchy->GetNodeType(node_index);
 
             if (node_type == Dive::NodeType::kMarkerNode)
             {
                 Dive::CommandHierarchy::MarkerType marker_type =
-                    m_command_hierarchy.GetMarkerNodeType(node_index);
+                    m_command_hierarchy->GetMarkerNodeType(node_index);
                 if (marker_type == Dive::CommandHierarchy::MarkerType::kInsert ||
                     marker_type == Dive::CommandHierarchy::MarkerType::kBeginEnd)
                 {
@@ -92,11 +141,11 @@ QVariant CommandModel::data(const QModelIndex& index, int role) const
     // 2nd column shows event id (will be swapped via moveSection() to be visually the 1st column)
     if (index.column() == 1)
     {
-        return GetNodeUIId(node_index, m_command_hierarchy, m_topology_ptr);
+        return GetNodeUIId(node_index, *m_command_hierarchy, m_topology_ptr);
     }
 
     // 1st column
-    return QString(m_command_hierarchy.GetNodeDesc(node_index));
+    return QString::fromStdString(m_command_hierarchy->GetNodeDesc(node_index));
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -112,7 +161,8 @@ QVariant CommandModel::headerData(int section, Qt::Orientation orientation, int
 {
     if (orientation == Qt::Horizontal && role == Qt::DisplayRole)
     {
-        if (section == 1 && (m_topology_ptr == &m_command_hierarchy.GetAllEventHierarchyTopology()))
+        if (section == 1 &&
+            (m_topology_ptr == &m_command_hierarchy->GetAllEventHierarchyTopology()))
         {
             return QString(tr("Event"));
         }
@@ -174,17 +224,20 @@ int CommandModel::rowCount(const QModelIndex& parent) const
 //--------------------------------------------------------------------------------------------------
 int CommandModel::columnCount(const QModelIndex& parent) const
 {
-    if (m_topology_ptr == &m_command_hierarchy.GetAllEventHierarchyTopology()) return 2;
+    if (m_topology_ptr == &m_command_hierarchy->GetAllEventHierarchyTopology()) return 2;
     return 1;
 }
 
 //--------------------------------------------------------------------------------------------------
 QModelIndex CommandModel::findNode(uint64_t node_index) const
 {
-    if (m_node_lookup.size() != m_command_hierarchy.size()) BuildNodeLookup();
-    if (node_index < m_command_hierarchy.size() && m_node_lookup[node_index].isValid())
-        return m_node_lookup[node_index];
-    return QModelIndex();
+    // The row of a node is its index among the children of its parent in the topology, so the index
+    // is created directly instead of walking the model. The root and the nodes that are not in the
+    // topology have no parent
+    if (m_topology_ptr == nullptr || node_index >= m_topology_ptr->GetNumNodes() ||
+        m_topology_ptr->GetParentNodeIndex(node_index) == UINT64_MAX)
+        return QModelIndex();
+    return createIndex(m_topology_ptr->GetChildIndex(node_index), 0, node_index);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -204,25 +257,6 @@ char CommandModel::GetEventNodeStream(uint64_t node_index) const { return '\0';
 //--------------------------------------------------------------------------------------------------
 uint32_t CommandModel::GetEventNodeIndexInStream(uint64_t node_index) const { return UINT32_MAX; }
 
-//--------------------------------------------------------------------------------------------------
-void CommandModel::BuildNodeLookup(const QModelIndex& parent) const
-{
-    if (!parent.isValid())
-    {
-        m_node_lookup.clear();
-        m_node_lookup.resize(m_command_hierarchy.size());
-    }
-    int n = rowCount(parent);
-    for (int r = 0; r < n; ++r)
-    {
-        auto idx = index(r, 0, parent);
-        uint64_t node_index = idx.internalId();
-        if (node_index < m_node_lookup.size())
-            m_node_lookup[node_index] = QPersistentModelIndex(idx);
-        BuildNodeLookup(idx);
-    }
-}
-
 //--------------------------------------------------------------------------------------------------
 QList<QModelIndex> CommandModel::search(const QModelIndex& start, const QVariant& value) const
 {
@@ -251,3 +285,39 @@ QList<QModelIndex> CommandModel::search(const QModelIndex& start, const QVariant
 
     return result;
 }
+
+//--------------------------------------------------------------------------------------------------
+std::shared_ptr<const Dive::NodeSearchIndex> CommandModel::GetSearchIndex() const
+{
+    std::lock_guard<std::mutex> lock(m_search_index_mutex);
+    return m_search_index;
+}
+
+//--------------------------------------------------------------------------------------------------
+void CommandModel::StartBuildingSearchIndex()
+{
+    StopBuildingSearchIndex();
+    if (m_topology_ptr == nullptr) return;
+
+    m_cancel_search_index = false;
+    const Dive::CommandHierarchy* command_hierarchy = m_command_hierarchy;
+    const Dive::SharedNodeTopology* topology_ptr = m_topology_ptr;
+    m_search_index_thread = std::thread([this, command_hierarchy, topology_ptr]() {
+        auto search_index = std::make_shared<Dive::NodeSearchIndex>();
+        if (search_index->Build(*command_hierarchy, *topology_ptr, &m_cancel_search_index))
+        {
+            std::lock_guard<std::mutex> lock(m_search_index_mutex);
+            m_search_index = std::move(search_index);
+        }
+    });
+}
+
+//--------------------------------------------------------------------------------------------------
+void CommandModel::StopBuildingSearchIndex()
+{
+    m_cancel_search_index = true;
+    if (m_search_index_thread.joinable()) m_search_index_thread.join();
+
+    std::lock_guard<std::mutex> lock(m_search_index_mutex);
+    m_search_index = nullptr;
+}
@@ -20,11 +20,17 @@
 #include <QList>
 #include <QModelIndex>
 #include <QVariant>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 // Forward Declarations
 namespace Dive
 {
 class CommandHierarchy;
+struct CommandHierarchyChunk;
+class NodeSearchIndex;
 class SharedNodeTopology;
 };  // namespace Dive
 
@@ -46,7 +52,20 @@ class CommandModel : public QAbstractItemModel
     void Reset();
     void BeginResetModel();
     void EndResetModel();
-    void SetTopologyToView(const Dive::SharedNodeTopology* topology_ptr);
+    // Builds the search index of the topology, unless it is still being appended to (see
+    // AppendChunk())
+    void SetTopologyToView(const Dive::SharedNodeTopology* topology_ptr,
+                           bool build_search_index = true);
+
+    // Switch to another command hierarchy, such as the one displayed while a capture is loading.
+    // Resets the model, so the topology must be set again
+    void SetCommandHierarchy(const Dive::CommandHierarchy& command_hierarchy);
+
+    // Append a chunk to the command hierarchy being viewed, whose all-event topology must be the
+    // one being viewed. The new children of the shown nodes are inserted as rows after the existing
+    // ones, so views keep their expanded and selected nodes
+    void AppendChunk(Dive::CommandHierarchy& command_hierarchy,
+                     const Dive::CommandHierarchyChunk& chunk);
 
     QVariant data(const QModelIndex& index, int role) const override;
     Qt::ItemFlags flags(const QModelIndex& index) const override;
@@ -57,6 +76,7 @@ class CommandModel : public QAbstractItemModel
     QModelIndex parent(const QModelIndex& index) const override;
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    // Returns an invalid index if the node is not in the topology being viewed
     QModelIndex findNode(uint64_t node_index) const;
 
     static QVariant GetNodeUIId(uint64_t node_index,
@@ -65,6 +85,14 @@ class CommandModel : public QAbstractItemModel
 
     QList<QModelIndex> search(const QModelIndex& start, const QVariant& value) const;
 
+    // The search index of the topology being viewed is built on a worker thread. This returns
+    // nullptr until it is ready
+    std::shared_ptr<const Dive::NodeSearchIndex> GetSearchIndex() const;
+
+    // Must be called before the command hierarchy is modified, since building the search index
+    // reads it
+    void StopBuildingSearchIndex();
+
  private:
     enum class UIBarrierIdVariant
     {
@@ -75,9 +103,13 @@ class CommandModel : public QAbstractItemModel
     bool EventNodeHasMarker(uint64_t node_index) const;
     char GetEventNodeStream(uint64_t node_index) const;
     uint32_t GetEventNodeIndexInStream(uint64_t node_index) const;
-    void BuildNodeLookup(const QModelIndex& parent = QModelIndex()) const;
+    void StartBuildingSearchIndex();
 
-    const Dive::CommandHierarchy& m_command_hierarchy;
+    const Dive::CommandHierarchy* m_command_hierarchy;
     const Dive::SharedNodeTopology* m_topology_ptr = nullptr;
-    mutable std::vector<QPersistentModelIndex> m_node_lookup;
+
+    mutable std::mutex m_search_index_mutex;
+    std::shared_ptr<const Dive::NodeSearchIndex> m_search_index;
+    std::thread m_search_index_thread;
+    std::atomic<bool> m_cancel_search_index = false;
 };
@@ -28,6 +28,7 @@
 #include "command_model.h"
 #include "dive_core/command_hierarchy.h"
 #include "dive_core/common/common.h"
+#include "dive_core/node_search_index.h"
 #include "gfxr_vulkan_command_arguments_filter_proxy_model.h"
 #include "gfxr_vulkan_command_filter_proxy_model.h"
 #include "gfxr_vulkan_command_model.h"
@@ -39,10 +40,15 @@ static constexpr uint64_t kInvalidNodeIndex = static_cast<uint64_t>(-1);
 // DiveFilterModel
 // =================================================================================================
 DiveFilterModel::DiveFilterModel(const Dive::CommandHierarchy& command_hierarchy, QObject* parent)
-    : QSortFilterProxyModel(parent), m_command_hierarchy(command_hierarchy)
+    : QSortFilterProxyModel(parent), m_command_hierarchy(&command_hierarchy)
 {
 }
 
+void DiveFilterModel::SetCommandHierarchy(const Dive::CommandHierarchy& command_hierarchy)
+{
+    m_command_hierarchy = &command_hierarchy;
+}
+
 void DiveFilterModel::applyNewFilterMode(FilterMode new_mode)
 {
     // Check if the mode is actually changing to avoid unnecessary resets
@@ -84,7 +90,7 @@ bool DiveFilterModel::IncludeIndex(uint64_t node_index) const
     }
 
     const auto& filter_exclude_indices =
-        m_command_hierarchy.GetFilterExcludeIndices(filter_list_type);
+        m_command_hierarchy->GetFilterExcludeIndices(filter_list_type);
 
     // If the node index is in the exclude list, we exclude the index.
     if (filter_exclude_indices.find(node_index) != filter_exclude_indices.end())
@@ -121,13 +127,13 @@ void DiveFilterModel::CollectPm4DrawCallIndices(const QModelIndex& parent_index)
         if (index.isValid())
         {
             uint64_t node_index = index.internalId();
-            Dive::NodeType node_type = m_command_hierarchy.GetNodeType(node_index);
+            Dive::NodeType node_type = m_command_hierarchy->GetNodeType(node_index);
 
             if (node_type == Dive::NodeType::kEventNode)
             {
-                Dive::Util::EventType type = m_command_hierarchy.GetEventNodeType(node_index);
+                Dive::Util::EventType type = m_command_hierarchy->GetEventNodeType(node_index);
                 bool is_correlation_ignored =
-                    m_command_hierarchy.IsEventNodeIgnoredDuringCorrelation(node_index);
+                    m_command_hierarchy->IsEventNodeIgnoredDuringCorrelation(node_index);
                 bool is_draw_or_dispatch = (type == Dive::Util::EventType::kDraw ||
                                             type == Dive::Util::EventType::kDispatch);
                 if (is_draw_or_dispatch && !is_correlation_ignored)
@@ -152,7 +158,7 @@ bool DiveFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceP
     QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
     uint64_t node_index = index.internalId();
 
-    Dive::NodeType current_node_type = m_command_hierarchy.GetNodeType(node_index);
+    Dive::NodeType current_node_type = m_command_hierarchy->GetNodeType(node_index);
 
     if (current_node_type == Dive::NodeType::kGfxrVulkanSubmitNode)
     {
@@ -267,8 +273,8 @@ void DiveTreeViewDelegate::paint(QPainter* painter, const QStyleOptionViewItem&
         QStyleOptionViewItem options = option;
         initStyleOption(&options, index);
 
-        options.text =
-            QString(m_dive_tree_view_ptr->GetCommandHierarchy().GetNodeDesc(source_node_index));
+        options.text = QString::fromStdString(
+            m_dive_tree_view_ptr->GetCommandHierarchy().GetNodeDesc(source_node_index));
 
         // Call to the base class function is needed to handle hover effects correctly
         if (options.state & QStyle::State_MouseOver || options.state & QStyle::State_Selected)
@@ -297,7 +303,7 @@ QSize DiveTreeViewDelegate::sizeHint(const QStyleOptionViewItem& option,
 // DiveTreeView
 // =================================================================================================
 DiveTreeView::DiveTreeView(const Dive::CommandHierarchy& command_hierarchy, QWidget* parent)
-    : QTreeView(parent), m_command_hierarchy(command_hierarchy)
+    : QTreeView(parent), m_command_hierarchy(&command_hierarchy)
 {
     setHorizontalScrollBar(new QScrollBar);
     horizontalScrollBar()->setEnabled(true);
@@ -309,6 +315,9 @@ DiveTreeView::DiveTreeView(const Dive::CommandHierarchy& command_hierarchy, QWid
     setAccessibleName("DiveCommandHierarchy");
 }
 
+//--------------------------------------------------------------------------------------------------
+DiveTreeView::~DiveTreeView() { StopIndexedSearch(); }
+
 //--------------------------------------------------------------------------------------------------
 bool DiveTreeView::RenderBranch(const QModelIndex& index) const { return true; }
 
@@ -461,10 +470,10 @@ QModelIndex DiveTreeView::GetProxyModelIndexFromSource(const QModelIndex& source
 void DiveTreeView::expandNode(const QModelIndex& index)
 {
     uint64_t node_index = GetNodeSourceIndex(index);
-    if (m_command_hierarchy.GetNodeType(node_index) == Dive::NodeType::kMarkerNode)
+    if (m_command_hierarchy->GetNodeType(node_index) == Dive::NodeType::kMarkerNode)
     {
         Dive::CommandHierarchy::MarkerType marker_type =
-            m_command_hierarchy.GetMarkerNodeType(node_index);
+            m_command_hierarchy->GetMarkerNodeType(node_index);
         if (marker_type == Dive::CommandHierarchy::MarkerType::kBeginEnd)
         {
             emit labelExpanded(node_index);
@@ -476,10 +485,10 @@ void DiveTreeView::expandNode(const QModelIndex& index)
 void DiveTreeView::collapseNode(const QModelIndex& index)
 {
     uint64_t node_index = GetNodeSourceIndex(index);
-    if (m_command_hierarchy.GetNodeType(node_index) == Dive::NodeType::kMarkerNode)
+    if (m_command_hierarchy->GetNodeType(node_index) == Dive::NodeType::kMarkerNode)
     {
         Dive::CommandHierarchy::MarkerType marker_type =
-            m_command_hierarchy.GetMarkerNodeType(node_index);
+            m_command_hierarchy->GetMarkerNodeType(node_index);
         if (marker_type == Dive::CommandHierarchy::MarkerType::kBeginEnd)
         {
             emit labelCollapsed(node_index);
@@ -530,12 +539,12 @@ void DiveTreeView::GotoEvent(bool is_above)
         }
 
         uint64_t node_idx = source_node_idx.internalId();
-        auto node_type = m_command_hierarchy.GetNodeType(node_idx);
+        auto node_type = m_command_hierarchy->GetNodeType(node_idx);
 
         // Check for Draw/Dispatch/Blit or relevant Marker
         if (node_type == Dive::NodeType::kEventNode ||
             (node_type == Dive::NodeType::kMarkerNode &&
-             m_command_hierarchy.GetMarkerNodeType(node_idx) !=
+             m_command_hierarchy->GetMarkerNodeType(node_idx) !=
                  Dive::CommandHierarchy::MarkerType::kBeginEnd) ||
             node_type == Dive::NodeType::kGfxrVulkanDrawCommandNode)
         {
@@ -578,7 +587,14 @@ void DiveTreeView::currentChanged(const QModelIndex& current, const QModelIndex&
 //--------------------------------------------------------------------------------------------------
 const Dive::CommandHierarchy& DiveTreeView::GetCommandHierarchy() const
 {
-    return m_command_hierarchy;
+    return *m_command_hierarchy;
+}
+
+//--------------------------------------------------------------------------------------------------
+void DiveTreeView::SetCommandHierarchy(const Dive::CommandHierarchy& command_hierarchy)
+{
+    StopIndexedSearch();
+    m_command_hierarchy = &command_hierarchy;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -694,11 +710,18 @@ void DiveTreeView::SetAndScrollToNode(QModelIndex& proxy_model_idx)
 //--------------------------------------------------------------------------------------------------
 void DiveTreeView::searchNodeByText(const QString& search_text)
 {
+    StopIndexedSearch();
     m_search_indexes.clear();
     m_search_index_it = m_search_indexes.begin();
 
     if (search_text.isEmpty()) return;
 
+    if (StartIndexedSearch(search_text))
+    {
+        emit updateSearch(0, 0);
+        return;
+    }
+
     // Get the currently active model (which is DiveFilterModel)
     const DiveFilterModel* filter_model = qobject_cast<const DiveFilterModel*>(model());
     if (!filter_model)
@@ -770,6 +793,92 @@ void DiveTreeView::searchNodeByText(const QString& search_text)
                       m_search_indexes.isEmpty() ? 0 : m_search_indexes.size());
 }
 
+//--------------------------------------------------------------------------------------------------
+bool DiveTreeView::StartIndexedSearch(const QString& search_text)
+{
+    // The GFXR models are searched with match() instead
+    CommandModel* command_model = qobject_cast<CommandModel*>(GetCommandModel());
+    if (!command_model) return false;
+
+    std::shared_ptr<const Dive::NodeSearchIndex> search_index = command_model->GetSearchIndex();
+    if (!search_index) return false;
+
+    // The index is kept alive by the worker thread, so it doesn't matter if the model drops it. The
+    // command hierarchy it reads is kept alive by stopping the search before it changes
+    uint64_t search_id = m_search_id;
+    m_cancel_search = false;
+    m_search_thread = std::thread([this, search_index, search_id,
+                                   text = search_text.toStdString()]() {
+        search_index->Search(
+            text,
+            [this, search_id](const std::vector<uint64_t>& node_indices) {
+                QMetaObject::invokeMethod(
+                    this,
+                    [this, search_id, node_indices]() {
+                        OnIndexedSearchResults(search_id, node_indices);
+                    },
+                    Qt::QueuedConnection);
+                return true;
+            },
+            &m_cancel_search);
+    });
+    return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+void DiveTreeView::StopIndexedSearch()
+{
+    m_cancel_search = true;
+    if (m_search_thread.joinable()) m_search_thread.join();
+
+    // Results of the stopped search may still be queued
+    ++m_search_id;
+}
+
+//--------------------------------------------------------------------------------------------------
+void DiveTreeView::OnIndexedSearchResults(uint64_t search_id,
+                                          const std::vector<uint64_t>& node_indices)
+{
+    if (search_id != m_search_id) return;
+
+    CommandModel* command_model = qobject_cast<CommandModel*>(GetCommandModel());
+    if (!command_model) return;
+
+    // Appending to the list invalidates the iterator
+    bool first_results = m_search_indexes.isEmpty();
+    int curr_pos = first_results ? 0 : (m_search_index_it - m_search_indexes.begin());
+    for (uint64_t node_index : node_indices)
+    {
+        // Nodes hidden by the filter have no proxy index
+        QModelIndex proxy_model_idx =
+            GetProxyModelIndexFromSource(command_model->findNode(node_index));
+        if (proxy_model_idx.isValid()) m_search_indexes.append(proxy_model_idx);
+    }
+    if (m_search_indexes.isEmpty()) return;
+    m_search_index_it = m_search_indexes.begin() + curr_pos;
+
+    if (first_results)
+    {
+        // This is a proxy index
+        QModelIndex curr_idx = currentIndex();
+        if (curr_idx.isValid() && curr_idx != *m_search_index_it)
+        {
+            m_search_index_it =
+                m_search_indexes.begin() + GetNearestSearchNode(GetNodeSourceIndex(curr_idx));
+        }
+        QModelIndex proxy_model_idx = *m_search_index_it;
+        SetAndScrollToNode(proxy_model_idx);
+    }
+    emit updateSearch(m_search_index_it - m_search_indexes.begin(), m_search_indexes.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+void DiveTreeView::reset()
+{
+    StopIndexedSearch();
+    QTreeView::reset();
+}
+
 //--------------------------------------------------------------------------------------------------
 void DiveTreeView::nextNodeInSearch()
 {
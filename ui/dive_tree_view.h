@@ -24,6 +24,9 @@
 #include <QSortFilterProxyModel>
 #include <QStyledItemDelegate>
 #include <QTreeView>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 // Forward declarations
 class CommandModel;
@@ -53,6 +56,8 @@ class DiveFilterModel : public QSortFilterProxyModel
     };
 
     DiveFilterModel(const Dive::CommandHierarchy& command_hierarchy, QObject* parent = nullptr);
+    // Must be called while the source model is empty, since filtering reads the command hierarchy
+    void SetCommandHierarchy(const Dive::CommandHierarchy& command_hierarchy);
     bool IncludeIndex(uint64_t node_index) const;
     void SetMode(FilterMode filter_mode);
     void CollectPm4DrawCallIndices(const QModelIndex& parent_index = QModelIndex());
@@ -68,7 +73,7 @@ class DiveFilterModel : public QSortFilterProxyModel
     bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
 
  private:
-    const Dive::CommandHierarchy& m_command_hierarchy;
+    const Dive::CommandHierarchy* m_command_hierarchy;
     FilterMode m_filter_mode = kNone;
     std::vector<uint64_t> m_pm4_draw_call_indices;
 };
@@ -101,10 +106,14 @@ class DiveTreeView : public QTreeView
 
  public:
     DiveTreeView(const Dive::CommandHierarchy& command_hierarchy, QWidget* parent = nullptr);
+    ~DiveTreeView() override;
 
     virtual bool RenderBranch(const QModelIndex& index) const;
 
     const Dive::CommandHierarchy& GetCommandHierarchy() const;
+    // Switch to another command hierarchy, such as the one displayed while a capture is loading.
+    // Must be called while the model is reset, and stops the search in progress
+    void SetCommandHierarchy(const Dive::CommandHierarchy& command_hierarchy);
 
     void RetainCurrentNode();
 
@@ -114,6 +123,9 @@ class DiveTreeView : public QTreeView
 
     uint64_t GetNodeSourceIndex(const QModelIndex& proxy_model_index) const;
 
+    // The search reads the command hierarchy, so it must be stopped before the hierarchy changes
+    void StopIndexedSearch();
+
  public slots:
     void setCurrentNode(uint64_t node_index);
     void expandNode(const QModelIndex& index);
@@ -131,10 +143,13 @@ class DiveTreeView : public QTreeView
     // Ensure the stored current node is reset when the filter mode changes
     void OnFilterModeChanged();
 
+    // Stops the search in progress, whose results refer to the nodes of the model being reset
+    void reset() override;
+
  protected:
     void currentChanged(const QModelIndex& current, const QModelIndex& previous) override;
     void keyPressEvent(QKeyEvent* event) Q_DECL_OVERRIDE;
-    const Dive::CommandHierarchy& m_command_hierarchy;
+    const Dive::CommandHierarchy* m_command_hierarchy;
 
  signals:
     void labelExpanded(uint64_t node_index);
@@ -148,6 +163,11 @@ class DiveTreeView : public QTreeView
     void SetAndScrollToNode(QModelIndex& proxy_model_idx);
     int GetNearestSearchNode(uint64_t source_node_idx);
 
+    // Searches the search index of the command model on a worker thread, if it is ready. Results
+    // are added to m_search_indexes as they are found
+    bool StartIndexedSearch(const QString& search_text);
+    void OnIndexedSearchResults(uint64_t search_id, const std::vector<uint64_t>& node_indices);
+
     QAbstractItemModel* GetCommandModel();
     QModelIndex GetNodeSourceModelIndex(const QModelIndex& proxy_model_index) const;
     QModelIndex GetProxyModelIndexFromSource(const QModelIndex& source_model_index) const;
@@ -156,4 +176,9 @@ class DiveTreeView : public QTreeView
     QList<QModelIndex> m_search_indexes;
     QList<QModelIndex>::Iterator m_search_index_it;
     Dive::DataCore* m_data_core = nullptr;
+
+    std::thread m_search_thread;
+    std::atomic<bool> m_cancel_search = false;
+    // Identifies the latest search, so the results of the previous ones are ignored
+    uint64_t m_search_id = 0;
 };
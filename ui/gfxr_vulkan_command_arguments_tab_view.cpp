@@ -23,11 +23,14 @@
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <iostream>
+#include <optional>
 #include <string>
 
+#include "dive_core/data_core.h"
 #include "dive_core/gfxr_vulkan_command_hierarchy.h"
 #include "gfxr_vulkan_command_arguments_filter_proxy_model.h"
 #include "gfxr_vulkan_command_filter_proxy_model.h"
+#include "gfxr_vulkan_command_model.h"
 #include "object_names.h"
 #include "search_bar.h"
 #include "shortcuts.h"
@@ -36,14 +39,14 @@
 // GfxrVulkanCommandArgumentsTabView
 // =================================================================================================
 GfxrVulkanCommandArgumentsTabView::GfxrVulkanCommandArgumentsTabView(
-    const Dive::CommandHierarchy& vulkan_command_hierarchy,
-    GfxrVulkanCommandArgumentsFilterProxyModel* proxy_model,
-    GfxrVulkanCommandModel* command_hierarchy_model, QWidget* parent)
-    : m_vulkan_command_hierarchy(vulkan_command_hierarchy),
-      m_arg_proxy_model(proxy_model),
-      m_command_hierarchy_model(command_hierarchy_model)
+    const Dive::DataCore& data_core, QWidget* parent)
+    : QFrame(parent), m_data_core(data_core)
 {
-    m_command_hierarchy_view = new DiveTreeView(m_vulkan_command_hierarchy);
+    m_command_hierarchy_model = new GfxrVulkanCommandModel(m_arguments_hierarchy);
+    m_command_hierarchy_model->setParent(this);
+    m_arg_proxy_model =
+        new GfxrVulkanCommandArgumentsFilterProxyModel(this, &m_arguments_hierarchy);
+    m_command_hierarchy_view = new DiveTreeView(m_arguments_hierarchy);
 
     m_arg_proxy_model->setSourceModel(m_command_hierarchy_model);
     m_command_hierarchy_view->setModel(m_arg_proxy_model);
@@ -73,16 +76,10 @@ GfxrVulkanCommandArgumentsTabView::GfxrVulkanCommandArgumentsTabView(
                      SLOT(OnSearchBarVisibilityChange(bool)));
 }
 
-//--------------------------------------------------------------------------------------------------
-void GfxrVulkanCommandArgumentsTabView::SetTopologyToView(const Dive::Topology* topology_ptr)
-{
-    m_command_hierarchy_model->SetTopologyToView(topology_ptr);
-}
-
 //--------------------------------------------------------------------------------------------------
 void GfxrVulkanCommandArgumentsTabView::ResetModel()
 {
-    m_command_hierarchy_model->Reset();
+    ClearArguments();
     // Reset search results
     m_command_hierarchy_view->reset();
     if (m_search_bar->isVisible())
@@ -94,30 +91,39 @@ void GfxrVulkanCommandArgumentsTabView::ResetModel()
 //--------------------------------------------------------------------------------------------------
 void GfxrVulkanCommandArgumentsTabView::OnSelectionChanged(const QModelIndex& index)
 {
-    if (!index.isValid())
+    QModelIndex source_index = index;
+    if (auto* proxy_model = qobject_cast<const QSortFilterProxyModel*>(index.model()))
     {
-        m_arg_proxy_model->SetTargetParentSourceIndex(QModelIndex());
-        return;
+        source_index = proxy_model->mapToSource(index);
     }
 
-    QAbstractItemModel* source_model_ptr = m_command_hierarchy_model;
-    QModelIndex source_index = index;
-
-    if (index.model() != source_model_ptr)
+    const Dive::CommandHierarchy& command_hierarchy = m_data_core.GetCommandHierarchy();
+    std::optional<uint64_t> block_index;
+    if (source_index.isValid())
     {
-        auto* selection_model = qobject_cast<QItemSelectionModel*>(sender());
-        if (selection_model)
-        {
-            auto* proxy_model = qobject_cast<QSortFilterProxyModel*>(selection_model->model());
-            if (proxy_model)
-            {
-                source_index = proxy_model->mapToSource(index);
-            }
-        }
+        block_index = command_hierarchy.GetGfxrNodeBlockIndex(source_index.internalId());
+    }
+    if (!block_index)
+    {
+        ClearArguments();
+        return;
     }
 
-    // Always use the source_index, regardless of whether a proxy was involved.
-    m_arg_proxy_model->SetTargetParentSourceIndex(source_index);
+    // The command is shown without arguments if they can't be decoded, such as for the commands
+    // read from an asset file
+    static const nlohmann::ordered_json kNoArgs = nlohmann::ordered_json::object();
+    Dive::GfxrCommandArgsCache::Args args =
+        m_data_core.GetGfxrCaptureData().GetCommandArgs(*block_index);
+
+    m_arg_proxy_model->SetTargetParentSourceIndex(QModelIndex());
+    m_command_hierarchy_model->Reset();
+    Dive::GfxrVulkanCommandHierarchyCreator creator(m_arguments_hierarchy,
+                                                    m_data_core.GetGfxrCaptureData());
+    creator.CreateArgumentTrees(command_hierarchy.GetNodeDesc(source_index.internalId()),
+                                args ? *args : kNoArgs);
+    m_command_hierarchy_model->SetTopologyToView(
+        &m_arguments_hierarchy.GetAllEventHierarchyTopology());
+    m_arg_proxy_model->SetTargetParentSourceIndex(m_command_hierarchy_model->index(0, 0));
 
     uint32_t column_count =
         static_cast<uint32_t>(m_command_hierarchy_model->columnCount(QModelIndex()));
@@ -132,6 +138,14 @@ void GfxrVulkanCommandArgumentsTabView::OnSelectionChanged(const QModelIndex& in
     m_command_hierarchy_view->expandAll();
 }
 
+//--------------------------------------------------------------------------------------------------
+void GfxrVulkanCommandArgumentsTabView::ClearArguments()
+{
+    m_arg_proxy_model->SetTargetParentSourceIndex(QModelIndex());
+    m_command_hierarchy_model->Reset();
+    m_arguments_hierarchy = Dive::CommandHierarchy();
+}
+
 //--------------------------------------------------------------------------------------------------
 void GfxrVulkanCommandArgumentsTabView::OnSearchCommandArgs()
 {
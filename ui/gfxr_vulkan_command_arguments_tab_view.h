@@ -17,6 +17,8 @@
 #include <QFrame>
 #include <QSortFilterProxyModel>
 
+#include "dive_core/command_hierarchy.h"
+
 #pragma once
 // Forward declaration
 class QGroupBox;
@@ -29,26 +31,24 @@ class DiveTreeView;
 class GfxrVulkanCommandModel;
 namespace Dive
 {
-class CommandHierarchy;
-class Topology;
+class DataCore;
 };  // namespace Dive
 
 //--------------------------------------------------------------------------------------------------
+// The arguments of the Vulkan commands are not kept once the capture is loaded. The arguments of
+// the selected command are decoded again from the GFXR file, into a hierarchy of their own
 class GfxrVulkanCommandArgumentsTabView : public QFrame
 {
     Q_OBJECT
 
  public:
-    GfxrVulkanCommandArgumentsTabView(const Dive::CommandHierarchy& vulkan_command_hierarchy,
-                                      GfxrVulkanCommandArgumentsFilterProxyModel* proxy_model,
-                                      GfxrVulkanCommandModel* command_hierarchy_model,
-                                      QWidget* parent = nullptr);
-
-    void SetTopologyToView(const Dive::Topology* topology_ptr);
+    GfxrVulkanCommandArgumentsTabView(const Dive::DataCore& data_core, QWidget* parent = nullptr);
 
     void ResetModel();
 
  public slots:
+    // The index is of a node of the command hierarchy of the data core, either from its model or
+    // from a proxy of it
     void OnSelectionChanged(const QModelIndex& index);
     void OnSearchCommandArgs();
     void OnSearchBarVisibilityChange(bool isHidden);
@@ -61,11 +61,16 @@ class GfxrVulkanCommandArgumentsTabView : public QFrame
     void HideOtherSearchBars();
 
  private:
+    // Show no arguments
+    void ClearArguments();
+
     DiveTreeView* m_command_hierarchy_view;
     QPushButton* m_search_trigger_button;
     SearchBar* m_search_bar = nullptr;
 
-    const Dive::CommandHierarchy& m_vulkan_command_hierarchy;
+    const Dive::DataCore& m_data_core;
+    // The selected command, with its arguments as children
+    Dive::CommandHierarchy m_arguments_hierarchy;
     GfxrVulkanCommandArgumentsFilterProxyModel* m_arg_proxy_model;
     GfxrVulkanCommandModel* m_command_hierarchy_model;
 };
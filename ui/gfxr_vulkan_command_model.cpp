@@ -58,7 +58,6 @@ void GfxrVulkanCommandModel::SetTopologyToView(const Dive::Topology* topology_pt
 {
     BeginResetModel();
     m_topology_ptr = topology_ptr;
-    m_node_lookup.clear();
     EndResetModel();
 }
 
@@ -68,7 +67,7 @@ QVariant GfxrVulkanCommandModel::data(const QModelIndex& index, int role) const
     if (!index.isValid()) return QVariant();
 
     uint64_t node_index = index.internalId();
-    QString full_node_desc = QString(m_command_hierarchy.GetNodeDesc(node_index));
+    QString full_node_desc = QString::fromStdString(m_command_hierarchy.GetNodeDesc(node_index));
     QString command_name = full_node_desc;
 
     int pos_colon = full_node_desc.indexOf(':');
@@ -184,29 +183,11 @@ int GfxrVulkanCommandModel::columnCount(const QModelIndex& parent) const { retur
 //--------------------------------------------------------------------------------------------------
 QModelIndex GfxrVulkanCommandModel::findNode(uint64_t node_index) const
 {
-    if (m_node_lookup.size() != m_command_hierarchy.size()) BuildNodeLookup();
-    if (node_index < m_command_hierarchy.size() && m_node_lookup[node_index].isValid())
-        return m_node_lookup[node_index];
-    return QModelIndex();
-}
-
-//--------------------------------------------------------------------------------------------------
-void GfxrVulkanCommandModel::BuildNodeLookup(const QModelIndex& parent) const
-{
-    if (!parent.isValid())
-    {
-        m_node_lookup.clear();
-        m_node_lookup.resize(m_command_hierarchy.size());
-    }
-    int n = rowCount(parent);
-    for (int r = 0; r < n; ++r)
-    {
-        auto ix = index(r, 0, parent);
-        uint64_t node_index = ix.internalId();
-        if (node_index < m_node_lookup.size())
-            m_node_lookup[node_index] = QPersistentModelIndex(ix);
-        BuildNodeLookup(ix);
-    }
+    // Same as CommandModel::findNode
+    if (m_topology_ptr == nullptr || node_index >= m_topology_ptr->Topology::GetNumNodes() ||
+        m_topology_ptr->GetParentNodeIndex(node_index) == UINT64_MAX)
+        return QModelIndex();
+    return createIndex(m_topology_ptr->GetChildIndex(node_index), 0, node_index);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -49,6 +49,7 @@ class GfxrVulkanCommandModel : public QAbstractItemModel
     QModelIndex parent(const QModelIndex& index) const override;
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    // Returns an invalid index if the node is not in the topology being viewed
     QModelIndex findNode(uint64_t node_index) const;
 
     QList<QModelIndex> search(const QModelIndex& start, const QVariant& value) const;
@@ -56,10 +57,7 @@ class GfxrVulkanCommandModel : public QAbstractItemModel
     uint64_t getNumNodes() const;
 
  private:
-    void BuildNodeLookup(const QModelIndex& parent = QModelIndex()) const;
-
     const Dive::CommandHierarchy& m_command_hierarchy;
     const Dive::Topology* m_topology_ptr;
     const std::unordered_map<std::string, const char*>& m_vulkan_command_tool_tip_summaries;
-    mutable std::vector<QPersistentModelIndex> m_node_lookup;
 };
@@ -71,6 +71,10 @@ ABSL_FLAG(std::string, test_scenario, "", "Execute test scenario.");
 
 ABSL_FLAG(bool, native_style, false, "Use system provided style");
 ABSL_FLAG(bool, maximize, false, "Launch application maximized");
+ABSL_FLAG(bool, shader_cache, true,
+          "Keep the disassembly of shaders in the user cache directory, and reuse it");
+ABSL_FLAG(bool, metadata_cache, true,
+          "Keep the parsed metadata of captures in the user cache directory, and reuse it");
 
 // QApplication flags:
 ABSL_RETIRED_FLAG(std::string, style, "", "Set the application GUI style");
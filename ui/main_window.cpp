@@ -52,6 +52,8 @@
 #include <memory>
 #include <optional>
 
+#include "absl/flags/declare.h"
+#include "absl/flags/flag.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "capture_service/constants.h"
@@ -60,6 +62,7 @@
 #include "dive/ui/types/file_path.h"
 #include "dive/utils/device_resources.h"
 #include "dive/utils/device_resources_constants.h"
+#include "dive_core/capture_metadata_cache.h"
 #include "dive_core/command_hierarchy.h"
 #include "dive_core/common/common.h"
 #include "dive_core/data_core.h"
@@ -78,7 +81,6 @@
 #include "ui/event_selection_model.h"
 #include "ui/event_state_view.h"
 #include "ui/frame_tab_view.h"
-#include "ui/gfxr_vulkan_command_arguments_filter_proxy_model.h"
 #include "ui/gfxr_vulkan_command_arguments_tab_view.h"
 #include "ui/gfxr_vulkan_command_filter.h"
 #include "ui/gfxr_vulkan_command_filter_proxy_model.h"
@@ -100,6 +102,9 @@
 #include "ui/what_if_configure_dialog.h"
 #include "ui/what_if_setup_dialog.h"
 
+ABSL_DECLARE_FLAG(bool, metadata_cache);
+ABSL_DECLARE_FLAG(bool, shader_cache);
+
 namespace
 {
 constexpr int kMessageTimeoutMs = 2500;
@@ -192,6 +197,16 @@ MainWindow::MainWindow(ApplicationController& controller) : m_controller(control
     m_error_dialog = new ErrorDialog(this);
 
     m_data_core = std::make_shared<Dive::DataCore>(&m_progress_tracker);
+    // Captures tend to be reopened many times, so skip re-parsing them when reopened
+    if (absl::GetFlag(FLAGS_metadata_cache))
+    {
+        m_data_core->SetMetadataCacheDirectory(Dive::CaptureMetadataCache::GetDefaultDirectory());
+    }
+    // Captures of the same application share most of their shaders
+    if (absl::GetFlag(FLAGS_shader_cache))
+    {
+        m_data_core->SetShaderCacheDirectory(Dive::ShaderDisassemblyCache::GetDefaultDirectory());
+    }
 
     m_capture_manager = new CaptureFileManager(this);
     m_capture_manager->Start(m_data_core);
@@ -200,6 +215,8 @@ MainWindow::MainWindow(ApplicationController& controller) : m_controller(control
 
     QObject::connect(m_capture_manager, &CaptureFileManager::FileLoadingFinished, this,
                      &MainWindow::OnFileLoaded);
+    QObject::connect(m_capture_manager, &CaptureFileManager::CommandHierarchyChunkLoaded, this,
+                     &MainWindow::OnCommandHierarchyChunkLoaded);
     QObject::connect(m_capture_manager, &CaptureFileManager::TraceStatsUpdated, this,
                      &MainWindow::OnTraceStatsUpdated);
 
@@ -278,10 +295,6 @@ MainWindow::MainWindow(ApplicationController& controller) : m_controller(control
         m_gfxr_vulkan_commands_filter_proxy_model = new GfxrVulkanCommandFilterProxyModel(
             m_data_core->GetCommandHierarchy(), m_command_hierarchy_view);
 
-        m_gfxr_vulkan_commands_arguments_filter_proxy_model =
-            new GfxrVulkanCommandArgumentsFilterProxyModel(m_command_hierarchy_view,
-                                                           &m_data_core->GetCommandHierarchy());
-
         m_filter_model = new DiveFilterModel(m_data_core->GetCommandHierarchy(), this);
         m_filter_model->setSourceModel(m_command_hierarchy_model);
         // Set the proxy model as the view's model
@@ -455,9 +468,8 @@ MainWindow::MainWindow(ApplicationController& controller) : m_controller(control
         m_event_state_view = new EventStateView(*m_data_core);
 
         m_perf_counter_tab_view = new PerfCounterTabView(*m_perf_counter_model, this);
-        m_gfxr_vulkan_command_arguments_tab_view = new GfxrVulkanCommandArgumentsTabView(
-            m_data_core->GetCommandHierarchy(), m_gfxr_vulkan_commands_arguments_filter_proxy_model,
-            m_gfxr_vulkan_command_hierarchy_model);
+        m_gfxr_vulkan_command_arguments_tab_view =
+            new GfxrVulkanCommandArgumentsTabView(*m_data_core);
         m_gpu_timing_tab_view =
             new GpuTimingTabView(*m_gpu_timing_model, m_data_core->GetCommandHierarchy(), this);
 
@@ -985,6 +997,12 @@ bool MainWindow::LoadFile(const std::string& file_name, bool is_temp_file, bool
         // Discard associated timing results.
         m_perf_counter_model->OnPerfCounterResultsGenerated("", std::nullopt);
         m_gpu_timing_model->OnGpuTimingResultsGenerated("");
+
+        // The search index is built from the command hierarchy, which is about to be reloaded, and
+        // searching it reads the hierarchy too.
+        m_command_hierarchy_view->StopIndexedSearch();
+        m_pm4_command_hierarchy_view->StopIndexedSearch();
+        m_command_hierarchy_model->StopBuildingSearchIndex();
         m_capture_manager->GetDataCoreLock().unlock();
 
         // Reset the command buffer model and view.
@@ -999,6 +1017,8 @@ bool MainWindow::LoadFile(const std::string& file_name, bool is_temp_file, bool
 
     auto reference = Dive::FilePath{file_name};
     auto components = m_capture_manager->ResolveComponents(reference);
+    // The chunks of the previous file are discarded once the next one is requested
+    HideLoadingCommandHierarchy();
     m_capture_manager->LoadFile(reference, components);
     // Clear task queue for fresh capture.
     m_loading_pending_task.clear();
@@ -1110,6 +1130,90 @@ void MainWindow::EmitLoadAssociatedFileTasks(const Dive::ComponentFilePaths& com
     }
 }
 
+//--------------------------------------------------------------------------------------------------
+void MainWindow::SetCommandHierarchyToView(const Dive::CommandHierarchy& command_hierarchy)
+{
+    // The model is reset with no topology, so nothing reads either hierarchy while they are
+    // switched
+    m_command_hierarchy_model->SetCommandHierarchy(command_hierarchy);
+    m_filter_model->SetCommandHierarchy(command_hierarchy);
+    m_command_hierarchy_view->SetCommandHierarchy(command_hierarchy);
+    m_pm4_command_hierarchy_view->SetCommandHierarchy(command_hierarchy);
+}
+
+//--------------------------------------------------------------------------------------------------
+void MainWindow::ShowLoadingCommandHierarchy()
+{
+    SetCommandHierarchyToView(*m_loading_command_hierarchy);
+    m_command_hierarchy_view->setModel(m_filter_model);
+    // The search index is built once the capture is loaded, since the hierarchy keeps growing
+    m_command_hierarchy_model->SetTopologyToView(
+        &m_loading_command_hierarchy->GetAllEventHierarchyTopology(), false);
+    m_middle_group_box->hide();
+    m_command_hierarchy_view->resizeColumnToContents(0);
+
+    // The rest of the window reads the data core, which is locked for loading. Widgets disabled
+    // beforehand stay disabled
+    std::vector<QWidget*> widgets = {menuBar(), m_file_tool_bar, m_tab_widget};
+    for (QWidget* widget :
+         m_left_group_box->findChildren<QWidget*>(QString(), Qt::FindDirectChildrenOnly))
+    {
+        if (widget != m_command_hierarchy_view) widgets.push_back(widget);
+    }
+    for (QWidget* widget : widgets)
+    {
+        if (widget->testAttribute(Qt::WA_Disabled)) continue;
+        widget->setEnabled(false);
+        m_loading_disabled_widgets.push_back(widget);
+    }
+    m_loading_window_disabled = testAttribute(Qt::WA_Disabled);
+    setDisabled(false);
+
+    // Progress is shown in the status bar instead (see UpdateOverlay())
+    m_overlay->Clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+void MainWindow::HideLoadingCommandHierarchy()
+{
+    if (m_loading_command_hierarchy == nullptr)
+    {
+        return;
+    }
+    SetCommandHierarchyToView(m_data_core->GetCommandHierarchy());
+    m_loading_command_hierarchy = nullptr;
+
+    for (QWidget* widget : m_loading_disabled_widgets)
+    {
+        widget->setEnabled(true);
+    }
+    m_loading_disabled_widgets.clear();
+    setDisabled(m_loading_window_disabled);
+    m_status_bar->clearMessage();
+}
+
+//--------------------------------------------------------------------------------------------------
+void MainWindow::OnCommandHierarchyChunkLoaded(
+    std::shared_ptr<const Dive::CommandHierarchyChunk> chunk)
+{
+    // Only while loading, since the data core's command hierarchy is displayed once it is loaded
+    if (m_capture_acquired)
+    {
+        return;
+    }
+
+    if (m_loading_command_hierarchy == nullptr)
+    {
+        m_loading_command_hierarchy = std::make_unique<Dive::CommandHierarchy>();
+        m_loading_command_hierarchy->AppendChunk(*chunk);
+        ShowLoadingCommandHierarchy();
+        return;
+    }
+
+    // Nodes already displayed keep their rows, so they stay expanded and selected
+    m_command_hierarchy_model->AppendChunk(*m_loading_command_hierarchy, *chunk);
+}
+
 //--------------------------------------------------------------------------------------------------
 void MainWindow::OnFileLoaded(const LoadFileResult& loaded_file)
 {
@@ -1132,6 +1236,7 @@ void MainWindow::OnFileLoaded(const LoadFileResult& loaded_file)
     }
 
     // Re-enable UI interaction now we are done async loading.
+    HideLoadingCommandHierarchy();
     setDisabled(false);
     HideOverlay();
 
@@ -1781,7 +1886,16 @@ void MainWindow::CreateStatusBar()
 }
 
 //--------------------------------------------------------------------------------------------------
-void MainWindow::UpdateOverlay(const QString& message) { m_overlay->SetMessage(message); }
+void MainWindow::UpdateOverlay(const QString& message)
+{
+    // The overlay would cover the command hierarchy displayed while loading
+    if (m_loading_command_hierarchy != nullptr)
+    {
+        m_status_bar->showMessage(message);
+        return;
+    }
+    m_overlay->SetMessage(message);
+}
 
 //--------------------------------------------------------------------------------------------------
 void MainWindow::OnHideOverlay() { m_overlay->Clear(); }
@@ -100,6 +100,7 @@ class DIVE_UI_LIB_EXPORT MainWindow : public QMainWindow
     void UpdateOverlay(const QString&);
     void OnCrossReference(Dive::CrossRef);
     void OnFileLoaded(const LoadFileResult& loaded_file);
+    void OnCommandHierarchyChunkLoaded(std::shared_ptr<const Dive::CommandHierarchyChunk>);
     void OnTraceAvailable(const QString&);
     void OnTabViewSearchBarVisibilityChange(bool isHidden);
     void OnTabViewChange();
@@ -130,6 +131,10 @@ class DIVE_UI_LIB_EXPORT MainWindow : public QMainWindow
     void OnGfxrFileLoaded();
     void EmitLoadAssociatedFileTasks(const Dive::ComponentFilePaths&);
 
+    void SetCommandHierarchyToView(const Dive::CommandHierarchy& command_hierarchy);
+    void ShowLoadingCommandHierarchy();
+    void HideLoadingCommandHierarchy();
+
     void StartTraceStats();
 
     void CreateActions();
@@ -301,13 +306,17 @@ class DIVE_UI_LIB_EXPORT MainWindow : public QMainWindow
     // Overlay to be displayed while capture
     OverlayHelper* m_overlay = nullptr;
 
-    GfxrVulkanCommandArgumentsFilterProxyModel*
-        m_gfxr_vulkan_commands_arguments_filter_proxy_model = nullptr;
     std::unique_ptr<Dive::AvailableMetrics> m_available_metrics;
     std::unique_ptr<Dive::CaptureStats> m_capture_stats;
 
     bool m_capture_acquired = false;
     LastRequest m_last_request;
 
+    // The command hierarchy of the submits loaded so far, which is displayed while the rest of the
+    // capture is loading. Only the command hierarchy view stays enabled while it is displayed
+    std::unique_ptr<Dive::CommandHierarchy> m_loading_command_hierarchy;
+    std::vector<QWidget*> m_loading_disabled_widgets;
+    bool m_loading_window_disabled = false;
+
     std::vector<std::function<void()>> m_loading_pending_task;
 };